@@ -0,0 +1,118 @@
+#include "BatchMerge.h"
+
+#include "Global/ParallelFor.h"
+
+#include <algorithm>
+#include <cmath>
+
+#undef min
+#undef max
+
+namespace
+{
+	// Hulls per merge task, keeps thread overhead small for frames with few polygons
+	const size_t mergeChunk = 64;
+
+	// True if the upper 3x3 is a rotation (or reflection), which keeps vector lengths
+	bool keepsLengths(const TransformKernels::Affine& tfm)
+	{
+		for ( int i = 0; i < 3; ++i )
+		{
+			for ( int j = 0; j < 3; ++j )
+			{
+				float dot = tfm.m[0][i]*tfm.m[0][j] + tfm.m[1][i]*tfm.m[1][j] + tfm.m[2][i]*tfm.m[2][j];
+				if ( std::fabs(dot - ((i == j) ? 1.0f : 0.0f)) > 1.0e-5f )
+					return false;
+			}
+		}
+
+		return true;
+	}
+}
+
+
+void BatchMerge::bakeColors(const std::vector<Color>& meshColors, uint32_t numVerts, const Vec<float>& color, float alpha, bool useColor,
+	std::vector<Color>& colorsOut)
+{
+	colorsOut.resize(numVerts);
+	for ( uint32_t i = 0; i < numVerts; ++i )
+	{
+		Color vertColor = (i < meshColors.size()) ? meshColors[i] : Color(1.0f, 1.0f, 1.0f, 1.0f);
+		if ( useColor )
+			vertColor = Color(color, vertColor.a);
+
+		vertColor.a *= alpha;
+		colorsOut[i] = vertColor;
+	}
+}
+
+void BatchMerge::merge(const std::vector<Hull>& hulls, VertexLayout layout, std::vector<uint8_t>& vertMemOut, std::vector<Vec<uint32_t>>& facesOut)
+{
+	size_t totalVerts = 0;
+	size_t totalFaces = 0;
+	for ( const Hull& hull : hulls )
+	{
+		totalVerts = std::max(totalVerts, size_t(hull.firstVert + hull.numVerts));
+		for ( int lod = 0; lod < hull.numLods; ++lod )
+			totalFaces = std::max(totalFaces, size_t(hull.firstFace[lod] + hull.numFaces[lod]));
+	}
+
+	size_t vertSize = layout.getVertSize();
+
+	vertMemOut.resize(totalVerts * vertSize);
+	facesOut.resize(totalFaces);
+
+	// Every hull owns disjoint vertex and face ranges so chunks can be written without locking
+	parallelFor(hulls.size(), mergeChunk, [&](size_t begin, size_t end)
+	{
+		VertexLayout chunkLayout = layout;
+
+		std::vector<Vec<float>> verts;
+		std::vector<Vec<float>> norms;
+		std::vector<Color> colors;
+
+		for ( size_t i = begin; i < end; ++i )
+		{
+			const Hull& hull = hulls[i];
+
+			verts.resize(hull.numVerts);
+			TransformKernels::transformPoints(hull.localToFrame, hull.vertices->data(), verts.data(), hull.numVerts);
+
+			// Meshes without normals get zero normals
+			size_t numNorms = std::min(hull.normals->size(), size_t(hull.numVerts));
+			norms.assign(hull.numVerts, Vec<float>(0.0f, 0.0f, 0.0f));
+
+			// The inverse transpose keeps normals perpendicular to the surface under non-uniform scale
+			TransformKernels::Affine normalTfm = hull.localToFrame.normalTransform();
+			TransformKernels::transformVectors(normalTfm, hull.normals->data(), norms.data(), numNorms);
+
+			// It also changes their length when it scales, they keep the mesh's lengths like they would under a rotation
+			if ( !keepsLengths(normalTfm) )
+			{
+				for ( size_t v = 0; v < numNorms; ++v )
+				{
+					Vec<float> meshNorm = (*hull.normals)[v];
+					float length = float(norms[v].length());
+					if ( length > 0.0f )
+						norms[v] = norms[v] * (float(meshNorm.length()) / length);
+				}
+			}
+
+			bakeColors(*hull.colors, hull.numVerts, hull.color, hull.alpha, hull.useColor, colors);
+
+			const float* attrData[VertexLayout::Attributes::ATTR_END] = {NULL};
+			attrData[VertexLayout::Attributes::Position] = (float*)verts.data();
+			attrData[VertexLayout::Attributes::Normal] = (float*)norms.data();
+			attrData[VertexLayout::Attributes::Color] = (float*)colors.data();
+
+			chunkLayout.interleave(vertMemOut.data() + hull.firstVert * vertSize, hull.numVerts, attrData);
+
+			for ( int lod = 0; lod < hull.numLods; ++lod )
+			{
+				const std::vector<Vec<uint32_t>>& lodFaces = *hull.lodFaces[lod];
+				for ( uint32_t f = 0; f < hull.numFaces[lod]; ++f )
+					facesOut[hull.firstFace[lod] + f] = lodFaces[f] + hull.firstVert;
+			}
+		}
+	});
+}
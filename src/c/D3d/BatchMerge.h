@@ -0,0 +1,49 @@
+#pragma once
+#include "Global/Vec.h"
+#include "Global/Color.h"
+#include "TransformKernels.h"
+#include "VertexLayouts.h"
+
+#include <cstdint>
+#include <vector>
+
+// CPU side of merging polygon hulls into one packed vertex/index buffer.
+// Works on plain mesh arrays so it doesn't depend on the scene graph, PolygonBatch gathers the hulls.
+class BatchMerge
+{
+public:
+	// Must cover ResourceCache::numLodLevels
+	static const int maxLods = 3;
+
+	// A single hull's mesh data and its ranges in the merged buffers
+	struct Hull
+	{
+		const std::vector<Vec<float>>* vertices;
+		const std::vector<Vec<float>>* normals;
+		const std::vector<Color>* colors;
+		// Level 0 is the full mesh
+		const std::vector<Vec<uint32_t>>* lodFaces[maxLods];
+
+		TransformKernels::Affine localToFrame;
+
+		// Color replaces the mesh vertex colors when useColor is set, alpha always scales them
+		Vec<float> color;
+		float alpha;
+		bool useColor;
+
+		uint32_t firstVert;
+		uint32_t numVerts;
+
+		uint32_t firstFace[maxLods];
+		uint32_t numFaces[maxLods];
+		int numLods;
+	};
+
+	// Per-vertex colors matching what the static color shader produces, meshes without colors are white
+	static void bakeColors(const std::vector<Color>& meshColors, uint32_t numVerts, const Vec<float>& color, float alpha, bool useColor,
+		std::vector<Color>& colorsOut);
+
+	// Fills the interleaved vertices and the offset faces of every LOD level for every hull, hulls are processed in parallel.
+	// Hull ranges must not overlap, the outputs are sized to the largest range end.
+	static void merge(const std::vector<Hull>& hulls, VertexLayout layout, std::vector<uint8_t>& vertMemOut, std::vector<Vec<uint32_t>>& facesOut);
+};
@@ -37,6 +37,7 @@ public:
 	void setCamera(Vec<float> cameraPositionIn, Vec<float> lookPositionIn, Vec<float> upDirectionIn);
 	virtual void updateProjectionTransform();
 	virtual void setViewportSize(Vec<int> viewportSizeIn);
+	Vec<int> getViewportSize() const {return viewportSize;}
 
 	DirectX::XMMATRIX getProjectionTransform() const {return ConvertMatrix(projectionTransform);}
 	DirectX::XMMATRIX getViewTransform() const {return ConvertMatrix(viewTransform);}
@@ -0,0 +1,65 @@
+#include "FrameScheduler.h"
+
+#include <algorithm>
+#include <limits>
+
+#undef min
+#undef max
+
+FrameScheduler::FrameScheduler()
+{
+	for ( int i = 0; i < NumTimers; ++i )
+	{
+		timers[i].enabled = false;
+		timers[i].period = Clock::duration::zero();
+		timers[i].deadline = Clock::time_point();
+	}
+}
+
+void FrameScheduler::setTimer(Timer timer, bool enabled, double periodSeconds, Clock::time_point now)
+{
+	TimerState& state = timers[timer];
+
+	Clock::duration period = std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double>(periodSeconds));
+	if ( period <= Clock::duration::zero() )
+		enabled = false;
+
+	if ( !enabled )
+	{
+		state.enabled = false;
+		return;
+	}
+
+	if ( state.enabled && state.period == period )
+		return;
+
+	state.enabled = true;
+	state.period = period;
+	state.deadline = now + period;
+}
+
+int FrameScheduler::takeElapsed(Timer timer, Clock::time_point now)
+{
+	TimerState& state = timers[timer];
+	if ( !state.enabled || now < state.deadline )
+		return 0;
+
+	Clock::duration::rep numPeriods = 1 + (now - state.deadline) / state.period;
+	state.deadline += numPeriods * state.period;
+
+	return int(std::min<Clock::duration::rep>(numPeriods, std::numeric_limits<int>::max()));
+}
+
+FrameScheduler::Clock::duration FrameScheduler::timeUntilNext(Clock::time_point now) const
+{
+	Clock::duration wait = Clock::duration::max();
+	for ( int i = 0; i < NumTimers; ++i )
+	{
+		if ( !timers[i].enabled )
+			continue;
+
+		wait = std::min(wait, std::max(Clock::duration::zero(), timers[i].deadline - now));
+	}
+
+	return wait;
+}
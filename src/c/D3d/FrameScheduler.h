@@ -0,0 +1,42 @@
+#pragma once
+
+#include <chrono>
+
+// Deadlines for the render loop's periodic work (playback, spinning and shader reloads).
+// The current time is always passed in, so the pacing never depends on which clock the caller reads.
+class FrameScheduler
+{
+public:
+	typedef std::chrono::steady_clock Clock;
+
+	enum Timer
+	{
+		Play,
+		Rotate,
+		ShaderReload,
+		NumTimers
+	};
+
+	FrameScheduler();
+
+	// Starts, stops or re-times a timer, a non-positive period stops it.
+	// Calling again with the same settings keeps the current deadline, a newly started timer first fires one period after now.
+	void setTimer(Timer timer, bool enabled, double periodSeconds, Clock::time_point now);
+
+	// Number of whole periods that have passed since the timer last fired, zero if it is not due yet.
+	// Deadlines advance by whole periods so the average rate holds however late the loop wakes.
+	int takeElapsed(Timer timer, Clock::time_point now);
+
+	// How long the loop can block before the next timer is due, Clock::duration::max() if none are running
+	Clock::duration timeUntilNext(Clock::time_point now) const;
+
+private:
+	struct TimerState
+	{
+		bool enabled;
+		Clock::duration period;
+		Clock::time_point deadline;
+	};
+
+	TimerState timers[NumTimers];
+};
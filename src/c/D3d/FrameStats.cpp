@@ -0,0 +1,226 @@
+#include "FrameStats.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+namespace
+{
+	const char* stageNames[FrameStats::NumStages] = {"Start", "Background", "Main", "Widget", "Overlay", "Present"};
+
+	const double nsToMs = 1.0e-6;
+
+	uint64_t elapsedNs(FrameStats::Clock::time_point from, FrameStats::Clock::time_point to)
+	{
+		return uint64_t(std::chrono::duration_cast<std::chrono::nanoseconds>(to - from).count());
+	}
+
+	// Nearest rank of the given fraction, sorts only as much as it needs
+	double percentileMs(std::vector<uint64_t>& values, double fraction)
+	{
+		if ( values.empty() )
+			return 0.0;
+
+		size_t rank = size_t(std::ceil(fraction * double(values.size())));
+		rank = (rank > 0) ? (rank - 1) : 0;
+		rank = std::min(rank, values.size() - 1);
+
+		std::nth_element(values.begin(), values.begin() + rank, values.end());
+		return double(values[rank]) * nsToMs;
+	}
+}
+
+
+const FrameStats::Clock::duration FrameStats::alertInterval = std::chrono::milliseconds(100);
+
+FrameStats::FrameStats()
+	: next(0), numSamples(0), frames(0), overBudget(0), droppedFrames(0), unreportedOverBudget(0)
+{
+	memset(&current, 0, sizeof(current));
+	setSettings(Settings());
+}
+
+void FrameStats::setSettings(const Settings& newSettings)
+{
+	std::lock_guard<std::mutex> lock(mutex);
+
+	settings = newSettings;
+	if ( settings.targetFps <= 0.0 )
+		settings.targetFps = Settings().targetFps;
+	if ( settings.window == 0 )
+		settings.window = 1;
+
+	intervalNs = 1.0e9 / settings.targetFps;
+	budgetNs = (settings.budgetMs > 0.0) ? (settings.budgetMs / nsToMs) : intervalNs;
+
+	// Keep the newest frames that still fit
+	if ( samples.size() != settings.window )
+	{
+		std::vector<Sample> resized(settings.window);
+
+		size_t keep = std::min(numSamples, settings.window);
+		for ( size_t i = 0; i < keep; ++i )
+			resized[keep - 1 - i] = samples[(next + samples.size() - 1 - i) % samples.size()];
+
+		samples.swap(resized);
+		numSamples = keep;
+		next = keep % settings.window;
+	}
+}
+
+FrameStats::Settings FrameStats::getSettings()
+{
+	std::lock_guard<std::mutex> lock(mutex);
+	return settings;
+}
+
+void FrameStats::beginFrame()
+{
+	frameStart = Clock::now();
+	stageStart = frameStart;
+
+	memset(&current, 0, sizeof(current));
+}
+
+void FrameStats::markStage(Stage stage)
+{
+	Clock::time_point now = Clock::now();
+
+	current.stages[stage] += elapsedNs(stageStart, now);
+	stageStart = now;
+}
+
+bool FrameStats::endFrame(Alert& alertOut)
+{
+	Clock::time_point now = Clock::now();
+	current.frame = elapsedNs(frameStart, now);
+
+	std::lock_guard<std::mutex> lock(mutex);
+
+	samples[next] = current;
+	next = (next + 1) % samples.size();
+	numSamples = std::min(numSamples + 1, samples.size());
+
+	++frames;
+
+	double frameNs = double(current.frame);
+	if ( frameNs > intervalNs )
+		droppedFrames += uint64_t(std::ceil(frameNs / intervalNs)) - 1;
+
+	if ( frameNs <= budgetNs )
+		return false;
+
+	++overBudget;
+	++unreportedOverBudget;
+
+	if ( now - lastAlert < alertInterval )
+		return false;
+
+	int slowest = 0;
+	for ( int i = 1; i < NumStages; ++i )
+	{
+		if ( current.stages[i] > current.stages[slowest] )
+			slowest = i;
+	}
+
+	alertOut.frameMs = frameNs * nsToMs;
+	alertOut.budgetMs = budgetNs * nsToMs;
+	alertOut.numFrames = unreportedOverBudget;
+	alertOut.slowestStage = Stage(slowest);
+	alertOut.slowestStageMs = double(current.stages[slowest]) * nsToMs;
+
+	unreportedOverBudget = 0;
+	lastAlert = now;
+
+	return true;
+}
+
+void FrameStats::getSummary(Summary& summaryOut)
+{
+	std::lock_guard<std::mutex> lock(mutex);
+
+	summaryOut.settings = settings;
+	summaryOut.settings.budgetMs = budgetNs * nsToMs;
+
+	summaryOut.windowFrames = numSamples;
+	summaryOut.frames = frames;
+	summaryOut.overBudget = overBudget;
+	summaryOut.droppedFrames = droppedFrames;
+
+	std::vector<uint64_t> frameNs(numSamples);
+
+	double frameSum = 0.0;
+	double stageSums[NumStages] = {0.0};
+	uint64_t stageMax[NumStages] = {0};
+
+	for ( size_t i = 0; i < numSamples; ++i )
+	{
+		const Sample& sample = samples[i];
+
+		frameNs[i] = sample.frame;
+		frameSum += double(sample.frame);
+
+		for ( int j = 0; j < NumStages; ++j )
+		{
+			stageSums[j] += double(sample.stages[j]);
+			stageMax[j] = std::max(stageMax[j], sample.stages[j]);
+		}
+	}
+
+	double count = (numSamples > 0) ? double(numSamples) : 1.0;
+
+	summaryOut.meanMs = frameSum / count * nsToMs;
+	summaryOut.p50Ms = percentileMs(frameNs, 0.50);
+	summaryOut.p95Ms = percentileMs(frameNs, 0.95);
+	summaryOut.p99Ms = percentileMs(frameNs, 0.99);
+	summaryOut.maxMs = percentileMs(frameNs, 1.0);
+
+	for ( int j = 0; j < NumStages; ++j )
+	{
+		summaryOut.stageMeanMs[j] = stageSums[j] / count * nsToMs;
+		summaryOut.stageMaxMs[j] = double(stageMax[j]) * nsToMs;
+	}
+}
+
+void FrameStats::reset()
+{
+	std::lock_guard<std::mutex> lock(mutex);
+
+	next = 0;
+	numSamples = 0;
+
+	frames = 0;
+	overBudget = 0;
+	droppedFrames = 0;
+	unreportedOverBudget = 0;
+}
+
+void FrameStats::getRecentMeans(size_t numFrames, double& frameMsOut, double stageMsOut[NumStages])
+{
+	std::lock_guard<std::mutex> lock(mutex);
+
+	numFrames = std::min(numFrames, numSamples);
+
+	double frameSum = 0.0;
+	double stageSums[NumStages] = {0.0};
+
+	for ( size_t i = 0; i < numFrames; ++i )
+	{
+		const Sample& sample = samples[(next + samples.size() - 1 - i) % samples.size()];
+
+		frameSum += double(sample.frame);
+		for ( int j = 0; j < NumStages; ++j )
+			stageSums[j] += double(sample.stages[j]);
+	}
+
+	double count = (numFrames > 0) ? double(numFrames) : 1.0;
+
+	frameMsOut = frameSum / count * nsToMs;
+	for ( int j = 0; j < NumStages; ++j )
+		stageMsOut[j] = stageSums[j] / count * nsToMs;
+}
+
+const char* FrameStats::getStageName(Stage stage)
+{
+	return (stage >= 0 && stage < NumStages) ? stageNames[stage] : "";
+}
@@ -0,0 +1,128 @@
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+#include <mutex>
+#include <vector>
+
+// Rolling statistics of how long rendered frames took, overall and per render stage.
+// The render thread times each frame with beginFrame/markStage/endFrame, anyone can read a summary.
+// Frames over the budget are counted and reported as alerts, at most one per alertInterval so a slow
+// stretch doesn't flood the event queue.
+class FrameStats
+{
+public:
+	typedef std::chrono::steady_clock Clock;
+
+	// In the order renderAll runs them
+	enum Stage
+	{
+		Start,
+		Background,
+		Main,
+		Widget,
+		Overlay,
+		Present,
+		NumStages
+	};
+
+	struct Settings
+	{
+		Settings() : targetFps(60.0), budgetMs(0.0), window(600) {}
+
+		// A frame that takes longer than 1/targetFps misses at least one display interval
+		double targetFps;
+		// Frames above this raise an alert, zero uses the target interval
+		double budgetMs;
+		// Number of most recent frames the percentiles are taken over
+		size_t window;
+	};
+
+	struct Summary
+	{
+		// budgetMs is the budget in effect, even when it follows the target rate
+		Settings settings;
+
+		// Frames the percentiles below cover (at most settings.window)
+		size_t windowFrames;
+
+		// Counts since the last reset
+		uint64_t frames;
+		uint64_t overBudget;
+		// Display intervals missed, a frame that took 2.5 intervals missed 2
+		uint64_t droppedFrames;
+
+		double meanMs;
+		double p50Ms;
+		double p95Ms;
+		double p99Ms;
+		double maxMs;
+
+		double stageMeanMs[NumStages];
+		double stageMaxMs[NumStages];
+	};
+
+	// Sent by endFrame when a frame went over budget
+	struct Alert
+	{
+		double frameMs;
+		double budgetMs;
+		// Frames over budget since the previous alert, including this one
+		uint64_t numFrames;
+
+		Stage slowestStage;
+		double slowestStageMs;
+	};
+
+	static const Clock::duration alertInterval;
+
+	FrameStats();
+
+	void setSettings(const Settings& newSettings);
+	Settings getSettings();
+
+	void beginFrame();
+	// Ends the stage that started at the previous mark (or beginFrame)
+	void markStage(Stage stage);
+	// Returns true with alertOut filled in when an alert should be sent for this frame
+	bool endFrame(Alert& alertOut);
+
+	void getSummary(Summary& summaryOut);
+	void reset();
+
+	// Means of the last numFrames frames for the on-screen stats, in milliseconds
+	void getRecentMeans(size_t numFrames, double& frameMsOut, double stageMsOut[NumStages]);
+
+	static const char* getStageName(Stage stage);
+
+private:
+	struct Sample
+	{
+		// Nanoseconds
+		uint64_t frame;
+		uint64_t stages[NumStages];
+	};
+
+	std::mutex mutex;
+
+	Settings settings;
+	double budgetNs;
+	double intervalNs;
+
+	// Ring of the last settings.window frames, next is where the next frame goes
+	std::vector<Sample> samples;
+	size_t next;
+	size_t numSamples;
+
+	uint64_t frames;
+	uint64_t overBudget;
+	uint64_t droppedFrames;
+
+	uint64_t unreportedOverBudget;
+	Clock::time_point lastAlert;
+
+	// Only touched by the render thread between beginFrame and endFrame
+	Sample current;
+	Clock::time_point frameStart;
+	Clock::time_point stageStart;
+};
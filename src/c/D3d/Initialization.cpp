@@ -61,7 +61,7 @@ HRESULT registerWindowClass(HINSTANCE hInstance, int nCmdShow)
 		{
 			DWORD errCode = GetLastError();
 
-			gMsgQueueToMex.addMessage("error","Unable to register window class!",errCode);
+			gMsgQueueToMex.addErrorMessage("Unable to register window class!", errCode);
 
 			return E_FAIL;
 		}
@@ -77,7 +77,7 @@ HRESULT registerWindowClass(HINSTANCE hInstance, int nCmdShow)
 	{
 		DWORD errCode = GetLastError();
 		
-		gMsgQueueToMex.addMessage("error","Unable to register window class!",errCode);
+		gMsgQueueToMex.addErrorMessage("Unable to register window class!", errCode);
 
 		return E_FAIL;
 	}
@@ -0,0 +1,434 @@
+#include "MarchingCubes.h"
+
+#include "Global/ParallelFor.h"
+
+#include <algorithm>
+#include <cmath>
+#include <mutex>
+#include <unordered_map>
+
+#undef min
+#undef max
+
+namespace
+{
+	const uint32_t invalidVert = 0xFFFFFFFF;
+
+	// Corner c of a cube sits at offset (c&1, (c>>1)&1, (c>>2)&1)
+	inline int cornerBit(int corner, int axis){return (corner >> axis) & 1;}
+
+	struct CaseTable
+	{
+		// Each edge runs from its lower corner along one axis
+		int edgeCorner[12];
+		int edgeAxis[12];
+
+		// Three edges per triangle for each of the 256 inside/outside corner cases
+		std::vector<uint8_t> triEdges[256];
+
+		CaseTable();
+	};
+
+	CaseTable::CaseTable()
+	{
+		int edgeLookup[8][8];
+		int numEdges = 0;
+		for ( int axis = 0; axis < 3; ++axis )
+		{
+			for ( int corner = 0; corner < 8; ++corner )
+			{
+				if ( cornerBit(corner, axis) )
+					continue;
+
+				int other = corner | (1 << axis);
+				edgeCorner[numEdges] = corner;
+				edgeAxis[numEdges] = axis;
+				edgeLookup[corner][other] = numEdges;
+				edgeLookup[other][corner] = numEdges;
+				++numEdges;
+			}
+		}
+
+		// Face corners in counter-clockwise order when viewed from outside the cube
+		int faceCorners[6][4];
+		for ( int axis = 0; axis < 3; ++axis )
+		{
+			int u = (axis + 1) % 3;
+			int v = (axis + 2) % 3;
+			for ( int side = 0; side < 2; ++side )
+			{
+				int* corners = faceCorners[2*axis + side];
+				const int uv[4][2] = {{0,0}, {1,0}, {1,1}, {0,1}};
+				for ( int i = 0; i < 4; ++i )
+				{
+					int order = (side == 1) ? i : (3 - i);
+					corners[i] = (side << axis) | (uv[order][0] << u) | (uv[order][1] << v);
+				}
+			}
+		}
+
+		for ( int cubeCase = 0; cubeCase < 256; ++cubeCase )
+		{
+			// Every crossing edge starts exactly one face segment, so the segments chain into closed loops
+			int nextEdge[12];
+			for ( int e = 0; e < 12; ++e )
+				nextEdge[e] = -1;
+
+			for ( int face = 0; face < 6; ++face )
+			{
+				const int* corners = faceCorners[face];
+				bool inside[4];
+				for ( int i = 0; i < 4; ++i )
+					inside[i] = cornerBit(cubeCase, corners[i]) != 0;
+
+				// One segment per run of inside corners, so ambiguous faces always keep the inside corners apart
+				for ( int i = 0; i < 4; ++i )
+				{
+					if ( !inside[i] || inside[(i + 3) % 4] )
+						continue;
+
+					int j = i;
+					while ( inside[(j + 1) % 4] )
+						j = (j + 1) % 4;
+
+					int enterEdge = edgeLookup[corners[(i + 3) % 4]][corners[i]];
+					int exitEdge = edgeLookup[corners[j]][corners[(j + 1) % 4]];
+					nextEdge[exitEdge] = enterEdge;
+				}
+			}
+
+			bool used[12] = {false};
+			for ( int start = 0; start < 12; ++start )
+			{
+				if ( nextEdge[start] < 0 || used[start] )
+					continue;
+
+				std::vector<int> loop;
+				for ( int e = start; !used[e]; e = nextEdge[e] )
+				{
+					used[e] = true;
+					loop.push_back(e);
+				}
+
+				for ( size_t k = 1; k + 1 < loop.size(); ++k )
+				{
+					triEdges[cubeCase].push_back(uint8_t(loop[0]));
+					triEdges[cubeCase].push_back(uint8_t(loop[k]));
+					triEdges[cubeCase].push_back(uint8_t(loop[k + 1]));
+				}
+			}
+		}
+	}
+
+	const CaseTable& getCaseTable()
+	{
+		static const CaseTable table;
+		return table;
+	}
+}
+
+
+uint32_t MarchingCubes::labelComponents(Vec<size_t> dims, std::vector<uint32_t>& labels)
+{
+	// The 13 neighbors of a voxel that are visited before it in memory order
+	int64_t neighborOffsets[13][3];
+	int numNeighbors = 0;
+	for ( int dz = -1; dz <= 0; ++dz )
+	{
+		for ( int dy = -1; dy <= 1; ++dy )
+		{
+			for ( int dx = -1; dx <= 1; ++dx )
+			{
+				if ( dz == 0 && (dy > 0 || (dy == 0 && dx >= 0)) )
+					continue;
+
+				neighborOffsets[numNeighbors][0] = dx;
+				neighborOffsets[numNeighbors][1] = dy;
+				neighborOffsets[numNeighbors][2] = dz;
+				++numNeighbors;
+			}
+		}
+	}
+
+	std::vector<uint32_t> parent(1, 0);
+	auto findRoot = [&parent](uint32_t node)
+	{
+		while ( parent[node] != node )
+		{
+			parent[node] = parent[parent[node]];
+			node = parent[node];
+		}
+		return node;
+	};
+
+	int64_t sx = (int64_t)dims.x;
+	int64_t sy = (int64_t)dims.y;
+	int64_t sz = (int64_t)dims.z;
+
+	for ( int64_t z = 0; z < sz; ++z )
+	{
+		for ( int64_t y = 0; y < sy; ++y )
+		{
+			for ( int64_t x = 0; x < sx; ++x )
+			{
+				size_t idx = size_t(x + y*sx + z*sx*sy);
+				if ( labels[idx] == 0 )
+					continue;
+
+				uint32_t current = 0;
+				for ( int n = 0; n < numNeighbors; ++n )
+				{
+					int64_t nx = x + neighborOffsets[n][0];
+					int64_t ny = y + neighborOffsets[n][1];
+					int64_t nz = z + neighborOffsets[n][2];
+					if ( nx < 0 || ny < 0 || nz < 0 || nx >= sx || ny >= sy )
+						continue;
+
+					uint32_t neighbor = labels[size_t(nx + ny*sx + nz*sx*sy)];
+					if ( neighbor == 0 )
+						continue;
+
+					uint32_t root = findRoot(neighbor);
+					if ( current == 0 )
+					{
+						current = root;
+						continue;
+					}
+
+					if ( root != current )
+					{
+						uint32_t low = std::min(root, current);
+						parent[std::max(root, current)] = low;
+						current = low;
+					}
+				}
+
+				if ( current == 0 )
+				{
+					current = uint32_t(parent.size());
+					parent.push_back(current);
+				}
+
+				labels[idx] = current;
+			}
+		}
+	}
+
+	// Renumber the roots in memory order of their first voxel
+	std::vector<uint32_t> componentIds(parent.size(), 0);
+	uint32_t numComponents = 0;
+	for ( size_t i = 0; i < labels.size(); ++i )
+	{
+		if ( labels[i] == 0 )
+			continue;
+
+		uint32_t root = findRoot(labels[i]);
+		if ( componentIds[root] == 0 )
+			componentIds[root] = ++numComponents;
+
+		labels[i] = componentIds[root];
+	}
+
+	return numComponents;
+}
+
+void MarchingCubes::extractSurfaces(Vec<size_t> dims, const uint32_t* labels, float isoLevel, size_t minVoxels, size_t maxVoxels,
+	std::vector<Surface>& surfacesOut)
+{
+	surfacesOut.clear();
+
+	// Gather bounds and voxel counts per label, planes are scanned in parallel
+	std::unordered_map<uint32_t, LabelBounds> allBounds;
+	std::mutex boundsMutex;
+
+	size_t planeSize = dims.x * dims.y;
+	parallelFor(dims.z, 4, [&](size_t beginZ, size_t endZ)
+	{
+		std::unordered_map<uint32_t, LabelBounds> localBounds;
+		for ( size_t z = beginZ; z < endZ; ++z )
+		{
+			for ( size_t y = 0; y < dims.y; ++y )
+			{
+				const uint32_t* row = labels + y*dims.x + z*planeSize;
+				for ( size_t x = 0; x < dims.x; ++x )
+				{
+					if ( row[x] == 0 )
+						continue;
+
+					Vec<size_t> pos(x, y, z);
+					auto it = localBounds.find(row[x]);
+					if ( it == localBounds.end() )
+					{
+						LabelBounds bounds;
+						bounds.minPos = pos;
+						bounds.maxPos = pos;
+						bounds.count = 0;
+						bounds.posSum = Vec<double>(0.0);
+
+						it = localBounds.emplace(row[x], bounds).first;
+					}
+
+					LabelBounds& bounds = it->second;
+					bounds.minPos = Vec<size_t>::min(bounds.minPos, pos);
+					bounds.maxPos = Vec<size_t>::max(bounds.maxPos, pos);
+					bounds.posSum += Vec<double>(pos);
+					++bounds.count;
+				}
+			}
+		}
+
+		std::lock_guard<std::mutex> lock(boundsMutex);
+		for ( auto& it : localBounds )
+		{
+			auto found = allBounds.find(it.first);
+			if ( found == allBounds.end() )
+			{
+				allBounds.emplace(it.first, it.second);
+				continue;
+			}
+
+			LabelBounds& bounds = found->second;
+			bounds.minPos = Vec<size_t>::min(bounds.minPos, it.second.minPos);
+			bounds.maxPos = Vec<size_t>::max(bounds.maxPos, it.second.maxPos);
+			bounds.posSum += it.second.posSum;
+			bounds.count += it.second.count;
+		}
+	});
+
+	std::vector<uint32_t> extractLabels;
+	extractLabels.reserve(allBounds.size());
+	for ( auto& it : allBounds )
+	{
+		if ( it.second.count >= minVoxels && it.second.count <= maxVoxels )
+			extractLabels.push_back(it.first);
+	}
+
+	std::sort(extractLabels.begin(), extractLabels.end());
+
+	surfacesOut.resize(extractLabels.size());
+	parallelFor(extractLabels.size(), 1, [&](size_t begin, size_t end)
+	{
+		for ( size_t i = begin; i < end; ++i )
+			extractLabel(dims, labels, extractLabels[i], allBounds.at(extractLabels[i]), isoLevel, surfacesOut[i]);
+	});
+}
+
+void MarchingCubes::extractLabel(Vec<size_t> dims, const uint32_t* labels, uint32_t label, const LabelBounds& bounds,
+	float isoLevel, Surface& surfaceOut)
+{
+	const CaseTable& table = getCaseTable();
+
+	surfaceOut.label = label;
+	surfaceOut.numVoxels = bounds.count;
+	surfaceOut.faces.clear();
+	surfaceOut.vertices.clear();
+	surfaceOut.normals.clear();
+
+	// Sample grid covers the label bounds plus one outside voxel on every side
+	int64_t origin[3];
+	int64_t size[3];
+	for ( int i = 0; i < 3; ++i )
+	{
+		origin[i] = int64_t(bounds.minPos.e[i]) - 1;
+		size[i] = int64_t(bounds.maxPos.e[i]) - int64_t(bounds.minPos.e[i]) + 3;
+	}
+
+	size_t numPoints = size_t(size[0] * size[1] * size[2]);
+	std::vector<uint8_t> inside(numPoints, 0);
+	for ( int64_t z = 1; z < size[2] - 1; ++z )
+	{
+		for ( int64_t y = 1; y < size[1] - 1; ++y )
+		{
+			const uint32_t* row = labels + size_t(origin[0] + (origin[1] + y)*int64_t(dims.x) + (origin[2] + z)*int64_t(dims.x*dims.y));
+			uint8_t* insideRow = inside.data() + size_t(y*size[0] + z*size[0]*size[1]);
+			for ( int64_t x = 1; x < size[0] - 1; ++x )
+				insideRow[x] = (row[x] == label) ? 1 : 0;
+		}
+	}
+
+	int64_t strides[3] = {1, size[0], size[0]*size[1]};
+
+	int64_t cornerOffsets[8];
+	for ( int c = 0; c < 8; ++c )
+		cornerOffsets[c] = cornerBit(c,0)*strides[0] + cornerBit(c,1)*strides[1] + cornerBit(c,2)*strides[2];
+
+	// One cached vertex per grid edge, indexed by the edge's lower point and axis
+	std::vector<uint32_t> edgeVerts(3 * numPoints, invalidVert);
+
+	// Vertices are placed like D3d.Polygon.Make, (column,row,plane) 1-based, shifted to the voxel center
+	Vec<float> imageOrigin(float(origin[1]) + 1.5f, float(origin[0]) + 1.5f, float(origin[2]) + 1.5f);
+
+	for ( int64_t z = 0; z < size[2] - 1; ++z )
+	{
+		for ( int64_t y = 0; y < size[1] - 1; ++y )
+		{
+			for ( int64_t x = 0; x < size[0] - 1; ++x )
+			{
+				int64_t cellIdx = x*strides[0] + y*strides[1] + z*strides[2];
+
+				int cubeCase = 0;
+				for ( int c = 0; c < 8; ++c )
+					cubeCase |= inside[size_t(cellIdx + cornerOffsets[c])] << c;
+
+				const std::vector<uint8_t>& triEdges = table.triEdges[cubeCase];
+				if ( triEdges.empty() )
+					continue;
+
+				uint32_t faceVerts[3];
+				for ( size_t t = 0; t < triEdges.size(); ++t )
+				{
+					int edge = triEdges[t];
+					int corner = table.edgeCorner[edge];
+					int axis = table.edgeAxis[edge];
+
+					int64_t pointIdx = cellIdx + cornerOffsets[corner];
+					uint32_t& vertIdx = edgeVerts[size_t(3*pointIdx + axis)];
+					if ( vertIdx == invalidVert )
+					{
+						// The crossing sits isoLevel of the way from the outside end to the inside end
+						float along = (inside[size_t(pointIdx)]) ? (1.0f - isoLevel) : isoLevel;
+
+						float point[3] = {float(x + cornerBit(corner,0)), float(y + cornerBit(corner,1)), float(z + cornerBit(corner,2))};
+						point[axis] += along;
+
+						vertIdx = uint32_t(surfaceOut.vertices.size());
+						surfaceOut.vertices.push_back(imageOrigin + Vec<float>(point[1], point[0], point[2]));
+					}
+
+					faceVerts[t % 3] = vertIdx;
+					if ( t % 3 == 2 )
+						surfaceOut.faces.push_back(Vec<uint32_t>(faceVerts[0], faceVerts[1], faceVerts[2]));
+				}
+			}
+		}
+	}
+
+	// Same space as the vertices so the centroid sits inside the surface
+	Vec<double> meanPos = bounds.posSum / double(bounds.count);
+	surfaceOut.centroid = Vec<float>(float(meanPos.y) + 1.5f, float(meanPos.x) + 1.5f, float(meanPos.z) + 1.5f);
+
+	computeNormals(surfaceOut);
+}
+
+void MarchingCubes::computeNormals(Surface& surface)
+{
+	surface.normals.assign(surface.vertices.size(), Vec<float>(0.0f));
+
+	// Unnormalized face normals weight each face by its area
+	for ( const Vec<uint32_t>& face : surface.faces )
+	{
+		const Vec<float>& v0 = surface.vertices[face.x];
+		Vec<float> faceNormal = Vec<float>::cross(surface.vertices[face.y] - v0, surface.vertices[face.z] - v0);
+
+		surface.normals[face.x] += faceNormal;
+		surface.normals[face.y] += faceNormal;
+		surface.normals[face.z] += faceNormal;
+	}
+
+	for ( Vec<float>& normal : surface.normals )
+	{
+		float length = std::sqrt(Vec<float>::dot(normal, normal));
+		if ( length > 0.0f )
+			normal = normal / length;
+	}
+}
@@ -0,0 +1,50 @@
+#pragma once
+#include "Global/Vec.h"
+
+#include <cstdint>
+#include <vector>
+
+// Extracts per-label surfaces from label volumes.
+// Volumes are 0-based in MATLAB memory order (row fastest, dims.x is the number of rows).
+// Cube cases are triangulated from a table generated once at startup that resolves ambiguous
+// faces the same way in both neighboring cubes, so every surface is closed.
+class MarchingCubes
+{
+public:
+	struct Surface
+	{
+		uint32_t label;
+		size_t numVoxels;
+
+		// Image space (column, row, plane), 1-based, matching D3d.Polygon.Make
+		Vec<float> centroid;
+
+		std::vector<Vec<uint32_t>> faces;
+		std::vector<Vec<float>> vertices;
+		std::vector<Vec<float>> normals;
+	};
+
+	// Replaces non-zero voxels with 26-connected component numbers starting at 1, returns the component count
+	static uint32_t labelComponents(Vec<size_t> dims, std::vector<uint32_t>& labels);
+
+	// Surfaces for every non-zero label with a voxel count in [minVoxels,maxVoxels], ordered by label.
+	// isoLevel is the crossing point on a voxel edge as a fraction from outside (0) to inside (1).
+	// Labels are extracted in parallel, each one reusing vertices along shared cube edges.
+	static void extractSurfaces(Vec<size_t> dims, const uint32_t* labels, float isoLevel, size_t minVoxels, size_t maxVoxels,
+		std::vector<Surface>& surfacesOut);
+
+private:
+	struct LabelBounds
+	{
+		Vec<size_t> minPos;
+		Vec<size_t> maxPos;
+
+		size_t count;
+		Vec<double> posSum;
+	};
+
+	static void extractLabel(Vec<size_t> dims, const uint32_t* labels, uint32_t label, const LabelBounds& bounds,
+		float isoLevel, Surface& surfaceOut);
+
+	static void computeNormals(Surface& surface);
+};
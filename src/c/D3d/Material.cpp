@@ -119,11 +119,53 @@ void PolygonMaterial::setColorModifier(Vec<float> colorMod, float alphaMod)
 	static_cast<PolygonParams*>(params.get())->setColorModifier(colorMod, alphaMod);
 }
 
+void PolygonMaterial::setColor(Vec<float> color, float alpha)
+{
+	static_cast<PolygonParams*>(params.get())->setColorOverride(color, alpha);
+}
+
+void PolygonMaterial::clearColor()
+{
+	static_cast<PolygonParams*>(params.get())->clearColorOverride();
+}
+
+DirectX::XMFLOAT4 PolygonMaterial::getColor()
+{
+	return params->ref<DirectX::XMFLOAT4>("colorOverride");
+}
+
 void PolygonMaterial::setLightOn(bool on)
 {
 	static_cast<PolygonParams*>(params.get())->setLightOn(on);
 }
 
+PolygonMaterial::State PolygonMaterial::getState()
+{
+	const DirectX::XMFLOAT4& colorOverride = params->ref<DirectX::XMFLOAT4>("colorOverride");
+
+	State state;
+	state.color = Vec<float>(colorOverride.x, colorOverride.y, colorOverride.z);
+	state.alpha = params->ref<DirectX::XMFLOAT4>("colorModifier").w;
+	state.useColor = (colorOverride.w > 0.0f);
+	state.lightOn = (params->ref<DirectX::XMFLOAT4>("flags").x > 0.0f);
+	state.wireframe = isWireframe();
+
+	return state;
+}
+
+void PolygonMaterial::setState(const State& state)
+{
+	if ( state.useColor )
+		setColor(state.color, state.alpha);
+	else
+		params->ref<DirectX::XMFLOAT4>("colorOverride") = DirectX::XMFLOAT4(state.color.x, state.color.y, state.color.z, 0.0f);
+
+	params->ref<DirectX::XMFLOAT4>("colorModifier").w = state.alpha;
+
+	setLightOn(state.lightOn);
+	setWireframe(state.wireframe);
+}
+
 
 
 TextMaterial::TextMaterial(Renderer* renderer)
@@ -40,6 +40,7 @@ public:
 
 
 	void attachTexture(int slot, std::shared_ptr<Texture> texture);
+	std::shared_ptr<Texture> getTexture(int slot) const {return (slot < textures.size()) ? textures[slot] : std::shared_ptr<Texture>();}
 
 
 	// Return generalized material parameter structure
@@ -51,7 +52,10 @@ public:
 	void setWireframe(bool wireframe);
 	void setCullMode(CullMode cullMode);
 
+	bool isWireframe() const {return wireframe;}
+
 	virtual void setColor(Vec<float> color, float alpha){}
+	virtual void clearColor(){}
 	virtual DirectX::XMFLOAT4 getColor(){return DirectX::XMFLOAT4(0.0f,0.0f,0.0f,0.0f);}
 
 	// Overloaded to potentially pass transform related variables to the pixel shader
@@ -94,11 +98,37 @@ class PolygonMaterial : public Material
 {
 	typedef PolygonParams ParamType;
 public:
+	// Parameter state used to share identical materials
+	struct State
+	{
+		State() : color(1.0f), alpha(1.0f), useColor(false), lightOn(true), wireframe(false) {}
+
+		bool operator==(const State& other) const
+		{
+			return (color == other.color && alpha == other.alpha && useColor == other.useColor
+				&& lightOn == other.lightOn && wireframe == other.wireframe);
+		}
+
+		Vec<float> color;
+		float alpha;
+		bool useColor;
+		bool lightOn;
+		bool wireframe;
+	};
+
 	PolygonMaterial(Renderer* renderer);
 
 	void setColorModifier(Vec<float> colorMod, float alphaMod);
 
+	// Replaces the per-vertex mesh color
+	virtual void setColor(Vec<float> color, float alpha);
+	virtual void clearColor();
+	virtual DirectX::XMFLOAT4 getColor();
+
 	void setLightOn(bool on);
+
+	State getState();
+	void setState(const State& state);
 private:
 	PolygonMaterial(){}
 };
@@ -44,6 +44,7 @@ PolygonParams::PolygonParams(Renderer* rendererIn)
 	: MaterialParameters(rendererIn)
 {
 	addParam<DirectX::XMFLOAT4>("colorModifier", DirectX::XMFLOAT4(1.0f,1.0f,1.0f,1.0f), "Multiplier on vertex color");
+	addParam<DirectX::XMFLOAT4>("colorOverride", DirectX::XMFLOAT4(0.0f,0.0f,0.0f,0.0f), "Replaces vertex color when w is set");
 }
 
 void PolygonParams::setColorModifier(Vec<float> colorMod, float alphaMod)
@@ -51,6 +52,18 @@ void PolygonParams::setColorModifier(Vec<float> colorMod, float alphaMod)
 	ref<DirectX::XMFLOAT4>("colorModifier") = DirectX::XMFLOAT4(colorMod.x,colorMod.y,colorMod.z,alphaMod);
 }
 
+void PolygonParams::setColorOverride(Vec<float> color, float alpha)
+{
+	ref<DirectX::XMFLOAT4>("colorOverride") = DirectX::XMFLOAT4(color.x,color.y,color.z,1.0f);
+	ref<DirectX::XMFLOAT4>("colorModifier").w = alpha;
+}
+
+void PolygonParams::clearColorOverride()
+{
+	ref<DirectX::XMFLOAT4>("colorOverride").w = 0.0f;
+	ref<DirectX::XMFLOAT4>("colorModifier").w = 1.0f;
+}
+
 
 // Material parameters for any volume renderer
 const Vec<float> VolumeParams::defaultColors[6] = 
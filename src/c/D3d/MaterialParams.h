@@ -132,6 +132,9 @@ public:
 	PolygonParams(Renderer* rendererIn);
 
 	void setColorModifier(Vec<float> colorMod, float alphaMod);
+	void setColorOverride(Vec<float> color, float alpha);
+	// Goes back to the vertex colors at full alpha
+	void clearColorOverride();
 private:
 	PolygonParams() : MaterialParameters(NULL){};
 };
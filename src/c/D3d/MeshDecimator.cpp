@@ -0,0 +1,382 @@
+#include "MeshDecimator.h"
+
+#include <algorithm>
+#include <cmath>
+#include <queue>
+#include <unordered_map>
+
+#undef min
+#undef max
+
+namespace
+{
+	// Symmetric 4x4 plane quadric (Garland-Heckbert), only the upper triangle is stored
+	struct Quadric
+	{
+		double a2, ab, ac, ad, b2, bc, bd, c2, cd, d2;
+
+		Quadric() : a2(0), ab(0), ac(0), ad(0), b2(0), bc(0), bd(0), c2(0), cd(0), d2(0) {}
+
+		void addPlane(double a, double b, double c, double d)
+		{
+			a2 += a*a; ab += a*b; ac += a*c; ad += a*d;
+			b2 += b*b; bc += b*c; bd += b*d;
+			c2 += c*c; cd += c*d;
+			d2 += d*d;
+		}
+
+		void add(const Quadric& other)
+		{
+			a2 += other.a2; ab += other.ab; ac += other.ac; ad += other.ad;
+			b2 += other.b2; bc += other.bc; bd += other.bd;
+			c2 += other.c2; cd += other.cd;
+			d2 += other.d2;
+		}
+
+		// Sum of squared distances from the point to every accumulated plane
+		double eval(const Vec<float>& pos) const
+		{
+			double x = pos.x;
+			double y = pos.y;
+			double z = pos.z;
+
+			return a2*x*x + 2.0*ab*x*y + 2.0*ac*x*z + 2.0*ad*x
+				+ b2*y*y + 2.0*bc*y*z + 2.0*bd*y
+				+ c2*z*z + 2.0*cd*z
+				+ d2;
+		}
+	};
+
+	struct Collapse
+	{
+		double cost;
+		uint32_t from;
+		uint32_t to;
+		uint32_t fromStamp;
+		uint32_t toStamp;
+
+		// Reversed so the priority queue pops the cheapest collapse first
+		bool operator<(const Collapse& other) const {return cost > other.cost;}
+	};
+
+	// Faces must keep their orientation within this angle (cosine) after a collapse
+	const double minFlipCos = 0.2;
+
+	inline uint64_t edgeKey(uint32_t a, uint32_t b)
+	{
+		return (a < b) ? ((uint64_t(a) << 32) | b) : ((uint64_t(b) << 32) | a);
+	}
+
+	inline bool faceHas(const Vec<uint32_t>& face, uint32_t vert)
+	{
+		return (face.x == vert || face.y == vert || face.z == vert);
+	}
+
+	inline Vec<double> faceCross(const Vec<float>& p0, const Vec<float>& p1, const Vec<float>& p2)
+	{
+		Vec<double> edge1(p1.x-p0.x, p1.y-p0.y, p1.z-p0.z);
+		Vec<double> edge2(p2.x-p0.x, p2.y-p0.y, p2.z-p0.z);
+
+		return Vec<double>::cross(edge1, edge2);
+	}
+
+	class DecimateState
+	{
+	public:
+		DecimateState(const std::vector<Vec<uint32_t>>& facesIn, const std::vector<Vec<float>>& vertices)
+			: vertices(vertices), numLiveFaces(0), maxCost(0.0)
+		{
+			uint32_t numVerts = (uint32_t)vertices.size();
+
+			faces.reserve(facesIn.size());
+			for ( const Vec<uint32_t>& face : facesIn )
+			{
+				// Drop degenerate and out of range faces, they can't be drawn anyway
+				if ( face.x >= numVerts || face.y >= numVerts || face.z >= numVerts )
+					continue;
+				if ( face.x == face.y || face.y == face.z || face.z == face.x )
+					continue;
+
+				faces.push_back(face);
+			}
+
+			numLiveFaces = faces.size();
+			liveFaces.assign(faces.size(), 1);
+
+			vertFaces.resize(numVerts);
+			quadrics.resize(numVerts);
+			stamps.assign(numVerts, 0);
+			removed.assign(numVerts, 0);
+			locked.assign(numVerts, 0);
+
+			std::unordered_map<uint64_t, int> edgeCounts;
+			edgeCounts.reserve(3 * faces.size());
+
+			for ( uint32_t f = 0; f < faces.size(); ++f )
+			{
+				const Vec<uint32_t>& face = faces[f];
+				for ( int i = 0; i < 3; ++i )
+				{
+					vertFaces[face.e[i]].push_back(f);
+					++edgeCounts[edgeKey(face.e[i], face.e[(i+1)%3])];
+				}
+
+				Vec<double> norm = faceCross(vertices[face.x], vertices[face.y], vertices[face.z]);
+				double len = norm.length();
+				if ( len <= 0.0 )
+					continue;
+
+				norm = norm / len;
+				double d = -(norm.x*vertices[face.x].x + norm.y*vertices[face.x].y + norm.z*vertices[face.x].z);
+
+				for ( int i = 0; i < 3; ++i )
+					quadrics[face.e[i]].addPlane(norm.x, norm.y, norm.z, d);
+			}
+
+			// Open borders and non-manifold edges keep their vertices in place
+			for ( auto& it : edgeCounts )
+			{
+				if ( it.second == 2 )
+					continue;
+
+				locked[uint32_t(it.first >> 32)] = 1;
+				locked[uint32_t(it.first & 0xFFFFFFFF)] = 1;
+			}
+
+			for ( const Vec<uint32_t>& face : faces )
+			{
+				for ( int i = 0; i < 3; ++i )
+				{
+					// Closed edges show up once in each direction, only queue them once
+					if ( face.e[i] < face.e[(i+1)%3] )
+						pushEdge(face.e[i], face.e[(i+1)%3]);
+				}
+			}
+		}
+
+		void run(const MeshDecimator::Target& target, MeshDecimator::Level& levelOut)
+		{
+			double maxTargetCost = double(target.maxError) * double(target.maxError);
+
+			while ( numLiveFaces > target.maxFaces && !queue.empty() )
+			{
+				Collapse collapse = queue.top();
+				if ( isStale(collapse) )
+				{
+					queue.pop();
+					continue;
+				}
+
+				// Leave it queued for a later level with a looser bound
+				if ( collapse.cost > maxTargetCost )
+					break;
+
+				queue.pop();
+
+				if ( !canCollapse(collapse.from, collapse.to) )
+					continue;
+
+				applyCollapse(collapse.from, collapse.to);
+				maxCost = std::max(maxCost, collapse.cost);
+			}
+
+			levelOut.faces.clear();
+			levelOut.faces.reserve(numLiveFaces);
+			for ( size_t f = 0; f < faces.size(); ++f )
+			{
+				if ( liveFaces[f] )
+					levelOut.faces.push_back(faces[f]);
+			}
+
+			levelOut.error = float(std::sqrt(maxCost));
+		}
+
+	private:
+		double collapseCost(uint32_t from, uint32_t to) const
+		{
+			Quadric sum = quadrics[from];
+			sum.add(quadrics[to]);
+
+			return std::max(0.0, sum.eval(vertices[to]));
+		}
+
+		// Queues the cheaper direction of an edge, locked vertices can only be collapsed onto
+		void pushEdge(uint32_t a, uint32_t b)
+		{
+			if ( locked[a] && locked[b] )
+				return;
+
+			Collapse collapse;
+			if ( locked[a] )
+			{
+				collapse.from = b;
+				collapse.to = a;
+				collapse.cost = collapseCost(b, a);
+			}
+			else if ( locked[b] )
+			{
+				collapse.from = a;
+				collapse.to = b;
+				collapse.cost = collapseCost(a, b);
+			}
+			else
+			{
+				double costAB = collapseCost(a, b);
+				double costBA = collapseCost(b, a);
+
+				collapse.from = (costAB <= costBA) ? a : b;
+				collapse.to = (costAB <= costBA) ? b : a;
+				collapse.cost = std::min(costAB, costBA);
+			}
+
+			collapse.fromStamp = stamps[collapse.from];
+			collapse.toStamp = stamps[collapse.to];
+
+			queue.push(collapse);
+		}
+
+		bool isStale(const Collapse& collapse) const
+		{
+			return (removed[collapse.from] || removed[collapse.to]
+				|| stamps[collapse.from] != collapse.fromStamp || stamps[collapse.to] != collapse.toStamp);
+		}
+
+		void gatherNeighbors(uint32_t vert, std::vector<uint32_t>& neighborsOut) const
+		{
+			neighborsOut.clear();
+			for ( uint32_t f : vertFaces[vert] )
+			{
+				if ( !liveFaces[f] )
+					continue;
+
+				for ( int i = 0; i < 3; ++i )
+				{
+					if ( faces[f].e[i] != vert )
+						neighborsOut.push_back(faces[f].e[i]);
+				}
+			}
+
+			std::sort(neighborsOut.begin(), neighborsOut.end());
+			neighborsOut.erase(std::unique(neighborsOut.begin(), neighborsOut.end()), neighborsOut.end());
+		}
+
+		bool canCollapse(uint32_t from, uint32_t to)
+		{
+			gatherNeighbors(from, fromNeighbors);
+			gatherNeighbors(to, toNeighbors);
+
+			if ( !std::binary_search(fromNeighbors.begin(), fromNeighbors.end(), to) )
+				return false;
+
+			// Link condition, the two faces on the edge must be the only ones sharing both vertices
+			size_t numShared = 0;
+			for ( uint32_t vert : fromNeighbors )
+			{
+				if ( std::binary_search(toNeighbors.begin(), toNeighbors.end(), vert) )
+					++numShared;
+			}
+
+			if ( numShared != 2 )
+				return false;
+
+			const Vec<float>& toPos = vertices[to];
+			for ( uint32_t f : vertFaces[from] )
+			{
+				if ( !liveFaces[f] || faceHas(faces[f], to) )
+					continue;
+
+				Vec<float> pos[3];
+				Vec<float> movedPos[3];
+				for ( int i = 0; i < 3; ++i )
+				{
+					pos[i] = vertices[faces[f].e[i]];
+					movedPos[i] = (faces[f].e[i] == from) ? toPos : pos[i];
+				}
+
+				Vec<double> oldNorm = faceCross(pos[0], pos[1], pos[2]);
+				Vec<double> newNorm = faceCross(movedPos[0], movedPos[1], movedPos[2]);
+
+				double newLenSqr = newNorm.lengthSqr();
+				if ( newLenSqr <= 0.0 )
+					return false;
+
+				if ( Vec<double>::dot(oldNorm, newNorm) <= minFlipCos * std::sqrt(oldNorm.lengthSqr() * newLenSqr) )
+					return false;
+			}
+
+			return true;
+		}
+
+		void applyCollapse(uint32_t from, uint32_t to)
+		{
+			for ( uint32_t f : vertFaces[from] )
+			{
+				if ( !liveFaces[f] )
+					continue;
+
+				if ( faceHas(faces[f], to) )
+				{
+					liveFaces[f] = 0;
+					--numLiveFaces;
+					continue;
+				}
+
+				for ( int i = 0; i < 3; ++i )
+				{
+					if ( faces[f].e[i] == from )
+						faces[f].e[i] = to;
+				}
+
+				vertFaces[to].push_back(f);
+			}
+
+			vertFaces[from].clear();
+			removed[from] = 1;
+
+			quadrics[to].add(quadrics[from]);
+			++stamps[to];
+
+			std::vector<uint32_t>& toFaces = vertFaces[to];
+			toFaces.erase(std::remove_if(toFaces.begin(), toFaces.end(), [this](uint32_t f){return !liveFaces[f];}), toFaces.end());
+
+			// Every edge around the merged vertex now uses its new quadric
+			gatherNeighbors(to, toNeighbors);
+			for ( uint32_t vert : toNeighbors )
+				pushEdge(to, vert);
+		}
+
+		const std::vector<Vec<float>>& vertices;
+
+		std::vector<Vec<uint32_t>> faces;
+		std::vector<unsigned char> liveFaces;
+		size_t numLiveFaces;
+
+		std::vector<std::vector<uint32_t>> vertFaces;
+		std::vector<Quadric> quadrics;
+		std::vector<uint32_t> stamps;
+		std::vector<unsigned char> removed;
+		std::vector<unsigned char> locked;
+
+		std::priority_queue<Collapse> queue;
+		double maxCost;
+
+		// Scratch space for collapse checks
+		std::vector<uint32_t> fromNeighbors;
+		std::vector<uint32_t> toNeighbors;
+	};
+}
+
+
+void MeshDecimator::decimate(const std::vector<Vec<uint32_t>>& faces, const std::vector<Vec<float>>& vertices,
+	const std::vector<Target>& targets, std::vector<Level>& levelsOut)
+{
+	levelsOut.clear();
+	levelsOut.resize(targets.size());
+
+	if ( targets.empty() )
+		return;
+
+	DecimateState state(faces, vertices);
+	for ( size_t i = 0; i < targets.size(); ++i )
+		state.run(targets[i], levelsOut[i]);
+}
@@ -0,0 +1,35 @@
+#pragma once
+#include "Global/Vec.h"
+
+#include <cstdint>
+#include <vector>
+
+// Quadric error decimation of closed triangle meshes.
+// Edges are collapsed onto one of their end vertices (half-edge collapse), so every decimated
+// face list still indexes the original vertex array and can share its vertex buffer.
+// Boundary and non-manifold vertices are never moved, collapses that fold faces over are rejected.
+class MeshDecimator
+{
+public:
+	// Decimation stops at maxFaces or when the next collapse's error (see Level::error) would be more than maxError
+	struct Target
+	{
+		size_t maxFaces;
+		float maxError;
+	};
+
+	struct Level
+	{
+		std::vector<Vec<uint32_t>> faces;
+
+		// Largest collapse error accepted to reach this level, in mesh units. A collapse's error is the square root
+		// of the summed squared distances from the kept vertex to the original face planes merged into it, so it bounds
+		// the distance to each of those planes from above. It isn't the distance between the two surfaces.
+		float error;
+	};
+
+	// Produces one level per target, targets must have decreasing face counts and increasing errors.
+	// Later levels continue collapsing from the previous level so the whole chain is built in one pass.
+	static void decimate(const std::vector<Vec<uint32_t>>& faces, const std::vector<Vec<float>>& vertices,
+		const std::vector<Target>& targets, std::vector<Level>& levelsOut);
+};
@@ -0,0 +1,297 @@
+#include "MeshOptimizer.h"
+
+#include "Global/Arena.h"
+
+#include <cmath>
+
+#undef min
+#undef max
+
+namespace
+{
+	const uint32_t invalidIndex = 0xFFFFFFFF;
+
+	// Scoring constants from Forsyth, "Linear-Speed Vertex Cache Optimisation"
+	const float cacheDecayPower = 1.5f;
+	const float lastTriScore = 0.75f;
+	const float valenceBoostScale = 2.0f;
+	const float valenceBoostPower = 0.5f;
+
+	// Valences past this use the last table entry, the boost is tiny by then anyway
+	const int maxValenceScore = 32;
+
+	class ScoreTables
+	{
+	public:
+		ScoreTables()
+		{
+			for ( int i = 0; i < MeshOptimizer::lruCacheSize; ++i )
+			{
+				// The last triangle's vertices get a fixed score so the next triangle doesn't just reuse the same edge
+				if ( i < 3 )
+					cache[i] = lastTriScore;
+				else
+					cache[i] = std::pow(1.0f - float(i - 3) / float(MeshOptimizer::lruCacheSize - 3), cacheDecayPower);
+			}
+
+			valence[0] = 0.0f;
+			for ( int i = 1; i < maxValenceScore; ++i )
+				valence[i] = valenceBoostScale * std::pow(float(i), -valenceBoostPower);
+		}
+
+		float vertexScore(int cachePos, uint32_t numLive) const
+		{
+			// Vertices without triangles left can't help anything
+			if ( numLive == 0 )
+				return -1.0f;
+
+			float score = (cachePos >= 0) ? cache[cachePos] : 0.0f;
+			return score + valence[(numLive < maxValenceScore) ? numLive : (maxValenceScore - 1)];
+		}
+
+	private:
+		float cache[MeshOptimizer::lruCacheSize];
+		float valence[maxValenceScore];
+	};
+
+	const ScoreTables scoreTables;
+}
+
+
+MeshOptimizer::Result MeshOptimizer::optimize(const MeshArrays& mesh)
+{
+	Result result;
+	result.faces = mesh.numFaces;
+	result.missesBefore = countCacheMisses(mesh.faces, mesh.numFaces, mesh.numVerts);
+
+	optimizeVertexCache(mesh.faces, mesh.numFaces, mesh.numVerts);
+	optimizeVertexFetch(mesh);
+
+	result.missesAfter = countCacheMisses(mesh.faces, mesh.numFaces, mesh.numVerts);
+
+	return result;
+}
+
+void MeshOptimizer::optimizeVertexCache(Vec<uint32_t>* faces, size_t numFaces, size_t numVerts)
+{
+	if ( numFaces == 0 )
+		return;
+
+	Arena& scratch = Arena::threadScratch();
+	Arena::Scope scratchScope(scratch);
+
+	// Live triangles of each vertex (compressed rows), emitted ones are swapped past numLive
+	uint32_t* numLive = scratch.allocArray<uint32_t>(numVerts);
+	uint32_t* vertFaceStart = scratch.allocArray<uint32_t>(numVerts + 1);
+	for ( size_t v = 0; v <= numVerts; ++v )
+		vertFaceStart[v] = 0;
+
+	for ( size_t f = 0; f < numFaces; ++f )
+	{
+		for ( int i = 0; i < 3; ++i )
+			++vertFaceStart[faces[f].e[i] + 1];
+	}
+
+	for ( size_t v = 0; v < numVerts; ++v )
+	{
+		numLive[v] = vertFaceStart[v+1];
+		vertFaceStart[v+1] += vertFaceStart[v];
+	}
+
+	uint32_t* vertFaces = scratch.allocArray<uint32_t>(vertFaceStart[numVerts]);
+	for ( size_t v = 0; v < numVerts; ++v )
+		numLive[v] = 0;
+
+	for ( size_t f = 0; f < numFaces; ++f )
+	{
+		for ( int i = 0; i < 3; ++i )
+		{
+			uint32_t v = faces[f].e[i];
+			vertFaces[vertFaceStart[v] + numLive[v]++] = uint32_t(f);
+		}
+	}
+
+	int* cachePos = scratch.allocArray<int>(numVerts);
+	float* vertScore = scratch.allocArray<float>(numVerts);
+	for ( size_t v = 0; v < numVerts; ++v )
+	{
+		cachePos[v] = -1;
+		vertScore[v] = scoreTables.vertexScore(-1, numLive[v]);
+	}
+
+	float* triScore = scratch.allocArray<float>(numFaces);
+	unsigned char* emitted = scratch.allocArray<unsigned char>(numFaces);
+	uint32_t bestFace = 0;
+	for ( size_t f = 0; f < numFaces; ++f )
+	{
+		triScore[f] = vertScore[faces[f].x] + vertScore[faces[f].y] + vertScore[faces[f].z];
+		emitted[f] = 0;
+
+		if ( triScore[f] > triScore[bestFace] )
+			bestFace = uint32_t(f);
+	}
+
+	// The new triangle's vertices are pushed on the front, so the cache can briefly hold three extra entries
+	uint32_t cache[lruCacheSize + 3];
+	uint32_t newCache[lruCacheSize + 3];
+	int cacheUsed = 0;
+
+	Vec<uint32_t>* ordered = scratch.allocArray<Vec<uint32_t>>(numFaces);
+	size_t numOrdered = 0;
+	// Fallback when nothing in the cache has triangles left, scanning forward keeps the whole pass linear
+	size_t nextUnemitted = 0;
+
+	while ( numOrdered < numFaces )
+	{
+		if ( bestFace == invalidIndex )
+		{
+			while ( emitted[nextUnemitted] )
+				++nextUnemitted;
+
+			bestFace = uint32_t(nextUnemitted);
+		}
+
+		const Vec<uint32_t> face = faces[bestFace];
+		ordered[numOrdered++] = face;
+		emitted[bestFace] = 1;
+
+		for ( int i = 0; i < 3; ++i )
+		{
+			uint32_t v = face.e[i];
+			uint32_t* liveFaces = vertFaces + vertFaceStart[v];
+			for ( uint32_t j = 0; j < numLive[v]; ++j )
+			{
+				if ( liveFaces[j] == bestFace )
+				{
+					liveFaces[j] = liveFaces[--numLive[v]];
+					break;
+				}
+			}
+		}
+
+		int newUsed = 0;
+		for ( int i = 0; i < 3; ++i )
+			newCache[newUsed++] = face.e[i];
+
+		for ( int i = 0; i < cacheUsed; ++i )
+		{
+			uint32_t v = cache[i];
+			if ( v != face.x && v != face.y && v != face.z )
+				newCache[newUsed++] = v;
+		}
+
+		// Entries past the cache size were just evicted, they are rescored but can't supply the next triangle
+		for ( int i = 0; i < newUsed; ++i )
+		{
+			uint32_t v = newCache[i];
+			cachePos[v] = (i < lruCacheSize) ? i : -1;
+			vertScore[v] = scoreTables.vertexScore(cachePos[v], numLive[v]);
+		}
+
+		bestFace = invalidIndex;
+		float bestScore = -1.0f;
+		for ( int i = 0; i < newUsed; ++i )
+		{
+			uint32_t v = newCache[i];
+			const uint32_t* liveFaces = vertFaces + vertFaceStart[v];
+			for ( uint32_t j = 0; j < numLive[v]; ++j )
+			{
+				uint32_t f = liveFaces[j];
+				triScore[f] = vertScore[faces[f].x] + vertScore[faces[f].y] + vertScore[faces[f].z];
+
+				if ( i < lruCacheSize && triScore[f] > bestScore )
+				{
+					bestScore = triScore[f];
+					bestFace = f;
+				}
+			}
+		}
+
+		cacheUsed = (newUsed < lruCacheSize) ? newUsed : lruCacheSize;
+		for ( int i = 0; i < cacheUsed; ++i )
+			cache[i] = newCache[i];
+	}
+
+	for ( size_t f = 0; f < numFaces; ++f )
+		faces[f] = ordered[f];
+}
+
+void MeshOptimizer::optimizeVertexFetch(const MeshArrays& mesh)
+{
+	size_t numVerts = mesh.numVerts;
+
+	Arena& scratch = Arena::threadScratch();
+	Arena::Scope scratchScope(scratch);
+
+	uint32_t* remap = scratch.allocArray<uint32_t>(numVerts);
+	for ( size_t v = 0; v < numVerts; ++v )
+		remap[v] = invalidIndex;
+
+	uint32_t nextIndex = 0;
+	for ( size_t f = 0; f < mesh.numFaces; ++f )
+	{
+		for ( int i = 0; i < 3; ++i )
+		{
+			uint32_t& newIndex = remap[mesh.faces[f].e[i]];
+			if ( newIndex == invalidIndex )
+				newIndex = nextIndex++;
+
+			mesh.faces[f].e[i] = newIndex;
+		}
+	}
+
+	for ( size_t v = 0; v < numVerts; ++v )
+	{
+		if ( remap[v] == invalidIndex )
+			remap[v] = nextIndex++;
+	}
+
+	// Reordered through scratch and copied back, so the arrays stay where the caller allocated them
+	Vec<float>* reordered = scratch.allocArray<Vec<float>>(numVerts);
+	for ( size_t v = 0; v < numVerts; ++v )
+		reordered[remap[v]] = mesh.vertices[v];
+
+	for ( size_t v = 0; v < numVerts; ++v )
+		mesh.vertices[v] = reordered[v];
+
+	if ( !mesh.normals )
+		return;
+
+	for ( size_t v = 0; v < numVerts; ++v )
+		reordered[remap[v]] = mesh.normals[v];
+
+	for ( size_t v = 0; v < numVerts; ++v )
+		mesh.normals[v] = reordered[v];
+}
+
+size_t MeshOptimizer::countCacheMisses(const Vec<uint32_t>* faces, size_t numFaces, size_t numVerts, int cacheSize)
+{
+	Arena& scratch = Arena::threadScratch();
+	Arena::Scope scratchScope(scratch);
+
+	// Insertion time of each vertex (0 is never), it is still cached until cacheSize newer vertices went in
+	size_t* inserted = scratch.allocArray<size_t>(numVerts);
+	for ( size_t v = 0; v < numVerts; ++v )
+		inserted[v] = 0;
+
+	size_t misses = 0;
+	for ( size_t f = 0; f < numFaces; ++f )
+	{
+		for ( int i = 0; i < 3; ++i )
+		{
+			uint32_t v = faces[f].e[i];
+			if ( inserted[v] == 0 || misses - inserted[v] >= size_t(cacheSize) )
+				inserted[v] = ++misses;
+		}
+	}
+
+	return misses;
+}
+
+double MeshOptimizer::computeAcmr(const std::vector<Vec<uint32_t>>& faces, size_t numVerts, int cacheSize)
+{
+	if ( faces.empty() )
+		return 0.0;
+
+	return double(countCacheMisses(faces, numVerts, cacheSize)) / double(faces.size());
+}
@@ -0,0 +1,75 @@
+#pragma once
+#include "Global/Vec.h"
+
+#include <cstdint>
+#include <vector>
+
+// Reorders triangle meshes for the GPU without changing what is drawn.
+// Faces are sorted for post-transform vertex cache reuse with Forsyth's linear-speed scoring,
+// then vertices are renumbered in order of first use so vertex fetches walk the buffer forward.
+class MeshOptimizer
+{
+public:
+	// Cache size the face order is tuned for (LRU, as in Forsyth's paper)
+	static const int lruCacheSize = 32;
+	// Cache size used to measure ACMR, a FIFO like the post-transform caches on most hardware
+	static const int fifoCacheSize = 16;
+
+	// One mesh, the arrays are reordered in place. normals is NULL or has numVerts entries.
+	struct MeshArrays
+	{
+		Vec<uint32_t>* faces;
+		size_t numFaces;
+		Vec<float>* vertices;
+		Vec<float>* normals;
+		size_t numVerts;
+	};
+
+	struct Result
+	{
+		size_t faces;
+		// Vertex shader invocations before and after, divide by faces for the ACMR
+		size_t missesBefore;
+		size_t missesAfter;
+	};
+
+	// Reorders the faces and then the vertices (normals follow them), every face keeps its winding
+	static Result optimize(const MeshArrays& mesh);
+	static Result optimize(std::vector<Vec<uint32_t>>& faces, std::vector<Vec<float>>& vertices, std::vector<Vec<float>>& normals)
+	{
+		return optimize(makeArrays(faces, vertices, normals));
+	}
+
+	static void optimizeVertexCache(Vec<uint32_t>* faces, size_t numFaces, size_t numVerts);
+	static void optimizeVertexCache(std::vector<Vec<uint32_t>>& faces, size_t numVerts) {optimizeVertexCache(faces.data(), faces.size(), numVerts);}
+
+	// Vertices no face uses are kept after the used ones, in their original order
+	static void optimizeVertexFetch(const MeshArrays& mesh);
+	static void optimizeVertexFetch(std::vector<Vec<uint32_t>>& faces, std::vector<Vec<float>>& vertices, std::vector<Vec<float>>& normals)
+	{
+		optimizeVertexFetch(makeArrays(faces, vertices, normals));
+	}
+
+	// Vertex shader invocations to draw the faces through a FIFO cache of cacheSize
+	static size_t countCacheMisses(const Vec<uint32_t>* faces, size_t numFaces, size_t numVerts, int cacheSize = fifoCacheSize);
+	static size_t countCacheMisses(const std::vector<Vec<uint32_t>>& faces, size_t numVerts, int cacheSize = fifoCacheSize)
+	{
+		return countCacheMisses(faces.data(), faces.size(), numVerts, cacheSize);
+	}
+
+	// Transformed vertices per triangle (average cache miss ratio), about 0.5 is ideal for large meshes and 3 means no reuse
+	static double computeAcmr(const std::vector<Vec<uint32_t>>& faces, size_t numVerts, int cacheSize = fifoCacheSize);
+
+private:
+	static MeshArrays makeArrays(std::vector<Vec<uint32_t>>& faces, std::vector<Vec<float>>& vertices, std::vector<Vec<float>>& normals)
+	{
+		MeshArrays mesh;
+		mesh.faces = faces.data();
+		mesh.numFaces = faces.size();
+		mesh.vertices = vertices.data();
+		mesh.normals = (normals.size() == vertices.size()) ? normals.data() : NULL;
+		mesh.numVerts = vertices.size();
+
+		return mesh;
+	}
+};
@@ -0,0 +1,235 @@
+#include "MeshPrep.h"
+
+#include "Global/Arena.h"
+#include "Global/ParallelFor.h"
+
+#include <cmath>
+#include <cstring>
+#include <unordered_map>
+#include <xmmintrin.h>
+
+namespace
+{
+	const uint32_t invalidVert = 0xFFFFFFFF;
+
+	// Faces per thread for the normal passes
+	const size_t normalChunk = 16384;
+
+	inline uint64_t cellKey(int64_t x, int64_t y, int64_t z)
+	{
+		// 21 bits per axis, cells far outside any image wrap but are still checked by distance
+		return (uint64_t(x) & 0x1FFFFF) | ((uint64_t(y) & 0x1FFFFF) << 21) | ((uint64_t(z) & 0x1FFFFF) << 42);
+	}
+
+	inline uint64_t exactKey(const Vec<float>& pos)
+	{
+		uint32_t bits[3];
+		memcpy(bits, pos.e, sizeof(bits));
+
+		return (uint64_t(bits[0]) * 0x9E3779B97F4A7C15ULL) ^ (uint64_t(bits[1]) * 0xC2B2AE3D27D4EB4FULL) ^ bits[2];
+	}
+
+	typedef std::unordered_map<uint64_t, uint32_t, std::hash<uint64_t>, std::equal_to<uint64_t>,
+		ArenaAllocator<std::pair<const uint64_t, uint32_t>>> CellMap;
+}
+
+
+size_t MeshPrep::weldVertices(Vec<uint32_t>* faces, size_t& numFaces, Vec<float>* vertices, size_t& numVerts, float weldDistance)
+{
+	Arena& scratch = Arena::threadScratch();
+	Arena::Scope scratchScope(scratch);
+
+	ArenaVector<uint32_t> remap(numVerts, invalidVert, scratch);
+	// Kept vertices are written over the front of the array, never past the one being read
+	size_t numWelded = 0;
+
+	// Each cell holds a chain of the kept vertices that fall in it
+	CellMap cellHeads(0, CellMap::hasher(), CellMap::key_equal(), scratch);
+	cellHeads.reserve(numVerts);
+	ArenaVector<uint32_t> nextInCell(scratch);
+	nextInCell.reserve(numVerts);
+
+	float distSqr = weldDistance * weldDistance;
+	float invCell = (weldDistance > 0.0f) ? (0.5f / weldDistance) : 0.0f;
+
+	for ( size_t i = 0; i < numVerts; ++i )
+	{
+		const Vec<float> pos = vertices[i];
+
+		uint32_t match = invalidVert;
+		uint64_t key;
+		if ( weldDistance > 0.0f )
+		{
+			int64_t cell[3];
+			int64_t side[3];
+			for ( int d = 0; d < 3; ++d )
+			{
+				float scaled = pos.e[d] * invCell;
+				cell[d] = int64_t(std::floor(scaled));
+				side[d] = (scaled - float(cell[d]) < 0.5f) ? -1 : 1;
+			}
+
+			key = cellKey(cell[0], cell[1], cell[2]);
+
+			// Anything within half a cell sits in this cell or the neighbors on the near side of each axis
+			for ( int n = 0; n < 8 && match == invalidVert; ++n )
+			{
+				auto it = cellHeads.find(cellKey(cell[0] + (n&1)*side[0], cell[1] + ((n>>1)&1)*side[1], cell[2] + ((n>>2)&1)*side[2]));
+				if ( it == cellHeads.end() )
+					continue;
+
+				for ( uint32_t v = it->second; v != invalidVert; v = nextInCell[v] )
+				{
+					if ( (vertices[v] - pos).lengthSqr() <= distSqr )
+					{
+						match = v;
+						break;
+					}
+				}
+			}
+		}
+		else
+		{
+			key = exactKey(pos);
+
+			auto it = cellHeads.find(key);
+			if ( it != cellHeads.end() )
+			{
+				for ( uint32_t v = it->second; v != invalidVert; v = nextInCell[v] )
+				{
+					if ( vertices[v] == pos )
+					{
+						match = v;
+						break;
+					}
+				}
+			}
+		}
+
+		if ( match == invalidVert )
+		{
+			match = uint32_t(numWelded++);
+			vertices[match] = pos;
+
+			auto inserted = cellHeads.emplace(key, match);
+			nextInCell.push_back((inserted.second) ? invalidVert : inserted.first->second);
+			inserted.first->second = match;
+		}
+
+		remap[i] = match;
+	}
+
+	size_t numKept = 0;
+	for ( size_t f = 0; f < numFaces; ++f )
+	{
+		const Vec<uint32_t> face = faces[f];
+		Vec<uint32_t> newFace(remap[face.x], remap[face.y], remap[face.z]);
+		if ( newFace.x == newFace.y || newFace.y == newFace.z || newFace.z == newFace.x )
+			continue;
+
+		faces[numKept++] = newFace;
+	}
+
+	numFaces = numKept;
+
+	size_t numRemoved = numVerts - numWelded;
+	numVerts = numWelded;
+
+	return numRemoved;
+}
+
+void MeshPrep::computeNormals(const Vec<uint32_t>* faces, size_t numFaces, const Vec<float>* vertices, size_t numVerts,
+	Vec<float>* normalsOut)
+{
+	Arena& scratch = Arena::threadScratch();
+	Arena::Scope scratchScope(scratch);
+
+	// Face normals as structure of arrays, the length of each is twice the face area
+	float* faceX = scratch.allocArray<float>(numFaces);
+	float* faceY = scratch.allocArray<float>(numFaces);
+	float* faceZ = scratch.allocArray<float>(numFaces);
+
+	parallelFor(numFaces, normalChunk, [&](size_t begin, size_t end)
+	{
+		size_t f = begin;
+		for ( ; f + 4 <= end; f += 4 )
+		{
+			const Vec<float>* p0[4];
+			const Vec<float>* p1[4];
+			const Vec<float>* p2[4];
+			for ( int i = 0; i < 4; ++i )
+			{
+				p0[i] = &vertices[faces[f+i].x];
+				p1[i] = &vertices[faces[f+i].y];
+				p2[i] = &vertices[faces[f+i].z];
+			}
+
+			__m128 x0 = _mm_setr_ps(p0[0]->x, p0[1]->x, p0[2]->x, p0[3]->x);
+			__m128 y0 = _mm_setr_ps(p0[0]->y, p0[1]->y, p0[2]->y, p0[3]->y);
+			__m128 z0 = _mm_setr_ps(p0[0]->z, p0[1]->z, p0[2]->z, p0[3]->z);
+
+			__m128 ax = _mm_sub_ps(_mm_setr_ps(p1[0]->x, p1[1]->x, p1[2]->x, p1[3]->x), x0);
+			__m128 ay = _mm_sub_ps(_mm_setr_ps(p1[0]->y, p1[1]->y, p1[2]->y, p1[3]->y), y0);
+			__m128 az = _mm_sub_ps(_mm_setr_ps(p1[0]->z, p1[1]->z, p1[2]->z, p1[3]->z), z0);
+
+			__m128 bx = _mm_sub_ps(_mm_setr_ps(p2[0]->x, p2[1]->x, p2[2]->x, p2[3]->x), x0);
+			__m128 by = _mm_sub_ps(_mm_setr_ps(p2[0]->y, p2[1]->y, p2[2]->y, p2[3]->y), y0);
+			__m128 bz = _mm_sub_ps(_mm_setr_ps(p2[0]->z, p2[1]->z, p2[2]->z, p2[3]->z), z0);
+
+			// b x a flips the winding to match CalcNorms
+			_mm_storeu_ps(&faceX[f], _mm_sub_ps(_mm_mul_ps(by, az), _mm_mul_ps(bz, ay)));
+			_mm_storeu_ps(&faceY[f], _mm_sub_ps(_mm_mul_ps(bz, ax), _mm_mul_ps(bx, az)));
+			_mm_storeu_ps(&faceZ[f], _mm_sub_ps(_mm_mul_ps(bx, ay), _mm_mul_ps(by, ax)));
+		}
+
+		for ( ; f < end; ++f )
+		{
+			const Vec<float>& v0 = vertices[faces[f].x];
+			Vec<float> normal = Vec<float>::cross(vertices[faces[f].z] - v0, vertices[faces[f].y] - v0);
+
+			faceX[f] = normal.x;
+			faceY[f] = normal.y;
+			faceZ[f] = normal.z;
+		}
+	});
+
+	// Vertex to face lists (compressed rows) so each vertex can be summed without locking
+	ArenaVector<uint32_t> vertFaceStart(numVerts + 1, 0, scratch);
+	for ( size_t f = 0; f < numFaces; ++f )
+	{
+		for ( int i = 0; i < 3; ++i )
+			++vertFaceStart[faces[f].e[i] + 1];
+	}
+
+	for ( size_t v = 0; v < numVerts; ++v )
+		vertFaceStart[v+1] += vertFaceStart[v];
+
+	uint32_t* vertFaces = scratch.allocArray<uint32_t>(vertFaceStart[numVerts]);
+	ArenaVector<uint32_t> fill(vertFaceStart.begin(), vertFaceStart.end() - 1, scratch);
+	for ( size_t f = 0; f < numFaces; ++f )
+	{
+		for ( int i = 0; i < 3; ++i )
+			vertFaces[fill[faces[f].e[i]]++] = uint32_t(f);
+	}
+
+	parallelFor(numVerts, normalChunk, [&](size_t begin, size_t end)
+	{
+		for ( size_t v = begin; v < end; ++v )
+		{
+			__m128 sum = _mm_setzero_ps();
+			for ( uint32_t i = vertFaceStart[v]; i < vertFaceStart[v+1]; ++i )
+			{
+				uint32_t f = vertFaces[i];
+				sum = _mm_add_ps(sum, _mm_setr_ps(faceX[f], faceY[f], faceZ[f], 0.0f));
+			}
+
+			float n[4];
+			_mm_storeu_ps(n, sum);
+
+			Vec<float> normal(n[0], n[1], n[2]);
+			float length = std::sqrt(Vec<float>::dot(normal, normal));
+
+			normalsOut[v] = (length > 0.0f) ? (normal / length) : Vec<float>(0.0f, 0.0f, 0.0f);
+		}
+	});
+}
@@ -0,0 +1,23 @@
+#pragma once
+#include "Global/Vec.h"
+
+#include <cstddef>
+#include <cstdint>
+
+// Native cleanup for triangle meshes that arrive without normals.
+// Welding removes the duplicated vertices isosurface style extractors emit, so the normals computed
+// afterwards are smooth across what were separate copies of the same point.
+class MeshPrep
+{
+public:
+	// Merges vertices within weldDistance of an earlier vertex (only identical positions when it is 0) using a spatial hash.
+	// Works in place: the kept vertices and faces move to the front and numFaces and numVerts are updated,
+	// faces that collapse are dropped. Returns the number of vertices removed.
+	static size_t weldVertices(Vec<uint32_t>* faces, size_t& numFaces, Vec<float>* vertices, size_t& numVerts, float weldDistance);
+
+	// Area weighted vertex normals, oriented like D3d.Polygon.CalcNorms (opposite the right-hand face winding).
+	// Face normals are computed four at a time with SSE, then each vertex sums its faces, both in parallel.
+	// normalsOut has room for numVerts normals.
+	static void computeNormals(const Vec<uint32_t>* faces, size_t numFaces, const Vec<float>* vertices, size_t numVerts,
+		Vec<float>* normalsOut);
+};
@@ -18,6 +18,10 @@
 #include "Global/ErrorMsg.h"
 
 #include <limits>
+#include <utility>
+
+#undef min
+#undef max
 
 
 const Vec<uint32_t> MeshPrimitive::unitQuadIdx[2] =
@@ -39,7 +43,8 @@ const Vec<float> MeshPrimitive::unitQuadNorms[4] =
 
 
 MeshPrimitive::MeshPrimitive(Renderer* rendererIn, VertexLayout::Types layoutType, const std::string& shaderFile, const std::string& shaderFunc)
-	: renderer(rendererIn), layout(layoutType), vertShaderIdx(-1), vertexBuffer(NULL), indexBuffer(NULL)
+	: renderer(rendererIn), layout(layoutType), lodVersion(0), vertShaderIdx(-1), vertexBuffer(NULL), indexBuffer(NULL),
+	indexFormat(DXGI_FORMAT_R32_UINT)
 {
 	loadShader(shaderFile,shaderFunc);
 }
@@ -66,6 +71,17 @@ void MeshPrimitive::setupMesh(const std::vector<Vec<uint32_t>>& facesIn, const s
 	updateCenterOfMass();
 }
 
+void MeshPrimitive::setupMesh(std::vector<Vec<uint32_t>>&& facesIn, std::vector<Vec<float>>&& verticesIn, std::vector<Vec<float>>&& normalsIn)
+{
+	faces = std::move(facesIn);
+	vertices = std::move(verticesIn);
+	normals = std::move(normalsIn);
+	texUVs.clear();
+	colors.clear();
+
+	updateCenterOfMass();
+}
+
 void MeshPrimitive::cleanupMesh()
 {
 	numFaces = 0;
@@ -89,25 +105,40 @@ void MeshPrimitive::initializeResources(UINT vertAccessFlags, UINT indexAccessFl
 	D3D11_USAGE vertUsage = (( vertAccessFlags != 0 ) ? D3D11_USAGE_DYNAMIC : D3D11_USAGE_IMMUTABLE);
 	D3D11_USAGE indexUsage = (( indexAccessFlags != 0 ) ? D3D11_USAGE_DYNAMIC : D3D11_USAGE_IMMUTABLE);
 
-	void* initData = layout.allocLayout(numVerts);
+	// Packed positions are stored relative to the mesh bounds
+	if ( layout.isPacked() )
+		layout.setPositionBounds(boundsMin, boundsMax);
+
+	// Staging memory is reused by the next upload, the buffer copies it on creation
+	void* initData = layout.stagingLayout(numVerts);
+
+	const float* attrData[VertexLayout::Attributes::ATTR_END] = {NULL};
+	attrData[VertexLayout::Attributes::Position] = (float*)(vertices.data());
 
-	layout.sliceIntoLayout(initData, VertexLayout::Attributes::Position, numVerts, (float*)(vertices.data()));
+	if ( normals.size() >= numVerts )
+		attrData[VertexLayout::Attributes::Normal] = (float*)(normals.data());
 
-	if ( layout.validAttribute(VertexLayout::Attributes::Normal) && normals.size() > 0 )
-		layout.sliceIntoLayout(initData, VertexLayout::Attributes::Normal, numVerts, (float*)(normals.data()));
+	if ( texUVs.size() >= numVerts )
+		attrData[VertexLayout::Attributes::TextureUV] = (float*)(texUVs.data());
 
-	if ( layout.validAttribute(VertexLayout::Attributes::TextureUV) && texUVs.size() > 0 )
-		layout.sliceIntoLayout(initData, VertexLayout::Attributes::TextureUV, numVerts, (float*)(texUVs.data()));
+	if ( colors.size() >= numVerts )
+		attrData[VertexLayout::Attributes::Color] = (float*)(colors.data());
 
-	if ( layout.validAttribute(VertexLayout::Attributes::Color) && colors.size() > 0 )
-		layout.sliceIntoLayout(initData, VertexLayout::Attributes::Color, numVerts, (float*)(colors.data()));
+	if ( backColors.size() >= numVerts )
+		attrData[VertexLayout::Attributes::ColorBack] = (float*)(backColors.data());
+
+	layout.interleave(initData, numVerts, attrData);
 
 	size_t bufferSize = numVerts * layout.getVertSize();
 	HRESULT hr = renderer->createVertexBuffer(vertAccessFlags, vertUsage, bufferSize, initData, &vertexBuffer);
 	if (FAILED(hr))
 		sendHrErrMessage(hr);
 
-	hr = renderer->createIndexBuffer(indexAccessFlags, indexUsage, faces, &indexBuffer);
+	// Only static index buffers can drop to 16-bit, dynamic ones are rewritten as 32-bit faces
+	DXGI_FORMAT* formatOut = (indexAccessFlags == 0) ? &indexFormat : NULL;
+	indexFormat = DXGI_FORMAT_R32_UINT;
+
+	hr = renderer->createIndexBuffer(indexAccessFlags, indexUsage, faces, &indexBuffer, formatOut);
 	if (FAILED(hr))
 		sendHrErrMessage(hr);
 }
@@ -115,13 +146,56 @@ void MeshPrimitive::initializeResources(UINT vertAccessFlags, UINT indexAccessFl
 void MeshPrimitive::updateCenterOfMass()
 {
 	centerOfMass = Vec<float>(0.0f, 0.0f, 0.0f);
+	boundsMin = Vec<float>(0.0f, 0.0f, 0.0f);
+	boundsMax = Vec<float>(0.0f, 0.0f, 0.0f);
 
+	if ( vertices.empty() )
+		return;
+
+	// Local bounds are kept with the center for screen-space selection
+	boundsMin = vertices[0];
+	boundsMax = vertices[0];
 	for ( int i=0; i < vertices.size(); ++i )
+	{
 		centerOfMass += vertices[i];
+		boundsMin = Vec<float>::min(boundsMin, vertices[i]);
+		boundsMax = Vec<float>::max(boundsMax, vertices[i]);
+	}
 
 	centerOfMass = centerOfMass / vertices.size();
 }
 
+size_t MeshPrimitive::getMemorySize() const
+{
+	size_t lodBytes = 0;
+	for ( const MeshDecimator::Level& level : lodLevels )
+		lodBytes += level.faces.size()*sizeof(Vec<uint32_t>);
+
+	return faces.size()*sizeof(Vec<uint32_t>) + vertices.size()*sizeof(Vec<float>) + normals.size()*sizeof(Vec<float>)
+		+ texUVs.size()*sizeof(Vec<float>) + colors.size()*sizeof(Color) + backColors.size()*sizeof(Color) + lodBytes;
+}
+
+void MeshPrimitive::getBufferBytes(size_t& vertexBytesOut, size_t& indexBytesOut, size_t& unpackedBytesOut) const
+{
+	VertexLayout bufferLayout = layout;
+
+	size_t indexSize = (indexFormat == DXGI_FORMAT_R16_UINT) ? sizeof(uint16_t) : sizeof(uint32_t);
+
+	vertexBytesOut = (vertexBuffer) ? numVerts * bufferLayout.getVertSize() : 0;
+	indexBytesOut = (indexBuffer) ? 3 * numFaces * indexSize : 0;
+	unpackedBytesOut = 0;
+	if ( vertexBuffer )
+		unpackedBytesOut += numVerts * bufferLayout.getUnpackedVertSize();
+	if ( indexBuffer )
+		unpackedBytesOut += 3 * numFaces * sizeof(uint32_t);
+}
+
+void MeshPrimitive::setLodLevels(std::vector<MeshDecimator::Level>& levelsIn, unsigned int version)
+{
+	lodLevels.swap(levelsIn);
+	lodVersion = version;
+}
+
 bool MeshPrimitive::intersectTriangle(Vec<uint32_t> face, Vec<float> lclPntVec, Vec<float> lclDirVec, Vec<float>& triCoord)
 {
 	// Find vectors for two edges sharing vert0
@@ -201,26 +275,38 @@ MeshPrimitive::~MeshPrimitive()
 
 StaticColorMesh::StaticColorMesh(Renderer* renderer, const std::vector<Vec<uint32_t>>& faces,
 	const std::vector<Vec<float>>& vertices, const std::vector<Vec<float>>& normals, const Color& color)
-	: MeshPrimitive(renderer, VertexLayout::Types::PNC, "StaticColorShader", "StaticColorVS_PNC")
+	: MeshPrimitive(renderer, VertexLayout::Types::PNCPacked, "StaticColorShader", "StaticColorVS_PNCPacked")
 {
 	setupMesh(faces, vertices, normals);
+	setSolidColor(color);
 
-	// Make a per-vertex color property
-	colors.resize(vertices.size());
-	for ( int i=0; i < vertices.size(); ++i )
-		colors[i] = color;
+	initializeResources();
+}
+
+StaticColorMesh::StaticColorMesh(Renderer* renderer, std::vector<Vec<uint32_t>>&& faces, std::vector<Vec<float>>&& vertices,
+	std::vector<Vec<float>>&& normals, const Color& color)
+	: MeshPrimitive(renderer, VertexLayout::Types::PNCPacked, "StaticColorShader", "StaticColorVS_PNCPacked")
+{
+	setupMesh(std::move(faces), std::move(vertices), std::move(normals));
+	setSolidColor(color);
 
 	initializeResources();
 }
 
 StaticColorMesh::StaticColorMesh(Renderer* renderer, const std::vector<Vec<uint32_t>>& faces, const std::vector<Vec<float>>& vertices,
 	const std::vector<Vec<float>>& normals, const std::vector<Color>& colors)
-	: MeshPrimitive(renderer, VertexLayout::Types::PNC, "StaticColorShader", "StaticColorVS_PNC")
+	: MeshPrimitive(renderer, VertexLayout::Types::PNCPacked, "StaticColorShader", "StaticColorVS_PNCPacked")
 {
 	setupMesh(faces, vertices, normals, std::vector<Vec<float>>(), colors);
 	initializeResources();
 }
 
+void StaticColorMesh::setSolidColor(const Color& color)
+{
+	// Make a per-vertex color property
+	colors.assign(vertices.size(), color);
+}
+
 Color StaticColorMesh::getColor()
 {
 	if ( colors.size() > 0 )
@@ -300,10 +386,13 @@ void TextQuads::updateResources()
 	D3D11_MAPPED_SUBRESOURCE res;
 	gRenderer->lockBuffer(vertexBuffer, D3D11_MAP_WRITE_DISCARD, res);
 
-	layout.sliceIntoLayout(res.pData, VertexLayout::Attributes::Position, numVerts, (float*)vertices.data());
-	layout.sliceIntoLayout(res.pData, VertexLayout::Attributes::TextureUV, numVerts, (float*)texUVs.data());
-	layout.sliceIntoLayout(res.pData, VertexLayout::Attributes::Color, numVerts, (float*)colors.data());
-	layout.sliceIntoLayout(res.pData, VertexLayout::Attributes::ColorBack, numVerts, (float*)backColors.data());
+	const float* attrData[VertexLayout::Attributes::ATTR_END] = {NULL};
+	attrData[VertexLayout::Attributes::Position] = (float*)vertices.data();
+	attrData[VertexLayout::Attributes::TextureUV] = (float*)texUVs.data();
+	attrData[VertexLayout::Attributes::Color] = (float*)colors.data();
+	attrData[VertexLayout::Attributes::ColorBack] = (float*)backColors.data();
+
+	layout.interleave(res.pData, numVerts, attrData);
 
 	gRenderer->releaseBuffer(vertexBuffer);
 }
@@ -16,6 +16,7 @@
 #pragma once
 #include "VertexLayouts.h"
 #include "Renderer.h"
+#include "MeshDecimator.h"
 
 #include "Global/Vec.h"
 #include "Global/Color.h"
@@ -39,6 +40,25 @@ public:
 
 	bool checkIntersect(Vec<float> lclPntVec, Vec<float> lclDirVec, float& depthOut);
 
+	Vec<float> getCenterOfMass() const {return centerOfMass;}
+	void getBounds(Vec<float>& minOut, Vec<float>& maxOut) const {minOut = boundsMin; maxOut = boundsMax;}
+	const std::vector<Vec<float>>& getVertices() const {return vertices;}
+	const std::vector<Vec<float>>& getNormals() const {return normals;}
+	const std::vector<Vec<uint32_t>>& getFaces() const {return faces;}
+	const std::vector<Color>& getColors() const {return colors;}
+
+	int getVertShaderIdx() const {return vertShaderIdx;}
+
+	// Decimated face lists over this mesh's vertices, coarsest last, built by the resource cache
+	const std::vector<MeshDecimator::Level>& getLodLevels() const {return lodLevels;}
+	unsigned int getLodVersion() const {return lodVersion;}
+	void setLodLevels(std::vector<MeshDecimator::Level>& levelsIn, unsigned int version);
+
+	// Bytes of triangle data held by this mesh (also mirrored in the GPU buffers)
+	size_t getMemorySize() const;
+	// Bytes in the GPU buffers, and what they would take with float attributes and 32-bit indices
+	void getBufferBytes(size_t& vertexBytesOut, size_t& indexBytesOut, size_t& unpackedBytesOut) const;
+
 	~MeshPrimitive();
 protected:
 	MeshPrimitive(Renderer* rendererIn, VertexLayout::Types layoutType = VertexLayout::Types::P,
@@ -54,6 +74,8 @@ protected:
 		const std::vector<Vec<float>>& normalsIn = std::vector<Vec<float>>(),
 		const std::vector<Vec<float>>& texUVsIn = std::vector<Vec<float>>(),
 		const std::vector<Color>& colorsIn = std::vector<Color>());
+	// Takes the arrays without copying them
+	void setupMesh(std::vector<Vec<uint32_t>>&& facesIn, std::vector<Vec<float>>&& verticesIn, std::vector<Vec<float>>&& normalsIn);
 
 	void cleanupMesh();
 
@@ -61,7 +83,6 @@ protected:
 	void initializeResources(UINT vertAccessFlags = 0, UINT indexAccessFlags = 0);
 	void updateCenterOfMass();
 
-	Vec<float> getCenterOfMass() const {return centerOfMass;}
 	bool intersectTriangle(Vec<uint32_t> face, Vec<float> lclPntVec, Vec<float> lclDirVec, Vec<float>& triCoord);
 
 	// TODO: This really should probably be part of the material system
@@ -69,7 +90,7 @@ protected:
 	virtual DirectX::XMMATRIX computeLocalToWorld(DirectX::XMMATRIX parentToWorld){return parentToWorld;}
 
 private:
-	MeshPrimitive():layout(VertexLayout::Types::P){}
+	MeshPrimitive():layout(VertexLayout::Types::P), lodVersion(0), indexFormat(DXGI_FORMAT_R32_UINT){}
 
 protected:
 
@@ -78,6 +99,8 @@ protected:
 	size_t numFaces;
 	size_t numVerts;
 	Vec<float> centerOfMass;
+	Vec<float> boundsMin;
+	Vec<float> boundsMax;
 
 	// Triangle resources
 	std::vector<Vec<uint32_t>> faces;
@@ -87,6 +110,9 @@ protected:
 	std::vector<Color> colors;
 	std::vector<Color> backColors;
 
+	std::vector<MeshDecimator::Level> lodLevels;
+	unsigned int lodVersion;
+
 	// Render resources
 	int vertShaderIdx;
 
@@ -94,17 +120,25 @@ protected:
 
 	ID3D11Buffer* vertexBuffer;
 	ID3D11Buffer* indexBuffer;
+	DXGI_FORMAT indexFormat;
 };
 
 
+// Uses the packed PNC layout, 16 bytes per vertex and 16-bit indices when the mesh is small enough
 class StaticColorMesh : public MeshPrimitive
 {
 	virtual Color getColor();
 
+	void setSolidColor(const Color& color);
+
 public:
 	StaticColorMesh(Renderer* renderer, const std::vector<Vec<uint32_t>>& faces, const std::vector<Vec<float>>& vertices,
 		const std::vector<Vec<float>>& normals, const Color& color);
 
+	// Moves the arrays into the mesh instead of copying them
+	StaticColorMesh(Renderer* renderer, std::vector<Vec<uint32_t>>&& faces, std::vector<Vec<float>>&& vertices,
+		std::vector<Vec<float>>&& normals, const Color& color);
+
 	StaticColorMesh(Renderer* renderer, const std::vector<Vec<uint32_t>>& faces, const std::vector<Vec<float>>& vertices,
 		const std::vector<Vec<float>>& normals, const std::vector<Color>& colors);
 };
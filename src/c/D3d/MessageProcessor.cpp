@@ -14,16 +14,20 @@
 ////////////////////////////////////////////////////////////////////////////////
 
 #include "MessageProcessor.h"
+#include "FrameScheduler.h"
 #include "Initialization.h"
 #include "Global/Globals.h"
 #include "Global/ErrorMsg.h"
 #include "Global/ModuleInfo.h"
+#include "Global/Profiler.h"
 #include "Global/WidgetData.h"
 #include "Messages/LoadData.h"
 #include "Messages/MessageHelpers.h"
 
-#include <time.h>
+#include <algorithm>
+#include <chrono>
 #include <thread>
+#include <vector>
 
 bool gUpdateShaders = true;
 bool gPlay = false;
@@ -35,6 +39,17 @@ float numAngles = 720.0f;
 
 const DirectX::XMMATRIX ROT_X = DirectX::XMMatrixRotationY(-1.0f/(numAngles)*DirectX::XM_2PI);
 
+// Longest the render thread spends on queued commands before drawing again
+const double messageBudgetSeconds = 0.010;
+
+const double rotateStepSeconds = 2.5/numAngles;
+const double shaderReloadSeconds = 1.0;
+
+static FrameScheduler frameScheduler;
+
+// Signaled by the message queue when a command arrives while the render thread is asleep
+static HANDLE messageWakeEvent = NULL;
+
 void ClientResize(HWND hWnd, int nWidth, int nHeight)
 {
 	RECT rcClient, rcWind;
@@ -69,6 +84,9 @@ LRESULT CALLBACK wndProc(HWND hWnd,UINT message,WPARAM wParam,LPARAM lParam)
 	static bool minimized = false;
 	static bool hullsOn = true;
 	static bool widgetOn = true;
+	static bool regionSelecting = false;
+	static bool lassoSelect = false;
+	static std::vector<Vec<float>> regionPoints;
 
 	float alpha = (altDown) ? (0.1f) : (1.0f);
 
@@ -139,7 +157,18 @@ LRESULT CALLBACK wndProc(HWND hWnd,UINT message,WPARAM wParam,LPARAM lParam)
 		gRenderer->forceUpdate();
 		break;
 	case WM_MOUSEMOVE:
-		if(leftButtonDown)
+		if(regionSelecting)
+		{
+			Vec<float> mousePnt((float)iMouseX, (float)iMouseY, 0.0f);
+			Vec<float> delta = mousePnt - regionPoints.back();
+
+			// Rectangles only track the opposite corner, lassos keep a point every few pixels
+			if(!lassoSelect)
+				regionPoints.back() = mousePnt;
+			else if(abs(delta.x) > 2.0f || abs(delta.y) > 2.0f)
+				regionPoints.push_back(mousePnt);
+		}
+		else if(leftButtonDown)
 		{
 			DirectX::XMMATRIX rotX,rotY;
 			if(shiftDown)
@@ -166,19 +195,59 @@ LRESULT CALLBACK wndProc(HWND hWnd,UINT message,WPARAM wParam,LPARAM lParam)
 			gRenderer->setClipChunkPercent(0.1f);
 		break;
 	case WM_RBUTTONDOWN:
+		if(shiftDown)
+		{
+			// Shift+right-drag selects by rectangle, adding alt draws a lasso instead
+			regionSelecting = true;
+			lassoSelect = altDown;
+			regionPoints.clear();
+			regionPoints.push_back(Vec<float>((float)iMouseX, (float)iMouseY, 0.0f));
+			regionPoints.push_back(Vec<float>((float)iMouseX, (float)iMouseY, 0.0f));
+			SetCapture(hWnd);
+			break;
+		}
+
 		gCameraDefaultMesh->getRay(iMouseX,iMouseY,pnt,direction);
 		index = gRenderer->getPolygon(pnt,direction);
 		if(ctrlDown)
 		{
-			gMsgQueueToMex.addMessage("cellSelected",index);
+			gMsgQueueToMex.addEvent(EventCellSelected, index);
 		}
 		else
 		{
-			gMsgQueueToMex.addMessage("rightClick",index);
+			gMsgQueueToMex.addEvent(EventRightClick, index);
+		}
+
+		// First visible voxel under the cursor, alt centers the view on it. A polygon hit already answers the click.
+		if ( index < 0 )
+		{
+			Vec<float> imagePos, modelPos;
+			if ( gRenderer->getVolumePoint(pnt, direction, imagePos, modelPos) )
+			{
+				if ( altDown )
+					gRenderer->setWorldOrigin(modelPos);
+
+				std::vector<double> hitPos = {imagePos.x, imagePos.y, imagePos.z, modelPos.x, modelPos.y, modelPos.z};
+				gMsgQueueToMex.addEvent(EventVolumePoint, hitPos);
+			}
 		}
 		ctrlDown = false;
 		gRenderer->forceUpdate();
 		break;
+	case WM_RBUTTONUP:
+		if(regionSelecting)
+		{
+			regionSelecting = false;
+			ReleaseCapture();
+
+			// Ctrl also selects polygons that only partially overlap the region
+			std::vector<int> selected = gRenderer->getPolygonsInRegion(regionPoints, ctrlDown);
+			gMsgQueueToMex.addEvent(EventPolygonsSelected, std::vector<double>(selected.begin(), selected.end()));
+
+			regionPoints.clear();
+			gRenderer->forceUpdate();
+		}
+		break;
 	case WM_LBUTTONUP:
 		leftButtonDown = false;
 		gRenderer->setClipChunkPercent(previousPeel);
@@ -228,22 +297,22 @@ LRESULT CALLBACK wndProc(HWND hWnd,UINT message,WPARAM wParam,LPARAM lParam)
 		else if(VK_SPACE==wParam)
 		{
 			gPlay = !gPlay;
-			gMsgQueueToMex.addMessage("play",gPlay);
+			gMsgQueueToMex.addEvent(EventPlay, gPlay);
 		}
 		else if(VK_SHIFT==wParam)
 		{
 			shiftDown = true;
-			gMsgQueueToMex.addMessage("keyDown","shift");
+			gMsgQueueToMex.addEvent(EventKeyDown, KeyShift);
 		}
 		else if(VK_CONTROL==wParam)
 		{
 			ctrlDown = true;
-			gMsgQueueToMex.addMessage("keyDown","ctrl");
+			gMsgQueueToMex.addEvent(EventKeyDown, KeyCtrl);
 		}
 		else if(VK_MENU == wParam)
 		{
 			altDown = true;
-			gMsgQueueToMex.addMessage("keyDown","alt");
+			gMsgQueueToMex.addEvent(EventKeyDown, KeyAlt);
 		}
 		else if('B' == wParam)
 		{
@@ -275,19 +344,16 @@ LRESULT CALLBACK wndProc(HWND hWnd,UINT message,WPARAM wParam,LPARAM lParam)
 		else if('H' == wParam)
 		{
 			hullsOn = !hullsOn;
-			gMsgQueueToMex.addMessage("togglePolygons",double(hullsOn));
+			gMsgQueueToMex.addEvent(EventTogglePolygons, double(hullsOn));
 
-			for ( auto& it : gRenderer->allSceneObjects(GraphicObjectTypes::Polygons) )
-			{
-				it.second->setRenderable(hullsOn);
-			}
+			gRenderer->allSceneObjects(GraphicObjectTypes::Polygons).setRenderable(hullsOn);
 
 			gRenderer->forceUpdate();
 		}
 		else if('L' == wParam)
 		{
 			gRenderer->toggleLabels();
-			gMsgQueueToMex.addMessage("toggleLabels",0.0);
+			gMsgQueueToMex.addEvent(EventToggleLabels, 0.0);
 			gRenderer->forceUpdate();
 		}
 		else if('P' == wParam)
@@ -306,7 +372,7 @@ LRESULT CALLBACK wndProc(HWND hWnd,UINT message,WPARAM wParam,LPARAM lParam)
 		else if('S' == wParam)
 		{
 			gRotate = !gRotate;
-			gMsgQueueToMex.addMessage("rotate",gRotate);
+			gMsgQueueToMex.addEvent(EventRotate, gRotate);
 		}
 		else if('W' == wParam)
 		{
@@ -317,7 +383,7 @@ LRESULT CALLBACK wndProc(HWND hWnd,UINT message,WPARAM wParam,LPARAM lParam)
 		}
 		else if('X' == wParam)
 		{
-			gMsgQueueToMex.addMessage("centerSelectedPolygon",1.0);
+			gMsgQueueToMex.addEvent(EventCenterSelectedPolygon, 1.0);
 			gRenderer->forceUpdate();
 		}
 		else if('1' == wParam || VK_NUMPAD1 == wParam)
@@ -333,7 +399,7 @@ LRESULT CALLBACK wndProc(HWND hWnd,UINT message,WPARAM wParam,LPARAM lParam)
 				ClientResize(gWindowHandle, 3840, 2160);
 			}
 			{
-				gMsgQueueToMex.addMessage("keyDown","number",1.0);
+				gMsgQueueToMex.addEvent(EventKeyDown, KeyNumber, 1.0);
 			}
 		}
 		else if('2' == wParam || VK_NUMPAD2 == wParam)
@@ -349,7 +415,7 @@ LRESULT CALLBACK wndProc(HWND hWnd,UINT message,WPARAM wParam,LPARAM lParam)
 				ClientResize(gWindowHandle, 3840/2, 2160);
 			}
 			{
-				gMsgQueueToMex.addMessage("keyDown","number",2.0);
+				gMsgQueueToMex.addEvent(EventKeyDown, KeyNumber, 2.0);
 			}
 		}
 		else if('3' == wParam || VK_NUMPAD3 == wParam)
@@ -365,7 +431,7 @@ LRESULT CALLBACK wndProc(HWND hWnd,UINT message,WPARAM wParam,LPARAM lParam)
 				ClientResize(gWindowHandle, 3840/3, 2160);
 			}
 			{
-				gMsgQueueToMex.addMessage("keyDown","number",3.0);
+				gMsgQueueToMex.addEvent(EventKeyDown, KeyNumber, 3.0);
 			}
 		}
 		else if('4' == wParam || VK_NUMPAD4 == wParam)
@@ -381,63 +447,63 @@ LRESULT CALLBACK wndProc(HWND hWnd,UINT message,WPARAM wParam,LPARAM lParam)
 				ClientResize(gWindowHandle, 3840/2, 2160/2);
 			}
 			{
-				gMsgQueueToMex.addMessage("keyDown","number",4.0);
+				gMsgQueueToMex.addEvent(EventKeyDown, KeyNumber, 4.0);
 			}
 		}
 		else if('5' == wParam || VK_NUMPAD5 == wParam)
 		{
-			gMsgQueueToMex.addMessage("keyDown","number",5.0);
+			gMsgQueueToMex.addEvent(EventKeyDown, KeyNumber, 5.0);
 		}
 		else if('6' == wParam || VK_NUMPAD6 == wParam)
 		{
-			gMsgQueueToMex.addMessage("keyDown","number",6.0);
+			gMsgQueueToMex.addEvent(EventKeyDown, KeyNumber, 6.0);
 		}
 		else if('7' == wParam || VK_NUMPAD7 == wParam)
 		{
-			gMsgQueueToMex.addMessage("keyDown","number",7.0);
+			gMsgQueueToMex.addEvent(EventKeyDown, KeyNumber, 7.0);
 		}
 		else if('8' == wParam || VK_NUMPAD8 == wParam)
 		{
-			gMsgQueueToMex.addMessage("keyDown","number",8.0);
+			gMsgQueueToMex.addEvent(EventKeyDown, KeyNumber, 8.0);
 		}
 		else if('9' == wParam || VK_NUMPAD9 == wParam)
 		{
-			gMsgQueueToMex.addMessage("keyDown","number",9.0);
+			gMsgQueueToMex.addEvent(EventKeyDown, KeyNumber, 9.0);
 		}
 		else if('0' == wParam || VK_NUMPAD0 == wParam)
 		{
-			gMsgQueueToMex.addMessage("keyDown","number",0.0);
+			gMsgQueueToMex.addEvent(EventKeyDown, KeyNumber, 0.0);
 		}
 		break;
 	case WM_SYSKEYDOWN:
 		if(VK_MENU==wParam)
 		{
 			altDown = true;
-			gMsgQueueToMex.addMessage("keyDown", "alt");
+			gMsgQueueToMex.addEvent(EventKeyDown, KeyAlt);
 		}
 		break;
 	case WM_KEYUP:
 		if(VK_SHIFT==wParam)
 		{
 			shiftDown = false;
-			gMsgQueueToMex.addMessage("keyUp","shift");
+			gMsgQueueToMex.addEvent(EventKeyUp, KeyShift);
 		}
 		else if(VK_CONTROL==wParam)
 		{
 			ctrlDown = false;
-			gMsgQueueToMex.addMessage("keyUp","ctrl");
+			gMsgQueueToMex.addEvent(EventKeyUp, KeyCtrl);
 		}
 		else if(VK_MENU==wParam)
 		{
 			altDown = false;
-			gMsgQueueToMex.addMessage("keyUp","alt");
+			gMsgQueueToMex.addEvent(EventKeyUp, KeyAlt);
 		}
 		break;
 	case WM_SYSKEYUP:
 		if(VK_MENU==wParam)
 		{
 			altDown = false;
-			gMsgQueueToMex.addMessage("keyDown", "alt");
+			gMsgQueueToMex.addEvent(EventKeyDown, KeyAlt);
 		}
 		break;
 
@@ -448,48 +514,37 @@ LRESULT CALLBACK wndProc(HWND hWnd,UINT message,WPARAM wParam,LPARAM lParam)
 
 void updateTime()
 {
-	static clock_t lastTimeUpdate = clock();
-	static clock_t lastRotateUpdate = clock();
-	static clock_t lastShaderUpdate = clock();
+	FrameScheduler::Clock::time_point now = FrameScheduler::Clock::now();
 
-	if ( gPlay )
-	{
-		float timeFromLast = (float)(clock() - lastTimeUpdate) / CLOCKS_PER_SEC;
-		if ( timeFromLast > 1.0f/gFramesPerSec )
-		{
-			lastTimeUpdate = clock();
+	frameScheduler.setTimer(FrameScheduler::Play, gPlay, 1.0/gFramesPerSec, now);
+	frameScheduler.setTimer(FrameScheduler::Rotate, gRotate, rotateStepSeconds, now);
+	frameScheduler.setTimer(FrameScheduler::ShaderReload, gUpdateShaders, shaderReloadSeconds, now);
 
-			gRenderer->incrementFrame();
+	if ( frameScheduler.takeElapsed(FrameScheduler::Play, now) > 0 )
+	{
+		gRenderer->incrementFrame();
 
-			gRenderer->forceUpdate();
-		}
+		gRenderer->forceUpdate();
 	}
 
-	if ( gRotate )
+	// Steps missed while the loop was asleep or drawing are applied together so the spin rate holds
+	int rotateSteps = std::min(frameScheduler.takeElapsed(FrameScheduler::Rotate, now), int(numAngles));
+	if ( rotateSteps > 0 )
 	{
-		float timeFromLast = (float)(clock() - lastRotateUpdate) / CLOCKS_PER_SEC;
-		if ( timeFromLast > 2.5f/numAngles )
-		{
-			lastRotateUpdate = clock();
+		DirectX::XMMATRIX worldRotation = gRenderer->getRootWorldRotation();
+		for ( int i = 0; i < rotateSteps; ++i )
+			worldRotation = worldRotation*ROT_X;
 
-			DirectX::XMMATRIX previousWorldRotation = gRenderer->getRootWorldRotation();
-			gRenderer->setWorldRotation(previousWorldRotation*ROT_X);
+		gRenderer->setWorldRotation(worldRotation);
 
-			gRenderer->forceUpdate();
-		}
+		gRenderer->forceUpdate();
 	}
 
-	if ( gUpdateShaders )
+	if ( frameScheduler.takeElapsed(FrameScheduler::ShaderReload, now) > 0 )
 	{
-		float shaderUpdateElapsed = (float)(clock() - lastShaderUpdate) / CLOCKS_PER_SEC;
-		if ( shaderUpdateElapsed > 1.0f )
-		{
-			lastShaderUpdate = clock();
-
-			bool update = gRenderer->updateRegisteredShaders();
-			if ( update )
-				gRenderer->forceUpdate();
-		}
+		bool update = gRenderer->updateRegisteredShaders();
+		if ( update )
+			gRenderer->forceUpdate();
 	}
 }
 
@@ -516,12 +571,53 @@ void updateCapture()
 
 void startThreadQueue()
 {
+	messageWakeEvent = CreateEvent(NULL, FALSE, FALSE, NULL);
+	gMsgQueueToDirectX.setWakeCallback([](){SetEvent(messageWakeEvent);});
+
 	gMsgQueueToDirectX.open();
 }
 
 void stopThreadQueue()
 {
 	gMsgQueueToDirectX.close();
+
+	gMsgQueueToDirectX.setWakeCallback(nullptr);
+	if ( messageWakeEvent != NULL )
+		CloseHandle(messageWakeEvent);
+
+	messageWakeEvent = NULL;
+}
+
+// Blocks the render thread until window input, a queued command, termination or the next animation deadline
+void waitForWork()
+{
+	if ( gRenderer->needsUpdate() || gCapture )
+		return;
+
+	if ( !gMsgQueueToDirectX.prepareToSleep() )
+		return;
+
+	FrameScheduler::Clock::duration wait = frameScheduler.timeUntilNext(FrameScheduler::Clock::now());
+
+	DWORD timeoutMs = INFINITE;
+	if ( wait != FrameScheduler::Clock::duration::max() )
+	{
+		// Rounded up so the loop doesn't wake just short of the deadline and go around again for nothing
+		std::chrono::milliseconds waitMs = std::chrono::duration_cast<std::chrono::milliseconds>(wait);
+		if ( waitMs < wait )
+			waitMs += std::chrono::milliseconds(1);
+
+		timeoutMs = DWORD(waitMs.count());
+	}
+
+	HANDLE handles[2];
+	DWORD numHandles = 0;
+	if ( gTermEvent != NULL )
+		handles[numHandles++] = gTermEvent;
+	if ( messageWakeEvent != NULL )
+		handles[numHandles++] = messageWakeEvent;
+
+	MsgWaitForMultipleObjectsEx(numHandles, handles, timeoutMs, QS_ALLINPUT, MWMO_INPUTAVAILABLE);
 }
 
 DWORD WINAPI messageLoop(LPVOID lpParam)
@@ -556,6 +652,8 @@ DWORD WINAPI messageLoop(LPVOID lpParam)
 		startThreadQueue();
 		gRendererInit = true;
 
+		Profiler::setThreadName("Render");
+
 		DWORD termWait = WaitForSingleObject(gTermEvent,0);
 
 		try
@@ -563,8 +661,12 @@ DWORD WINAPI messageLoop(LPVOID lpParam)
 			// DirectX thread
 			while(termWait != WAIT_OBJECT_0 && SUCCEEDED(hr))
 			{
-				if(PeekMessage(&msg,NULL,0,0,PM_REMOVE))
+				// Handle all pending window input before drawing
+				while ( PeekMessage(&msg,NULL,0,0,PM_REMOVE) )
 				{
+					if ( msg.message == WM_QUIT )
+						break;
+
 					TranslateMessage(&msg);
 					DispatchMessage(&msg);
 				}
@@ -588,6 +690,8 @@ DWORD WINAPI messageLoop(LPVOID lpParam)
 				// This function checks if renderer needs update then calls renderall()
 				gRenderer->renderUpdate();
 
+				// Sleep rather than spin when nothing is animating or waiting to be drawn
+				waitForWork();
 
 				termWait = WaitForSingleObject(gTermEvent,0);
 			}
@@ -636,8 +740,8 @@ DWORD WINAPI messageLoop(LPVOID lpParam)
 
 		gRendererInit = false;
 
-		gMsgQueueToMex.addMessage("loadDone", 0);
-		gMsgQueueToMex.addMessage("close",1.0);
+		gMsgQueueToMex.setLoadDone();
+		gMsgQueueToMex.addEvent(EventClose, 1.0);
 	}
 	catch(const std::exception& e)
 	{
@@ -660,7 +764,8 @@ HRESULT checkMessage()
 	if ( gMsgQueueToDirectX.getNumMessages() == 0 )
 		return S_OK;
 
-	bool success = gMsgQueueToDirectX.processNext();
+	// Bursts of commands are handled in one loop turn, the budget keeps a long burst from stalling rendering
+	bool success = gMsgQueueToDirectX.processPending(messageBudgetSeconds);
 
 	return ((success) ? (S_OK) : (S_FALSE));
 }
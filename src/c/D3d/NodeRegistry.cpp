@@ -0,0 +1,319 @@
+#include "NodeRegistry.h"
+#include "SceneNode.h"
+#include "Material.h"
+
+#include <algorithm>
+#include <intrin.h>
+
+namespace
+{
+	bool testBit(const std::vector<uint64_t>& bits, size_t slot)
+	{
+		return ((bits[slot / 64] >> (slot % 64)) & 1) != 0;
+	}
+
+	void setBit(std::vector<uint64_t>& bits, size_t slot, bool value)
+	{
+		uint64_t bit = uint64_t(1) << (slot % 64);
+		if ( value )
+			bits[slot / 64] |= bit;
+		else
+			bits[slot / 64] &= ~bit;
+	}
+}
+
+
+NodeRegistry::NodeRegistry()
+	: stateVersion(0)
+{}
+
+bool NodeRegistry::insert(int index, GraphicObjectNode* node)
+{
+	if ( getSlot(index) != invalidSlot )
+		return false;
+
+	size_t slot = nodes.size();
+
+	setSlot(index, uint32_t(slot));
+	nodes.push_back(node);
+	indices.push_back(index);
+
+	// Packed state starts out as whatever the node's material was made with
+	Vec<float> color(1.0f, 1.0f, 1.0f);
+	float alpha = 1.0f;
+	uint8_t nodeFlags = 0;
+
+	PolygonMaterial* polyMaterial = dynamic_cast<PolygonMaterial*>(node->getMaterial().get());
+	if ( polyMaterial )
+	{
+		PolygonMaterial::State matState = polyMaterial->getState();
+		color = matState.color;
+		alpha = matState.alpha;
+		nodeFlags |= (matState.useColor) ? UseColor : 0;
+	}
+
+	if ( node->getMaterial() && node->getMaterial()->isWireframe() )
+		nodeFlags |= Wireframe;
+
+	colors.push_back(color);
+	alphas.push_back(alpha);
+	flags.push_back(nodeFlags);
+
+	if ( slot % 64 == 0 )
+		stateDirty.push_back(0);
+
+	return true;
+}
+
+bool NodeRegistry::erase(int index, GraphicObjectNode* node)
+{
+	uint32_t slot = getSlot(index);
+	if ( slot == invalidSlot || nodes[slot] != node )
+		return false;
+
+	// Swap the last entry into the freed slot to keep storage packed
+	uint32_t last = uint32_t(nodes.size() - 1);
+	if ( slot != last )
+	{
+		nodes[slot] = nodes[last];
+		indices[slot] = indices[last];
+		setSlot(indices[slot], slot);
+
+		colors[slot] = colors[last];
+		alphas[slot] = alphas[last];
+		flags[slot] = flags[last];
+		setBit(stateDirty, slot, testBit(stateDirty, last));
+	}
+
+	nodes.pop_back();
+	indices.pop_back();
+	setSlot(index, invalidSlot);
+
+	colors.pop_back();
+	alphas.pop_back();
+	flags.pop_back();
+	setBit(stateDirty, last, false);
+	stateDirty.resize((nodes.size() + 63) / 64);
+
+	return true;
+}
+
+void NodeRegistry::clear()
+{
+	nodes.clear();
+	indices.clear();
+
+	colors.clear();
+	alphas.clear();
+	flags.clear();
+	stateDirty.clear();
+
+	pages[0].clear();
+	pages[1].clear();
+}
+
+GraphicObjectNode* NodeRegistry::find(int index) const
+{
+	uint32_t slot = getSlot(index);
+	if ( slot == invalidSlot )
+		return NULL;
+
+	return nodes[slot];
+}
+
+int NodeRegistry::findSlot(const GraphicObjectNode* node) const
+{
+	uint32_t slot = getSlot(node->getIndex());
+	if ( slot == invalidSlot || nodes[slot] != node )
+		return -1;
+
+	return int(slot);
+}
+
+void NodeRegistry::makeMask(const std::vector<int>& indexList, std::vector<uint64_t>& maskOut) const
+{
+	maskOut.assign((nodes.size() + 63) / 64, 0);
+
+	for ( int index : indexList )
+	{
+		uint32_t slot = getSlot(index);
+		if ( slot == invalidSlot )
+			continue;
+
+		maskOut[slot / 64] |= (uint64_t(1) << (slot % 64));
+	}
+}
+
+void NodeRegistry::setRenderable(const std::vector<uint64_t>& mask, bool render)
+{
+	// Flags are set directly so the update request only walks the tree once
+	GraphicObjectNode* changed = NULL;
+	for ( size_t word = 0; word < mask.size(); ++word )
+	{
+		uint64_t bits = mask[word];
+		while ( bits )
+		{
+			unsigned long bit;
+			_BitScanForward64(&bit, bits);
+			bits &= bits - 1;
+
+			GraphicObjectNode* node = nodes[word*64 + bit];
+			if ( node->renderable == render )
+				continue;
+
+			node->renderable = render;
+			changed = node;
+		}
+	}
+
+	if ( changed )
+		changed->requestUpdate();
+}
+
+void NodeRegistry::setRenderable(bool render)
+{
+	GraphicObjectNode* changed = NULL;
+	for ( GraphicObjectNode* node : nodes )
+	{
+		if ( node->renderable == render )
+			continue;
+
+		node->renderable = render;
+		changed = node;
+	}
+
+	if ( changed )
+		changed->requestUpdate();
+}
+
+size_t NodeRegistry::applyState(const BulkState& state)
+{
+	size_t count = (state.indices.empty()) ? nodes.size() : state.indices.size();
+
+	bool setColors = (!state.colors.empty() || state.clearColors);
+	bool setWireframe = (state.wireframe >= 0);
+
+	GraphicObjectNode* changed = NULL;
+	size_t numApplied = 0;
+	for ( size_t i = 0; i < count; ++i )
+	{
+		uint32_t slot = (state.indices.empty()) ? uint32_t(i) : getSlot(state.indices[i]);
+		if ( slot == invalidSlot )
+			continue;
+
+		++numApplied;
+
+		if ( !state.visible.empty() )
+		{
+			GraphicObjectNode* node = nodes[slot];
+
+			bool render = (state.visible[(state.visible.size() > 1) ? i : 0] != 0);
+			if ( node->renderable != render )
+			{
+				node->renderable = render;
+				changed = node;
+			}
+		}
+
+		if ( !setColors && !setWireframe )
+			continue;
+
+		if ( !state.colors.empty() )
+		{
+			size_t colorIdx = (state.colors.size() > 1) ? i : 0;
+			colors[slot] = state.colors[colorIdx];
+			alphas[slot] = state.alphas[colorIdx];
+			flags[slot] |= UseColor;
+		}
+		else if ( state.clearColors )
+		{
+			alphas[slot] = 1.0f;
+			flags[slot] &= ~UseColor;
+		}
+
+		if ( setWireframe )
+		{
+			if ( state.wireframe != 0 )
+				flags[slot] |= Wireframe;
+			else
+				flags[slot] &= ~Wireframe;
+		}
+
+		setBit(stateDirty, slot, true);
+		changed = nodes[slot];
+	}
+
+	if ( numApplied > 0 && (setColors || setWireframe) )
+		++stateVersion;
+
+	if ( changed )
+		changed->requestUpdate();
+
+	return numApplied;
+}
+
+NodeRegistry::NodeState NodeRegistry::stateAt(size_t slot) const
+{
+	NodeState state;
+	state.color = colors[slot];
+	state.alpha = alphas[slot];
+	state.useColor = ((flags[slot] & UseColor) != 0);
+	state.wireframe = ((flags[slot] & Wireframe) != 0);
+
+	return state;
+}
+
+void NodeRegistry::resolveMaterial(GraphicObjectNode* node)
+{
+	uint32_t slot = getSlot(node->getIndex());
+	if ( slot == invalidSlot || nodes[slot] != node || !testBit(stateDirty, slot) )
+		return;
+
+	setBit(stateDirty, slot, false);
+
+	NodeState state = stateAt(slot);
+	if ( state.useColor )
+		node->setColor(state.color, state.alpha);
+	else
+		node->clearColor();
+
+	node->setWireframe(state.wireframe);
+}
+
+uint32_t NodeRegistry::getSlot(int index) const
+{
+	int sign = (index < 0) ? 1 : 0;
+	size_t offset = (index < 0) ? size_t(-(int64_t)index - 1) : size_t(index);
+
+	size_t page = offset >> pageBits;
+	if ( page >= pages[sign].size() || !pages[sign][page] )
+		return invalidSlot;
+
+	return pages[sign][page][offset & (pageSize - 1)];
+}
+
+void NodeRegistry::setSlot(int index, uint32_t slot)
+{
+	int sign = (index < 0) ? 1 : 0;
+	size_t offset = (index < 0) ? size_t(-(int64_t)index - 1) : size_t(index);
+
+	size_t page = offset >> pageBits;
+	if ( page >= pages[sign].size() )
+	{
+		if ( slot == invalidSlot )
+			return;
+
+		pages[sign].resize(page + 1);
+	}
+
+	if ( !pages[sign][page] )
+	{
+		if ( slot == invalidSlot )
+			return;
+
+		pages[sign][page].reset(new uint32_t[pageSize]);
+		std::fill(pages[sign][page].get(), pages[sign][page].get() + pageSize, invalidSlot);
+	}
+
+	pages[sign][page][offset & (pageSize - 1)] = slot;
+}
@@ -0,0 +1,110 @@
+#pragma once
+#include "Global/Vec.h"
+
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+class GraphicObjectNode;
+
+// Index to node lookup for a single graphic object type.
+// Nodes are kept packed in a dense array for iteration and a paged sparse table maps
+// object indices to dense slots, so lookup, insert and remove are all constant time.
+// Color and wireframe state lives in packed arrays next to the nodes. Polygon batches read it
+// directly, nodes drawn on their own get it copied into their material by resolveMaterial.
+class NodeRegistry
+{
+public:
+	typedef std::vector<GraphicObjectNode*>::const_iterator const_iterator;
+
+	// State applied to many nodes at once. An empty index list selects every node, and each
+	// per-node list is either empty (unchanged), a single value for all, or one value per index.
+	struct BulkState
+	{
+		BulkState() : clearColors(false), wireframe(-1) {}
+
+		std::vector<int> indices;
+		std::vector<char> visible;
+		std::vector<Vec<float>> colors;
+		std::vector<float> alphas;
+
+		// Without colors, goes back to the mesh's own vertex colors at full alpha
+		bool clearColors;
+
+		// -1 leaves wireframe unchanged
+		int wireframe;
+	};
+
+	// Packed state of a single node, color only replaces the mesh vertex colors when useColor is set
+	struct NodeState
+	{
+		Vec<float> color;
+		float alpha;
+		bool useColor;
+		bool wireframe;
+	};
+
+	NodeRegistry();
+
+	bool insert(int index, GraphicObjectNode* node);
+	// Only removes the entry if it currently refers to node
+	bool erase(int index, GraphicObjectNode* node);
+	void clear();
+
+	GraphicObjectNode* find(int index) const;
+	// Dense slot holding node, -1 if it isn't registered
+	int findSlot(const GraphicObjectNode* node) const;
+	bool contains(int index) const {return (find(index) != NULL);}
+
+	size_t size() const {return nodes.size();}
+	bool empty() const {return nodes.empty();}
+
+	GraphicObjectNode* nodeAt(size_t slot) const {return nodes[slot];}
+	int indexAt(size_t slot) const {return indices[slot];}
+
+	const_iterator begin() const {return nodes.begin();}
+	const_iterator end() const {return nodes.end();}
+
+	// Bulk visibility, bit i of the mask selects dense slot i
+	void makeMask(const std::vector<int>& indices, std::vector<uint64_t>& maskOut) const;
+	void setRenderable(const std::vector<uint64_t>& mask, bool render);
+	void setRenderable(bool render);
+
+	// Returns the number of nodes that were found and updated
+	size_t applyState(const BulkState& state);
+
+	NodeState stateAt(size_t slot) const;
+	// Changes whenever applyState changes any color or wireframe state
+	uint64_t getStateVersion() const {return stateVersion;}
+
+	// Copies changed state into the material of a node that is drawn on its own
+	void resolveMaterial(GraphicObjectNode* node);
+
+private:
+	enum StateFlags
+	{
+		UseColor = 1,
+		Wireframe = 2
+	};
+
+	static const int pageBits = 12;
+	static const int pageSize = 1 << pageBits;
+	static const uint32_t invalidSlot = 0xFFFFFFFF;
+
+	uint32_t getSlot(int index) const;
+	void setSlot(int index, uint32_t slot);
+
+	// Dense storage
+	std::vector<GraphicObjectNode*> nodes;
+	std::vector<int> indices;
+
+	// Packed state by dense slot, a set bit in stateDirty means the node's material hasn't seen the change yet
+	std::vector<Vec<float>> colors;
+	std::vector<float> alphas;
+	std::vector<uint8_t> flags;
+	std::vector<uint64_t> stateDirty;
+	uint64_t stateVersion;
+
+	// Sparse pages of dense slots, negative indices are kept in their own set of pages
+	std::vector<std::unique_ptr<uint32_t[]>> pages[2];
+};
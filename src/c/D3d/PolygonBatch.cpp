@@ -0,0 +1,446 @@
+#include "PolygonBatch.h"
+#include "BatchMerge.h"
+#include "SceneNode.h"
+#include "NodeRegistry.h"
+#include "Renderer.h"
+#include "MeshPrimitive.h"
+#include "Material.h"
+#include "ResourceCache.h"
+#include "TransformKernels.h"
+
+#include "Global/Defines.h"
+#include "Global/ErrorMsg.h"
+#include "Global/Profiler.h"
+
+#include <algorithm>
+#include <cmath>
+
+#undef min
+#undef max
+
+namespace
+{
+	void setEntryState(PolygonBatch::Entry& entry, const PolygonMaterial::State& state)
+	{
+		entry.color = state.color;
+		entry.alpha = state.alpha;
+		entry.useColor = state.useColor;
+		entry.bucket = ((state.wireframe) ? 1 : 0) | ((state.lightOn) ? 2 : 0);
+	}
+}
+
+
+PolygonBatch::PolygonBatch(Renderer* renderer, SceneNode* frameNode)
+	: renderer(renderer), frameNode(frameNode), registry(&renderer->allSceneObjects(GraphicObjectTypes::Polygons)), stateVersion(0), layout(VertexLayout::Types::PNCPacked), numFaces(0), numDrawnFaces(0), numFullDetailFaces(0),
+	vertexBuffer(NULL), indexBuffer(NULL), indexFormat(DXGI_FORMAT_R32_UINT)
+{
+	// Same shader every static color mesh registers, only hulls using it can be merged
+	vertShaderIdx = renderer->registerVertexShader("StaticColorShader", "StaticColorVS_PNCPacked", layout);
+
+	build();
+}
+
+PolygonBatch::~PolygonBatch()
+{
+	releaseResources();
+}
+
+void PolygonBatch::releaseResources()
+{
+	SAFE_RELEASE(vertexBuffer);
+	SAFE_RELEASE(indexBuffer);
+
+	numFaces = 0;
+	numDrawnFaces = 0;
+	numFullDetailFaces = 0;
+}
+
+DirectX::XMMATRIX PolygonBatch::getLocalToFrame(const GraphicObjectNode* node, const SceneNode* frameNode)
+{
+	DirectX::XMMATRIX localToFrame = node->localToParentTransform;
+	for ( const SceneNode* parent = node->parentNode; parent != NULL && parent != frameNode; parent = parent->parentNode )
+		localToFrame = localToFrame * parent->localToParentTransform;
+
+	return localToFrame;
+}
+
+PolygonMaterial::State PolygonBatch::getEntryState(const Entry& entry, PolygonMaterial* material) const
+{
+	// Lighting stays on the material, color and wireframe come from the registry's packed state
+	PolygonMaterial::State state = material->getState();
+	if ( entry.registrySlot < 0 )
+		return state;
+
+	NodeRegistry::NodeState nodeState = registry->stateAt(entry.registrySlot);
+	state.color = nodeState.color;
+	state.alpha = nodeState.alpha;
+	state.useColor = nodeState.useColor;
+	state.wireframe = nodeState.wireframe;
+
+	return state;
+}
+
+void PolygonBatch::build()
+{
+	releaseResources();
+
+	entries.clear();
+	unbatched.clear();
+	vertMem.clear();
+
+	stateVersion = registry->getStateVersion();
+
+	// Collect every hull below the frame, hidden ones too so visibility changes never force a rebuild
+	std::vector<SceneNode*> stack(1, frameNode);
+	while ( !stack.empty() )
+	{
+		SceneNode* sceneNode = stack.back();
+		stack.pop_back();
+
+		if ( sceneNode->type == GraphicObjectTypes::Polygons )
+		{
+			GraphicObjectNode* node = dynamic_cast<GraphicObjectNode*>(sceneNode);
+			if ( !node )
+				continue;
+
+			MeshPrimitive* mesh = node->getMesh().get();
+			PolygonMaterial* material = dynamic_cast<PolygonMaterial*>(node->getMaterial().get());
+			if ( !mesh || !material || mesh->getVertShaderIdx() != vertShaderIdx || mesh->getFaces().empty() )
+			{
+				unbatched.push_back(node);
+				continue;
+			}
+
+			const std::vector<MeshDecimator::Level>& lodLevels = mesh->getLodLevels();
+
+			Entry entry;
+			entry.node = node;
+			entry.material = material;
+			entry.materialVersion = node->getMaterialVersion();
+			entry.registrySlot = registry->findSlot(node);
+			entry.numVerts = (uint32_t)mesh->getVertices().size();
+			entry.numLods = 1 + (int)std::min(lodLevels.size(), size_t(ResourceCache::numLodLevels-1));
+			entry.lod = 0;
+			entry.visible = node->isRenderable();
+
+			for ( int i = 0; i < ResourceCache::numLodLevels; ++i )
+			{
+				entry.firstFace[i] = 0;
+				entry.numFaces[i] = 0;
+			}
+
+			entry.numFaces[0] = (uint32_t)mesh->getFaces().size();
+			for ( int i = 1; i < entry.numLods; ++i )
+				entry.numFaces[i] = (uint32_t)lodLevels[i-1].faces.size();
+
+			setEntryBounds(entry, mesh, getLocalToFrame(node, frameNode));
+
+			setEntryState(entry, getEntryState(entry, material));
+			entries.push_back(entry);
+			continue;
+		}
+
+		const std::vector<SceneNode*>& children = sceneNode->childrenNodes;
+		for ( auto it = children.rbegin(); it != children.rend(); ++it )
+			stack.push_back(*it);
+	}
+
+	// Keep each bucket contiguous in the merged buffers, scene order is kept within a bucket
+	std::stable_sort(entries.begin(), entries.end(), [](const Entry& a, const Entry& b){return a.bucket < b.bucket;});
+
+	uint32_t vertOffset = 0;
+	for ( Entry& entry : entries )
+	{
+		entry.firstVert = vertOffset;
+		vertOffset += entry.numVerts;
+	}
+
+	// Every LOD level has its own index section with the entries in the same order,
+	// so neighboring hulls drawn at the same level still merge into one run
+	uint32_t faceOffset = 0;
+	for ( int lod = 0; lod < ResourceCache::numLodLevels; ++lod )
+	{
+		for ( Entry& entry : entries )
+		{
+			if ( lod >= entry.numLods )
+				continue;
+
+			entry.firstFace[lod] = faceOffset;
+			faceOffset += entry.numFaces[lod];
+		}
+	}
+
+	for ( int i = 0; i < numBuckets; ++i )
+	{
+		buckets[i].material.reset();
+		buckets[i].runs.clear();
+	}
+
+	if ( entries.empty() )
+		return;
+
+	// Packed positions are relative to bounds around every hull in the frame
+	Vec<float> boundsMin = entries[0].boundsCenter - entries[0].boundsRadius;
+	Vec<float> boundsMax = entries[0].boundsCenter + entries[0].boundsRadius;
+	for ( const Entry& entry : entries )
+	{
+		boundsMin = Vec<float>::min(boundsMin, entry.boundsCenter - entry.boundsRadius);
+		boundsMax = Vec<float>::max(boundsMax, entry.boundsCenter + entry.boundsRadius);
+	}
+
+	layout.setPositionBounds(boundsMin, boundsMax);
+
+	std::vector<Vec<uint32_t>> faces;
+	mergeEntries(entries, frameNode, layout, vertMem, faces);
+
+	HRESULT hr = renderer->createVertexBuffer(0, D3D11_USAGE_DEFAULT, vertMem.size(), vertMem.data(), &vertexBuffer);
+	if ( SUCCEEDED(hr) )
+		hr = renderer->createIndexBuffer(0, D3D11_USAGE_IMMUTABLE, faces, &indexBuffer, &indexFormat);
+
+	if ( FAILED(hr) )
+	{
+		sendHrErrMessage(hr);
+
+		// Fall back to drawing every hull on its own
+		releaseResources();
+		for ( const Entry& entry : entries )
+			unbatched.push_back(entry.node);
+
+		entries.clear();
+		vertMem.clear();
+		return;
+	}
+
+	numFaces = faces.size();
+
+	// Colors are baked into the vertices, bucket materials only carry the raster and lighting state
+	for ( const Entry& entry : entries )
+	{
+		if ( buckets[entry.bucket].material )
+			continue;
+
+		PolygonMaterial::State state;
+		state.wireframe = ((entry.bucket & 1) != 0);
+		state.lightOn = ((entry.bucket & 2) != 0);
+
+		buckets[entry.bucket].material = renderer->getResourceCache()->getPolygonMaterial(state);
+	}
+
+	updateRuns();
+}
+
+void PolygonBatch::mergeEntries(const std::vector<Entry>& entries, SceneNode* frameNode, VertexLayout layout,
+	std::vector<uint8_t>& vertMemOut, std::vector<Vec<uint32_t>>& facesOut)
+{
+	static_assert(ResourceCache::numLodLevels <= BatchMerge::maxLods, "BatchMerge::maxLods must cover every LOD level");
+
+	std::vector<BatchMerge::Hull> hulls(entries.size());
+	for ( size_t i = 0; i < entries.size(); ++i )
+	{
+		const Entry& entry = entries[i];
+		const MeshPrimitive* mesh = entry.node->getMesh().get();
+
+		BatchMerge::Hull& hull = hulls[i];
+		hull.vertices = &mesh->getVertices();
+		hull.normals = &mesh->getNormals();
+		hull.colors = &mesh->getColors();
+
+		hull.localToFrame = TransformKernels::Affine::fromXMMATRIX(getLocalToFrame(entry.node, frameNode));
+
+		hull.color = entry.color;
+		hull.alpha = entry.alpha;
+		hull.useColor = entry.useColor;
+
+		hull.firstVert = entry.firstVert;
+		hull.numVerts = entry.numVerts;
+		hull.numLods = entry.numLods;
+		for ( int lod = 0; lod < entry.numLods; ++lod )
+		{
+			hull.lodFaces[lod] = (lod == 0) ? &mesh->getFaces() : &mesh->getLodLevels()[lod-1].faces;
+			hull.firstFace[lod] = entry.firstFace[lod];
+			hull.numFaces[lod] = entry.numFaces[lod];
+		}
+	}
+
+	BatchMerge::merge(hulls, layout, vertMemOut, facesOut);
+}
+
+bool PolygonBatch::sync()
+{
+	PROFILE_ZONE("SyncPolygonBatch");
+
+	bool runsChanged = false;
+
+	uint32_t dirtyBegin = UINT32_MAX;
+	uint32_t dirtyEnd = 0;
+
+	std::vector<Color> colors;
+	size_t vertSize = layout.getVertSize();
+
+	// Bulk state changes only touch the registry, every entry is re-checked against it when its version moves
+	bool stateChanged = (registry->getStateVersion() != stateVersion);
+	stateVersion = registry->getStateVersion();
+
+	for ( Entry& entry : entries )
+	{
+		GraphicObjectNode* node = entry.node;
+
+		bool visible = node->isRenderable();
+		if ( visible != entry.visible )
+		{
+			entry.visible = visible;
+			runsChanged = true;
+		}
+
+		const Material* material = node->getMaterial().get();
+		if ( !stateChanged && material == entry.material && node->getMaterialVersion() == entry.materialVersion )
+			continue;
+
+		PolygonMaterial* polyMaterial = dynamic_cast<PolygonMaterial*>(node->getMaterial().get());
+		if ( !polyMaterial )
+			return false;
+
+		Entry oldEntry = entry;
+		setEntryState(entry, getEntryState(entry, polyMaterial));
+
+		// Moving between buckets changes the buffer layout
+		if ( entry.bucket != oldEntry.bucket )
+			return false;
+
+		entry.material = material;
+		entry.materialVersion = node->getMaterialVersion();
+
+		if ( entry.useColor == oldEntry.useColor && entry.alpha == oldEntry.alpha && (!entry.useColor || entry.color == oldEntry.color) )
+			continue;
+
+		BatchMerge::bakeColors(node->getMesh()->getColors(), entry.numVerts, entry.color, entry.alpha, entry.useColor, colors);
+		layout.sliceIntoLayout(vertMem.data() + entry.firstVert * vertSize, VertexLayout::Attributes::Color, entry.numVerts, (float*)colors.data());
+
+		dirtyBegin = std::min(dirtyBegin, entry.firstVert);
+		dirtyEnd = std::max(dirtyEnd, entry.firstVert + entry.numVerts);
+	}
+
+	if ( dirtyBegin < dirtyEnd )
+	{
+		size_t byteOffset = dirtyBegin * vertSize;
+		renderer->updateBufferRegion(vertexBuffer, byteOffset, (dirtyEnd - dirtyBegin) * vertSize, vertMem.data() + byteOffset);
+	}
+
+	if ( runsChanged )
+		updateRuns();
+
+	return true;
+}
+
+void PolygonBatch::selectLods(const DirectX::XMMATRIX& frameToView, const DirectX::XMMATRIX& projection, float viewportHeight,
+	const ResourceCache::LodSettings& settings)
+{
+	DirectX::XMFLOAT4X4 proj;
+	DirectX::XMStoreFloat4x4(&proj, projection);
+
+	float viewScale = DirectX::XMVectorGetX(DirectX::XMVector3Length(frameToView.r[0]));
+
+	bool lodsChanged = false;
+	for ( Entry& entry : entries )
+	{
+		int lod = 0;
+
+		DirectX::XMVECTOR center = DirectX::XMVector3TransformCoord(DirectX::XMVectorSet(entry.boundsCenter.x, entry.boundsCenter.y, entry.boundsCenter.z, 1.0f), frameToView);
+		float clipW = DirectX::XMVectorGetZ(center) * proj._34 + proj._44;
+		float radius = entry.boundsRadius * viewScale;
+
+		// Hulls the camera is inside of (or behind) stay at full detail
+		if ( settings.errorPixels > 0.0f && clipW > radius * std::fabs(proj._34) && clipW > 0.0f )
+		{
+			float diameterPixels = radius * proj._22 * viewportHeight / clipW;
+			while ( lod < entry.numLods-1 && diameterPixels < settings.levelPixels[lod] )
+				++lod;
+		}
+
+		if ( lod != entry.lod )
+		{
+			entry.lod = lod;
+			lodsChanged = true;
+		}
+	}
+
+	if ( lodsChanged )
+		updateRuns();
+}
+
+void PolygonBatch::setEntryBounds(Entry& entry, const MeshPrimitive* mesh, const DirectX::XMMATRIX& localToFrame)
+{
+	Vec<float> boundsMin, boundsMax;
+	mesh->getBounds(boundsMin, boundsMax);
+
+	Vec<float> center = (boundsMin + boundsMax) * 0.5f;
+	DirectX::XMVECTOR frameCenter = DirectX::XMVector3TransformCoord(DirectX::XMVectorSet(center.x, center.y, center.z, 1.0f), localToFrame);
+
+	// Largest axis scale keeps the sphere around scaled hulls
+	float scale = 0.0f;
+	for ( int i = 0; i < 3; ++i )
+		scale = std::max(scale, DirectX::XMVectorGetX(DirectX::XMVector3Length(localToFrame.r[i])));
+
+	entry.boundsCenter = Vec<float>(DirectX::XMVectorGetX(frameCenter), DirectX::XMVectorGetY(frameCenter), DirectX::XMVectorGetZ(frameCenter));
+	entry.boundsRadius = 0.5f * float((boundsMax - boundsMin).length()) * scale;
+}
+
+void PolygonBatch::updateRuns()
+{
+	for ( int i = 0; i < numBuckets; ++i )
+		buckets[i].runs.clear();
+
+	numDrawnFaces = 0;
+	numFullDetailFaces = 0;
+
+	// Entries are ordered by bucket with contiguous faces in each level, neighboring visible hulls
+	// at the same level share a draw
+	for ( const Entry& entry : entries )
+	{
+		if ( !entry.visible )
+			continue;
+
+		uint32_t firstFace = entry.firstFace[entry.lod];
+		uint32_t numLodFaces = entry.numFaces[entry.lod];
+
+		numDrawnFaces += numLodFaces;
+		numFullDetailFaces += entry.numFaces[0];
+
+		std::vector<Run>& runs = buckets[entry.bucket].runs;
+		if ( !runs.empty() && runs.back().firstFace + runs.back().numFaces == firstFace )
+		{
+			runs.back().numFaces += numLodFaces;
+			continue;
+		}
+
+		Run run;
+		run.firstFace = firstFace;
+		run.numFaces = numLodFaces;
+		runs.push_back(run);
+	}
+}
+
+void PolygonBatch::getBufferBytes(size_t& vertexBytesOut, size_t& indexBytesOut, size_t& unpackedBytesOut) const
+{
+	VertexLayout bufferLayout = layout;
+
+	size_t numVerts = vertMem.size() / bufferLayout.getVertSize();
+	size_t indexSize = (indexFormat == DXGI_FORMAT_R16_UINT) ? sizeof(uint16_t) : sizeof(uint32_t);
+
+	vertexBytesOut = (vertexBuffer) ? vertMem.size() : 0;
+	indexBytesOut = (indexBuffer) ? 3 * numFaces * indexSize : 0;
+	unpackedBytesOut = 0;
+	if ( vertexBuffer )
+		unpackedBytesOut += numVerts * bufferLayout.getUnpackedVertSize();
+	if ( indexBuffer )
+		unpackedBytesOut += 3 * numFaces * sizeof(uint32_t);
+}
+
+size_t PolygonBatch::getNumDrawCalls() const
+{
+	size_t numCalls = unbatched.size();
+	for ( int i = 0; i < numBuckets; ++i )
+		numCalls += buckets[i].runs.size();
+
+	return numCalls;
+}
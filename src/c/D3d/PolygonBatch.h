@@ -0,0 +1,147 @@
+#pragma once
+#include "Global/Vec.h"
+#include "VertexLayouts.h"
+#include "ResourceCache.h"
+
+#include <d3d11.h>
+#include <DirectXMath.h>
+
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+class Renderer;
+class SceneNode;
+class GraphicObjectNode;
+class Material;
+class PolygonMaterial;
+class MeshPrimitive;
+class NodeRegistry;
+
+// Merges all polygon hulls below a frame node into one packed vertex/index buffer.
+// Node transforms (relative to the frame node) and material colors are baked into the vertices and
+// hulls are grouped into buckets by wireframe/lighting state, so a frame draws in a handful of calls.
+// A side table keeps each hull's buffer ranges, color state and visibility: visibility changes only
+// rebuild the draw runs and color changes only re-upload that hull's vertices. Color and wireframe
+// come from the registry's packed state, lighting from the hull's material.
+// Decimated LOD levels share the hull vertices, the index buffer holds one section per level and
+// each hull's level is picked per frame from its projected size.
+class PolygonBatch
+{
+	friend class Renderer;
+
+public:
+	// Buckets are indexed by (wireframe | lightOn<<1)
+	static const int numBuckets = 4;
+
+	// Side table entry for a single hull
+	struct Entry
+	{
+		GraphicObjectNode* node;
+
+		// Material identity and version at the last bake, used to detect state changes
+		const Material* material;
+		unsigned int materialVersion;
+
+		// Slot of the hull's packed state in the polygon registry, -1 if it isn't registered
+		int registrySlot;
+
+		// Baked color state, color replaces the mesh vertex colors when useColor is set
+		Vec<float> color;
+		float alpha;
+		bool useColor;
+
+		uint32_t firstVert;
+		uint32_t numVerts;
+
+		// Face ranges for each LOD level this hull has, level 0 is the full mesh
+		uint32_t firstFace[ResourceCache::numLodLevels];
+		uint32_t numFaces[ResourceCache::numLodLevels];
+		int numLods;
+		int lod;
+
+		// Bounding sphere in frame space for picking the LOD level
+		Vec<float> boundsCenter;
+		float boundsRadius;
+
+		int bucket;
+		bool visible;
+	};
+
+	// Contiguous range of visible faces in the merged index buffer
+	struct Run
+	{
+		uint32_t firstFace;
+		uint32_t numFaces;
+	};
+
+	struct Bucket
+	{
+		std::shared_ptr<PolygonMaterial> material;
+		std::vector<Run> runs;
+	};
+
+	PolygonBatch(Renderer* renderer, SceneNode* frameNode);
+	~PolygonBatch();
+
+	// Pulls visibility and color changes from the nodes, returns false if the batch must be rebuilt
+	bool sync();
+
+	// Picks each hull's LOD level from its projected bounding sphere, frameToView includes the frame node transform
+	void selectLods(const DirectX::XMMATRIX& frameToView, const DirectX::XMMATRIX& projection, float viewportHeight,
+		const ResourceCache::LodSettings& settings);
+
+	SceneNode* getFrameNode() const {return frameNode;}
+	size_t getNumEntries() const {return entries.size();}
+	size_t getNumDrawCalls() const;
+
+	// Visible faces as currently drawn and as they would be at full detail
+	size_t getNumDrawnFaces() const {return numDrawnFaces;}
+	size_t getNumFullDetailFaces() const {return numFullDetailFaces;}
+
+	// Bytes in the merged GPU buffers, and what they would take with float attributes and 32-bit indices
+	void getBufferBytes(size_t& vertexBytesOut, size_t& indexBytesOut, size_t& unpackedBytesOut) const;
+
+	const std::vector<GraphicObjectNode*>& getUnbatchedNodes() const {return unbatched;}
+
+	// CPU merge step, fills the interleaved vertices and offset faces of every LOD level for every entry.
+	// Entries must already have their buffer ranges assigned, the work itself is done by BatchMerge.
+	static void mergeEntries(const std::vector<Entry>& entries, SceneNode* frameNode, VertexLayout layout,
+		std::vector<uint8_t>& vertMemOut, std::vector<Vec<uint32_t>>& facesOut);
+
+private:
+	PolygonBatch();
+
+	static DirectX::XMMATRIX getLocalToFrame(const GraphicObjectNode* node, const SceneNode* frameNode);
+	PolygonMaterial::State getEntryState(const Entry& entry, PolygonMaterial* material) const;
+	static void setEntryBounds(Entry& entry, const MeshPrimitive* mesh, const DirectX::XMMATRIX& localToFrame);
+
+	void build();
+	void releaseResources();
+
+	void updateRuns();
+
+	Renderer* renderer;
+	SceneNode* frameNode;
+
+	const NodeRegistry* registry;
+	uint64_t stateVersion;
+
+	std::vector<Entry> entries;
+	std::vector<GraphicObjectNode*> unbatched;
+	Bucket buckets[numBuckets];
+
+	// CPU copy of the merged vertices for partial color updates
+	std::vector<uint8_t> vertMem;
+
+	int vertShaderIdx;
+	VertexLayout layout;
+
+	size_t numFaces;
+	size_t numDrawnFaces;
+	size_t numFullDetailFaces;
+
+	ID3D11Buffer* vertexBuffer;
+	ID3D11Buffer* indexBuffer;
+	DXGI_FORMAT indexFormat;
+};
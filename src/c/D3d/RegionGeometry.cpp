@@ -0,0 +1,102 @@
+#include "RegionGeometry.h"
+
+#include <algorithm>
+
+namespace
+{
+	// Twice the signed area of abc, positive when counter-clockwise
+	inline float orient(const Vec<float>& a, const Vec<float>& b, const Vec<float>& c)
+	{
+		return (b.x - a.x) * (c.y - a.y) - (b.y - a.y) * (c.x - a.x);
+	}
+
+	// For c already known to be on the line through ab
+	inline bool onSegment(const Vec<float>& a, const Vec<float>& b, const Vec<float>& c)
+	{
+		return c.x >= std::min(a.x, b.x) && c.x <= std::max(a.x, b.x) && c.y >= std::min(a.y, b.y) && c.y <= std::max(a.y, b.y);
+	}
+
+	// Touching or collinear overlapping segments count as crossing
+	bool segmentsCross(const Vec<float>& a, const Vec<float>& b, const Vec<float>& c, const Vec<float>& d)
+	{
+		float abc = orient(a, b, c);
+		float abd = orient(a, b, d);
+		float cda = orient(c, d, a);
+		float cdb = orient(c, d, b);
+
+		if ( ((abc > 0.0f && abd < 0.0f) || (abc < 0.0f && abd > 0.0f)) && ((cda > 0.0f && cdb < 0.0f) || (cda < 0.0f && cdb > 0.0f)) )
+			return true;
+
+		return (abc == 0.0f && onSegment(a, b, c)) || (abd == 0.0f && onSegment(a, b, d))
+			|| (cda == 0.0f && onSegment(c, d, a)) || (cdb == 0.0f && onSegment(c, d, b));
+	}
+}
+
+
+bool RegionGeometry::insideRegion(const Vec<float>* region, size_t numRegion, float x, float y)
+{
+	bool inside = false;
+	for ( size_t i = 0, j = numRegion - 1; i < numRegion; j = i++ )
+	{
+		const Vec<float>& a = region[i];
+		const Vec<float>& b = region[j];
+
+		if ( (a.y > y) != (b.y > y) )
+		{
+			float crossX = a.x + (y - a.y) * (b.x - a.x) / (b.y - a.y);
+			if ( x < crossX )
+				inside = !inside;
+		}
+	}
+
+	return inside;
+}
+
+bool RegionGeometry::polygonTouchesRegion(const Vec<float>* poly, size_t numPoly, const Vec<float>* region, size_t numRegion)
+{
+	for ( size_t i = 0; i < numPoly; ++i )
+	{
+		if ( insideRegion(region, numRegion, poly[i].x, poly[i].y) )
+			return true;
+	}
+
+	// With no edges crossing, the region is either all inside the polygon or all outside
+	if ( insideRegion(poly, numPoly, region[0].x, region[0].y) )
+		return true;
+
+	for ( size_t i = 0, j = numPoly - 1; i < numPoly; j = i++ )
+	{
+		for ( size_t k = 0, l = numRegion - 1; k < numRegion; l = k++ )
+		{
+			if ( segmentsCross(poly[j], poly[i], region[l], region[k]) )
+				return true;
+		}
+	}
+
+	return false;
+}
+
+size_t RegionGeometry::clipTriangleToScreen(const Vec<float> clipPos[3], Vec<int> viewSize, Vec<float> screenOut[4])
+{
+	// Sutherland-Hodgman against the single plane w = minClipW
+	size_t numOut = 0;
+	for ( int i = 0; i < 3; ++i )
+	{
+		const Vec<float>& cur = clipPos[i];
+		const Vec<float>& next = clipPos[(i + 1) % 3];
+
+		bool curIn = (cur.z >= minClipW);
+		bool nextIn = (next.z >= minClipW);
+
+		if ( curIn )
+			screenOut[numOut++] = clipToScreen(cur, viewSize);
+
+		if ( curIn != nextIn )
+		{
+			float t = (minClipW - cur.z) / (next.z - cur.z);
+			screenOut[numOut++] = clipToScreen(cur + (next - cur) * t, viewSize);
+		}
+	}
+
+	return numOut;
+}
@@ -0,0 +1,28 @@
+#pragma once
+#include "Global/Vec.h"
+
+#include <cstddef>
+
+// 2D tests behind region selection, in window pixels (only x and y are used).
+// Regions are closed polygons that may be concave or self intersecting, they are filled by the even-odd rule.
+namespace RegionGeometry
+{
+	// Clip space w below this is treated as behind the camera
+	const float minClipW = 1.0e-5f;
+
+	bool insideRegion(const Vec<float>* region, size_t numRegion, float x, float y);
+
+	// True if the convex polygon overlaps the region: one of its corners is inside the region,
+	// the region lies inside it, or their edges cross
+	bool polygonTouchesRegion(const Vec<float>* poly, size_t numPoly, const Vec<float>* region, size_t numRegion);
+
+	// Clips a triangle given as clip space (x, y, w) to the part in front of the camera (w >= minClipW)
+	// and maps it to window pixels. Returns the number of points written to screenOut, 0, 3 or 4.
+	size_t clipTriangleToScreen(const Vec<float> clipPos[3], Vec<int> viewSize, Vec<float> screenOut[4]);
+
+	inline Vec<float> clipToScreen(const Vec<float>& clipPos, Vec<int> viewSize)
+	{
+		float invW = 1.0f / clipPos.z;
+		return Vec<float>((clipPos.x * invW + 1.0f) * 0.5f * viewSize.x, (1.0f - clipPos.y * invW) * 0.5f * viewSize.y, 0.0f);
+	}
+}
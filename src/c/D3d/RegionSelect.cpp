@@ -0,0 +1,330 @@
+#include "RegionSelect.h"
+#include "Camera.h"
+#include "SceneNode.h"
+#include "MeshPrimitive.h"
+#include "RegionGeometry.h"
+
+#include "Global/Arena.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <limits>
+
+#undef min
+#undef max
+
+const float RegionSelector::cellSize = 32.0f;
+
+
+RegionSelector::RegionSelector()
+	: valid(false), cachedFrame(0), cachedVersion(0)
+{}
+
+std::vector<int> RegionSelector::select(const NodeRegistry& polygons, SceneNode* frameNode, unsigned int frame, unsigned int sceneVersion,
+	const Camera* camera, const std::vector<Vec<float>>& regionIn, bool touching)
+{
+	std::vector<int> selected;
+	if ( !frameNode || !camera || regionIn.size() < 2 )
+		return selected;
+
+	DirectX::XMMATRIX viewProj = DirectX::XMMatrixMultiply(camera->getViewTransform(), camera->getProjectionTransform());
+	DirectX::XMFLOAT4X4 viewProjF;
+	DirectX::XMStoreFloat4x4(&viewProjF, viewProj);
+
+	Vec<int> viewSize = camera->getViewportSize();
+	if ( !isCacheValid(frame, sceneVersion, viewProjF, viewSize) )
+	{
+		buildIndex(polygons, frameNode, viewProj, viewSize);
+
+		cachedFrame = frame;
+		cachedVersion = sceneVersion;
+		cachedViewProj = viewProjF;
+		valid = true;
+	}
+
+	std::vector<Vec<float>> region = closeRegion(regionIn);
+
+	Vec<float> regionMin = region[0];
+	Vec<float> regionMax = region[0];
+	for ( int i = 1; i < region.size(); ++i )
+	{
+		regionMin = Vec<float>::min(regionMin, region[i]);
+		regionMax = Vec<float>::max(regionMax, region[i]);
+	}
+
+	// Only visit grid cells overlapping the region bounds
+	int minCellX = std::max(0, std::min(gridDims.x - 1, int(regionMin.x / cellSize)));
+	int maxCellX = std::max(0, std::min(gridDims.x - 1, int(regionMax.x / cellSize)));
+	int minCellY = std::max(0, std::min(gridDims.y - 1, int(regionMin.y / cellSize)));
+	int maxCellY = std::max(0, std::min(gridDims.y - 1, int(regionMax.y / cellSize)));
+
+	std::vector<bool> picked(nodes.size(), false);
+	for ( int y = minCellY; y <= maxCellY; ++y )
+	{
+		for ( int x = minCellX; x <= maxCellX; ++x )
+		{
+			int cell = x + y*gridDims.x;
+			for ( uint32_t i = cellStart[cell]; i < cellStart[cell + 1]; ++i )
+			{
+				uint32_t entry = cellEntries[i];
+				if ( !nodes[entry]->isRenderable() )
+					continue;
+
+				const Vec<float>& pos = screenCenters[entry];
+				if ( pos.x < regionMin.x || pos.x > regionMax.x || pos.y < regionMin.y || pos.y > regionMax.y )
+					continue;
+
+				if ( RegionGeometry::insideRegion(region.data(), region.size(), pos.x, pos.y) )
+					picked[entry] = true;
+			}
+		}
+	}
+
+	if ( touching )
+	{
+		for ( int i = 0; i < nodes.size(); ++i )
+		{
+			// A polygon whose centroid is behind the camera can still have triangles in front of it
+			if ( picked[i] || !nodes[i]->isRenderable() )
+				continue;
+
+			// Cheap rejection on the projected bounding box before testing individual triangles
+			const Vec<float>& boxMin = screenBoxes[0][i];
+			const Vec<float>& boxMax = screenBoxes[1][i];
+			if ( boxMax.x < regionMin.x || boxMin.x > regionMax.x || boxMax.y < regionMin.y || boxMin.y > regionMax.y )
+				continue;
+
+			picked[i] = touchesRegion(nodes[i], viewProj, region, regionMin, regionMax);
+		}
+	}
+
+	for ( int i = 0; i < nodes.size(); ++i )
+	{
+		if ( picked[i] )
+			selected.push_back(nodes[i]->getIndex());
+	}
+
+	std::sort(selected.begin(), selected.end());
+
+	return selected;
+}
+
+bool RegionSelector::isCacheValid(unsigned int frame, unsigned int sceneVersion, const DirectX::XMFLOAT4X4& viewProj, Vec<int> viewSize)
+{
+	if ( !valid )
+		return false;
+
+	if ( frame != cachedFrame || sceneVersion != cachedVersion || viewSize != cachedViewSize )
+		return false;
+
+	return (memcmp(&viewProj, &cachedViewProj, sizeof(DirectX::XMFLOAT4X4)) == 0);
+}
+
+void RegionSelector::buildIndex(const NodeRegistry& polygons, SceneNode* frameNode, const DirectX::XMMATRIX& viewProj, Vec<int> viewSize)
+{
+	cachedViewSize = viewSize;
+
+	nodes.clear();
+	screenCenters.clear();
+	screenBoxes[0].clear();
+	screenBoxes[1].clear();
+	inFront.clear();
+
+	// Only keep polygons that are attached somewhere below the current frame's node
+	for ( GraphicObjectNode* node : polygons )
+	{
+		SceneNode* parent = node->getParentNode();
+		while ( parent && parent != frameNode )
+			parent = parent->getParentNode();
+
+		if ( parent == frameNode )
+			nodes.push_back(node);
+	}
+
+	screenCenters.resize(nodes.size());
+	screenBoxes[0].resize(nodes.size());
+	screenBoxes[1].resize(nodes.size());
+	inFront.resize(nodes.size());
+
+	for ( int i = 0; i < nodes.size(); ++i )
+	{
+		const std::shared_ptr<MeshPrimitive>& mesh = nodes[i]->getMesh();
+
+		// Project the centroid and the bounding box corners in one stream
+		DirectX::XMFLOAT3 points[9];
+		Vec<float> center = mesh->getCenterOfMass();
+		Vec<float> bounds[2];
+		mesh->getBounds(bounds[0], bounds[1]);
+
+		points[0] = DirectX::XMFLOAT3(center.x, center.y, center.z);
+		for ( int c = 0; c < 8; ++c )
+			points[c + 1] = DirectX::XMFLOAT3(bounds[c & 1].x, bounds[(c >> 1) & 1].y, bounds[(c >> 2) & 1].z);
+
+		DirectX::XMFLOAT4 projected[9];
+		DirectX::XMMATRIX toClip = DirectX::XMMatrixMultiply(nodes[i]->getLocalToWorld(), viewProj);
+		DirectX::XMVector3TransformStream(projected, sizeof(DirectX::XMFLOAT4), points, sizeof(DirectX::XMFLOAT3), 9, toClip);
+
+		// Centroids behind the camera can't be selected
+		inFront[i] = (projected[0].w > 0.0f);
+		screenCenters[i] = toScreen(projected[0]);
+
+		Vec<float> boxMin(std::numeric_limits<float>::max());
+		Vec<float> boxMax(-std::numeric_limits<float>::max());
+		for ( int c = 1; c < 9; ++c )
+		{
+			if ( projected[c].w <= 0.0f )
+			{
+				// Box crosses the camera plane, treat it as covering the whole view
+				boxMin = Vec<float>(-std::numeric_limits<float>::max());
+				boxMax = Vec<float>(std::numeric_limits<float>::max());
+				break;
+			}
+
+			Vec<float> corner = toScreen(projected[c]);
+			boxMin = Vec<float>::min(boxMin, corner);
+			boxMax = Vec<float>::max(boxMax, corner);
+		}
+
+		screenBoxes[0][i] = boxMin;
+		screenBoxes[1][i] = boxMax;
+	}
+
+	// Bucket the projected centroids into grid cells (counting sort)
+	gridDims = Vec<int>(std::max(1, int(std::ceil(viewSize.x / cellSize))), std::max(1, int(std::ceil(viewSize.y / cellSize))), 1);
+
+	std::vector<int> entryCell(nodes.size(), -1);
+	cellStart.assign(gridDims.x*gridDims.y + 1, 0);
+	for ( int i = 0; i < nodes.size(); ++i )
+	{
+		if ( !inFront[i] )
+			continue;
+
+		int x = std::max(0, std::min(gridDims.x - 1, int(screenCenters[i].x / cellSize)));
+		int y = std::max(0, std::min(gridDims.y - 1, int(screenCenters[i].y / cellSize)));
+
+		entryCell[i] = x + y*gridDims.x;
+		++cellStart[entryCell[i] + 1];
+	}
+
+	for ( int i = 1; i < cellStart.size(); ++i )
+		cellStart[i] += cellStart[i - 1];
+
+	std::vector<uint32_t> fill(cellStart.begin(), cellStart.end() - 1);
+	cellEntries.resize(cellStart.back());
+	for ( int i = 0; i < nodes.size(); ++i )
+	{
+		if ( entryCell[i] < 0 )
+			continue;
+
+		cellEntries[fill[entryCell[i]]++] = i;
+	}
+}
+
+bool RegionSelector::touchesRegion(GraphicObjectNode* node, const DirectX::XMMATRIX& viewProj, const std::vector<Vec<float>>& region,
+	Vec<float> regionMin, Vec<float> regionMax)
+{
+	const std::vector<Vec<float>>& verts = node->getMesh()->getVertices();
+	const std::vector<Vec<uint32_t>>& faces = node->getMesh()->getFaces();
+	if ( verts.empty() )
+		return false;
+
+	DirectX::XMMATRIX toClip = DirectX::XMMatrixMultiply(node->getLocalToWorld(), viewProj);
+
+	Arena& scratch = Arena::threadScratch();
+	Arena::Scope scratchScope(scratch);
+
+	// Clip space (x, y, w) and window position of every vertex, faces look both up by index
+	Vec<float>* clipPos = scratch.allocArray<Vec<float>>(verts.size());
+	Vec<float>* screenPos = scratch.allocArray<Vec<float>>(verts.size());
+
+	// Vec<float> is three packed floats so it can be streamed directly
+	const size_t chunkSize = 256;
+	DirectX::XMFLOAT4 projected[chunkSize];
+	for ( size_t start = 0; start < verts.size(); start += chunkSize )
+	{
+		size_t count = std::min(chunkSize, verts.size() - start);
+		DirectX::XMVector3TransformStream(projected, sizeof(DirectX::XMFLOAT4), (const DirectX::XMFLOAT3*)verts[start].e, sizeof(Vec<float>), count, toClip);
+
+		for ( size_t i = 0; i < count; ++i )
+		{
+			Vec<float> clip(projected[i].x, projected[i].y, projected[i].w);
+			clipPos[start + i] = clip;
+
+			if ( clip.z < RegionGeometry::minClipW )
+				continue;
+
+			// A vertex inside settles it without looking at any triangle
+			Vec<float> pos = RegionGeometry::clipToScreen(clip, cachedViewSize);
+			if ( RegionGeometry::insideRegion(region.data(), region.size(), pos.x, pos.y) )
+				return true;
+
+			screenPos[start + i] = pos;
+		}
+	}
+
+	// Triangles can still cross the region with all of their vertices outside it, or hold the whole region
+	for ( const Vec<uint32_t>& face : faces )
+	{
+		Vec<float> tri[4];
+		size_t numPoints = 3;
+
+		const Vec<float>* clipTri[3] = {&clipPos[face.x], &clipPos[face.y], &clipPos[face.z]};
+		if ( clipTri[0]->z >= RegionGeometry::minClipW && clipTri[1]->z >= RegionGeometry::minClipW && clipTri[2]->z >= RegionGeometry::minClipW )
+		{
+			tri[0] = screenPos[face.x];
+			tri[1] = screenPos[face.y];
+			tri[2] = screenPos[face.z];
+		}
+		else
+		{
+			Vec<float> clipCorners[3] = {*clipTri[0], *clipTri[1], *clipTri[2]};
+			numPoints = RegionGeometry::clipTriangleToScreen(clipCorners, cachedViewSize, tri);
+			if ( numPoints == 0 )
+				continue;
+		}
+
+		Vec<float> triMin = tri[0];
+		Vec<float> triMax = tri[0];
+		for ( size_t i = 1; i < numPoints; ++i )
+		{
+			triMin = Vec<float>::min(triMin, tri[i]);
+			triMax = Vec<float>::max(triMax, tri[i]);
+		}
+
+		if ( triMax.x < regionMin.x || triMin.x > regionMax.x || triMax.y < regionMin.y || triMin.y > regionMax.y )
+			continue;
+
+		if ( RegionGeometry::polygonTouchesRegion(tri, numPoints, region.data(), region.size()) )
+			return true;
+	}
+
+	return false;
+}
+
+Vec<float> RegionSelector::toScreen(const DirectX::XMFLOAT4& clipPos) const
+{
+	float invW = 1.0f / clipPos.w;
+
+	Vec<float> pos;
+	pos.x = (clipPos.x * invW + 1.0f) * 0.5f * cachedViewSize.x;
+	pos.y = (1.0f - clipPos.y * invW) * 0.5f * cachedViewSize.y;
+	pos.z = clipPos.z * invW;
+
+	return pos;
+}
+
+std::vector<Vec<float>> RegionSelector::closeRegion(const std::vector<Vec<float>>& region)
+{
+	if ( region.size() != 2 )
+		return region;
+
+	// Expand rectangle corners into a closed region
+	std::vector<Vec<float>> rect(4);
+	rect[0] = Vec<float>(region[0].x, region[0].y, 0.0f);
+	rect[1] = Vec<float>(region[1].x, region[0].y, 0.0f);
+	rect[2] = Vec<float>(region[1].x, region[1].y, 0.0f);
+	rect[3] = Vec<float>(region[0].x, region[1].y, 0.0f);
+
+	return rect;
+}
@@ -0,0 +1,58 @@
+#pragma once
+#include "Global/Vec.h"
+
+#include <DirectXMath.h>
+
+#include <cstdint>
+#include <vector>
+
+class Camera;
+class SceneNode;
+class GraphicObjectNode;
+class NodeRegistry;
+
+// Screen-space selection of polygons by rectangle or lasso region.
+// Projected centroids are bucketed into a uniform pixel grid which is only rebuilt when the
+// frame, scene graph or camera changes, so repeated queries while dragging stay cheap.
+class RegionSelector
+{
+public:
+	RegionSelector();
+
+	void invalidate(){ valid = false; }
+
+	// The region is a closed polygon in window pixel coordinates, two points are treated as opposite rectangle corners.
+	// If touching is set a polygon is also selected when any of its triangles overlap the region,
+	// the parts of triangles behind the camera are clipped off.
+	std::vector<int> select(const NodeRegistry& polygons, SceneNode* frameNode, unsigned int frame, unsigned int sceneVersion,
+		const Camera* camera, const std::vector<Vec<float>>& region, bool touching);
+
+private:
+	static const float cellSize;
+
+	bool isCacheValid(unsigned int frame, unsigned int sceneVersion, const DirectX::XMFLOAT4X4& viewProj, Vec<int> viewSize);
+	void buildIndex(const NodeRegistry& polygons, SceneNode* frameNode, const DirectX::XMMATRIX& viewProj, Vec<int> viewSize);
+
+	bool touchesRegion(GraphicObjectNode* node, const DirectX::XMMATRIX& viewProj, const std::vector<Vec<float>>& region,
+		Vec<float> regionMin, Vec<float> regionMax);
+	Vec<float> toScreen(const DirectX::XMFLOAT4& clipPos) const;
+
+	static std::vector<Vec<float>> closeRegion(const std::vector<Vec<float>>& region);
+
+	bool valid;
+	unsigned int cachedFrame;
+	unsigned int cachedVersion;
+	Vec<int> cachedViewSize;
+	DirectX::XMFLOAT4X4 cachedViewProj;
+
+	// Per-polygon projection results for the cached frame
+	std::vector<GraphicObjectNode*> nodes;
+	std::vector<Vec<float>> screenCenters;
+	std::vector<Vec<float>> screenBoxes[2];
+	std::vector<bool> inFront;
+
+	// Uniform grid stored in counting-sort order, cellStart has one extra entry
+	Vec<int> gridDims;
+	std::vector<uint32_t> cellStart;
+	std::vector<uint32_t> cellEntries;
+};
@@ -18,16 +18,20 @@
 #include "Material.h"
 #include "MaterialParams.h"
 #include "Camera.h"
-#include "Timer.h"
 #include "RenderTarget.h"
 #include "DepthTarget.h"
 #include "VolumeInfo.h"
 #include "TextRenderer.h"
+#include "RegionSelect.h"
+#include "ResourceCache.h"
+#include "PolygonBatch.h"
+#include "VertexPacking.h"
 
 #include "Global/Defines.h"
 #include "Global/Globals.h"
 
 #include "Global/ErrorMsg.h"
+#include "Global/Profiler.h"
 
 #include <d3dcompiler.h>
 #include <Windows.h>
@@ -45,8 +49,15 @@ Renderer::Renderer()
 {
 	textRenderer = NULL;
 	volInfo = NULL;
+	regionSelector = new RegionSelector();
+	resourceCache = new ResourceCache(this);
+	polygonBatchVersion = 0;
+	polygonFacesDrawn = 0;
+	polygonFacesFull = 0;
 
 	fallbackPS = NULL;
+	previousVertexShader = NULL;
+	previousPixelShader = NULL;
 
 	isDirty = true;
 	isRendering = false;
@@ -65,19 +76,6 @@ Renderer::Renderer()
 	captureFilePath = "./";
 	captureFileName = "";
 	dllRoot = "";
-
-	for(int i = 0; i<NUM_TIMES; ++i)
-	{
-		frameTimes[i] = 0;
-		startTimes[i] = 0;
-		preTimes  [i] = 0;
-		mainTimes [i] = 0;
-		postTimes [i] = 0;
-		gdiTimes  [i] = 0;
-		endTimes  [i] = 0;
-	}
-
-	curTimeIdx = 0;
 }
 
 Renderer::~Renderer()
@@ -85,6 +83,9 @@ Renderer::~Renderer()
 	SAFE_DELETE(volInfo);
 	SAFE_DELETE(rootScene);
 	SAFE_DELETE(textRenderer);
+	SAFE_DELETE(regionSelector);
+	clearPolygonBatches();
+	SAFE_DELETE(resourceCache);
 
 	clearVertexShaderList();
 	clearPixelShaderList();
@@ -290,7 +291,8 @@ HRESULT Renderer::createVertexBuffer(UINT accessFlags, D3D11_USAGE usage, size_t
 	return result;
 }
 
-HRESULT Renderer::createIndexBuffer(UINT accessFlags, D3D11_USAGE usage, const std::vector<Vec<unsigned int>>& faces, ID3D11Buffer** indexBufferOut)
+HRESULT Renderer::createIndexBuffer(UINT accessFlags, D3D11_USAGE usage, const std::vector<Vec<unsigned int>>& faces, ID3D11Buffer** indexBufferOut,
+	DXGI_FORMAT* formatOut)
 {
 	//WaitForSingleObject(mutexDevice,INFINITE);
 	if (faces.size()==0)
@@ -307,6 +309,20 @@ HRESULT Renderer::createIndexBuffer(UINT accessFlags, D3D11_USAGE usage, const s
 	indexBufferDesc.StructureByteStride = 0;
 
 	indexData.pSysMem = faces.data();
+
+	// Callers that can take either format get 16-bit indices whenever every vertex index fits
+	std::vector<uint16_t> shortIndices;
+	if ( formatOut )
+	{
+		*formatOut = DXGI_FORMAT_R32_UINT;
+		if ( VertexPacking::packIndices16(faces, shortIndices) )
+		{
+			*formatOut = DXGI_FORMAT_R16_UINT;
+			indexBufferDesc.ByteWidth = (unsigned int)(sizeof(uint16_t) * shortIndices.size());
+			indexData.pSysMem = shortIndices.data();
+		}
+	}
+
 	indexData.SysMemPitch = 0;
 	indexData.SysMemSlicePitch = 0;
 
@@ -347,6 +363,19 @@ void Renderer::releaseBuffer(ID3D11Buffer* buffer)
 	renderContext->Unmap(buffer, 0);
 }
 
+void Renderer::updateBufferRegion(ID3D11Buffer* buffer, size_t byteOffset, size_t byteSize, const void* data)
+{
+	D3D11_BOX region;
+	region.left = (UINT)byteOffset;
+	region.right = (UINT)(byteOffset + byteSize);
+	region.top = 0;
+	region.bottom = 1;
+	region.front = 0;
+	region.back = 1;
+
+	renderContext->UpdateSubresource(buffer, 0, &region, data, 0, 0);
+}
+
 void Renderer::updateShaderParams(const void* params, ID3D11Buffer* buffer)
 {
 	renderContext->UpdateSubresource(buffer,0,NULL,params,0,0);
@@ -698,46 +727,44 @@ void Renderer::renderUpdate()
 
 void Renderer::renderAll(TargetChains renderChain)
 {
+	PROFILE_ZONE("Frame");
+
 	static int counter = 0;
 
-	UINT64 frameTime = GetTimeMs64();
+	frameStats.beginFrame();
 	//rootScene->updateRenderableList();
 
-	UINT64 startTime = GetTimeMs64();
 	startRender(renderChain);
-	startTimes[curTimeIdx] = GetTimeMs64()-startTime;
+	frameStats.markStage(FrameStats::Start);
 
-	UINT64 preTime = GetTimeMs64();
 	renderBackground(renderChain);
-	preTimes[curTimeIdx] = GetTimeMs64()-preTime;
+	frameStats.markStage(FrameStats::Background);
 
 	// Clear depth target before rendering polygons and volume data
 	clearDepthTarget(renderChain, DepthTargetTypes::DefaultDT, 1.0f);
 
-	UINT64 mainTime = GetTimeMs64();
 	renderPolygons(renderChain);
 	renderVolume(renderChain);
-	mainTimes[curTimeIdx] = GetTimeMs64()-mainTime;
+	frameStats.markStage(FrameStats::Main);
 
 	// And again before rendering the widget
 	clearDepthTarget(renderChain, DepthTargetTypes::DefaultDT, 1.0f);
 
-	UINT64 postTime = GetTimeMs64();
 	renderWidget(renderChain);
-	postTimes[curTimeIdx] = GetTimeMs64()-postTime;
+	frameStats.markStage(FrameStats::Widget);
 
-	UINT64 gdiTime = GetTimeMs64();
 	renderTextOverlays(renderChain);
-	gdiTimes[curTimeIdx] = GetTimeMs64()-gdiTime;
+	frameStats.markStage(FrameStats::Overlay);
 
-	UINT64 endTime = GetTimeMs64();
 	endRender(renderChain);
-	endTimes[curTimeIdx] = GetTimeMs64()-endTime;
+	frameStats.markStage(FrameStats::Present);
 
-	frameTimes[curTimeIdx] = GetTimeMs64()-frameTime;
-	++curTimeIdx;
-	if ( curTimeIdx >= NUM_TIMES )
-		curTimeIdx = 0;
+	FrameStats::Alert alert;
+	if ( frameStats.endFrame(alert) )
+	{
+		std::vector<double> values = {alert.frameMs, alert.budgetMs, double(alert.numFrames), double(alert.slowestStage + 1), alert.slowestStageMs};
+		gMsgQueueToMex.addEvent(EventFrameOverBudget, values);
+	}
 }
 
 void Renderer::attachToRootScene(SceneNode* sceneIn, Section section,int frame)
@@ -752,15 +779,10 @@ void Renderer::removeSceneObjects(GraphicObjectTypes type)
 
 GraphicObjectNode* Renderer::findSceneObject(GraphicObjectTypes type, int index)
 {
-	std::map<int, GraphicObjectNode*>& sceneObjects = rootScene->sceneObjectRegistry(type);
-
-	if ( sceneObjects.count(index) == 0 )
-		return NULL;
-
-	return sceneObjects[index];
+	return rootScene->sceneObjectRegistry(type).find(index);
 }
 
-std::map<int, GraphicObjectNode*>& Renderer::allSceneObjects(GraphicObjectTypes type)
+NodeRegistry& Renderer::allSceneObjects(GraphicObjectTypes type)
 {
 	return rootScene->sceneObjectRegistry(type);
 }
@@ -806,6 +828,8 @@ void Renderer::clearDepthTarget(TargetChains chain, DepthTargetTypes dt, float c
 
 void Renderer::renderBackground(TargetChains chain)
 {
+	PROFILE_ZONE("RenderBackground");
+
 	SceneNode* preRoot = rootScene->getRenderSectionNode(Renderer::Section::Pre, 0);
 	if ( !preRoot )
 		return;
@@ -819,19 +843,152 @@ void Renderer::renderBackground(TargetChains chain)
 
 void Renderer::renderPolygons(TargetChains chain)
 {
+	PROFILE_ZONE("RenderPolygons");
+
+	polygonFacesDrawn = 0;
+	polygonFacesFull = 0;
+
 	SceneNode* mainRoot = rootScene->getRenderSectionNode(Renderer::Section::Main, currentFrame);
 	if ( !mainRoot )
 		return;
 
-	RenderFilter renderFilter(mainRoot, GraphicObjectTypes::Polygons);
+	PolygonBatch* batch = getPolygonBatch(mainRoot, currentFrame);
 
-	GraphicObjectNode* node = renderFilter.first();
-	for ( ; node != NULL; node = renderFilter.next() )
+	// Hulls that are small on screen draw from their decimated levels
+	{
+		PROFILE_ZONE("SelectLods");
+		batch->selectLods(mainRoot->getLocalToWorldTransform() * gCameraDefaultMesh->getViewTransform(), gCameraDefaultMesh->getProjectionTransform(),
+			float(gCameraDefaultMesh->getViewportSize().y), resourceCache->getLodSettings());
+	}
+
+	renderPolygonBatch(gCameraDefaultMesh, batch, FrontClipPos(), BackClipPos());
+
+	polygonFacesDrawn += batch->getNumDrawnFaces();
+	polygonFacesFull += batch->getNumFullDetailFaces();
+
+	// Hulls that can't share the merged buffers are still drawn on their own, from their materials
+	NodeRegistry& registry = allSceneObjects(GraphicObjectTypes::Polygons);
+	const std::vector<GraphicObjectNode*>& unbatched = batch->getUnbatchedNodes();
+	for ( GraphicObjectNode* node : unbatched )
+	{
+		if ( !node->isRenderable() )
+			continue;
+
+		registry.resolveMaterial(node);
 		renderNode(gCameraDefaultMesh, node, FrontClipPos(), BackClipPos());
+
+		polygonFacesDrawn += node->getMesh()->getFaces().size();
+		polygonFacesFull += node->getMesh()->getFaces().size();
+	}
+}
+
+PolygonBatch* Renderer::getPolygonBatch(SceneNode* frameNode, unsigned int frame)
+{
+	if ( polygonBatchVersion != rootScene->getStructureVersion() )
+	{
+		clearPolygonBatches();
+		polygonBatchVersion = rootScene->getStructureVersion();
+	}
+
+	auto it = polygonBatches.find(frame);
+	if ( it != polygonBatches.end() )
+	{
+		if ( it->second->getFrameNode() == frameNode && it->second->sync() )
+			return it->second;
+
+		delete it->second;
+		polygonBatches.erase(it);
+	}
+
+	// Drop the batch furthest from this frame to bound the duplicated buffer memory
+	if ( polygonBatches.size() >= maxPolygonBatches )
+	{
+		auto furthest = polygonBatches.begin();
+		for ( auto check = polygonBatches.begin(); check != polygonBatches.end(); ++check )
+		{
+			unsigned int checkDist = (check->first > frame) ? (check->first - frame) : (frame - check->first);
+			unsigned int furthestDist = (furthest->first > frame) ? (furthest->first - frame) : (frame - furthest->first);
+			if ( checkDist > furthestDist )
+				furthest = check;
+		}
+
+		delete furthest->second;
+		polygonBatches.erase(furthest);
+	}
+
+	PROFILE_ZONE("BuildPolygonBatch");
+
+	// Meshes added since the last build get their LOD levels before being merged
+	resourceCache->updateLods();
+
+	PolygonBatch* batch = new PolygonBatch(this, frameNode);
+	polygonBatches[frame] = batch;
+
+	return batch;
+}
+
+void Renderer::getBufferMemory(std::vector<BufferMemory>& memoryOut)
+{
+	static const char* typeNames[GraphicObjectTypes::NumGO] = {"Group", "Widget", "Polygons", "Border", "Text", "OriginalVolume", "ProcessedVolume"};
+
+	memoryOut.clear();
+	for ( int i = GraphicObjectTypes::Widget; i < GraphicObjectTypes::NumGO; ++i )
+	{
+		BufferMemory memory = {typeNames[i], 0, 0, 0, 0, 0};
+
+		// Shared meshes are only counted once
+		std::set<const MeshPrimitive*> counted;
+
+		NodeRegistry& registry = allSceneObjects((GraphicObjectTypes)i);
+		for ( GraphicObjectNode* node : registry )
+		{
+			++memory.objects;
+
+			const MeshPrimitive* mesh = node->getMesh().get();
+			if ( !mesh || !counted.insert(mesh).second )
+				continue;
+
+			size_t vertexBytes, indexBytes, unpackedBytes;
+			mesh->getBufferBytes(vertexBytes, indexBytes, unpackedBytes);
+
+			++memory.buffers;
+			memory.vertexBytes += vertexBytes;
+			memory.indexBytes += indexBytes;
+			memory.unpackedBytes += unpackedBytes;
+		}
+
+		memoryOut.push_back(memory);
+	}
+
+	// Merged buffers are held on top of the polygon meshes
+	BufferMemory batchMemory = {"PolygonBatches", 0, 0, 0, 0, 0};
+	for ( auto& it : polygonBatches )
+	{
+		size_t vertexBytes, indexBytes, unpackedBytes;
+		it.second->getBufferBytes(vertexBytes, indexBytes, unpackedBytes);
+
+		batchMemory.objects += it.second->getNumEntries();
+		++batchMemory.buffers;
+		batchMemory.vertexBytes += vertexBytes;
+		batchMemory.indexBytes += indexBytes;
+		batchMemory.unpackedBytes += unpackedBytes;
+	}
+
+	memoryOut.push_back(batchMemory);
+}
+
+void Renderer::clearPolygonBatches()
+{
+	for ( auto& it : polygonBatches )
+		delete it.second;
+
+	polygonBatches.clear();
 }
 
 void Renderer::renderVolume(TargetChains chain)
 {
+	PROFILE_ZONE("RenderVolume");
+
 	SceneNode* mainRoot = rootScene->getRenderSectionNode(Renderer::Section::Main, currentFrame);
 	if ( !mainRoot )
 		return;
@@ -846,6 +1003,8 @@ void Renderer::renderVolume(TargetChains chain)
 
 void Renderer::renderWidget(TargetChains chain)
 {
+	PROFILE_ZONE("RenderWidget");
+
 	SceneNode* postRoot = rootScene->getRenderSectionNode(Renderer::Section::Post, 0);
 	if ( !postRoot )
 		return;
@@ -859,6 +1018,8 @@ void Renderer::renderWidget(TargetChains chain)
 
 void Renderer::renderTextOverlays(TargetChains chain)
 {
+	PROFILE_ZONE("RenderTextOverlays");
+
 	if ( labelsOn )
 	{
 		SceneNode* mainRoot = rootScene->getRenderSectionNode(Renderer::Section::Main, currentFrame);
@@ -866,10 +1027,15 @@ void Renderer::renderTextOverlays(TargetChains chain)
 			return;
 
 		RenderFilter renderFilter(mainRoot, GraphicObjectTypes::Polygons);
+		NodeRegistry& registry = allSceneObjects(GraphicObjectTypes::Polygons);
 
+		// Label backgrounds use the material color
 		GraphicObjectNode* node = renderFilter.first();
 		for ( ; node != NULL; node = renderFilter.next() )
+		{
+			registry.resolveMaterial(node);
 			renderLabel(chain, gCameraDefaultMesh, node);
+		}
 	}
 
 	if ( scaleBarOn )
@@ -886,6 +1052,8 @@ void Renderer::renderTextOverlays(TargetChains chain)
 
 void Renderer::startRender(TargetChains chain)
 {
+	PROFILE_ZONE("StartRender");
+
 	if ( lastChain != chain )
 		resetViewPort(chain);
 
@@ -902,6 +1070,8 @@ void Renderer::startRender(TargetChains chain)
 
 void Renderer::endRender(TargetChains chain)
 {
+	PROFILE_ZONE("EndRender");
+
 	if ( chain == TargetChains::Screen )
 		getSwapChain()->present(0,0);
 
@@ -1039,9 +1209,6 @@ ID3DBlob* Renderer::compileShaderFile(const std::string& filename, const std::st
 
 void Renderer::renderNode(const Camera* camera, const GraphicObjectNode* node, float frontClip, float backClip)
 {
-	static ID3D11VertexShader* previousVertexShader = NULL;
-	static ID3D11PixelShader* previousPixelShader = NULL;
-
 	const VertexShaderEntry& vsEntry = vertexShaderRegistry[node->mesh->vertShaderIdx];
 	const PixelShaderEntry& psEntry = pixelShaderRegistry[node->material->shaderIdx];
 
@@ -1061,6 +1228,7 @@ void Renderer::renderNode(const Camera* camera, const GraphicObjectNode* node, f
 	vcb.worldTransform = DirectX::XMMatrixTranspose(node->getLocalToWorld());
 	vcb.depthPeelPlanes.x = frontClip;
 	vcb.depthPeelPlanes.y = backClip;
+	setPositionDecode(vcb, node->mesh->layout);
 	updateShaderParams(&vcb,vertexShaderConstBuffer);
 
 	if ( previousVertexShader != vertShader )
@@ -1069,17 +1237,21 @@ void Renderer::renderNode(const Camera* camera, const GraphicObjectNode* node, f
 		previousVertexShader = vertShader;
 	}
 
-	setGeometry(node->mesh->layout, node->mesh->vertexBuffer, node->mesh->indexBuffer);
+	setGeometry(node->mesh->layout, node->mesh->vertexBuffer, node->mesh->indexBuffer, node->mesh->indexFormat);
 
 
 	// Material and pixel shader setup
 
 	//Pixel Shader setup
-	node->material->updateTransformParams(node->getLocalToWorldTransform(), camera->getViewTransform(), camera->getProjectionTransform());
-	node->material->getParams()->updateParams(); //can be sped up by doing this differently
-	
-	node->material->bindTextures();
-	node->material->bindConstants(); //TODO this needs tweeking
+	{
+		PROFILE_ZONE("UpdateMaterial");
+
+		node->material->updateTransformParams(node->getLocalToWorldTransform(), camera->getViewTransform(), camera->getProjectionTransform());
+		node->material->getParams()->updateParams(); //can be sped up by doing this differently
+
+		node->material->bindTextures();
+		node->material->bindConstants(); //TODO this needs tweeking
+	}
 	
 	if (previousPixelShader != pixShader)
 	{
@@ -1093,6 +1265,65 @@ void Renderer::renderNode(const Camera* camera, const GraphicObjectNode* node, f
 	drawTriangles(node->mesh->numFaces);
 }
 
+void Renderer::renderPolygonBatch(const Camera* camera, const PolygonBatch* batch, float frontClip, float backClip)
+{
+	if ( !batch->vertexBuffer || !batch->indexBuffer )
+		return;
+
+	const VertexShaderEntry& vsEntry = vertexShaderRegistry[batch->vertShaderIdx];
+
+	// Hull transforms are baked relative to the frame node
+	VertexShaderConstBuffer vcb;
+
+	vcb.projectionTransform = DirectX::XMMatrixTranspose(camera->getProjectionTransform());
+	vcb.viewTransform = DirectX::XMMatrixTranspose(camera->getViewTransform());
+	vcb.worldTransform = DirectX::XMMatrixTranspose(batch->frameNode->getLocalToWorldTransform());
+	vcb.depthPeelPlanes.x = frontClip;
+	vcb.depthPeelPlanes.y = backClip;
+	setPositionDecode(vcb, batch->layout);
+	updateShaderParams(&vcb,vertexShaderConstBuffer);
+
+	if ( previousVertexShader != vsEntry.shader )
+	{
+		setVertexShader(vsEntry.shader, vsEntry.layout);
+		previousVertexShader = vsEntry.shader;
+	}
+
+	setGeometry(batch->layout, batch->vertexBuffer, batch->indexBuffer, batch->indexFormat);
+
+	for ( int i = 0; i < PolygonBatch::numBuckets; ++i )
+	{
+		const PolygonBatch::Bucket& bucket = batch->buckets[i];
+		if ( !bucket.material || bucket.runs.empty() )
+			continue;
+
+		Material* material = bucket.material.get();
+		ID3D11PixelShader* pixShader = pixelShaderRegistry[material->shaderIdx].shader;
+		if ( vsEntry.error )
+			pixShader = fallbackPS;
+
+		{
+			PROFILE_ZONE("UpdateMaterial");
+
+			material->getParams()->updateParams();
+			material->bindTextures();
+			material->bindConstants();
+		}
+
+		if ( previousPixelShader != pixShader )
+		{
+			setPixelShader(pixShader);
+			previousPixelShader = pixShader;
+		}
+
+		setRasterizerState(material->rasterState);
+		setDepthStencilState(material->depthStencilState);
+
+		for ( const PolygonBatch::Run& run : bucket.runs )
+			drawTriangles(run.numFaces, run.firstFace);
+	}
+}
+
 
 void Renderer::renderLabel(TargetChains chain, const Camera* camera, const GraphicObjectNode* node)
 {
@@ -1103,6 +1334,11 @@ void Renderer::renderLabel(TargetChains chain, const Camera* camera, const Graph
 	Vec<int> pos(0,0,0);
 
 	Color bgColor = node->mesh->getColor();
+
+	// Shared polygon meshes are white, their color comes from the material
+	DirectX::XMFLOAT4 materialColor = node->material->getColor();
+	if ( materialColor.w > 0.0f )
+		bgColor = Color(materialColor.x, materialColor.y, materialColor.z, 1.0f);
 	Color fgColor(1.0f,1.0f,1.0f,1.0f);
 
 	if ( bgColor.r + bgColor.g + bgColor.b > 1.5f )
@@ -1212,46 +1448,17 @@ void Renderer::renderFrameNum(TargetChains chain)
 
 void Renderer::renderFPS(TargetChains chain)
 {
-	UINT64 totalTimes = 0;
-	UINT64 startTime  = 0;
-	UINT64 preTime	  = 0;
-	UINT64 mainTime   = 0;
-	UINT64 postTime  = 0;
-	UINT64 gdiTime   = 0;
-	UINT64 endTime   = 0;
-
 	double avgFrame = 0;
-	double avgStart = 0;
-	double avgPre = 0;
-	double avgMain = 0;
-	double avgPost = 0;
-	double avgGdi = 0;
-	double avgEnd = 0;
-
-	for(int i = 0; i<NUM_TIMES; ++i)
-		totalTimes += frameTimes[i];
-
-	avgFrame = double(totalTimes)/NUM_TIMES;
+	double avgStages[FrameStats::NumStages];
 
-	if(statsOn)
-	{
-		for(int i = 0; i<NUM_TIMES; ++i)
-		{
-			startTime += startTimes[i];
-			preTime += preTimes[i];
-			mainTime += mainTimes[i];
-			postTime += postTimes[i];
-			gdiTime += gdiTimes[i];
-			endTime += endTimes[i];
-		}
+	frameStats.getRecentMeans(NUM_TIMES, avgFrame, avgStages);
 
-		avgStart = double(startTime)/NUM_TIMES;
-		avgPre = double(preTime)/NUM_TIMES;
-		avgMain = double(mainTime)/NUM_TIMES;
-		avgPost = double(postTime)/NUM_TIMES;
-		avgGdi = double(gdiTime)/NUM_TIMES;
-		avgEnd = double(endTime)/NUM_TIMES;
-	}
+	double avgStart = avgStages[FrameStats::Start];
+	double avgPre = avgStages[FrameStats::Background];
+	double avgMain = avgStages[FrameStats::Main];
+	double avgPost = avgStages[FrameStats::Widget];
+	double avgGdi = avgStages[FrameStats::Overlay];
+	double avgEnd = avgStages[FrameStats::Present];
 
 	char buff[36];
 	double fps = 1000.0/avgFrame;
@@ -1319,18 +1526,27 @@ void Renderer::setDepthStencilState(ID3D11DepthStencilState* depthStencilState)
 	renderContext->OMSetDepthStencilState(depthStencilState,NULL);
 }
 
-void Renderer::setGeometry(VertexLayout layout, ID3D11Buffer* vertexBuffer, ID3D11Buffer* indexBuffer)
+void Renderer::setGeometry(VertexLayout layout, ID3D11Buffer* vertexBuffer, ID3D11Buffer* indexBuffer, DXGI_FORMAT indexFormat)
 {
 	UINT stride = layout.getVertSize();
 	UINT offset = 0;
 
-	renderContext->IASetIndexBuffer(indexBuffer,DXGI_FORMAT_R32_UINT,0);
+	renderContext->IASetIndexBuffer(indexBuffer,indexFormat,0);
 	renderContext->IASetVertexBuffers(0,1,&vertexBuffer,&stride,&offset);
 }
 
-void Renderer::drawTriangles(size_t numFaces)
+void Renderer::setPositionDecode(VertexShaderConstBuffer& vcb, const VertexLayout& layout)
 {
-	renderContext->DrawIndexed(unsigned int(3*numFaces),0,0);
+	Vec<float> scale, offset;
+	layout.getPositionDecode(scale, offset);
+
+	vcb.positionScale = DirectX::XMFLOAT4(scale.x, scale.y, scale.z, 1.0f);
+	vcb.positionOffset = DirectX::XMFLOAT4(offset.x, offset.y, offset.z, 0.0f);
+}
+
+void Renderer::drawTriangles(size_t numFaces, size_t firstFace)
+{
+	renderContext->DrawIndexed(unsigned int(3*numFaces),unsigned int(3*firstFace),0);
 }
 
 void Renderer::setPixelShaderConsts(ID3D11Buffer* buffer)
@@ -1482,6 +1698,52 @@ void Renderer::readSurface(unsigned char* outBuffer, ID3D11Texture2D* texture, V
 	renderContext->Unmap(texture, 0);
 }
 
+bool Renderer::readVolume(unsigned char* outBuffer, ID3D11Resource* texture, Vec<size_t> dims)
+{
+	D3D11_TEXTURE3D_DESC desc;
+	desc.Format = DXGI_FORMAT_R8_UNORM;
+	desc.Width = (unsigned int)dims.x;
+	desc.Height = (unsigned int)dims.y;
+	desc.Depth = (unsigned int)dims.z;
+	desc.MipLevels = 1;
+	desc.Usage = D3D11_USAGE_STAGING;
+	desc.BindFlags = 0;
+	desc.CPUAccessFlags = D3D11_CPU_ACCESS_READ;
+	desc.MiscFlags = 0;
+
+	ID3D11Texture3D* staging = createTexture3D(&desc);
+	if ( !staging )
+		return false;
+
+	renderContext->CopyResource(staging, texture);
+
+	D3D11_MAPPED_SUBRESOURCE resource;
+	HRESULT hr = renderContext->Map(staging, 0, D3D11_MAP_READ, 0, &resource);
+	if ( FAILED(hr) )
+	{
+		sendHrErrMessage(hr);
+		SAFE_RELEASE(staging);
+		return false;
+	}
+
+	unsigned char* outLine = outBuffer;
+	for ( size_t z=0; z < dims.z; ++z )
+	{
+		const unsigned char* inLine = (const unsigned char*)resource.pData + z*resource.DepthPitch;
+		for ( size_t y=0; y < dims.y; ++y )
+		{
+			memcpy(outLine, inLine, dims.x);
+			inLine += resource.RowPitch;
+			outLine += dims.x;
+		}
+	}
+
+	renderContext->Unmap(staging, 0);
+	SAFE_RELEASE(staging);
+
+	return true;
+}
+
 
 
 ID3D11RasterizerState* Renderer::getRasterizerState(bool wireframe, D3D11_CULL_MODE cullFaces)
@@ -1610,6 +1872,81 @@ int Renderer::getPolygon(Vec<float> pnt, Vec<float> direction)
 	return node->getIndex();
 }
 
+std::vector<int> Renderer::getPolygonsInRegion(const std::vector<Vec<float>>& region, bool touching)
+{
+	SceneNode* frameNode = rootScene->getRenderSectionNode(Section::Main, currentFrame);
+	if ( !frameNode )
+		return std::vector<int>();
+
+	return regionSelector->select(rootScene->sceneObjectRegistry(GraphicObjectTypes::Polygons), frameNode, currentFrame,
+		rootScene->getSceneVersion(), gCameraDefaultMesh, region, touching);
+}
+
+bool Renderer::getVolumePoint(Vec<float> pnt, Vec<float> direction, Vec<float>& imagePosOut, Vec<float>& modelPosOut, float opacityThreshold)
+{
+	SceneNode* frameNode = rootScene->getRenderSectionNode(Section::Main, currentFrame);
+	if ( !volInfo || !frameNode )
+		return false;
+
+	// Volumes are clipped on world z, find the part of the ray between the clip planes
+	float tMin = 0.0f;
+	float tMax = FLT_MAX;
+	if ( fabs(direction.z) > 1e-8f )
+	{
+		float tFront = (frontClipPos - pnt.z) / direction.z;
+		float tBack = (backClipPos - pnt.z) / direction.z;
+
+		float tNear = (tFront < tBack) ? tFront : tBack;
+		if ( tNear > tMin )
+			tMin = tNear;
+
+		tMax = (tFront < tBack) ? tBack : tFront;
+	}
+	else if ( pnt.z < frontClipPos || pnt.z > backClipPos )
+	{
+		return false;
+	}
+
+	if ( tMin > tMax )
+		return false;
+
+	// Transforming the point and direction separately keeps the same ray parameter in every space
+	DirectX::XMMATRIX worldToModel = DirectX::XMMatrixInverse(NULL, frameNode->getLocalToWorldTransform());
+	DirectX::XMVECTOR modelPntVec = DirectX::XMVector3TransformCoord(DirectX::XMVectorSet(pnt.x, pnt.y, pnt.z, 1.0f), worldToModel);
+	DirectX::XMVECTOR modelDirVec = DirectX::XMVector3TransformNormal(DirectX::XMVectorSet(direction.x, direction.y, direction.z, 0.0f), worldToModel);
+
+	Vec<float> modelPnt(DirectX::XMVectorGetX(modelPntVec), DirectX::XMVectorGetY(modelPntVec), DirectX::XMVectorGetZ(modelPntVec));
+	Vec<float> modelDir(DirectX::XMVectorGetX(modelDirVec), DirectX::XMVectorGetY(modelDirVec), DirectX::XMVectorGetZ(modelDirVec));
+
+	Vec<float> imagePnt = volInfo->modelToImageSpace(modelPnt);
+	Vec<float> imageDir = volInfo->modelToImageDirection(modelDir);
+
+	// Nearest hit over all visible volume types
+	bool found = false;
+	float hitT = tMax;
+	for ( int i=GraphicObjectTypes::OriginalVolume; i < GraphicObjectTypes::NumGO; ++i )
+	{
+		GraphicObjectNode* node = findSceneObject((GraphicObjectTypes)i, currentFrame);
+		if ( !node || !node->isRenderable() )
+			continue;
+
+		float typeT;
+		if ( volInfo->pickVolume((GraphicObjectTypes)i, currentFrame, node, imagePnt, imageDir, tMin, hitT, opacityThreshold, typeT) )
+		{
+			hitT = typeT;
+			found = true;
+		}
+	}
+
+	if ( !found )
+		return false;
+
+	imagePosOut = imagePnt + imageDir * hitT;
+	modelPosOut = modelPnt + modelDir * hitT;
+
+	return true;
+}
+
 void Renderer::setViewportSize(Vec<int> sizeIn, TargetChains selectChain)
 {
 	viewportSize[selectChain] = sizeIn;
@@ -1682,7 +2019,7 @@ void Renderer::incrementFrame()
 		}
 	}
 
-	gMsgQueueToMex.addMessage("timeChange",currentFrame+1);
+	gMsgQueueToMex.addEvent(EventTimeChange, currentFrame+1);
 }
 
 void Renderer::decrementFrame()
@@ -1690,7 +2027,7 @@ void Renderer::decrementFrame()
 	if (currentFrame!=0)
 		--currentFrame;
 
-	gMsgQueueToMex.addMessage("timeChange",currentFrame+1);
+	gMsgQueueToMex.addEvent(EventTimeChange, currentFrame+1);
 }
 
 unsigned int Renderer::getNumberOfFrames()
@@ -16,6 +16,7 @@
 #pragma once
 #include "Global/Vec.h"
 #include "VertexLayouts.h"
+#include "FrameStats.h"
 
 #include <d3d11.h>
 #include <DXGI1_2.h>
@@ -41,6 +42,10 @@ class RenderTarget;
 class DepthTarget;
 class SwapChainTarget;
 class VolumeInfo;
+class RegionSelector;
+class ResourceCache;
+class PolygonBatch;
+class NodeRegistry;
 
 enum GraphicObjectTypes
 {
@@ -99,6 +104,25 @@ public:
 		DirectX::XMMATRIX viewTransform;
 		DirectX::XMMATRIX projectionTransform;
 		DirectX::XMFLOAT4 depthPeelPlanes;
+
+		// Decode for packed vertex positions, see VertexLayout::getPositionDecode
+		DirectX::XMFLOAT4 positionScale;
+		DirectX::XMFLOAT4 positionOffset;
+	};
+
+	// GPU vertex and index buffer use for one kind of scene object
+	struct BufferMemory
+	{
+		std::string name;
+
+		size_t objects;
+		// Unique meshes (or merged batches) holding buffers
+		size_t buffers;
+
+		size_t vertexBytes;
+		size_t indexBytes;
+		// Same buffers with float attributes and 32-bit indices
+		size_t unpackedBytes;
 	};
 
 	static const float cornerVolumeDist;
@@ -121,7 +145,7 @@ public:
 	void attachToRootScene(SceneNode* sceneIn, Section section, int frame);
 	void removeSceneObjects(GraphicObjectTypes type);
 	GraphicObjectNode* findSceneObject(GraphicObjectTypes type, int index);
-	std::map<int,GraphicObjectNode*>& allSceneObjects(GraphicObjectTypes type);
+	NodeRegistry& allSceneObjects(GraphicObjectTypes type);
 
 	void clearVertexShaderList();
 	void clearPixelShaderList();
@@ -169,9 +193,19 @@ public:
 		const std::map<std::string,std::string>& variables = std::map<std::string,std::string>());
 
 	VolumeInfo* getVolumeInfo(){ return volInfo; }
+	ResourceCache* getResourceCache(){ return resourceCache; }
+	FrameStats& getFrameStats(){ return frameStats; }
 	DirectX::XMMATRIX getRootWorldRotation();
 
+	// One entry per scene object type plus the merged polygon batches
+	void getBufferMemory(std::vector<BufferMemory>& memoryOut);
+
+	// Polygon faces drawn in the last frame and how many the hulls have at full detail
+	void getPolygonFaceCounts(size_t& drawnOut, size_t& fullDetailOut) const {drawnOut = polygonFacesDrawn; fullDetailOut = polygonFacesFull;}
+
 	int getPolygon(Vec<float> pnt, Vec<float> direction);
+	std::vector<int> getPolygonsInRegion(const std::vector<Vec<float>>& region, bool touching = false);
+	bool getVolumePoint(Vec<float> pnt, Vec<float> direction, Vec<float>& imagePosOut, Vec<float>& modelPosOut, float opacityThreshold = 0.1f);
 	float getClipChunkPercent(){return clipChunkPercent;}
 	HRESULT captureWindow(std::string* filenameOut);
 	HRESULT captureWindow(std::string filePathIn, std::string fileNameIn, std::string& filenameOut);
@@ -200,15 +234,22 @@ public:
 
 	void endRender(TargetChains renderChain);
 
+	// Drops the merged polygon buffers, needed when hull geometry changes without attaching or removing nodes
+	void clearPolygonBatches();
+
 //////////////////////////////////////////////////////////////////////////
 // Resource setup for external classes
 //////////////////////////////////////////////////////////////////////////
 	HRESULT createVertexBuffer(UINT accessFlags, D3D11_USAGE usage, size_t bufferSize, const void* initData, ID3D11Buffer** vertexBufferOut);
-	HRESULT createIndexBuffer(UINT accessFlags, D3D11_USAGE usage, const std::vector<Vec<unsigned int>>& faces, ID3D11Buffer** indexBufferOut);
+	// formatOut allows a 16-bit index buffer when all indices fit, the chosen format is returned in it
+	HRESULT createIndexBuffer(UINT accessFlags, D3D11_USAGE usage, const std::vector<Vec<unsigned int>>& faces, ID3D11Buffer** indexBufferOut,
+		DXGI_FORMAT* formatOut = NULL);
 	HRESULT createConstantBuffer(size_t size, ID3D11Buffer** constBufferOut);
 
 	HRESULT lockBuffer(ID3D11Buffer* buffer, D3D11_MAP mapType, D3D11_MAPPED_SUBRESOURCE& outResource);
 	void releaseBuffer(ID3D11Buffer* buffer);
+	// Copies into part of a default-usage buffer
+	void updateBufferRegion(ID3D11Buffer* buffer, size_t byteOffset, size_t byteSize, const void* data);
 
 	IDXGISwapChain1* createSwapChain(HWND hWnd, Vec<size_t> dims, bool stereo, DXGI_FORMAT format, UINT flags);
 
@@ -221,6 +262,8 @@ public:
 
 	void stageResource(ID3D11Texture2D* stageTexture, ID3D11Texture2D* renderTexture);
 	void readSurface(unsigned char* outBuffer, ID3D11Texture2D* texture, Vec<size_t> dims, size_t pixelSize);
+	// Reads back a single channel 8-bit volume texture through a temporary staging copy
+	bool readVolume(unsigned char* outBuffer, ID3D11Resource* texture, Vec<size_t> dims);
 
 	ID3D11RasterizerState* getRasterizerState(bool wireframe, D3D11_CULL_MODE cullFaces);
 	ID3D11DepthStencilState* getDepthStencilState(bool depthTest);
@@ -255,8 +298,9 @@ private:
 	void setRasterizerState(ID3D11RasterizerState* rasterState);
 	void setPixelShader(ID3D11PixelShader* shader);
 	void setDepthStencilState(ID3D11DepthStencilState* depthStencilState);
-	void setGeometry(VertexLayout layoutInfo, ID3D11Buffer* vertexBuffer, ID3D11Buffer* indexBuffer);
-	void drawTriangles(size_t numFaces);
+	void setGeometry(VertexLayout layoutInfo, ID3D11Buffer* vertexBuffer, ID3D11Buffer* indexBuffer, DXGI_FORMAT indexFormat = DXGI_FORMAT_R32_UINT);
+	static void setPositionDecode(VertexShaderConstBuffer& vcb, const VertexLayout& layout);
+	void drawTriangles(size_t numFaces, size_t firstFace = 0);
 
 	HRESULT compileVertexShader(const std::string& filename, const std::string& functionName,
 		const std::map<std::string, std::string>& variables, const std::vector<D3D11_INPUT_ELEMENT_DESC>& layoutDesc,
@@ -269,6 +313,9 @@ private:
 	ID3DBlob* compileShaderFile(const std::string& filename, const std::string& entryFunction, const std::string& shaderModel, const std::map<std::string, std::string>& repVars);
 
 	void renderNode(const Camera* camera, const GraphicObjectNode* node, float frontClip=-10, float backClip=10);
+	void renderPolygonBatch(const Camera* camera, const PolygonBatch* batch, float frontClip, float backClip);
+
+	PolygonBatch* getPolygonBatch(SceneNode* frameNode, unsigned int frame);
 
 	void renderLabel(TargetChains chain, const Camera* camera, const GraphicObjectNode* node);
 	void renderScaleValue(TargetChains chain, const Camera* camera);
@@ -349,6 +396,19 @@ private:
 	//TODO: Should probably put cameras in the scene
 	RootSceneNode* rootScene;
 	TextRenderer* textRenderer;
+	RegionSelector* regionSelector;
+	ResourceCache* resourceCache;
+
+	// Merged polygon buffers per frame, all are rebuilt when nodes are attached or removed
+	static const size_t maxPolygonBatches = 16;
+	std::map<unsigned int,PolygonBatch*> polygonBatches;
+	unsigned int polygonBatchVersion;
+	size_t polygonFacesDrawn;
+	size_t polygonFacesFull;
+
+	// Last shaders bound by renderNode/renderPolygonBatch
+	ID3D11VertexShader* previousVertexShader;
+	ID3D11PixelShader* previousPixelShader;
 
 	unsigned int currentFrame;
 	float clipChunkPercent;
@@ -365,15 +425,9 @@ private:
 	std::string captureFileName;
 	std::string dllRoot;
 
+	// The on-screen stats average this many of the most recent frames
 	static const int NUM_TIMES = 20;
-	UINT64 frameTimes[NUM_TIMES];
-	UINT64 startTimes[NUM_TIMES];
-	UINT64 preTimes[NUM_TIMES];
-	UINT64 mainTimes[NUM_TIMES];
-	UINT64 postTimes[NUM_TIMES];
-	UINT64 gdiTimes[NUM_TIMES];
-	UINT64 endTimes[NUM_TIMES];
-	int curTimeIdx;
+	FrameStats frameStats;
 
 private:
 	std::shared_ptr<RenderTarget> renderChains[TargetChains::NumTC][RenderTargetTypes::NumRT];
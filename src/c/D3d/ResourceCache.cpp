@@ -0,0 +1,392 @@
+#include "ResourceCache.h"
+#include "MeshPrimitive.h"
+#include "MeshDecimator.h"
+
+#include "Global/ParallelFor.h"
+#include "Global/Profiler.h"
+
+#include <chrono>
+#include <cmath>
+#include <cstring>
+#include <utility>
+
+#undef min
+#undef max
+
+// Quantization used when comparing geometry, model space spans roughly [-1,1]
+const double ResourceCache::vertQuantScale = 1.0e6;
+const double ResourceCache::normQuantScale = 1.0e4;
+
+namespace
+{
+	const uint64_t fnvOffset = 14695981039346656037ULL;
+	const uint64_t fnvPrime = 1099511628211ULL;
+
+	// Meshes smaller than this are cheap enough to always draw at full detail
+	const size_t minLodFaces = 64;
+
+	// Meshes this small already fit in the vertex cache whatever their order
+	const size_t minOptimizeFaces = 32;
+
+	inline void hashBytes(uint64_t& hash, const void* data, size_t size)
+	{
+		const unsigned char* bytes = (const unsigned char*)data;
+		for ( size_t i = 0; i < size; ++i )
+		{
+			hash ^= bytes[i];
+			hash *= fnvPrime;
+		}
+	}
+
+	inline int64_t quantize(float val, double scale)
+	{
+		return int64_t(std::floor(val * scale + 0.5));
+	}
+
+	inline bool quantEqual(const Vec<float>& a, const Vec<float>& b, double scale)
+	{
+		for ( int i = 0; i < 3; ++i )
+		{
+			if ( quantize(a.e[i], scale) != quantize(b.e[i], scale) )
+				return false;
+		}
+
+		return true;
+	}
+}
+
+
+ResourceCache::ResourceCache(Renderer* renderer)
+	: renderer(renderer), insertsSinceSweep(0), lodVersion(1), lodBuildSeconds(0.0), meshOptimize(true), optimizedMeshes(0),
+	optimizedFaces(0), optimizedMissesBefore(0), optimizedMissesAfter(0), optimizeSeconds(0.0)
+{
+	lodSettings.errorPixels = 1.0f;
+	lodSettings.levelPixels[0] = 128.0f;
+	lodSettings.levelPixels[1] = 32.0f;
+}
+
+uint64_t ResourceCache::preparePolygonMesh(const MeshOptimizer::MeshArrays& mesh, Vec<float>& offsetOut)
+{
+	offsetOut = (mesh.numVerts == 0) ? Vec<float>(0.0f) : mesh.vertices[0];
+
+	// Meshes are stored relative to their first vertex so translated copies can share them
+	for ( size_t i = 0; i < mesh.numVerts; ++i )
+		mesh.vertices[i] = mesh.vertices[i] - offsetOut;
+
+	return hashMesh(mesh);
+}
+
+std::shared_ptr<MeshPrimitive> ResourceCache::getPreparedPolygonMesh(uint64_t hash, const MeshOptimizer::MeshArrays& arrays)
+{
+	auto range = meshes.equal_range(hash);
+	for ( auto it = range.first; it != range.second; ++it )
+	{
+		std::shared_ptr<MeshPrimitive> mesh = it->second.lock();
+		if ( mesh && meshMatches(mesh.get(), arrays) )
+			return mesh;
+	}
+
+	// The one copy of the queued arrays
+	std::vector<Vec<uint32_t>> faces(arrays.faces, arrays.faces + arrays.numFaces);
+	std::vector<Vec<float>> vertices(arrays.vertices, arrays.vertices + arrays.numVerts);
+	std::vector<Vec<float>> normals;
+	if ( arrays.normals )
+		normals.assign(arrays.normals, arrays.normals + arrays.numVerts);
+
+	std::shared_ptr<MeshPrimitive> mesh = std::make_shared<StaticColorMesh>(renderer, std::move(faces), std::move(vertices), std::move(normals),
+		Color(1.0f, 1.0f, 1.0f, 1.0f));
+	meshes.emplace(hash, mesh);
+
+	if ( ++insertsSinceSweep > 1024 )
+	{
+		removeExpired(meshes);
+		removeExpired(materials);
+		insertsSinceSweep = 0;
+	}
+
+	return mesh;
+}
+
+std::shared_ptr<PolygonMaterial> ResourceCache::getPolygonMaterial(const PolygonMaterial::State& state)
+{
+	uint64_t hash = hashMaterial(state);
+
+	auto range = materials.equal_range(hash);
+	for ( auto it = range.first; it != range.second; ++it )
+	{
+		std::shared_ptr<PolygonMaterial> material = it->second.lock();
+		if ( material && material->getState() == state )
+			return material;
+	}
+
+	std::shared_ptr<PolygonMaterial> material = std::make_shared<PolygonMaterial>(renderer);
+	material->setState(state);
+
+	materials.emplace(hash, material);
+
+	return material;
+}
+
+void ResourceCache::optimizeMeshes(std::vector<MeshOptimizer::MeshArrays>& batch)
+{
+	if ( !meshOptimize || batch.empty() )
+		return;
+
+	PROFILE_ZONE("OptimizeMeshes");
+
+	std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+
+	std::vector<MeshOptimizer::Result> results(batch.size());
+	parallelFor(batch.size(), 16, [&](size_t begin, size_t end)
+	{
+		for ( size_t i = begin; i < end; ++i )
+		{
+			MeshOptimizer::MeshArrays& mesh = batch[i];
+			if ( mesh.numFaces < minOptimizeFaces )
+			{
+				results[i].faces = 0;
+				continue;
+			}
+
+			results[i] = MeshOptimizer::optimize(mesh);
+		}
+	});
+
+	for ( const MeshOptimizer::Result& result : results )
+	{
+		if ( result.faces == 0 )
+			continue;
+
+		++optimizedMeshes;
+		optimizedFaces += result.faces;
+		optimizedMissesBefore += result.missesBefore;
+		optimizedMissesAfter += result.missesAfter;
+	}
+
+	optimizeSeconds += std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+bool ResourceCache::setLodSettings(const LodSettings& settings)
+{
+	if ( memcmp(&settings, &lodSettings, sizeof(LodSettings)) == 0 )
+		return false;
+
+	lodSettings = settings;
+	++lodVersion;
+
+	return true;
+}
+
+void ResourceCache::updateLods()
+{
+	PROFILE_ZONE("UpdateLods");
+
+	std::vector<std::shared_ptr<MeshPrimitive>> pending;
+	for ( auto& it : meshes )
+	{
+		std::shared_ptr<MeshPrimitive> mesh = it.second.lock();
+		if ( mesh && mesh->getLodVersion() != lodVersion )
+			pending.push_back(mesh);
+	}
+
+	if ( pending.empty() )
+		return;
+
+	std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+
+	// Each mesh owns its levels, so meshes can be decimated independently
+	LodSettings settings = lodSettings;
+	unsigned int version = lodVersion;
+	bool optimize = meshOptimize;
+	parallelFor(pending.size(), 1, [&](size_t begin, size_t end)
+	{
+		for ( size_t i = begin; i < end; ++i )
+			buildMeshLods(pending[i].get(), settings, version, optimize);
+	});
+
+	lodBuildSeconds += std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+void ResourceCache::buildMeshLods(MeshPrimitive* mesh, const LodSettings& settings, unsigned int version, bool optimize)
+{
+	std::vector<MeshDecimator::Level> levels;
+
+	size_t numFaces = mesh->getFaces().size();
+	if ( settings.errorPixels <= 0.0f || numFaces < 4*minLodFaces )
+	{
+		mesh->setLodLevels(levels, version);
+		return;
+	}
+
+	Vec<float> boundsMin, boundsMax;
+	mesh->getBounds(boundsMin, boundsMax);
+	float diagonal = float((boundsMax - boundsMin).length());
+
+	// A level is only seen below its pixel size, so this bound keeps its error, and with it the moved vertices'
+	// distances to their original face planes, under errorPixels on screen
+	std::vector<MeshDecimator::Target> targets(numLodLevels-1);
+	for ( int i = 0; i < numLodLevels-1; ++i )
+	{
+		targets[i].maxFaces = std::max(minLodFaces, numFaces >> (2*(i+1)));
+		targets[i].maxError = diagonal * settings.errorPixels / std::max(settings.levelPixels[i], 1.0f);
+	}
+
+	MeshDecimator::decimate(mesh->getFaces(), mesh->getVertices(), targets, levels);
+
+	// Drop levels that barely improve on the one before them
+	size_t prevFaces = numFaces;
+	for ( size_t i = 0; i < levels.size(); ++i )
+	{
+		if ( levels[i].faces.size() * 10 > prevFaces * 9 )
+		{
+			levels.resize(i);
+			break;
+		}
+
+		prevFaces = levels[i].faces.size();
+	}
+
+	// Levels share the full detail vertex order, so only their faces can be reordered
+	if ( optimize )
+	{
+		for ( MeshDecimator::Level& level : levels )
+			MeshOptimizer::optimizeVertexCache(level.faces, mesh->getVertices().size());
+	}
+
+	mesh->setLodLevels(levels, version);
+}
+
+ResourceCache::Stats ResourceCache::getStats()
+{
+	removeExpired(meshes);
+	removeExpired(materials);
+
+	Stats stats;
+	memset(&stats, 0, sizeof(Stats));
+
+	for ( auto& it : meshes )
+	{
+		std::shared_ptr<MeshPrimitive> mesh = it.second.lock();
+		if ( !mesh )
+			continue;
+
+		// Don't count the reference held by this loop
+		size_t refs = mesh.use_count() - 1;
+		size_t bytes = mesh->getMemorySize();
+
+		++stats.meshes;
+		stats.meshRefs += refs;
+		stats.meshBytes += bytes;
+		if ( refs > 1 )
+			stats.meshBytesSaved += (refs - 1) * bytes;
+
+		const std::vector<MeshDecimator::Level>& levels = mesh->getLodLevels();
+		if ( !levels.empty() )
+			++stats.lodMeshes;
+
+		Vec<float> boundsMin, boundsMax;
+		mesh->getBounds(boundsMin, boundsMax);
+		double diagonal = (boundsMax - boundsMin).length();
+
+		size_t levelFaces = mesh->getFaces().size();
+		stats.lodFaces[0] += levelFaces;
+		for ( int i = 1; i < numLodLevels; ++i )
+		{
+			if ( i <= levels.size() )
+			{
+				levelFaces = levels[i-1].faces.size();
+				if ( diagonal > 0.0 )
+					stats.lodMaxError = std::max(stats.lodMaxError, levels[i-1].error / diagonal);
+			}
+
+			stats.lodFaces[i] += levelFaces;
+		}
+	}
+
+	stats.lodBuildSeconds = lodBuildSeconds;
+
+	stats.optimizedMeshes = optimizedMeshes;
+	stats.optimizedFaces = optimizedFaces;
+	stats.optimizedMissesBefore = optimizedMissesBefore;
+	stats.optimizedMissesAfter = optimizedMissesAfter;
+	stats.optimizeSeconds = optimizeSeconds;
+
+	for ( auto& it : materials )
+	{
+		std::shared_ptr<PolygonMaterial> material = it.second.lock();
+		if ( !material )
+			continue;
+
+		++stats.materials;
+		stats.materialRefs += material.use_count() - 1;
+	}
+
+	return stats;
+}
+
+uint64_t ResourceCache::hashMesh(const MeshOptimizer::MeshArrays& mesh)
+{
+	uint64_t hash = fnvOffset;
+
+	size_t numNormals = (mesh.normals) ? mesh.numVerts : 0;
+	size_t counts[3] = {mesh.numFaces, mesh.numVerts, numNormals};
+	hashBytes(hash, counts, sizeof(counts));
+	hashBytes(hash, mesh.faces, mesh.numFaces * sizeof(Vec<uint32_t>));
+
+	for ( size_t i = 0; i < mesh.numVerts; ++i )
+	{
+		const Vec<float>& vert = mesh.vertices[i];
+		int64_t quant[3] = {quantize(vert.x, vertQuantScale), quantize(vert.y, vertQuantScale), quantize(vert.z, vertQuantScale)};
+		hashBytes(hash, quant, sizeof(quant));
+	}
+
+	for ( size_t i = 0; i < numNormals; ++i )
+	{
+		const Vec<float>& norm = mesh.normals[i];
+		int64_t quant[3] = {quantize(norm.x, normQuantScale), quantize(norm.y, normQuantScale), quantize(norm.z, normQuantScale)};
+		hashBytes(hash, quant, sizeof(quant));
+	}
+
+	return hash;
+}
+
+uint64_t ResourceCache::hashMaterial(const PolygonMaterial::State& state)
+{
+	uint64_t hash = fnvOffset;
+
+	hashBytes(hash, state.color.e, sizeof(state.color.e));
+	hashBytes(hash, &state.alpha, sizeof(state.alpha));
+
+	unsigned char flags[3] = {state.useColor, state.lightOn, state.wireframe};
+	hashBytes(hash, flags, sizeof(flags));
+
+	return hash;
+}
+
+bool ResourceCache::meshMatches(const MeshPrimitive* mesh, const MeshOptimizer::MeshArrays& arrays)
+{
+	const std::vector<Vec<uint32_t>>& meshFaces = mesh->getFaces();
+	const std::vector<Vec<float>>& meshVerts = mesh->getVertices();
+	const std::vector<Vec<float>>& meshNorms = mesh->getNormals();
+
+	size_t numNormals = (arrays.normals) ? arrays.numVerts : 0;
+	if ( meshFaces.size() != arrays.numFaces || meshVerts.size() != arrays.numVerts || meshNorms.size() != numNormals )
+		return false;
+
+	if ( memcmp(meshFaces.data(), arrays.faces, arrays.numFaces * sizeof(Vec<uint32_t>)) != 0 )
+		return false;
+
+	for ( size_t i = 0; i < arrays.numVerts; ++i )
+	{
+		if ( !quantEqual(meshVerts[i], arrays.vertices[i], vertQuantScale) )
+			return false;
+	}
+
+	for ( size_t i = 0; i < numNormals; ++i )
+	{
+		if ( !quantEqual(meshNorms[i], arrays.normals[i], normQuantScale) )
+			return false;
+	}
+
+	return true;
+}
@@ -0,0 +1,133 @@
+#pragma once
+#include "Global/Vec.h"
+#include "Material.h"
+#include "MeshOptimizer.h"
+
+#include <cstdint>
+#include <memory>
+#include <unordered_map>
+#include <vector>
+
+class Renderer;
+class MeshPrimitive;
+
+// Shares identical polygon meshes and materials between scene nodes.
+// Meshes are keyed by a hash of their faces, normals and translation-free vertex positions, so
+// repeated template shapes are stored once and placed by the node transform. Materials are keyed
+// by their parameter state. Only weak references are held, resources are freed with their last node.
+// Shared meshes also carry decimated LOD levels, built here once per unique mesh.
+// New polygon meshes can be reordered for the vertex cache before they are looked up, the reordering
+// is deterministic so identical shapes still match each other.
+class ResourceCache
+{
+public:
+	// Full detail mesh plus decimated levels
+	static const int numLodLevels = 3;
+
+	struct LodSettings
+	{
+		// Largest on-screen deviation (pixels) a decimated level may introduce, 0 turns LODs off
+		float errorPixels;
+
+		// A hull's level is used once its projected bounding box diagonal drops below this size (pixels)
+		float levelPixels[numLodLevels-1];
+	};
+
+	struct Stats
+	{
+		size_t meshes;
+		size_t meshRefs;
+		size_t meshBytes;
+		size_t meshBytesSaved;
+
+		size_t materials;
+		size_t materialRefs;
+
+		// Unique mesh faces at each LOD level, meshes without a level count their next finer one
+		size_t lodFaces[numLodLevels];
+		size_t lodMeshes;
+		// Largest decimation error (see MeshDecimator::Level::error) as a fraction of the mesh bounding box diagonal
+		double lodMaxError;
+		double lodBuildSeconds;
+
+		// Faces reordered for the vertex cache and their vertex shader invocations before and after
+		size_t optimizedMeshes;
+		size_t optimizedFaces;
+		size_t optimizedMissesBefore;
+		size_t optimizedMissesAfter;
+		double optimizeSeconds;
+
+		// Polygon faces in the current frame, as drawn and at full detail
+		size_t frameFaces;
+		size_t frameFullFaces;
+	};
+
+	ResourceCache(Renderer* renderer);
+
+	// Polygon meshes are looked up in two halves. Vertices are in model space.
+	// Preparing moves the vertices relative to offsetOut, the translation that places the shared mesh, and hashes the mesh.
+	// It touches no cache state so it can run on the thread pool. The lookup has to be on the render thread,
+	// the arrays are only copied into a new mesh when nothing matches them.
+	static uint64_t preparePolygonMesh(const MeshOptimizer::MeshArrays& mesh, Vec<float>& offsetOut);
+	std::shared_ptr<MeshPrimitive> getPreparedPolygonMesh(uint64_t hash, const MeshOptimizer::MeshArrays& mesh);
+
+	std::shared_ptr<PolygonMaterial> getPolygonMaterial(const PolygonMaterial::State& state);
+
+	bool getMeshOptimize() const {return meshOptimize;}
+	void setMeshOptimize(bool optimize) {meshOptimize = optimize;}
+
+	// Reorders a batch of new polygon meshes in parallel when mesh optimization is on, call before preparePolygonMesh
+	void optimizeMeshes(std::vector<MeshOptimizer::MeshArrays>& batch);
+
+	const LodSettings& getLodSettings() const {return lodSettings;}
+	// Returns true if existing LOD levels have to be rebuilt for the new settings
+	bool setLodSettings(const LodSettings& settings);
+
+	// Decimates every shared mesh without levels for the current settings, meshes are processed in parallel
+	void updateLods();
+
+	Stats getStats();
+
+private:
+	static const double vertQuantScale;
+	static const double normQuantScale;
+
+	static void buildMeshLods(MeshPrimitive* mesh, const LodSettings& settings, unsigned int version, bool optimize);
+
+	static uint64_t hashMesh(const MeshOptimizer::MeshArrays& mesh);
+	static uint64_t hashMaterial(const PolygonMaterial::State& state);
+
+	static bool meshMatches(const MeshPrimitive* mesh, const MeshOptimizer::MeshArrays& arrays);
+
+	template <typename T>
+	static void removeExpired(std::unordered_multimap<uint64_t, std::weak_ptr<T>>& entries)
+	{
+		for ( auto it = entries.begin(); it != entries.end(); )
+		{
+			if ( it->second.expired() )
+				it = entries.erase(it);
+			else
+				++it;
+		}
+	}
+
+	Renderer* renderer;
+
+	std::unordered_multimap<uint64_t, std::weak_ptr<MeshPrimitive>> meshes;
+	std::unordered_multimap<uint64_t, std::weak_ptr<PolygonMaterial>> materials;
+
+	// Expired entries are swept after this many insertions
+	size_t insertsSinceSweep;
+
+	LodSettings lodSettings;
+	// Bumped whenever the settings change, meshes remember the version their levels were built with
+	unsigned int lodVersion;
+	double lodBuildSeconds;
+
+	bool meshOptimize;
+	size_t optimizedMeshes;
+	size_t optimizedFaces;
+	size_t optimizedMissesBefore;
+	size_t optimizedMissesAfter;
+	double optimizeSeconds;
+};
@@ -16,6 +16,8 @@
 #include "SceneNode.h"
 #include "Global/Globals.h"
 #include "Global/ErrorMsg.h"
+#include "Global/Profiler.h"
+#include "ResourceCache.h"
 
 #undef max
 
@@ -75,6 +77,7 @@ void SceneNode::detatchFromParentNode()
 
 	// Remove any graphic object entries in the root registry.
 	removeEntries(getRegistry());
+	structureChanged();
 
 	setParentNode(NULL);
 }
@@ -137,7 +140,7 @@ void SceneNode::updateTransforms(DirectX::XMMATRIX parentToWorldIn)
 	}
 }
 
-SceneNode::NodeRegistry* SceneNode::getRegistry()
+NodeRegistry* SceneNode::getRegistry()
 {
 	if ( !parentNode )
 		return NULL;
@@ -145,7 +148,7 @@ SceneNode::NodeRegistry* SceneNode::getRegistry()
 	return parentNode->getRegistry();
 }
 
-bool SceneNode::addEntries(SceneNode::NodeRegistry* registry)
+bool SceneNode::addEntries(NodeRegistry* registry)
 {
 	if ( !registry )
 		return false;
@@ -156,7 +159,7 @@ bool SceneNode::addEntries(SceneNode::NodeRegistry* registry)
 	return true;
 }
 
-bool SceneNode::removeEntries(SceneNode::NodeRegistry* registry)
+bool SceneNode::removeEntries(NodeRegistry* registry)
 {
 	if ( !registry )
 		return false;
@@ -171,6 +174,7 @@ bool SceneNode::addChildNode(SceneNode* child)
 {
 	//TODO check for dups (cycles)
 	childrenNodes.push_back(child);
+	structureChanged();
 
 	// Bubble up to a RootSceneNode (returns a valid registry)
 	NodeRegistry* registry = getRegistry();
@@ -186,6 +190,12 @@ void SceneNode::requestUpdate()
 		parentNode->requestUpdate();
 }
 
+void SceneNode::structureChanged()
+{
+	if ( parentNode )
+		parentNode->structureChanged();
+}
+
 void SceneNode::updateAddTypes()
 {
 	Histogram deltas = childTypes;
@@ -219,11 +229,12 @@ void SceneNode::subtractTypes(const Histogram& deltas)
 
 void SceneNode::detatchChildNode(SceneNode* child)
 {
-	for (std::vector<SceneNode*>::iterator it=childrenNodes.begin(); it!=childrenNodes.end(); ++it)
+	// Search from the back, bulk removals tend to detach the most recently added children
+	for ( size_t i=childrenNodes.size(); i > 0; --i )
 	{
-		if (*it==child)
+		if ( childrenNodes[i-1] == child )
 		{
-			childrenNodes.erase(it,it+1);
+			childrenNodes.erase(childrenNodes.begin() + (i-1));
 			break;
 		}
 	}
@@ -235,6 +246,8 @@ GraphicObjectNode::GraphicObjectNode(int index, GraphicObjectTypes type, std::sh
 	: SceneNode(index, type), mesh(mesh), material(material)
 {
 	renderable = true;
+	sharedMaterial = false;
+	materialVersion = 0;
 
 	updateTransforms(parentToWorld);
 }
@@ -247,11 +260,61 @@ void GraphicObjectNode::releaseRenderResources()
 	renderable = false;
 }
 
+void GraphicObjectNode::setLightOn(bool on)
+{
+	++materialVersion;
+
+	PolygonMaterial* polyMaterial = dynamic_cast<PolygonMaterial*>(material.get());
+	if ( sharedMaterial && polyMaterial )
+	{
+		PolygonMaterial::State state = polyMaterial->getState();
+		state.lightOn = on;
+
+		material = gRenderer->getResourceCache()->getPolygonMaterial(state);
+		return;
+	}
+
+	material->getParams()->setLightOn(on);
+}
+
 void GraphicObjectNode::setColor(Vec<float> color, float alpha)
 {
+	++materialVersion;
+
+	PolygonMaterial* polyMaterial = dynamic_cast<PolygonMaterial*>(material.get());
+	if ( sharedMaterial && polyMaterial )
+	{
+		PolygonMaterial::State state = polyMaterial->getState();
+		state.color = color;
+		state.alpha = alpha;
+		state.useColor = true;
+
+		material = gRenderer->getResourceCache()->getPolygonMaterial(state);
+		return;
+	}
+
 	material->setColor(color, alpha);
 }
 
+void GraphicObjectNode::clearColor()
+{
+	++materialVersion;
+
+	PolygonMaterial* polyMaterial = dynamic_cast<PolygonMaterial*>(material.get());
+	if ( sharedMaterial && polyMaterial )
+	{
+		PolygonMaterial::State state = polyMaterial->getState();
+		state.color = Vec<float>(1.0f);
+		state.alpha = 1.0f;
+		state.useColor = false;
+
+		material = gRenderer->getResourceCache()->getPolygonMaterial(state);
+		return;
+	}
+
+	material->clearColor();
+}
+
 void GraphicObjectNode::setRenderable(bool render)
 {
 	renderable = render;
@@ -260,6 +323,18 @@ void GraphicObjectNode::setRenderable(bool render)
 
 void GraphicObjectNode::setWireframe(bool wireframe)
 {
+	++materialVersion;
+
+	PolygonMaterial* polyMaterial = dynamic_cast<PolygonMaterial*>(material.get());
+	if ( sharedMaterial && polyMaterial )
+	{
+		PolygonMaterial::State state = polyMaterial->getState();
+		state.wireframe = wireframe;
+
+		material = gRenderer->getResourceCache()->getPolygonMaterial(state);
+		return;
+	}
+
 	material->setWireframe(wireframe);
 }
 
@@ -296,25 +371,20 @@ void GraphicObjectNode::updateTransforms(DirectX::XMMATRIX parentToWorldIn)
 	localToWorld = mesh->computeLocalToWorld(localToParentTransform * parentToWorld);
 }
 
-bool GraphicObjectNode::addEntries(SceneNode::NodeRegistry* registry)
+bool GraphicObjectNode::addEntries(NodeRegistry* registry)
 {
 	if ( !registry )
 		return false;
 
-	if ( registry[type].count(index) > 0 )
-		return false;
-
-	registry[type].insert(std::make_pair(index, this));
-	return true;
+	return registry[type].insert(index, this);
 }
 
-bool GraphicObjectNode::removeEntries(SceneNode::NodeRegistry* registry)
+bool GraphicObjectNode::removeEntries(NodeRegistry* registry)
 {
 	if ( !registry )
 		return false;
 
-	registry[type].erase(index);
-	return true;
+	return registry[type].erase(index, this);
 }
 
 
@@ -393,7 +463,7 @@ bool RenderFilter::checkChildren(SceneNode* node, GraphicObjectTypes filter)
 
 
 RootSceneNode::RootSceneNode()
-	: SceneNode(GraphicObjectTypes::Group)
+	: SceneNode(GraphicObjectTypes::Group), sceneVersion(0), structureVersion(0)
 {
 	for (int i=0; i<Renderer::Section::SectionEnd; ++i)
 	{
@@ -425,6 +495,7 @@ void RootSceneNode::clearSectionNodes(Renderer::Section section)
 		delete rootChildrenNodes[section][i];
 
 	rootChildrenNodes[section].clear();
+	structureChanged();
 }
 
 void RootSceneNode::initRenderSectionNodes(Renderer::Section section, int numFrames)
@@ -452,6 +523,9 @@ SceneNode* RootSceneNode::getRenderSectionNode(Renderer::Section section, int fr
 
 void RootSceneNode::updateTransforms(DirectX::XMMATRIX parentToWorldIn)
 {
+	PROFILE_ZONE("UpdateSceneTransforms");
+
+	++sceneVersion;
 	parentToWorld = parentToWorldIn;
 
 	DirectX::XMMATRIX transMatrix = DirectX::XMMatrixTranslation(-origin.x,-origin.y,-origin.z);
@@ -486,25 +560,27 @@ int RootSceneNode::getNumFrames()
 	return maxFrames;
 }
 
-std::map<int, GraphicObjectNode*>& RootSceneNode::sceneObjectRegistry(GraphicObjectTypes type)
+NodeRegistry& RootSceneNode::sceneObjectRegistry(GraphicObjectTypes type)
 {
 	return registry[type];
 }
 
 void RootSceneNode::removeRegisteredObjects(GraphicObjectTypes type)
 {
-	for ( auto it = registry[type].begin(); it != registry[type].end(); )
+	// Deleting from the back keeps the registry swap-free and usually detaches the
+	// most recently attached children, which are found first by detatchChildNode
+	while ( !registry[type].empty() )
 	{
-		GraphicObjectNode* child = it->second;
+		GraphicObjectNode* child = registry[type].nodeAt(registry[type].size() - 1);
 		delete child;
-
-		it = registry[type].begin();
 	}
 }
 
 
 SceneNode* RootSceneNode::pickNode(Vec<float> pnt, Vec<float> direction, unsigned int currentFrame, GraphicObjectTypes filter, float& depthOut)
 {
+	PROFILE_ZONE("PickNode");
+
 	std::vector<SceneNode*> children = rootChildrenNodes[Renderer::Section::Main][currentFrame]->getChildren();
 
 	SceneNode* nodeOut = NULL;
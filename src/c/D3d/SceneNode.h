@@ -19,6 +19,7 @@
 
 #include "MeshPrimitive.h"
 #include "Material.h"
+#include "NodeRegistry.h"
 
 #include "Eigen/Eigen"
 
@@ -31,12 +32,12 @@ class GraphicObjectNode;
 class SceneNode
 {
 protected:
-	typedef std::map<int, GraphicObjectNode*> NodeRegistry;
 	typedef Eigen::Matrix<size_t, GraphicObjectTypes::NumGO, 1> Histogram;
 
 public:
 	friend class RootSceneNode;
 	friend class RenderFilter;
+	friend class PolygonBatch;
 
 	SceneNode(GraphicObjectTypes type);
 
@@ -74,6 +75,8 @@ protected:
 	virtual const std::vector<SceneNode*>& getChildren();
 	virtual void updateTransforms(DirectX::XMMATRIX parentToWorldIn);
 	virtual void requestUpdate();
+	// Bubbles up to the root whenever nodes are attached or detached below it
+	virtual void structureChanged();
 
 	void updateAddTypes();
 	void updateSubtractTypes();
@@ -104,22 +107,31 @@ class GraphicObjectNode : public SceneNode
 {
 public:
 	friend class Renderer;
+	friend class NodeRegistry;
 
 	GraphicObjectNode(int index, GraphicObjectTypes type, std::shared_ptr<MeshPrimitive> mesh, std::shared_ptr<Material> material);
 	virtual ~GraphicObjectNode();
 
 	void releaseRenderResources();
-	void setLightOn(bool on){material->getParams()->setLightOn(on);}
+	void setLightOn(bool on);
 
 	void setColor(Vec<float> color, float alpha);
+	// Back to the mesh's vertex colors
+	void clearColor();
 	void setRenderable(bool render);
 	void setWireframe(bool wireframe);
 
+	// Shared materials come from the resource cache and are swapped rather than modified by the setters
+	void setMaterialShared(bool shared){sharedMaterial = shared;}
+
 	virtual bool isRenderable(){return renderable;}
 	virtual SceneNode* pickNode(Vec<float> pnt, Vec<float> direction, GraphicObjectTypes filter, float& depthOut);
 
 	DirectX::XMMATRIX getLocalToWorld() const {return localToWorld;};
 
+	// Incremented by the material setters so batched copies of this node can pick up changes
+	unsigned int getMaterialVersion() const {return materialVersion;}
+
 	std::shared_ptr<MeshPrimitive>& getMesh(){return mesh;}
 	std::shared_ptr<Material>& getMaterial(){return material;}
 
@@ -136,6 +148,8 @@ private:
 	DirectX::XMMATRIX localToWorld;
 
 	bool renderable;
+	bool sharedMaterial;
+	unsigned int materialVersion;
 
 	// Render properties
 	std::shared_ptr<MeshPrimitive> mesh;
@@ -177,9 +191,14 @@ public:
 
 	int getNumFrames();
 
-	std::map<int,GraphicObjectNode*>& sceneObjectRegistry(GraphicObjectTypes type);
+	NodeRegistry& sceneObjectRegistry(GraphicObjectTypes type);
 	void removeRegisteredObjects(GraphicObjectTypes type);
 
+	// Changes whenever nodes are attached/detached or the world transform is updated
+	unsigned int getSceneVersion() const {return sceneVersion;}
+	// Changes only when nodes are attached/detached
+	unsigned int getStructureVersion() const {return structureVersion;}
+
 	SceneNode* pickNode(Vec<float> pnt, Vec<float> direction, unsigned int currentFrame, GraphicObjectTypes filter,float& depthOut);
 	virtual SceneNode* pickNode(Vec<float> pnt, Vec<float> direction, GraphicObjectTypes filter, float& depthOut){return NULL;}
 
@@ -197,8 +216,12 @@ protected:
 	void clearSectionNodes(Renderer::Section section);
 
 	virtual NodeRegistry* getRegistry(){return registry;}
+	virtual void structureChanged(){++sceneVersion; ++structureVersion;}
 
 private:
+	unsigned int sceneVersion;
+	unsigned int structureVersion;
+
 	Vec<float> origin;
 	DirectX::XMMATRIX rootRotationMatrix;
 
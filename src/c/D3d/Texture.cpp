@@ -43,6 +43,20 @@ Const3DTexture::Const3DTexture(Renderer* rendererIn, Vec<size_t> dims, const uns
 	SAFE_RELEASE(texture3D);
 }
 
+bool Const3DTexture::readData(unsigned char* dataOut)
+{
+	if ( !resourceView )
+		return false;
+
+	ID3D11Resource* texture3D = NULL;
+	resourceView->GetResource(&texture3D);
+
+	bool read = renderer->readVolume(dataOut, texture3D, dims);
+
+	SAFE_RELEASE(texture3D);
+	return read;
+}
+
 
 
 TextAtlasTexture::TextAtlasTexture(Renderer* rendererIn, HWND hwnd, const std::string& fontFace, int textHeight, const std::string& charList)
@@ -43,6 +43,9 @@ class Const3DTexture : public ConstTextureBase
 public:
 	Const3DTexture(Renderer* rendererIn, Vec<size_t> dims, const unsigned char* texData);
 
+	// Copies the texture back from the GPU, dataOut has to hold dims.product() bytes
+	bool readData(unsigned char* dataOut);
+
 private:
 	Const3DTexture();
 	
@@ -0,0 +1,177 @@
+#include "TransformKernels.h"
+#include "TransformKernelsAvx2.h"
+
+#include "Global/ParallelFor.h"
+
+#include <cmath>
+#include <cstring>
+#include <intrin.h>
+
+namespace
+{
+	// Each thread gets at least this many points, below it the threads cost more than they save
+	const size_t parallelChunk = TransformKernels::parallelThreshold / 2;
+
+	bool detectAvx2()
+	{
+		int info[4];
+		__cpuid(info, 0);
+		if ( info[0] < 7 )
+			return false;
+
+		__cpuid(info, 1);
+		bool fma = (info[2] & (1 << 12)) != 0;
+		bool osxsave = (info[2] & (1 << 27)) != 0;
+		bool avx = (info[2] & (1 << 28)) != 0;
+		if ( !fma || !osxsave || !avx )
+			return false;
+
+		// The OS has to save the upper halves of the ymm registers
+		if ( (_xgetbv(0) & 0x6) != 0x6 )
+			return false;
+
+		__cpuidex(info, 7, 0);
+		return (info[1] & (1 << 5)) != 0;
+	}
+
+	const bool avx2Supported = detectAvx2();
+
+	inline void applyScalar(const TransformKernels::Affine& tfm, float w, float& x, float& y, float& z)
+	{
+		float ox = tfm.m[0][0]*x + tfm.m[0][1]*y + tfm.m[0][2]*z + tfm.m[0][3]*w;
+		float oy = tfm.m[1][0]*x + tfm.m[1][1]*y + tfm.m[1][2]*z + tfm.m[1][3]*w;
+		float oz = tfm.m[2][0]*x + tfm.m[2][1]*y + tfm.m[2][2]*z + tfm.m[2][3]*w;
+
+		x = ox;
+		y = oy;
+		z = oz;
+	}
+
+	void transformAoSScalar(const TransformKernels::Affine& tfm, const Vec<float>* in, Vec<float>* out, size_t count, float w)
+	{
+		for ( size_t i = 0; i < count; ++i )
+		{
+			float x = in[i].x;
+			float y = in[i].y;
+			float z = in[i].z;
+			applyScalar(tfm, w, x, y, z);
+
+			out[i] = Vec<float>(x, y, z);
+		}
+	}
+
+	void transformAoS(const TransformKernels::Affine& tfm, const Vec<float>* in, Vec<float>* out, size_t count, bool translate)
+	{
+		parallelFor(count, parallelChunk, [&](size_t begin, size_t end)
+		{
+			size_t done = (avx2Supported) ? TransformKernelsAvx2::transformAoS(tfm, in + begin, out + begin, end - begin, translate) : 0;
+			transformAoSScalar(tfm, in + begin + done, out + begin + done, end - begin - done, (translate) ? 1.0f : 0.0f);
+		});
+	}
+}
+
+
+TransformKernels::Affine TransformKernels::Affine::identity()
+{
+	Affine tfm;
+	memset(tfm.m, 0, sizeof(tfm.m));
+	for ( int r = 0; r < 3; ++r )
+		tfm.m[r][r] = 1.0f;
+
+	return tfm;
+}
+
+TransformKernels::Affine TransformKernels::Affine::fromColumnMajor(const float* mat4x4)
+{
+	Affine tfm;
+	for ( int r = 0; r < 3; ++r )
+	{
+		for ( int c = 0; c < 4; ++c )
+			tfm.m[r][c] = mat4x4[4*c + r];
+	}
+
+	return tfm;
+}
+
+TransformKernels::Affine TransformKernels::Affine::fromXMMATRIX(DirectX::FXMMATRIX mat)
+{
+	DirectX::XMFLOAT4X4 rowMajor;
+	DirectX::XMStoreFloat4x4(&rowMajor, mat);
+
+	Affine tfm;
+	for ( int r = 0; r < 3; ++r )
+	{
+		for ( int c = 0; c < 4; ++c )
+			tfm.m[r][c] = rowMajor.m[c][r];
+	}
+
+	return tfm;
+}
+
+TransformKernels::Affine TransformKernels::Affine::normalTransform() const
+{
+	// Cofactors of the upper 3x3 are its inverse transpose scaled by the determinant
+	Affine normTfm = identity();
+	for ( int r = 0; r < 3; ++r )
+	{
+		for ( int c = 0; c < 3; ++c )
+		{
+			int r1 = (r + 1) % 3;
+			int r2 = (r + 2) % 3;
+			int c1 = (c + 1) % 3;
+			int c2 = (c + 2) % 3;
+
+			normTfm.m[r][c] = m[r1][c1]*m[r2][c2] - m[r1][c2]*m[r2][c1];
+		}
+	}
+
+	float det = m[0][0]*normTfm.m[0][0] + m[0][1]*normTfm.m[0][1] + m[0][2]*normTfm.m[0][2];
+	if ( det == 0.0f )
+		return normTfm;
+
+	for ( int r = 0; r < 3; ++r )
+	{
+		for ( int c = 0; c < 3; ++c )
+			normTfm.m[r][c] /= det;
+	}
+
+	return normTfm;
+}
+
+bool TransformKernels::hasAvx2()
+{
+	return avx2Supported;
+}
+
+void TransformKernels::transformPoints(const Affine& tfm, const Vec<float>* in, Vec<float>* out, size_t count)
+{
+	transformAoS(tfm, in, out, count, true);
+}
+
+void TransformKernels::transformVectors(const Affine& tfm, const Vec<float>* in, Vec<float>* out, size_t count)
+{
+	transformAoS(tfm, in, out, count, false);
+}
+
+void TransformKernels::transformPointsSoA(const Affine& tfm, float* x, float* y, float* z, size_t count)
+{
+	parallelFor(count, parallelChunk, [&](size_t begin, size_t end)
+	{
+		size_t i = begin;
+		if ( avx2Supported )
+			i += TransformKernelsAvx2::transformSoA(tfm, x + begin, y + begin, z + begin, end - begin);
+
+		for ( ; i < end; ++i )
+			applyScalar(tfm, 1.0f, x[i], y[i], z[i]);
+	});
+}
+
+void TransformKernels::transformPointsScalar(const Affine& tfm, const Vec<float>* in, Vec<float>* out, size_t count)
+{
+	transformAoSScalar(tfm, in, out, count, 1.0f);
+}
+
+void TransformKernels::transformVectorsScalar(const Affine& tfm, const Vec<float>* in, Vec<float>* out, size_t count)
+{
+	transformAoSScalar(tfm, in, out, count, 0.0f);
+}
@@ -0,0 +1,44 @@
+#pragma once
+#include "Global/Vec.h"
+
+#include <DirectXMath.h>
+
+#include <cstddef>
+
+// Batch affine transforms of points and direction vectors.
+// AoS arrays are packed Vec<float> (12 bytes per point), SoA arrays are separate x, y and z streams.
+// Eight points at a time go through AVX2/FMA when the CPU has it, with a scalar path otherwise.
+// Large batches are split over threads, small ones run on the calling thread.
+namespace TransformKernels
+{
+	// out = m * (x,y,z,1) with column vectors, the implied last row is (0,0,0,1)
+	struct Affine
+	{
+		float m[3][4];
+
+		static Affine identity();
+		// Eigen's default 4x4 storage, e.g. Matrix4f::data()
+		static Affine fromColumnMajor(const float* mat4x4);
+		// DirectXMath multiplies row vectors, so this is the transpose of the upper 4x3
+		static Affine fromXMMATRIX(DirectX::FXMMATRIX mat);
+
+		// Inverse transpose of the upper 3x3, use it with transformVectors for normals under non-uniform scale
+		Affine normalTransform() const;
+	};
+
+	// Batches at least this size are split over threads
+	const size_t parallelThreshold = 1 << 18;
+
+	bool hasAvx2();
+
+	// In and out may be the same array
+	void transformPoints(const Affine& tfm, const Vec<float>* in, Vec<float>* out, size_t count);
+	void transformPointsSoA(const Affine& tfm, float* x, float* y, float* z, size_t count);
+
+	// Upper 3x3 only, like XMVector3TransformNormal, the results are not renormalized
+	void transformVectors(const Affine& tfm, const Vec<float>* in, Vec<float>* out, size_t count);
+
+	// Reference versions of the above on the calling thread, used for the AVX2 tails and for benchmarking
+	void transformPointsScalar(const Affine& tfm, const Vec<float>* in, Vec<float>* out, size_t count);
+	void transformVectorsScalar(const Affine& tfm, const Vec<float>* in, Vec<float>* out, size_t count);
+}
@@ -0,0 +1,101 @@
+#include "TransformKernelsAvx2.h"
+
+#include <immintrin.h>
+
+namespace
+{
+	// Three ymm loads of eight packed xyz points, split into x, y and z lanes
+	inline void loadAoS8(const float* src, __m256& x, __m256& y, __m256& z)
+	{
+		__m256 m03 = _mm256_insertf128_ps(_mm256_castps128_ps256(_mm_loadu_ps(src)), _mm_loadu_ps(src + 12), 1);
+		__m256 m14 = _mm256_insertf128_ps(_mm256_castps128_ps256(_mm_loadu_ps(src + 4)), _mm_loadu_ps(src + 16), 1);
+		__m256 m25 = _mm256_insertf128_ps(_mm256_castps128_ps256(_mm_loadu_ps(src + 8)), _mm_loadu_ps(src + 20), 1);
+
+		__m256 xy = _mm256_shuffle_ps(m14, m25, _MM_SHUFFLE(2,1,3,2));
+		__m256 yz = _mm256_shuffle_ps(m03, m14, _MM_SHUFFLE(1,0,2,1));
+		x = _mm256_shuffle_ps(m03, xy, _MM_SHUFFLE(2,0,3,0));
+		y = _mm256_shuffle_ps(yz, xy, _MM_SHUFFLE(3,1,2,0));
+		z = _mm256_shuffle_ps(yz, m25, _MM_SHUFFLE(3,0,3,1));
+	}
+
+	inline void storeAoS8(float* dst, __m256 x, __m256 y, __m256 z)
+	{
+		__m256 rxy = _mm256_shuffle_ps(x, y, _MM_SHUFFLE(2,0,2,0));
+		__m256 ryz = _mm256_shuffle_ps(y, z, _MM_SHUFFLE(3,1,3,1));
+		__m256 rzx = _mm256_shuffle_ps(z, x, _MM_SHUFFLE(3,1,2,0));
+
+		__m256 r03 = _mm256_shuffle_ps(rxy, rzx, _MM_SHUFFLE(2,0,2,0));
+		__m256 r14 = _mm256_shuffle_ps(ryz, rxy, _MM_SHUFFLE(3,1,2,0));
+		__m256 r25 = _mm256_shuffle_ps(rzx, ryz, _MM_SHUFFLE(3,1,3,1));
+
+		_mm_storeu_ps(dst, _mm256_castps256_ps128(r03));
+		_mm_storeu_ps(dst + 4, _mm256_castps256_ps128(r14));
+		_mm_storeu_ps(dst + 8, _mm256_castps256_ps128(r25));
+		_mm_storeu_ps(dst + 12, _mm256_extractf128_ps(r03, 1));
+		_mm_storeu_ps(dst + 16, _mm256_extractf128_ps(r14, 1));
+		_mm_storeu_ps(dst + 20, _mm256_extractf128_ps(r25, 1));
+	}
+
+	struct AvxAffine
+	{
+		__m256 m[3][4];
+
+		AvxAffine(const TransformKernels::Affine& tfm, bool translate)
+		{
+			for ( int r = 0; r < 3; ++r )
+			{
+				for ( int c = 0; c < 4; ++c )
+					m[r][c] = _mm256_set1_ps((c < 3 || translate) ? tfm.m[r][c] : 0.0f);
+			}
+		}
+
+		inline void apply(__m256& x, __m256& y, __m256& z) const
+		{
+			__m256 ox = _mm256_fmadd_ps(m[0][0], x, _mm256_fmadd_ps(m[0][1], y, _mm256_fmadd_ps(m[0][2], z, m[0][3])));
+			__m256 oy = _mm256_fmadd_ps(m[1][0], x, _mm256_fmadd_ps(m[1][1], y, _mm256_fmadd_ps(m[1][2], z, m[1][3])));
+			__m256 oz = _mm256_fmadd_ps(m[2][0], x, _mm256_fmadd_ps(m[2][1], y, _mm256_fmadd_ps(m[2][2], z, m[2][3])));
+
+			x = ox;
+			y = oy;
+			z = oz;
+		}
+	};
+}
+
+
+size_t TransformKernelsAvx2::transformAoS(const TransformKernels::Affine& tfm, const Vec<float>* in, Vec<float>* out, size_t count, bool translate)
+{
+	AvxAffine avxTfm(tfm, translate);
+
+	// All eight points are loaded before any are stored, so in place works
+	size_t i = 0;
+	for ( ; i + 8 <= count; i += 8 )
+	{
+		__m256 x, y, z;
+		loadAoS8(in[i].e, x, y, z);
+		avxTfm.apply(x, y, z);
+		storeAoS8(out[i].e, x, y, z);
+	}
+
+	return i;
+}
+
+size_t TransformKernelsAvx2::transformSoA(const TransformKernels::Affine& tfm, float* x, float* y, float* z, size_t count)
+{
+	AvxAffine avxTfm(tfm, true);
+
+	size_t i = 0;
+	for ( ; i + 8 <= count; i += 8 )
+	{
+		__m256 vx = _mm256_loadu_ps(x + i);
+		__m256 vy = _mm256_loadu_ps(y + i);
+		__m256 vz = _mm256_loadu_ps(z + i);
+		avxTfm.apply(vx, vy, vz);
+
+		_mm256_storeu_ps(x + i, vx);
+		_mm256_storeu_ps(y + i, vy);
+		_mm256_storeu_ps(z + i, vz);
+	}
+
+	return i;
+}
@@ -0,0 +1,14 @@
+#pragma once
+#include "TransformKernels.h"
+
+#include <cstddef>
+
+// The AVX2/FMA loops of TransformKernels, only call them when TransformKernels::hasAvx2() is true.
+// They live in their own file so gcc/clang can build just this one for AVX2, the rest has to run on any x64 CPU.
+// Each handles whole groups of eight and returns how many it did, the caller finishes the tail.
+namespace TransformKernelsAvx2
+{
+	// In and out may be the same array
+	size_t transformAoS(const TransformKernels::Affine& tfm, const Vec<float>* in, Vec<float>* out, size_t count, bool translate);
+	size_t transformSoA(const TransformKernels::Affine& tfm, float* x, float* y, float* z, size_t count);
+}
@@ -1,4 +1,12 @@
 #include "VertexLayouts.h"
+#include "VertexPacking.h"
+
+#include <algorithm>
+#include <cstring>
+#include <xmmintrin.h>
+
+#undef min
+#undef max
 
 const std::string VertexLayout::semantic[Attributes::ATTR_END] = {"POSITION","NORMAL","TEXCOORD","COLOR","COLOR"};
 const uint32_t VertexLayout::semanticIdx[Attributes::ATTR_END] ={0,0,0,0,1};
@@ -12,6 +20,15 @@ const DXGI_FORMAT VertexLayout::format[Attributes::ATTR_END] =
 
 const uint32_t VertexLayout::elems[Attributes::ATTR_END] = {3,3,3,4,4};
 
+const DXGI_FORMAT VertexLayout::packedFormat[Attributes::ATTR_END] =
+		{DXGI_FORMAT_R16G16B16A16_SNORM,
+		DXGI_FORMAT_R10G10B10A2_UNORM,
+		DXGI_FORMAT_R16G16_FLOAT,
+		DXGI_FORMAT_R8G8B8A8_UNORM,
+		DXGI_FORMAT_R8G8B8A8_UNORM};
+
+const uint32_t VertexLayout::packedSize[Attributes::ATTR_END] = {8,4,4,4,4};
+
 const std::map<VertexLayout::Types, VertexLayout::Info> VertexLayout::layoutInfo =
 		{{VertexLayout::Types::P, VertexLayout::Info(VertexLayout::Types::P,"P")},
 		{VertexLayout::Types::PN, VertexLayout::Info(VertexLayout::Types::PN,"PN")},
@@ -21,24 +38,29 @@ const std::map<VertexLayout::Types, VertexLayout::Info> VertexLayout::layoutInfo
 		{VertexLayout::Types::PTC, VertexLayout::Info(VertexLayout::Types::PTC,"PTC")},
 		{VertexLayout::Types::PTCC, VertexLayout::Info(VertexLayout::Types::PTCC,"PTCC")},
 		{VertexLayout::Types::PNTC, VertexLayout::Info(VertexLayout::Types::PNTC,"PNTC")},
-		{VertexLayout::Types::PNTCC, VertexLayout::Info(VertexLayout::Types::PNTCC, "PNTCC")}};
+		{VertexLayout::Types::PNTCC, VertexLayout::Info(VertexLayout::Types::PNTCC, "PNTCC")},
+		{VertexLayout::Types::PNCPacked, VertexLayout::Info(VertexLayout::Types::PNCPacked, "PNCPacked")}};
 
 VertexLayout::Info::Info(VertexLayout::Types layout, const std::string& name)
 	: name(name), size(0)
 {
+	bool packed = ((LAYOUT_ELEM(Attributes::ATTR_END) & layout) != 0);
+
 	int accumOffset = 0;
 	for ( int i=0; i < Attributes::ATTR_END; ++i )
 	{
 		offsets[i] = -1;
+		sizes[i] = 0;
 		if ( !(LAYOUT_ELEM(i) & layout) )
 			continue;
 
 		offsets[i] = accumOffset;
+		sizes[i] = (packed) ? packedSize[i] : (elemSize * elems[i]);
 
 		D3D11_INPUT_ELEMENT_DESC newDesc;
 		newDesc.SemanticName = semantic[i].c_str();
 		newDesc.SemanticIndex = semanticIdx[i];
-		newDesc.Format = format[i];
+		newDesc.Format = (packed) ? packedFormat[i] : format[i];
 		newDesc.InputSlot = 0;
 		newDesc.AlignedByteOffset = offsets[i];
 		newDesc.InputSlotClass = D3D11_INPUT_PER_VERTEX_DATA;
@@ -46,13 +68,13 @@ VertexLayout::Info::Info(VertexLayout::Types layout, const std::string& name)
 
 		inputLayout.push_back(newDesc);
 
-		size += elemSize * elems[i];
-		accumOffset += elemSize * elems[i];
+		size += sizes[i];
+		accumOffset += sizes[i];
 	}
 }
 
 VertexLayout::VertexLayout(VertexLayout::Types layoutType)
-	: layoutType(layoutType)
+	: layoutType(layoutType), posScale(1.0f, 1.0f, 1.0f), posOffset(0.0f, 0.0f, 0.0f)
 {}
 
 size_t VertexLayout::getVertSize()
@@ -60,9 +82,34 @@ size_t VertexLayout::getVertSize()
 	return layoutInfo.at(layoutType).size;
 }
 
-void* VertexLayout::allocLayout(size_t numVerts)
+size_t VertexLayout::getUnpackedVertSize()
+{
+	size_t size = 0;
+	for ( int i=0; i < Attributes::ATTR_END; ++i )
+	{
+		if ( validAttribute((Attributes)i) )
+			size += elemSize * elems[i];
+	}
+
+	return size;
+}
+
+void* VertexLayout::stagingLayout(size_t numVerts)
 {
-	return new uint8_t[numVerts * getVertSize()];
+	// Keeps large meshes from pinning their staging size for the life of the thread
+	static const size_t maxKeptBytes = 64 * 1024 * 1024;
+
+	static thread_local std::vector<uint8_t> staging;
+
+	size_t bytes = numVerts * getVertSize();
+	if ( bytes > staging.size() || (staging.size() > maxKeptBytes && bytes < staging.size() / 4) )
+	{
+		staging.clear();
+		staging.shrink_to_fit();
+		staging.resize(bytes);
+	}
+
+	return staging.data();
 }
 
 void VertexLayout::sliceIntoLayout(void* vertMem, Attributes attr, size_t numVerts, const float* data, size_t outPitch)
@@ -75,15 +122,146 @@ void VertexLayout::sliceIntoLayout(void* vertMem, Attributes attr, size_t numVer
 
 	uint8_t* inLine = (uint8_t*)data;
 	uint8_t* outLine = (uint8_t*)vertMem;
-	for ( int i=0; i < numVerts; ++i )
+
+	if ( !isPacked() )
+	{
+		for ( size_t i=0; i < numVerts; ++i )
+		{
+			memcpy(outLine + attrOffset, inLine, attrSize);
+
+			outLine += outPitch;
+			inLine += attrSize;
+		}
+
+		return;
+	}
+
+	Vec<float> invHalfExtent = Vec<float>(1.0f, 1.0f, 1.0f) / posScale;
+	for ( size_t i=0; i < numVerts; ++i )
 	{
-		memcpy(outLine + attrOffset, inLine, attrSize);
+		const float* inVals = (const float*)inLine;
+
+		switch ( attr )
+		{
+		case Attributes::Position:
+			VertexPacking::packPosition(Vec<float>(inVals[0], inVals[1], inVals[2]), posOffset, invHalfExtent, outLine + attrOffset);
+			break;
+		case Attributes::Normal:
+			VertexPacking::packNormal(Vec<float>(inVals[0], inVals[1], inVals[2]), outLine + attrOffset);
+			break;
+		case Attributes::TextureUV:
+			VertexPacking::packTextureUV(Vec<float>(inVals[0], inVals[1], inVals[2]), outLine + attrOffset);
+			break;
+		default:
+			VertexPacking::packColor(::Color(inVals[0], inVals[1], inVals[2], inVals[3]), outLine + attrOffset);
+			break;
+		}
 
 		outLine += outPitch;
 		inLine += attrSize;
 	}
 }
 
+void VertexLayout::interleave(void* vertMem, size_t numVerts, const float* const data[Attributes::ATTR_END], size_t outPitch)
+{
+	const Info& info = layoutInfo.at(layoutType);
+	if ( outPitch == 0 )
+		outPitch = info.size;
+
+	// Attributes in this layout, in buffer order
+	int numAttrs = 0;
+	int attrs[Attributes::ATTR_END];
+	for ( int i=0; i < Attributes::ATTR_END; ++i )
+	{
+		if ( validAttribute((Attributes)i) )
+			attrs[numAttrs++] = i;
+	}
+
+	uint8_t* outLine = (uint8_t*)vertMem;
+
+	if ( isPacked() )
+	{
+		Vec<float> invHalfExtent = Vec<float>(1.0f, 1.0f, 1.0f) / posScale;
+		for ( size_t v=0; v < numVerts; ++v )
+		{
+			for ( int a=0; a < numAttrs; ++a )
+			{
+				int attr = attrs[a];
+				uint8_t* out = outLine + info.offsets[attr];
+				if ( !data[attr] )
+				{
+					memset(out, 0, info.sizes[attr]);
+					continue;
+				}
+
+				const float* in = data[attr] + v*elems[attr];
+				switch ( attr )
+				{
+				case Attributes::Position:
+					VertexPacking::packPosition(Vec<float>(in[0], in[1], in[2]), posOffset, invHalfExtent, out);
+					break;
+				case Attributes::Normal:
+					VertexPacking::packNormal(Vec<float>(in[0], in[1], in[2]), out);
+					break;
+				case Attributes::TextureUV:
+					VertexPacking::packTextureUV(Vec<float>(in[0], in[1], in[2]), out);
+					break;
+				default:
+					VertexPacking::packColor(::Color(in[0], in[1], in[2], in[3]), out);
+					break;
+				}
+			}
+
+			outLine += outPitch;
+		}
+
+		return;
+	}
+
+	// Every float attribute is moved with one 16 byte load and store. The extra lane of a 3 float attribute
+	// spills into the attribute (or vertex) after it, which is written later, so only the last vertex needs
+	// exact sized copies. A padded pitch would let the spill land outside the vertex so it takes the slow path.
+	size_t numFast = (outPitch == size_t(info.size) && numVerts > 0) ? numVerts - 1 : 0;
+
+	const __m128 zero = _mm_setzero_ps();
+	for ( size_t v=0; v < numFast; ++v )
+	{
+		for ( int a=0; a < numAttrs; ++a )
+		{
+			int attr = attrs[a];
+			__m128 val = (data[attr]) ? _mm_loadu_ps(data[attr] + v*elems[attr]) : zero;
+			_mm_storeu_ps((float*)(outLine + info.offsets[attr]), val);
+		}
+
+		outLine += outPitch;
+	}
+
+	for ( size_t v=numFast; v < numVerts; ++v )
+	{
+		for ( int a=0; a < numAttrs; ++a )
+		{
+			int attr = attrs[a];
+			size_t attrSize = elemSize*elems[attr];
+			if ( data[attr] )
+				memcpy(outLine + info.offsets[attr], data[attr] + v*elems[attr], attrSize);
+			else
+				memset(outLine + info.offsets[attr], 0, attrSize);
+		}
+
+		outLine += outPitch;
+	}
+}
+
+void VertexLayout::setPositionBounds(Vec<float> boundsMin, Vec<float> boundsMax)
+{
+	posOffset = (boundsMin + boundsMax) * 0.5f;
+	posScale = (boundsMax - boundsMin) * 0.5f;
+
+	// Flat meshes still need a valid decode scale
+	for ( int i = 0; i < 3; ++i )
+		posScale.e[i] = std::max(posScale.e[i], 1e-6f);
+}
+
 const std::string& VertexLayout::getName()
 {
 	return layoutInfo.at(layoutType).name;
@@ -37,16 +37,31 @@ public:
 		PTC	= LAYOUT_ELEM(Attributes::Position)	| LAYOUT_ELEM(Attributes::TextureUV)| LAYOUT_ELEM(Attributes::Color),
 		PTCC = LAYOUT_ELEM(Attributes::Position)| LAYOUT_ELEM(Attributes::TextureUV)| LAYOUT_ELEM(Attributes::Color)	| LAYOUT_ELEM(Attributes::ColorBack),
 		PNTC = LAYOUT_ELEM(Attributes::Position) | LAYOUT_ELEM(Attributes::Normal)	| LAYOUT_ELEM(Attributes::TextureUV)| LAYOUT_ELEM(Attributes::Color),
-		PNTCC = LAYOUT_ELEM(Attributes::Position) | LAYOUT_ELEM(Attributes::Normal)	| LAYOUT_ELEM(Attributes::TextureUV)| LAYOUT_ELEM(Attributes::Color) | LAYOUT_ELEM(Attributes::ColorBack)
+		PNTCC = LAYOUT_ELEM(Attributes::Position) | LAYOUT_ELEM(Attributes::Normal)	| LAYOUT_ELEM(Attributes::TextureUV)| LAYOUT_ELEM(Attributes::Color) | LAYOUT_ELEM(Attributes::ColorBack),
+
+		// The bit past the last attribute selects the compact formats (see VertexPacking.h), 16 bytes per PNC vertex instead of 40
+		PNCPacked = PNC | LAYOUT_ELEM(Attributes::ATTR_END)
 	};
 
 public:
 	VertexLayout(Types layoutType = Types::P);
 
 	size_t getVertSize();
+	// Size of the same attributes stored as floats
+	size_t getUnpackedVertSize();
 	bool validAttribute(Attributes attr){return ((LAYOUT_ELEM(attr) & layoutType) != 0);}
-	void* allocLayout(size_t numVerts);
+	bool isPacked() const {return ((LAYOUT_ELEM(Attributes::ATTR_END) & layoutType) != 0);}
+	// Scratch memory for one vertex upload, owned by the calling thread and reused by its next call (don't free it)
+	void* stagingLayout(size_t numVerts);
+	// Input data is always float (Color is 4 floats, the others 3), packed layouts encode while slicing
 	void sliceIntoLayout(void* vertMem, Attributes attr, size_t numVerts, const float* data, size_t outPitch = 0);
+	// Writes every attribute of each vertex in one pass, data is indexed by Attributes and NULL entries are zero filled
+	void interleave(void* vertMem, size_t numVerts, const float* const data[Attributes::ATTR_END], size_t outPitch = 0);
+
+	// Packed positions are stored relative to these bounds, set them before slicing in positions
+	void setPositionBounds(Vec<float> boundsMin, Vec<float> boundsMax);
+	// Shader decode, modelPos = packedPos*scale + offset (identity for float layouts)
+	void getPositionDecode(Vec<float>& scaleOut, Vec<float>& offsetOut) const {scaleOut = posScale; offsetOut = posOffset;}
 
 	Types getType(){return layoutType;}
 
@@ -62,6 +77,7 @@ private:
 
 		int size;
 		int offsets[Attributes::ATTR_END];
+		int sizes[Attributes::ATTR_END];
 
 		Info(Types layout, const std::string& name);
 	};
@@ -70,6 +86,8 @@ private:
 	static const uint32_t semanticIdx[Attributes::ATTR_END];
 
 	static const DXGI_FORMAT format[Attributes::ATTR_END];
+	static const DXGI_FORMAT packedFormat[Attributes::ATTR_END];
+	static const uint32_t packedSize[Attributes::ATTR_END];
 
 	static const uint32_t elemSize = sizeof(float);
 	static const uint32_t elems[Attributes::ATTR_END];
@@ -78,4 +96,7 @@ private:
 
 	// Non-static info
 	Types layoutType;
+
+	Vec<float> posScale;
+	Vec<float> posOffset;
 };
\ No newline at end of file
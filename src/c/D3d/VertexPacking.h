@@ -0,0 +1,73 @@
+#pragma once
+#include "Global/Vec.h"
+#include "Global/Color.h"
+
+#include <DirectXMath.h>
+#include <DirectXPackedVector.h>
+
+#include <cstdint>
+#include <cstring>
+#include <vector>
+
+// Encoders for the compact vertex and index formats.
+// Colors and normals are decoded by the input assembler, positions are snorm16 in [-1,1] over the
+// mesh bounds and rescaled in the vertex shader with the decode values from the vertex layout.
+namespace VertexPacking
+{
+	// DXGI_FORMAT_R16G16B16A16_SNORM, w is always 1
+	inline void packPosition(const Vec<float>& pos, const Vec<float>& center, const Vec<float>& invHalfExtent, void* out)
+	{
+		DirectX::PackedVector::XMSHORTN4 packed;
+		DirectX::PackedVector::XMStoreShortN4(&packed, DirectX::XMVectorSet(
+			(pos.x - center.x) * invHalfExtent.x, (pos.y - center.y) * invHalfExtent.y, (pos.z - center.z) * invHalfExtent.z, 1.0f));
+
+		memcpy(out, &packed, sizeof(packed));
+	}
+
+	// DXGI_FORMAT_R10G10B10A2_UNORM, components are biased to [0,1] and expanded again in the shader
+	inline void packNormal(const Vec<float>& normal, void* out)
+	{
+		DirectX::PackedVector::XMUDECN4 packed;
+		DirectX::PackedVector::XMStoreUDecN4(&packed, DirectX::XMVectorSet(
+			normal.x*0.5f + 0.5f, normal.y*0.5f + 0.5f, normal.z*0.5f + 0.5f, 0.0f));
+
+		memcpy(out, &packed, sizeof(packed));
+	}
+
+	// DXGI_FORMAT_R16G16_FLOAT
+	inline void packTextureUV(const Vec<float>& uv, void* out)
+	{
+		DirectX::PackedVector::XMHALF2 packed(uv.x, uv.y);
+		memcpy(out, &packed, sizeof(packed));
+	}
+
+	// DXGI_FORMAT_R8G8B8A8_UNORM
+	inline void packColor(const Color& color, void* out)
+	{
+		DirectX::PackedVector::XMUBYTEN4 packed;
+		DirectX::PackedVector::XMStoreUByteN4(&packed, DirectX::XMVectorSet(color.r, color.g, color.b, color.a));
+
+		memcpy(out, &packed, sizeof(packed));
+	}
+
+	// DXGI_FORMAT_R16_UINT indices, returns false (and leaves indicesOut empty) if any vertex index doesn't fit
+	inline bool packIndices16(const std::vector<Vec<uint32_t>>& faces, std::vector<uint16_t>& indicesOut)
+	{
+		indicesOut.clear();
+		for ( const Vec<uint32_t>& face : faces )
+		{
+			if ( face.x > 0xFFFF || face.y > 0xFFFF || face.z > 0xFFFF )
+				return false;
+		}
+
+		indicesOut.resize(3 * faces.size());
+		for ( size_t i = 0; i < faces.size(); ++i )
+		{
+			indicesOut[3*i] = uint16_t(faces[i].x);
+			indicesOut[3*i + 1] = uint16_t(faces[i].y);
+			indicesOut[3*i + 2] = uint16_t(faces[i].z);
+		}
+
+		return true;
+	}
+}
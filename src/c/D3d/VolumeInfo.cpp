@@ -4,6 +4,9 @@
 #include "MeshPrimitive.h"
 #include "Material.h"
 #include "MaterialParams.h"
+#include "Texture.h"
+
+#include "Global/Profiler.h"
 
 
 VolumeInfo::VolumeInfo(Renderer* renderer, int numFrames, int numChannels, Vec<size_t> dims, Vec<float> physSize, bool columnMajor)
@@ -14,7 +17,10 @@ VolumeInfo::VolumeInfo(Renderer* renderer, int numFrames, int numChannels, Vec<s
 	volumeMesh = createMesh<ViewAlignedPlanes>();
 
 	for ( int i=GraphicObjectTypes::OriginalVolume; i < GraphicObjectTypes::NumGO; ++i )
+	{
 		createParams<StaticVolumeParams>((GraphicObjectTypes)i, numChannels);
+		pickFrame[i - GraphicObjectTypes::OriginalVolume] = -1;
+	}
 }
 
 std::shared_ptr<VolumeParams> VolumeInfo::getParams(GraphicObjectTypes type) const
@@ -43,6 +49,79 @@ GraphicObjectNode* VolumeInfo::createNode(GraphicObjectTypes type, int frame, co
 	return node;
 }
 
+void VolumeInfo::clearPickData(GraphicObjectTypes type, int frame)
+{
+	int volType = type - GraphicObjectTypes::OriginalVolume;
+	if ( frame >= 0 && frame != pickFrame[volType] )
+		return;
+
+	pickData[volType].reset();
+	pickFrame[volType] = -1;
+}
+
+std::shared_ptr<VolumePickData> VolumeInfo::buildPickData(GraphicObjectNode* node) const
+{
+	PROFILE_ZONE("BuildPickData");
+
+	std::vector<unsigned char> imageData(numChannels*dims.product());
+	for ( int c=0; c < numChannels; ++c )
+	{
+		Const3DTexture* texture = dynamic_cast<Const3DTexture*>(node->getMaterial()->getTexture(c).get());
+		if ( !texture || !texture->readData(imageData.data() + c*dims.product()) )
+			return std::shared_ptr<VolumePickData>();
+	}
+
+	return std::make_shared<VolumePickData>(dims, numChannels, imageData.data());
+}
+
+bool VolumeInfo::pickVolume(GraphicObjectTypes type, int frame, GraphicObjectNode* node, Vec<float> imagePnt, Vec<float> imageDir,
+	float tMin, float tMax, float threshold, float& hitT)
+{
+	int volType = type - GraphicObjectTypes::OriginalVolume;
+
+	if ( pickFrame[volType] != frame || !pickData[volType] )
+	{
+		pickData[volType] = buildPickData(node);
+		pickFrame[volType] = frame;
+	}
+
+	if ( !pickData[volType] )
+		return false;
+
+	std::shared_ptr<VolumeParams> params = getParams(type);
+
+	const DirectX::XMFLOAT4* transferFcns = params->ptr<DirectX::XMFLOAT4>("transferFunctions");
+	const DirectX::XMFLOAT4* ranges = params->ptr<DirectX::XMFLOAT4>("ranges");
+	const DirectX::XMFLOAT4* colors = params->ptr<DirectX::XMFLOAT4>("channelColors");
+
+	std::vector<VolumePickData::ChannelParams> chanParams(numChannels);
+	for ( int c=0; c < numChannels; ++c )
+	{
+		chanParams[c].transferFcn = Vec<float>(transferFcns[c].x, transferFcns[c].y, transferFcns[c].z);
+		chanParams[c].range = Vec<float>(ranges[c].x, ranges[c].y, 0.0f);
+		chanParams[c].color = Vec<float>(colors[c].x, colors[c].y, colors[c].z);
+		chanParams[c].alpha = colors[c].w;
+	}
+
+	// Image space is 1-based (column, row, plane), the volume data is 0-based (row, column, plane)
+	Vec<float> voxelPnt(imagePnt.y - 1.0f, imagePnt.x - 1.0f, imagePnt.z - 1.0f);
+	Vec<float> voxelDir(imageDir.y, imageDir.x, imageDir.z);
+
+	return pickData[volType]->march(voxelPnt, voxelDir, tMin, tMax, chanParams, threshold, hitT);
+}
+
+Vec<float> VolumeInfo::modelToImageSpace(Vec<float> pnt) const
+{
+	Eigen::Vector4f imPnt = modelToIm * Eigen::Vector4f(pnt.x, pnt.y, pnt.z, 1.0f);
+	return Vec<float>(imPnt[0], imPnt[1], imPnt[2]);
+}
+
+Vec<float> VolumeInfo::modelToImageDirection(Vec<float> dir) const
+{
+	Eigen::Vector4f imDir = modelToIm * Eigen::Vector4f(dir.x, dir.y, dir.z, 0.0f);
+	return Vec<float>(imDir[0], imDir[1], imDir[2]);
+}
+
 void VolumeInfo::updateImToModel()
 {
 	Vec<float> dimsf = getDims();
@@ -62,5 +141,7 @@ void VolumeInfo::updateImToModel()
 							* Eigen::Translation3f(-1.0f, -1.0f, -1.0f);
 
 	imToModel = (transform).matrix();
+	modelToIm = imToModel.inverse();
+	imToModelAffine = TransformKernels::Affine::fromColumnMajor(imToModel.data());
 }
 
@@ -2,6 +2,8 @@
 
 #include "Renderer.h"
 #include "MaterialParams.h"
+#include "VolumePick.h"
+#include "TransformKernels.h"
 
 // This is a helper class that keeps track of information related to 
 // the currently loaded volume (created using InitTexture call)
@@ -18,6 +20,14 @@ public:
 	std::shared_ptr<VolumeParams> getParams(GraphicObjectTypes type) const;
 	GraphicObjectNode* createNode(GraphicObjectTypes type, int frame, const unsigned char* imageData = NULL) const;
 
+	// Drops the cached pick data if it belongs to this frame, a negative frame drops it for any frame of the type
+	void clearPickData(GraphicObjectTypes type, int frame = -1);
+
+	// Ray is in image space, returns the ray parameter of the first voxel whose transfer-function opacity reaches the threshold.
+	// The first pick on a frame reads its textures back from node, only the last picked frame of each type is kept.
+	bool pickVolume(GraphicObjectTypes type, int frame, GraphicObjectNode* node, Vec<float> imagePnt, Vec<float> imageDir,
+		float tMin, float tMax, float threshold, float& hitT);
+
 
 	void setFrames(int framesIn)
 	{
@@ -58,6 +68,16 @@ public:
 		}
 	}
 
+	// In place for vertices that are already floats, uses the batch transform kernels
+	void imageToModelSpace(Vec<float>* verts, size_t numVerts) const
+	{
+		TransformKernels::transformPoints(imToModelAffine, verts, verts, numVerts);
+	}
+
+	// Convert from normalized model space back to image space
+	Vec<float> modelToImageSpace(Vec<float> pnt) const;
+	Vec<float> modelToImageDirection(Vec<float> dir) const;
+
 private:
 	VolumeInfo(){}
 	VolumeInfo(const VolumeInfo& other){}
@@ -105,10 +125,18 @@ private:
 	Vec<size_t> dims;
 
 	Eigen::Matrix4f imToModel;
+	Eigen::Matrix4f modelToIm;
+	TransformKernels::Affine imToModelAffine;
 
 	// Shared parameters (transfer function, etc.) for rendering volume frames
 	std::shared_ptr<VolumeParams> sharedParams[GraphicObjectTypes::NumGO - GraphicObjectTypes::OriginalVolume];
 
 	// Shared volume mesh for rendering
 	std::shared_ptr<MeshPrimitive> volumeMesh;
+
+	std::shared_ptr<VolumePickData> buildPickData(GraphicObjectNode* node) const;
+
+	// CPU-side copy of the last picked frame of each type
+	int pickFrame[GraphicObjectTypes::NumGO - GraphicObjectTypes::OriginalVolume];
+	std::shared_ptr<VolumePickData> pickData[GraphicObjectTypes::NumGO - GraphicObjectTypes::OriginalVolume];
 };
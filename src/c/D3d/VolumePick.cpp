@@ -0,0 +1,271 @@
+#include "VolumePick.h"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+#undef min
+#undef max
+
+
+VolumePickData::VolumePickData(Vec<size_t> dims, int numChannels, const unsigned char* imageData)
+	: dims(dims), numChannels(numChannels)
+{
+	data.assign(imageData, imageData + numChannels*dims.product());
+	buildBricks();
+}
+
+void VolumePickData::buildBricks()
+{
+	brickDims = (dims + (brickSize - 1)) / brickSize;
+
+	size_t numBricks = brickDims.product();
+	brickMin.assign(numChannels*numBricks, 255);
+	brickMax.assign(numChannels*numBricks, 0);
+
+	for ( int c = 0; c < numChannels; ++c )
+	{
+		const uint8_t* chanData = data.data() + c*dims.product();
+		uint8_t* chanMin = brickMin.data() + c*numBricks;
+		uint8_t* chanMax = brickMax.data() + c*numBricks;
+
+		for ( size_t bz = 0; bz < brickDims.z; ++bz )
+		{
+			for ( size_t by = 0; by < brickDims.y; ++by )
+			{
+				for ( size_t bx = 0; bx < brickDims.x; ++bx )
+				{
+					// Interpolated samples in a brick can also read from the next voxel over
+					Vec<size_t> start(bx*brickSize, by*brickSize, bz*brickSize);
+					Vec<size_t> end = Vec<size_t>::min(start + (brickSize + 1), dims);
+
+					uint8_t minVal = 255;
+					uint8_t maxVal = 0;
+					for ( size_t z = start.z; z < end.z; ++z )
+					{
+						for ( size_t y = start.y; y < end.y; ++y )
+						{
+							const uint8_t* row = chanData + (y + z*dims.y)*dims.x;
+							for ( size_t x = start.x; x < end.x; ++x )
+							{
+								minVal = std::min(minVal, row[x]);
+								maxVal = std::max(maxVal, row[x]);
+							}
+						}
+					}
+
+					size_t brick = bx + (by + bz*brickDims.y)*brickDims.x;
+					chanMin[brick] = minVal;
+					chanMax[brick] = maxVal;
+				}
+			}
+		}
+	}
+
+	brickEmpty.clear();
+	cachedParams.clear();
+}
+
+void VolumePickData::updateEmptyBricks(const std::vector<ChannelParams>& params, float threshold)
+{
+	std::vector<float> paramKey;
+	paramKey.reserve(params.size()*10 + 1);
+	paramKey.push_back(threshold);
+	for ( const ChannelParams& chan : params )
+	{
+		for ( int i = 0; i < 3; ++i )
+		{
+			paramKey.push_back(chan.transferFcn.e[i]);
+			paramKey.push_back(chan.range.e[i]);
+			paramKey.push_back(chan.color.e[i]);
+		}
+		paramKey.push_back(chan.alpha);
+	}
+
+	if ( !brickEmpty.empty() && paramKey == cachedParams )
+		return;
+
+	size_t numBricks = brickDims.product();
+	brickEmpty.assign(numBricks, false);
+
+	for ( size_t b = 0; b < numBricks; ++b )
+	{
+		// Upper bound on the opacity anywhere in this brick, mirrors the composite in ViewAlignedVolumePS
+		Vec<float> alphaBound(0.0f);
+		for ( int c = 0; c < numChannels && c < params.size(); ++c )
+		{
+			float maxMapped = maxMappedIntensity(brickMin[c*numBricks + b] / 255.0f, brickMax[c*numBricks + b] / 255.0f, params[c]);
+			alphaBound += params[c].color * (maxMapped * params[c].alpha / 2.0f);
+		}
+
+		brickEmpty[b] = (alphaBound.maxValue() < threshold);
+	}
+
+	cachedParams = paramKey;
+}
+
+bool VolumePickData::march(Vec<float> origin, Vec<float> direction, float tMin, float tMax,
+	const std::vector<ChannelParams>& params, float threshold, float& hitT)
+{
+	// Clip the ray to the volume bounds (voxel centers are at integer positions)
+	for ( int i = 0; i < 3; ++i )
+	{
+		float lo = 0.0f;
+		float hi = float(dims.e[i] - 1);
+
+		if ( std::abs(direction.e[i]) < 1e-8f )
+		{
+			if ( origin.e[i] < lo || origin.e[i] > hi )
+				return false;
+
+			continue;
+		}
+
+		float t0 = (lo - origin.e[i]) / direction.e[i];
+		float t1 = (hi - origin.e[i]) / direction.e[i];
+
+		tMin = std::max(tMin, std::min(t0, t1));
+		tMax = std::min(tMax, std::max(t0, t1));
+	}
+
+	if ( tMin > tMax )
+		return false;
+
+	updateEmptyBricks(params, threshold);
+
+	// Half-voxel steps along the ray
+	float dirLength = std::sqrt(Vec<float>::dot(direction, direction));
+	float dt = 0.5f / dirLength;
+
+	float prevT = tMin;
+	for ( float t = tMin; t <= tMax; t += dt )
+	{
+		Vec<float> pos = origin + direction * t;
+
+		if ( brickEmpty[brickIndex(pos)] )
+		{
+			// Jump to the far side of this brick and re-align to the step size
+			float exitT = brickExit(origin, direction, pos);
+			prevT = t;
+			t = std::max(t, tMin + std::ceil((exitT - tMin) / dt) * dt - dt);
+			continue;
+		}
+
+		if ( sampleOpacity(pos, params) < threshold )
+		{
+			prevT = t;
+			continue;
+		}
+
+		// Refine the crossing between the last empty sample and this one
+		float lo = prevT;
+		float hi = t;
+		for ( int i = 0; i < 5; ++i )
+		{
+			float mid = 0.5f * (lo + hi);
+			if ( sampleOpacity(origin + direction * mid, params) < threshold )
+				lo = mid;
+			else
+				hi = mid;
+		}
+
+		hitT = hi;
+		return true;
+	}
+
+	return false;
+}
+
+float VolumePickData::sampleOpacity(Vec<float> pos, const std::vector<ChannelParams>& params) const
+{
+	Vec<float> alphaComposite(0.0f);
+	for ( int c = 0; c < numChannels && c < params.size(); ++c )
+	{
+		float intensity = mapIntensity(sampleChannel(pos, c), params[c]);
+		if ( intensity < 0.01f || params[c].alpha < 0.01f )
+			continue;
+
+		alphaComposite += params[c].color * (intensity * params[c].alpha / 2.0f);
+	}
+
+	return alphaComposite.maxValue();
+}
+
+float VolumePickData::sampleChannel(Vec<float> pos, int channel) const
+{
+	// Trilinear interpolation to match the linear sampler used for rendering
+	Vec<float> maxPos = Vec<float>(dims) - 1.0f;
+	pos = Vec<float>::max(Vec<float>(0.0f), Vec<float>::min(pos, maxPos));
+
+	Vec<size_t> base(size_t(pos.x), size_t(pos.y), size_t(pos.z));
+	Vec<size_t> next = Vec<size_t>::min(base + 1, dims - 1);
+	Vec<float> frac = pos - Vec<float>(base);
+
+	const uint8_t* chanData = data.data() + channel*dims.product();
+	auto voxel = [&](size_t x, size_t y, size_t z){ return float(chanData[x + (y + z*dims.y)*dims.x]); };
+
+	float c00 = voxel(base.x, base.y, base.z) * (1.0f - frac.x) + voxel(next.x, base.y, base.z) * frac.x;
+	float c10 = voxel(base.x, next.y, base.z) * (1.0f - frac.x) + voxel(next.x, next.y, base.z) * frac.x;
+	float c01 = voxel(base.x, base.y, next.z) * (1.0f - frac.x) + voxel(next.x, base.y, next.z) * frac.x;
+	float c11 = voxel(base.x, next.y, next.z) * (1.0f - frac.x) + voxel(next.x, next.y, next.z) * frac.x;
+
+	float c0 = c00 * (1.0f - frac.y) + c10 * frac.y;
+	float c1 = c01 * (1.0f - frac.y) + c11 * frac.y;
+
+	return (c0 * (1.0f - frac.z) + c1 * frac.z) / 255.0f;
+}
+
+float VolumePickData::mapIntensity(float intensity, const ChannelParams& params)
+{
+	intensity = std::min(std::max(intensity, params.range.x), params.range.y);
+	return params.transferFcn.x*intensity*intensity + params.transferFcn.y*intensity + params.transferFcn.z;
+}
+
+float VolumePickData::maxMappedIntensity(float minIntensity, float maxIntensity, const ChannelParams& params)
+{
+	// Clamping is monotonic so the clamped interval is just the clamped end points
+	float lo = std::min(std::max(minIntensity, params.range.x), params.range.y);
+	float hi = std::min(std::max(maxIntensity, params.range.x), params.range.y);
+
+	float maxVal = std::max(mapIntensity(lo, params), mapIntensity(hi, params));
+
+	// A downward parabola can peak inside the interval
+	float a = params.transferFcn.x;
+	if ( a < 0.0f )
+	{
+		float vertex = -params.transferFcn.y / (2.0f*a);
+		if ( vertex > lo && vertex < hi )
+			maxVal = std::max(maxVal, mapIntensity(vertex, params));
+	}
+
+	return maxVal;
+}
+
+int VolumePickData::brickIndex(Vec<float> pos) const
+{
+	Vec<size_t> brick;
+	for ( int i = 0; i < 3; ++i )
+	{
+		float clamped = std::min(std::max(pos.e[i], 0.0f), float(dims.e[i] - 1));
+		brick.e[i] = size_t(clamped) / brickSize;
+	}
+
+	return int(brick.x + (brick.y + brick.z*brickDims.y)*brickDims.x);
+}
+
+float VolumePickData::brickExit(Vec<float> origin, Vec<float> direction, Vec<float> pos) const
+{
+	float exitT = std::numeric_limits<float>::max();
+	for ( int i = 0; i < 3; ++i )
+	{
+		if ( std::abs(direction.e[i]) < 1e-8f )
+			continue;
+
+		float brickStart = std::floor(std::max(pos.e[i], 0.0f) / brickSize) * brickSize;
+		float bound = (direction.e[i] > 0.0f) ? (brickStart + brickSize) : (brickStart);
+
+		exitT = std::min(exitT, (bound - origin.e[i]) / direction.e[i]);
+	}
+
+	return exitT;
+}
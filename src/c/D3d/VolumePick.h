@@ -0,0 +1,54 @@
+#pragma once
+#include "Global/Vec.h"
+
+#include <cstdint>
+#include <vector>
+
+// CPU copy of a single volume frame, used to find the first visible voxel under the cursor.
+// A coarse min/max brick summary lets ray queries skip over space the transfer function leaves empty.
+class VolumePickData
+{
+public:
+	struct ChannelParams
+	{
+		Vec<float> transferFcn;
+		Vec<float> range;
+		Vec<float> color;
+		float alpha;
+	};
+
+	VolumePickData(Vec<size_t> dims, int numChannels, const unsigned char* imageData);
+
+	// Ray is in 0-based voxel coordinates (x=row, y=column, z=plane), hitT is the ray parameter of the first
+	// sample whose opacity reaches the threshold.
+	bool march(Vec<float> origin, Vec<float> direction, float tMin, float tMax,
+		const std::vector<ChannelParams>& params, float threshold, float& hitT);
+
+private:
+	static const int brickSize = 8;
+
+	void buildBricks();
+	void updateEmptyBricks(const std::vector<ChannelParams>& params, float threshold);
+
+	float sampleOpacity(Vec<float> pos, const std::vector<ChannelParams>& params) const;
+	float sampleChannel(Vec<float> pos, int channel) const;
+
+	static float mapIntensity(float intensity, const ChannelParams& params);
+	static float maxMappedIntensity(float minIntensity, float maxIntensity, const ChannelParams& params);
+
+	int brickIndex(Vec<float> pos) const;
+	float brickExit(Vec<float> origin, Vec<float> direction, Vec<float> pos) const;
+
+	Vec<size_t> dims;
+	int numChannels;
+	std::vector<uint8_t> data;
+
+	// Per-channel min/max over each brick (including a one voxel border for interpolation)
+	Vec<size_t> brickDims;
+	std::vector<uint8_t> brickMin;
+	std::vector<uint8_t> brickMax;
+
+	// Empty brick flags are only recomputed when the transfer function or threshold change
+	std::vector<bool> brickEmpty;
+	std::vector<float> cachedParams;
+};
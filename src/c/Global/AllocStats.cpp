@@ -0,0 +1,70 @@
+#include "AllocStats.h"
+
+#ifdef D3D_ALLOC_STATS
+
+#include <atomic>
+#include <cstdlib>
+#include <new>
+
+namespace
+{
+	std::atomic<size_t> heapAllocations(0);
+	std::atomic<size_t> heapFrees(0);
+}
+
+
+// The array, sized and nothrow forms all forward to these two
+void* operator new(size_t size)
+{
+	void* ptr = malloc((size > 0) ? size : 1);
+	if ( !ptr )
+		throw std::bad_alloc();
+
+	heapAllocations.fetch_add(1, std::memory_order_relaxed);
+
+	return ptr;
+}
+
+void operator delete(void* ptr) noexcept
+{
+	if ( !ptr )
+		return;
+
+	heapFrees.fetch_add(1, std::memory_order_relaxed);
+	free(ptr);
+}
+
+
+bool AllocStats::isEnabled()
+{
+	return true;
+}
+
+size_t AllocStats::getHeapAllocations()
+{
+	return heapAllocations.load(std::memory_order_relaxed);
+}
+
+size_t AllocStats::getHeapFrees()
+{
+	return heapFrees.load(std::memory_order_relaxed);
+}
+
+#else
+
+bool AllocStats::isEnabled()
+{
+	return false;
+}
+
+size_t AllocStats::getHeapAllocations()
+{
+	return 0;
+}
+
+size_t AllocStats::getHeapFrees()
+{
+	return 0;
+}
+
+#endif
@@ -0,0 +1,14 @@
+#pragma once
+
+#include <cstddef>
+
+// Counts of the heap allocations made by this module.
+// Counting replaces the global operator new and delete, so it is only compiled in when D3D_ALLOC_STATS is defined
+// (add it to the D3dLib preprocessor definitions for an instrumented build). Otherwise the counters stay at zero.
+namespace AllocStats
+{
+	bool isEnabled();
+
+	size_t getHeapAllocations();
+	size_t getHeapFrees();
+}
@@ -0,0 +1,129 @@
+#include "Arena.h"
+
+std::atomic<size_t> Arena::totalChunks(0);
+std::atomic<size_t> Arena::totalAllocations(0);
+std::atomic<size_t> Arena::totalBytes(0);
+
+
+Arena::Arena(size_t chunkSize)
+	: chunkSize(chunkSize), cur(NULL), end(NULL), dtors(NULL), bytesUsed(0)
+{}
+
+Arena::~Arena()
+{
+	reset();
+
+	for ( Chunk& chunk : chunks )
+		delete[] chunk.data;
+}
+
+void* Arena::allocate(size_t bytes, size_t align)
+{
+	uintptr_t aligned = (uintptr_t(cur) + align - 1) & ~uintptr_t(align - 1);
+	if ( !cur || aligned + bytes > uintptr_t(end) )
+	{
+		addChunk(bytes + align);
+		aligned = (uintptr_t(cur) + align - 1) & ~uintptr_t(align - 1);
+	}
+
+	cur = (uint8_t*)(aligned + bytes);
+	bytesUsed += bytes;
+
+	++totalAllocations;
+	totalBytes += bytes;
+
+	return (void*)aligned;
+}
+
+void Arena::reset()
+{
+	for ( DtorNode* node = dtors; node != NULL; node = node->next )
+		node->destroy(node->obj);
+
+	dtors = NULL;
+	bytesUsed = 0;
+
+	if ( chunks.empty() )
+	{
+		cur = NULL;
+		end = NULL;
+		return;
+	}
+
+	// Only the largest chunk is kept, so an arena that is reused settles on a single chunk that fits its work
+	size_t largest = 0;
+	for ( size_t i = 1; i < chunks.size(); ++i )
+	{
+		if ( chunks[i].size > chunks[largest].size )
+			largest = i;
+	}
+
+	for ( size_t i = 0; i < chunks.size(); ++i )
+	{
+		if ( i != largest )
+			delete[] chunks[i].data;
+	}
+
+	chunks[0] = chunks[largest];
+	chunks.resize(1);
+
+	cur = chunks[0].data;
+	end = chunks[0].data + chunks[0].size;
+}
+
+void Arena::rewind(const Scope& scope)
+{
+	// Nothing from before the scope is left, so this can also trim the chunks back to one
+	if ( scope.bytesUsed == 0 && scope.dtors == NULL )
+	{
+		reset();
+		return;
+	}
+
+	for ( DtorNode* node = dtors; node != scope.dtors; node = node->next )
+		node->destroy(node->obj);
+
+	for ( size_t i = scope.numChunks; i < chunks.size(); ++i )
+		delete[] chunks[i].data;
+
+	chunks.resize(scope.numChunks);
+
+	dtors = scope.dtors;
+	cur = scope.cur;
+	end = scope.end;
+	bytesUsed = scope.bytesUsed;
+}
+
+void Arena::addChunk(size_t minBytes)
+{
+	// Chunks double so a big payload only takes a handful of them
+	size_t size = (chunks.empty()) ? chunkSize : (2 * chunks.back().size);
+	if ( size < minBytes )
+		size = minBytes;
+
+	Chunk chunk;
+	chunk.data = new uint8_t[size];
+	chunk.size = size;
+	chunks.push_back(chunk);
+
+	cur = chunk.data;
+	end = chunk.data + size;
+
+	++totalChunks;
+}
+
+Arena::Stats Arena::getStats()
+{
+	Stats stats;
+	stats.chunks = totalChunks;
+	stats.allocations = totalAllocations;
+	stats.bytes = totalBytes;
+
+	return stats;
+}
+
+Arena& Arena::threadScratch()
+{
+	thread_local Arena scratch(1024 * 1024);
+	return scratch;
+}
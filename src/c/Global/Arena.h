@@ -0,0 +1,156 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <new>
+#include <utility>
+#include <vector>
+
+// Bump allocator for data that dies together, like one message's payload or one mesh's scratch space.
+// Allocations are carved out of large chunks and only released all at once by reset() or the destructor.
+// An arena is not thread safe, give each thread its own.
+class Arena
+{
+	struct DtorNode
+	{
+		void (*destroy)(void*);
+		void* obj;
+		DtorNode* next;
+	};
+
+public:
+	struct Stats
+	{
+		// Chunks taken from the heap
+		size_t chunks;
+		// Allocations served from chunks, each one would otherwise have been a heap allocation
+		size_t allocations;
+		size_t bytes;
+	};
+
+	static const size_t defaultChunkSize = 256 * 1024;
+
+	// Upper bound on the extra bytes create() takes per object for its destructor entry and alignment
+	static const size_t createOverhead = 4 * sizeof(void*);
+
+	explicit Arena(size_t chunkSize = defaultChunkSize);
+	~Arena();
+
+	void* allocate(size_t bytes, size_t align = alignof(std::max_align_t));
+
+	template <typename T>
+	T* allocArray(size_t count)
+	{
+		return (T*)allocate(count * sizeof(T), alignof(T));
+	}
+
+	// Objects with destructors are destroyed by reset(), in reverse order of creation
+	template <typename T, typename... Args>
+	T* create(Args&&... args)
+	{
+		DtorNode* node = (DtorNode*)allocate(sizeof(DtorNode), alignof(DtorNode));
+		T* obj = new (allocate(sizeof(T), alignof(T))) T(std::forward<Args>(args)...);
+
+		node->destroy = [](void* ptr){((T*)ptr)->~T();};
+		node->obj = obj;
+		node->next = dtors;
+		dtors = node;
+
+		return obj;
+	}
+
+	// Destroys created objects and releases the memory, one chunk is kept for reuse
+	void reset();
+
+	// Rewinds the arena to where it was when the scope started, memory allocated before that stays valid.
+	// Scopes nest, so code that runs in the middle of another arena user only releases its own allocations.
+	class Scope
+	{
+	public:
+		explicit Scope(Arena& arena)
+			: arena(arena), numChunks(arena.chunks.size()), cur(arena.cur), end(arena.end), dtors(arena.dtors), bytesUsed(arena.bytesUsed)
+		{}
+
+		~Scope() {arena.rewind(*this);}
+
+	private:
+		Scope(const Scope&);
+		Scope& operator=(const Scope&);
+
+		friend class Arena;
+
+		Arena& arena;
+		size_t numChunks;
+		uint8_t* cur;
+		uint8_t* end;
+		DtorNode* dtors;
+		size_t bytesUsed;
+	};
+
+	size_t getBytesUsed() const {return bytesUsed;}
+
+	// Totals over every arena since the module was loaded
+	static Stats getStats();
+
+	// This thread's arena for temporaries that only live for one call, hold a Scope on it for as long as they are used.
+	// Nested users (a helper, or a pool task this thread runs while it waits) then get the memory after the caller's.
+	static Arena& threadScratch();
+
+private:
+	Arena(const Arena&);
+	Arena& operator=(const Arena&);
+
+	void rewind(const Scope& scope);
+
+	struct Chunk
+	{
+		uint8_t* data;
+		size_t size;
+	};
+
+	void addChunk(size_t minBytes);
+
+	size_t chunkSize;
+
+	std::vector<Chunk> chunks;
+	uint8_t* cur;
+	uint8_t* end;
+
+	DtorNode* dtors;
+	size_t bytesUsed;
+
+	static std::atomic<size_t> totalChunks;
+	static std::atomic<size_t> totalAllocations;
+	static std::atomic<size_t> totalBytes;
+};
+
+
+// Lets standard containers take their storage from an arena, deallocation is a no-op
+template <typename T>
+class ArenaAllocator
+{
+public:
+	typedef T value_type;
+
+	ArenaAllocator(Arena& arena) : arena(&arena) {}
+
+	template <typename U>
+	ArenaAllocator(const ArenaAllocator<U>& other) : arena(other.arena) {}
+
+	T* allocate(size_t count) {return arena->allocArray<T>(count);}
+	void deallocate(T*, size_t) {}
+
+	template <typename U>
+	bool operator==(const ArenaAllocator<U>& other) const {return arena == other.arena;}
+	template <typename U>
+	bool operator!=(const ArenaAllocator<U>& other) const {return arena != other.arena;}
+
+private:
+	template <typename U> friend class ArenaAllocator;
+
+	Arena* arena;
+};
+
+template <typename T>
+using ArenaVector = std::vector<T, ArenaAllocator<T>>;
@@ -8,3 +8,6 @@
 
 void errMessage(std::string message, const char *file, int line);
 void hrErrMessage(HRESULT hr, const char *file, int line);
+
+// Errors sent from this thread are appended to errorsOut instead of the MEX return queue, until called again with NULL
+void captureErrMessages(std::string* errorsOut);
@@ -22,7 +22,7 @@
 
 #include "Defines.h"
 #include "Messages/MessageQueue.h"
-#include "Messages/ReturnQueue.h"
+#include "Messages/EventQueue.h"
 
 #include "windows.h"
 
@@ -52,4 +52,4 @@ extern float gFramesPerSec;
 
 // Global Queues
 extern MessageQueue gMsgQueueToDirectX;
-extern ReturnQueue gMsgQueueToMex;
+extern EventQueue gMsgQueueToMex;
@@ -0,0 +1,99 @@
+#include "LatencyHistogram.h"
+
+#include <intrin.h>
+
+#include <cmath>
+#include <cstring>
+
+namespace
+{
+	int highestBit(uint64_t value)
+	{
+		unsigned long bit;
+		_BitScanReverse64(&bit, value);
+
+		return int(bit);
+	}
+}
+
+
+LatencyHistogram::LatencyHistogram()
+{
+	reset();
+}
+
+void LatencyHistogram::record(uint64_t nanoseconds)
+{
+	++counts[bucketIndex(nanoseconds)];
+
+	++count;
+	sum += nanoseconds;
+	if ( nanoseconds > maxValue )
+		maxValue = nanoseconds;
+}
+
+void LatencyHistogram::reset()
+{
+	memset(counts, 0, sizeof(counts));
+
+	count = 0;
+	sum = 0;
+	maxValue = 0;
+}
+
+uint64_t LatencyHistogram::getPercentile(double fraction) const
+{
+	if ( count == 0 )
+		return 0;
+
+	uint64_t target = uint64_t(std::ceil(fraction * double(count)));
+	if ( target < 1 )
+		target = 1;
+
+	uint64_t seen = 0;
+	for ( int i = 0; i < numBuckets; ++i )
+	{
+		seen += counts[i];
+		if ( seen < target )
+			continue;
+
+		uint64_t bound = bucketUpperBound(i);
+		return (bound < maxValue) ? bound : maxValue;
+	}
+
+	return maxValue;
+}
+
+void LatencyHistogram::add(const LatencyHistogram& other)
+{
+	for ( int i = 0; i < numBuckets; ++i )
+		counts[i] += other.counts[i];
+
+	count += other.count;
+	sum += other.sum;
+	if ( other.maxValue > maxValue )
+		maxValue = other.maxValue;
+}
+
+int LatencyHistogram::bucketIndex(uint64_t value)
+{
+	// The first two powers of two are exact, one value per bucket
+	if ( value < 2*subBuckets )
+		return int(value);
+
+	int shift = highestBit(value) - subBucketBits;
+	int index = (shift + 1)*subBuckets + int(value >> shift) - subBuckets;
+
+	return (index < numBuckets) ? index : (numBuckets - 1);
+}
+
+uint64_t LatencyHistogram::bucketUpperBound(int index)
+{
+	if ( index < 2*subBuckets )
+		return uint64_t(index);
+
+	int shift = index / subBuckets - 1;
+	uint64_t subBucket = uint64_t(index % subBuckets + subBuckets);
+
+	return ((subBucket + 1) << shift) - 1;
+}
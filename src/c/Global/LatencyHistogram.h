@@ -0,0 +1,41 @@
+#pragma once
+
+#include <cstdint>
+
+// Fixed size log-linear histogram of durations in nanoseconds, in the style of HdrHistogram.
+// Every power of two is split into subBuckets linear buckets, so any recorded value is known to within 1/subBuckets
+// (about 6%) from 1ns up to over an hour. Recording is a bit scan and an increment, no allocation, no locking.
+class LatencyHistogram
+{
+public:
+	LatencyHistogram();
+
+	void record(uint64_t nanoseconds);
+	void reset();
+
+	uint64_t getCount() const {return count;}
+	uint64_t getMax() const {return maxValue;}
+	double getMean() const {return (count > 0) ? (double(sum) / double(count)) : 0.0;}
+
+	// Upper bound of the bucket holding the given fraction (0-1] of the recorded values, never above getMax()
+	uint64_t getPercentile(double fraction) const;
+
+	void add(const LatencyHistogram& other);
+
+private:
+	static const int subBucketBits = 4;
+	static const int subBuckets = 1 << subBucketBits;
+
+	// Values of 2^42ns (73 minutes) and above all land in the last bucket
+	static const int maxValueBits = 42;
+	static const int numBuckets = (maxValueBits - subBucketBits + 1) * subBuckets;
+
+	static int bucketIndex(uint64_t value);
+	static uint64_t bucketUpperBound(int index);
+
+	uint32_t counts[numBuckets];
+
+	uint64_t count;
+	uint64_t sum;
+	uint64_t maxValue;
+};
@@ -0,0 +1,105 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+
+// Bounded lock-free ring for many producer threads and one consumer thread.
+// Each cell carries a sequence number (Vyukov's bounded queue), producers claim a position with one
+// compare-exchange on the tail and publish the cell by bumping its sequence. The consumer never locks,
+// it stops at the first cell that hasn't been published yet, so items always come out in claim order.
+template <typename T>
+class MpscRing
+{
+public:
+	// Capacity is rounded up to a power of two
+	explicit MpscRing(size_t minCapacity)
+		: head(0), tail(0)
+	{
+		size_t capacity = 2;
+		while ( capacity < minCapacity )
+			capacity *= 2;
+
+		mask = capacity - 1;
+		cells.reset(new Cell[capacity]);
+		for ( size_t i = 0; i < capacity; ++i )
+			cells[i].sequence.store(i, std::memory_order_relaxed);
+	}
+
+	// Returns false if the ring is full. ticketOut gets the item's position, positions count up from 0 in pop order.
+	bool tryPush(const T& item, uint64_t* ticketOut = NULL)
+	{
+		uint64_t pos = tail.load(std::memory_order_relaxed);
+		Cell* cell;
+		for ( ;; )
+		{
+			cell = &cells[pos & mask];
+			int64_t diff = int64_t(cell->sequence.load(std::memory_order_acquire)) - int64_t(pos);
+			if ( diff == 0 )
+			{
+				if ( tail.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed) )
+					break;
+			}
+			else if ( diff < 0 )
+			{
+				return false;
+			}
+			else
+			{
+				pos = tail.load(std::memory_order_relaxed);
+			}
+		}
+
+		cell->item = item;
+		cell->sequence.store(pos + 1, std::memory_order_release);
+
+		if ( ticketOut )
+			*ticketOut = pos;
+
+		return true;
+	}
+
+	// Consumer thread only, returns false when empty or the next item is still being written
+	bool tryPop(T& itemOut)
+	{
+		uint64_t pos = head.load(std::memory_order_relaxed);
+		Cell& cell = cells[pos & mask];
+		if ( cell.sequence.load(std::memory_order_acquire) != pos + 1 )
+			return false;
+
+		itemOut = cell.item;
+		cell.sequence.store(pos + mask + 1, std::memory_order_release);
+		head.store(pos + 1, std::memory_order_relaxed);
+
+		return true;
+	}
+
+	// Claimed but not yet popped, may be stale by the time it returns
+	size_t sizeApprox() const
+	{
+		uint64_t popped = head.load(std::memory_order_relaxed);
+		uint64_t claimed = tail.load(std::memory_order_relaxed);
+
+		return (claimed > popped) ? size_t(claimed - popped) : 0;
+	}
+
+	size_t capacity() const {return mask + 1;}
+
+private:
+	MpscRing(const MpscRing&);
+	MpscRing& operator=(const MpscRing&);
+
+	struct Cell
+	{
+		std::atomic<uint64_t> sequence;
+		T item;
+	};
+
+	std::unique_ptr<Cell[]> cells;
+	size_t mask;
+
+	// Kept on separate cache lines so producers and the consumer don't fight over them
+	alignas(64) std::atomic<uint64_t> head;
+	alignas(64) std::atomic<uint64_t> tail;
+};
@@ -0,0 +1,83 @@
+#pragma once
+
+#include "ThreadPool.h"
+
+#include <exception>
+#include <vector>
+
+// Workers steal the oldest tasks, so the newest chunks are the likeliest to still be waiting for this thread.
+// Every chunk is joined even if one failed, the exception of the earliest failed chunk is returned.
+inline std::exception_ptr joinChunks(ThreadPool& pool, const std::vector<ThreadPool::TaskHandle>& chunks)
+{
+	std::exception_ptr error;
+	for ( size_t i = chunks.size(); i > 0; --i )
+	{
+		try
+		{
+			pool.join(chunks[i-1]);
+		}
+		catch(...)
+		{
+			error = std::current_exception();
+		}
+	}
+
+	return error;
+}
+
+// Splits [0,count) into contiguous chunks and calls func(begin,end) for each chunk on the shared thread pool.
+// Chunks are never smaller than minChunk, so small inputs run inline on the calling thread.
+// The calling thread takes the first chunk and then any of its chunks no worker has started yet, so this can also be
+// used from inside a pool task. It never runs unrelated pool tasks, those could clobber the caller's thread scratch.
+// If any chunk throws, the exception is rethrown here once every chunk has finished.
+template <typename Func>
+void parallelFor(size_t count, size_t minChunk, Func func)
+{
+	if ( count == 0 )
+		return;
+
+	ThreadPool& pool = ThreadPool::shared();
+	size_t numThreads = pool.getNumWorkers() + 1;
+
+	if ( minChunk == 0 )
+		minChunk = 1;
+
+	size_t maxThreads = (count + minChunk - 1) / minChunk;
+	numThreads = (numThreads < maxThreads) ? numThreads : maxThreads;
+
+	if ( numThreads <= 1 )
+	{
+		func(size_t(0), count);
+		return;
+	}
+
+	size_t chunkSize = (count + numThreads - 1) / numThreads;
+
+	std::vector<ThreadPool::TaskHandle> chunks;
+	chunks.reserve(numThreads - 1);
+
+	for ( size_t i = 1; i < numThreads; ++i )
+	{
+		size_t begin = i * chunkSize;
+		size_t end = (begin + chunkSize < count) ? (begin + chunkSize) : count;
+		if ( begin >= end )
+			break;
+
+		chunks.push_back(pool.submit([&func, begin, end](){func(begin, end);}));
+	}
+
+	// The chunks reference func, they have to finish even if the first chunk throws
+	try
+	{
+		func(size_t(0), (chunkSize < count) ? chunkSize : count);
+	}
+	catch(...)
+	{
+		joinChunks(pool, chunks);
+		throw;
+	}
+
+	std::exception_ptr error = joinChunks(pool, chunks);
+	if ( error )
+		std::rethrow_exception(error);
+}
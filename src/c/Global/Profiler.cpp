@@ -0,0 +1,251 @@
+#include "Profiler.h"
+
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+namespace
+{
+	struct Zone
+	{
+		const char* name;
+		uint64_t start;
+		uint64_t end;
+	};
+
+	// 24MB of zones per thread at most, plenty for a few minutes of frames
+	const size_t zonesPerChunk = 4096;
+	const size_t maxChunks = 256;
+
+	// Only the owning thread adds zones. The chunk list, name and resets are guarded by the mutex
+	// so a trace can be written while the thread keeps recording.
+	struct ThreadBuffer
+	{
+		ThreadBuffer(uint32_t threadId) : threadId(threadId), count(0), dropped(0), generation(0), exited(false) {}
+
+		uint32_t threadId;
+		std::string name;
+
+		std::mutex mutex;
+		std::vector<std::unique_ptr<Zone[]>> chunks;
+
+		// Zones below this are complete and may be read by a writer holding the mutex
+		std::atomic<size_t> count;
+		std::atomic<size_t> dropped;
+
+		// Recording generation the zones belong to, the owner empties its buffer when start() moves on
+		uint64_t generation;
+
+		std::atomic<bool> exited;
+	};
+
+	std::mutex buffersMutex;
+	std::vector<std::shared_ptr<ThreadBuffer>> buffers;
+	uint32_t nextThreadId = 1;
+
+	std::atomic<uint64_t> currentGeneration(1);
+	std::atomic<uint64_t> recordStart(0);
+
+	const std::chrono::steady_clock::time_point clockBase = std::chrono::steady_clock::now();
+
+	// Flags the buffer when its thread goes away, the next start() lets go of it
+	struct ThreadBufferOwner
+	{
+		ThreadBufferOwner() : buffer(NULL) {}
+		~ThreadBufferOwner()
+		{
+			if ( buffer )
+				buffer->exited = true;
+		}
+
+		ThreadBuffer* buffer;
+	};
+
+	thread_local ThreadBufferOwner threadBuffer;
+
+	ThreadBuffer* getThreadBuffer()
+	{
+		if ( threadBuffer.buffer )
+			return threadBuffer.buffer;
+
+		std::lock_guard<std::mutex> lock(buffersMutex);
+
+		std::shared_ptr<ThreadBuffer> buffer = std::make_shared<ThreadBuffer>(nextThreadId++);
+		buffer->generation = currentGeneration;
+		buffers.push_back(buffer);
+
+		threadBuffer.buffer = buffer.get();
+		return threadBuffer.buffer;
+	}
+
+	void writeJsonString(FILE* file, const char* str)
+	{
+		// Type names come through as "class MessageX"
+		if ( strncmp(str, "class ", 6) == 0 )
+			str += 6;
+		else if ( strncmp(str, "struct ", 7) == 0 )
+			str += 7;
+
+		fputc('"', file);
+		for ( ; *str; ++str )
+		{
+			unsigned char c = (unsigned char)*str;
+			if ( c == '"' || c == '\\' )
+				fprintf(file, "\\%c", c);
+			else if ( c < 0x20 )
+				fprintf(file, "\\u%04x", c);
+			else
+				fputc(c, file);
+		}
+		fputc('"', file);
+	}
+}
+
+
+std::atomic<bool> Profiler::enabled(false);
+
+void Profiler::start()
+{
+	std::lock_guard<std::mutex> lock(buffersMutex);
+
+	// Buffers of threads that have ended won't record again
+	std::vector<std::shared_ptr<ThreadBuffer>> live;
+	for ( const std::shared_ptr<ThreadBuffer>& buffer : buffers )
+	{
+		if ( !buffer->exited )
+			live.push_back(buffer);
+	}
+
+	buffers.swap(live);
+
+	++currentGeneration;
+	recordStart = now();
+	enabled = true;
+}
+
+void Profiler::stop()
+{
+	enabled = false;
+}
+
+void Profiler::setThreadName(const std::string& name)
+{
+	ThreadBuffer* buffer = getThreadBuffer();
+
+	std::lock_guard<std::mutex> lock(buffer->mutex);
+	buffer->name = name;
+}
+
+uint64_t Profiler::now()
+{
+	return uint64_t(std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - clockBase).count()) + 1;
+}
+
+void Profiler::recordZone(const char* name, uint64_t start, uint64_t end)
+{
+	ThreadBuffer* buffer = getThreadBuffer();
+
+	// First zone since a restart, anything older is thrown away
+	uint64_t generation = currentGeneration.load(std::memory_order_relaxed);
+	if ( buffer->generation != generation )
+	{
+		std::lock_guard<std::mutex> lock(buffer->mutex);
+
+		buffer->chunks.clear();
+		buffer->count = 0;
+		buffer->dropped = 0;
+		buffer->generation = generation;
+	}
+
+	size_t index = buffer->count.load(std::memory_order_relaxed);
+	size_t chunk = index / zonesPerChunk;
+
+	if ( chunk >= buffer->chunks.size() )
+	{
+		if ( chunk >= maxChunks )
+		{
+			buffer->dropped.fetch_add(1, std::memory_order_relaxed);
+			return;
+		}
+
+		std::lock_guard<std::mutex> lock(buffer->mutex);
+		buffer->chunks.emplace_back(new Zone[zonesPerChunk]);
+	}
+
+	Zone& zone = buffer->chunks[chunk][index % zonesPerChunk];
+	zone.name = name;
+	zone.start = start;
+	zone.end = end;
+
+	buffer->count.store(index + 1, std::memory_order_release);
+}
+
+bool Profiler::writeChromeTrace(const std::string& path, Stats& statsOut)
+{
+	statsOut.zones = 0;
+	statsOut.threads = 0;
+	statsOut.dropped = 0;
+
+	FILE* file = fopen(path.c_str(), "w");
+	if ( !file )
+		return false;
+
+	std::vector<std::shared_ptr<ThreadBuffer>> threads;
+	{
+		std::lock_guard<std::mutex> lock(buffersMutex);
+		threads = buffers;
+	}
+
+	uint64_t startTime = recordStart;
+	uint64_t generation = currentGeneration;
+
+	fprintf(file, "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n");
+	fprintf(file, "{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":1,\"tid\":0,\"args\":{\"name\":\"D3d Viewer\"}}");
+
+	for ( const std::shared_ptr<ThreadBuffer>& buffer : threads )
+	{
+		std::lock_guard<std::mutex> lock(buffer->mutex);
+
+		// Still holding zones from before the last start()
+		if ( buffer->generation != generation )
+			continue;
+
+		size_t count = buffer->count.load(std::memory_order_acquire);
+
+		++statsOut.threads;
+		statsOut.dropped += buffer->dropped;
+
+		char threadName[32];
+		sprintf(threadName, "Thread %u", buffer->threadId);
+
+		fprintf(file, ",\n{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":%u,\"args\":{\"name\":", buffer->threadId);
+		writeJsonString(file, buffer->name.empty() ? threadName : buffer->name.c_str());
+		fprintf(file, "}}");
+
+		for ( size_t i = 0; i < count; ++i )
+		{
+			const Zone& zone = buffer->chunks[i / zonesPerChunk][i % zonesPerChunk];
+
+			// Opened before the start and closed after it
+			if ( zone.start < startTime )
+				continue;
+
+			fprintf(file, ",\n{\"name\":");
+			writeJsonString(file, zone.name);
+			fprintf(file, ",\"ph\":\"X\",\"pid\":1,\"tid\":%u,\"ts\":%.3f,\"dur\":%.3f}", buffer->threadId,
+				double(zone.start - startTime) * 1.0e-3, double(zone.end - zone.start) * 1.0e-3);
+
+			++statsOut.zones;
+		}
+	}
+
+	fprintf(file, "\n]}\n");
+
+	bool written = (ferror(file) == 0);
+	fclose(file);
+
+	return written;
+}
@@ -0,0 +1,72 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+// Scoped timing zones, written out as a Chrome trace (chrome://tracing or ui.perfetto.dev).
+// PROFILE_ZONE("Name") at the top of a scope times the rest of it, zones inside it show up nested below it.
+// Each thread records into its own buffer without locking. While the profiler is stopped a zone is one relaxed
+// load and a branch, so zones stay in release builds.
+namespace Profiler
+{
+	struct Stats
+	{
+		size_t zones;
+		size_t threads;
+		// Zones not kept because a thread's buffer was full
+		size_t dropped;
+	};
+
+	extern std::atomic<bool> enabled;
+
+	inline bool isEnabled()
+	{
+		return enabled.load(std::memory_order_relaxed);
+	}
+
+	// Starting throws away everything recorded before
+	void start();
+	void stop();
+
+	// Shown as the thread's name in traces, threads without a name are numbered
+	void setThreadName(const std::string& name);
+
+	// Writes the zones recorded since start(), can be called while recording. Returns false if the file can't be written.
+	bool writeChromeTrace(const std::string& path, Stats& statsOut);
+
+	// Nanoseconds on the steady clock, never 0
+	uint64_t now();
+
+	// name has to outlive the profiler, string literals and typeid names are fine
+	void recordZone(const char* name, uint64_t start, uint64_t end);
+}
+
+
+class ProfileZone
+{
+public:
+	explicit ProfileZone(const char* name) : name(name), start(0)
+	{
+		if ( Profiler::isEnabled() )
+			start = Profiler::now();
+	}
+
+	~ProfileZone()
+	{
+		if ( start != 0 )
+			Profiler::recordZone(name, start, Profiler::now());
+	}
+
+private:
+	ProfileZone(const ProfileZone&);
+	ProfileZone& operator=(const ProfileZone&);
+
+	const char* name;
+	uint64_t start;
+};
+
+#define PROFILE_ZONE_CONCAT_INNER(a, b) a##b
+#define PROFILE_ZONE_CONCAT(a, b) PROFILE_ZONE_CONCAT_INNER(a, b)
+#define PROFILE_ZONE(name) ProfileZone PROFILE_ZONE_CONCAT(profileZone, __LINE__)(name)
@@ -0,0 +1,128 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <mutex>
+#include <queue>
+#include <thread>
+#include <vector>
+
+#undef min
+#undef max
+
+// Throughput and latency of a many producer, one consumer queue, shared by the QueueBenchmark command and the tests.
+// Any queue with bool tryPush(const Item&) and bool tryPop(Item&) can be measured, e.g. MpscRing<QueueBenchmark::Item>.
+namespace QueueBenchmark
+{
+	struct Item
+	{
+		uint32_t producer;
+		uint32_t sequence;
+		int64_t pushNs;
+	};
+
+	inline int64_t nowNs()
+	{
+		return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+	}
+
+	// The message queue before the ring, a mutex around a std::queue popped one item per lock
+	class MutexQueue
+	{
+	public:
+		bool tryPush(const Item& item)
+		{
+			std::lock_guard<std::mutex> lock(mutex);
+			items.push(item);
+
+			return true;
+		}
+
+		bool tryPop(Item& itemOut)
+		{
+			std::lock_guard<std::mutex> lock(mutex);
+			if ( items.empty() )
+				return false;
+
+			itemOut = items.front();
+			items.pop();
+
+			return true;
+		}
+
+	private:
+		std::mutex mutex;
+		std::queue<Item> items;
+	};
+
+	struct Result
+	{
+		double seconds;
+		double latencyMedianUs;
+		double latency99Us;
+		bool valid;
+	};
+
+	// Producers push numItems between them while one consumer pops, checking that nothing is lost,
+	// duplicated or reordered within a producer
+	template <typename Q>
+	Result run(Q& queue, size_t numItems, int numProducers)
+	{
+		std::vector<int64_t> latencies;
+		latencies.reserve(numItems);
+
+		std::vector<uint32_t> nextSequence(numProducers, 0);
+		bool valid = true;
+
+		std::atomic<bool> go(false);
+		std::vector<std::thread> producers;
+		for ( int p = 0; p < numProducers; ++p )
+		{
+			size_t count = numItems / numProducers + ((size_t(p) < numItems % numProducers) ? 1 : 0);
+			producers.emplace_back([&queue, &go, p, count]()
+			{
+				while ( !go )
+					std::this_thread::yield();
+
+				for ( size_t i = 0; i < count; ++i )
+				{
+					Item item = {uint32_t(p), uint32_t(i), nowNs()};
+					while ( !queue.tryPush(item) )
+						std::this_thread::yield();
+				}
+			});
+		}
+
+		std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+		go = true;
+
+		size_t received = 0;
+		Item item;
+		while ( received < numItems )
+		{
+			if ( !queue.tryPop(item) )
+				continue;
+
+			latencies.push_back(nowNs() - item.pushNs);
+			if ( item.sequence != nextSequence[item.producer]++ )
+				valid = false;
+
+			++received;
+		}
+
+		Result result;
+		result.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+		for ( std::thread& producer : producers )
+			producer.join();
+
+		std::sort(latencies.begin(), latencies.end());
+		result.latencyMedianUs = double(latencies[latencies.size() / 2]) * 1e-3;
+		result.latency99Us = double(latencies[(latencies.size() * 99) / 100]) * 1e-3;
+		result.valid = valid;
+
+		return result;
+	}
+}
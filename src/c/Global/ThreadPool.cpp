@@ -0,0 +1,278 @@
+#include "ThreadPool.h"
+#include "Profiler.h"
+
+#include <string>
+#include <utility>
+
+namespace
+{
+	std::mutex sharedMutex;
+	std::unique_ptr<ThreadPool> sharedPool;
+
+	// Which pool and queue the current thread works for, workers push their own follow-up tasks locally
+	thread_local ThreadPool* currentPool = NULL;
+	thread_local size_t currentQueue = 0;
+}
+
+
+ThreadPool& ThreadPool::shared()
+{
+	std::lock_guard<std::mutex> lock(sharedMutex);
+
+	if ( !sharedPool )
+	{
+		size_t numThreads = std::thread::hardware_concurrency();
+		sharedPool.reset(new ThreadPool((numThreads > 1) ? (numThreads - 1) : 1));
+	}
+
+	return *sharedPool;
+}
+
+void ThreadPool::shutdownShared()
+{
+	std::unique_ptr<ThreadPool> pool;
+	{
+		std::lock_guard<std::mutex> lock(sharedMutex);
+		pool.swap(sharedPool);
+	}
+
+	// Joined outside the lock in case a queued task still asks for the pool
+	pool.reset();
+}
+
+ThreadPool::CancelToken ThreadPool::makeCancelToken()
+{
+	return std::make_shared<std::atomic<bool>>(false);
+}
+
+ThreadPool::ThreadPool(size_t numWorkers)
+	: numQueued(0), numWaiting(0), nextSteal(0), running(true)
+{
+	if ( numWorkers == 0 )
+		numWorkers = 1;
+
+	for ( size_t i = 0; i < numWorkers + 1; ++i )
+		queues.emplace_back(new WorkerQueue());
+
+	workers.reserve(numWorkers);
+	for ( size_t i = 0; i < numWorkers; ++i )
+		workers.emplace_back(&ThreadPool::workerLoop, this, i);
+}
+
+ThreadPool::~ThreadPool()
+{
+	{
+		std::lock_guard<std::mutex> lock(sleepMutex);
+		running = false;
+	}
+
+	taskQueued.notify_all();
+
+	for ( std::thread& worker : workers )
+		worker.join();
+}
+
+ThreadPool::TaskHandle ThreadPool::submit(std::function<void()> func, const std::vector<TaskHandle>& dependsOn, CancelToken cancelToken)
+{
+	TaskHandle task = std::make_shared<Task>(std::move(func), cancelToken);
+
+	for ( const TaskHandle& dependency : dependsOn )
+	{
+		if ( !dependency )
+			continue;
+
+		std::lock_guard<std::mutex> lock(dependency->mutex);
+		if ( dependency->finished )
+			continue;
+
+		++task->numPending;
+		dependency->dependents.push_back(task);
+	}
+
+	// Drop the submission hold, whoever releases the last dependency queues the task
+	if ( --task->numPending == 0 )
+		enqueue(task);
+
+	return task;
+}
+
+bool ThreadPool::isDone(const TaskHandle& task)
+{
+	return !task || task->done.load();
+}
+
+void ThreadPool::wait(const TaskHandle& task)
+{
+	while ( !isDone(task) )
+	{
+		if ( tryRunOne() )
+			continue;
+
+		std::unique_lock<std::mutex> lock(sleepMutex);
+		++numWaiting;
+		taskFinished.wait(lock, [&]{return isDone(task) || numQueued > 0;});
+		--numWaiting;
+	}
+
+	rethrowError(task);
+}
+
+void ThreadPool::join(const TaskHandle& task)
+{
+	// Only once it is queued, its dependencies may still be running
+	if ( !isDone(task) && task->numPending == 0 )
+		runTask(task);
+
+	if ( !isDone(task) )
+	{
+		std::unique_lock<std::mutex> lock(sleepMutex);
+		++numWaiting;
+		taskFinished.wait(lock, [&]{return isDone(task);});
+		--numWaiting;
+	}
+
+	rethrowError(task);
+}
+
+void ThreadPool::rethrowError(const TaskHandle& task)
+{
+	if ( task && task->error )
+		std::rethrow_exception(task->error);
+}
+
+void ThreadPool::workerLoop(size_t index)
+{
+	currentPool = this;
+	currentQueue = index;
+
+	Profiler::setThreadName("Worker " + std::to_string(index));
+
+	for ( ;; )
+	{
+		if ( tryRunOne() )
+			continue;
+
+		std::unique_lock<std::mutex> lock(sleepMutex);
+		taskQueued.wait(lock, [&]{return numQueued > 0 || !running;});
+
+		// Whatever is still queued runs before the pool goes away
+		if ( !running && numQueued == 0 )
+			break;
+	}
+
+	currentPool = NULL;
+}
+
+void ThreadPool::enqueue(const TaskHandle& task)
+{
+	size_t queue = (currentPool == this) ? currentQueue : workers.size();
+	{
+		std::lock_guard<std::mutex> lock(queues[queue]->mutex);
+		queues[queue]->tasks.push_back(task);
+	}
+
+	++numQueued;
+
+	// Taking the lock orders this with a thread that checked numQueued and is about to sleep
+	{
+		std::lock_guard<std::mutex> lock(sleepMutex);
+	}
+
+	taskQueued.notify_one();
+	if ( numWaiting > 0 )
+		taskFinished.notify_all();
+}
+
+bool ThreadPool::tryRunOne()
+{
+	TaskHandle task = popTask();
+	if ( !task )
+		return false;
+
+	runTask(task);
+	return true;
+}
+
+ThreadPool::TaskHandle ThreadPool::popTask()
+{
+	if ( numQueued == 0 )
+		return TaskHandle();
+
+	TaskHandle task;
+
+	// Newest task on our own queue first
+	if ( currentPool == this )
+	{
+		WorkerQueue& own = *queues[currentQueue];
+
+		std::lock_guard<std::mutex> lock(own.mutex);
+		if ( !own.tasks.empty() )
+		{
+			task = own.tasks.back();
+			own.tasks.pop_back();
+		}
+	}
+
+	// Then the oldest from anyone else, starting at a different queue each time so one isn't drained first
+	size_t start = nextSteal++;
+	for ( size_t i = 0; !task && i < queues.size(); ++i )
+	{
+		WorkerQueue& victim = *queues[(start + i) % queues.size()];
+
+		std::lock_guard<std::mutex> lock(victim.mutex);
+		if ( !victim.tasks.empty() )
+		{
+			task = victim.tasks.front();
+			victim.tasks.pop_front();
+		}
+	}
+
+	if ( task )
+		--numQueued;
+
+	return task;
+}
+
+void ThreadPool::runTask(const TaskHandle& task)
+{
+	// Another thread has it already
+	if ( task->claimed.exchange(true) )
+		return;
+
+	if ( !task->wasCancelled() && task->func )
+	{
+		try
+		{
+			task->func();
+		}
+		catch(...)
+		{
+			// Nobody is there to catch it on a worker, it goes to whoever waits on the task
+			task->error = std::current_exception();
+		}
+	}
+
+	// Let go of anything the function captured
+	task->func = std::function<void()>();
+
+	std::vector<TaskHandle> dependents;
+	{
+		std::lock_guard<std::mutex> lock(task->mutex);
+		task->finished = true;
+		dependents.swap(task->dependents);
+	}
+
+	task->done = true;
+
+	if ( numWaiting > 0 )
+	{
+		std::lock_guard<std::mutex> lock(sleepMutex);
+		taskFinished.notify_all();
+	}
+
+	for ( const TaskHandle& dependent : dependents )
+	{
+		if ( --dependent->numPending == 0 )
+			enqueue(dependent);
+	}
+}
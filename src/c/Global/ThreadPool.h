@@ -0,0 +1,120 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Worker threads shared by everything that has CPU work to get off the render and MEX threads.
+// Every worker owns a deque, tasks submitted from a worker go on the back of its own deque and are popped from there
+// (newest first, still warm in cache), idle workers steal the oldest task from the front of someone else's.
+// A task may depend on other tasks, it is only queued once all of them have finished.
+// Waiting on a task runs queued tasks in the meantime, so tasks can wait on tasks without tying up a worker.
+class ThreadPool
+{
+public:
+	// Cancelled tasks are skipped, tasks that are already running can poll their token to stop early
+	typedef std::shared_ptr<std::atomic<bool>> CancelToken;
+
+	class Task;
+	typedef std::shared_ptr<Task> TaskHandle;
+
+	// Created on first use, workers = hardware threads - 1 so the thread that submits keeps a core
+	static ThreadPool& shared();
+
+	// Joins the shared pool's workers, call before the module unloads. Queued tasks still run first.
+	static void shutdownShared();
+
+	static CancelToken makeCancelToken();
+	static bool isCancelled(const CancelToken& token) {return token && token->load(std::memory_order_relaxed);}
+	static void cancel(const CancelToken& token) {if ( token ) token->store(true);}
+
+	explicit ThreadPool(size_t numWorkers);
+	~ThreadPool();
+
+	size_t getNumWorkers() const {return workers.size();}
+
+	// Runs func once every task in dependsOn has finished (cancelled or not).
+	// If cancelToken is set before the task starts, func is skipped but the task still finishes and releases its dependents.
+	TaskHandle submit(std::function<void()> func, const std::vector<TaskHandle>& dependsOn = std::vector<TaskHandle>(),
+		CancelToken cancelToken = CancelToken());
+
+	static bool isDone(const TaskHandle& task);
+
+	// Runs other queued tasks on this thread until task has finished.
+	// An exception thrown by the task is rethrown here (and to every other thread that waits on it).
+	void wait(const TaskHandle& task);
+
+	// Runs task on this thread if no one has started it yet, otherwise blocks until it finishes.
+	// Never runs anything else, so whatever this thread was in the middle of (scratch memory, locks) is left alone.
+	// Rethrows the task's exception like wait.
+	void join(const TaskHandle& task);
+
+private:
+	struct WorkerQueue
+	{
+		std::mutex mutex;
+		std::deque<TaskHandle> tasks;
+	};
+
+	void workerLoop(size_t index);
+
+	void enqueue(const TaskHandle& task);
+	bool tryRunOne();
+	TaskHandle popTask();
+	void runTask(const TaskHandle& task);
+	static void rethrowError(const TaskHandle& task);
+
+	std::vector<std::thread> workers;
+
+	// One more queue than workers, for tasks submitted from outside the pool
+	std::vector<std::unique_ptr<WorkerQueue>> queues;
+
+	std::atomic<size_t> numQueued;
+	std::atomic<size_t> numWaiting;
+	std::atomic<size_t> nextSteal;
+	bool running;
+
+	// Sleeping workers wait for queued tasks, waiting threads also wake when any task finishes
+	std::mutex sleepMutex;
+	std::condition_variable taskQueued;
+	std::condition_variable taskFinished;
+};
+
+class ThreadPool::Task
+{
+public:
+	friend class ThreadPool;
+
+	Task(std::function<void()> func, CancelToken cancelToken)
+		: func(std::move(func)), cancelToken(cancelToken), numPending(1), claimed(false), finished(false), done(false)
+	{}
+
+	bool wasCancelled() const {return ThreadPool::isCancelled(cancelToken);}
+
+private:
+	std::function<void()> func;
+	CancelToken cancelToken;
+
+	// Unfinished dependencies, plus one held while the task is being submitted
+	std::atomic<size_t> numPending;
+
+	// Set by the thread that runs it, a task joined before a worker got to it is still on a queue and skipped there
+	std::atomic<bool> claimed;
+
+	// Guards finished and dependents, a dependency that finishes while a new task registers with it is not missed
+	std::mutex mutex;
+	bool finished;
+	std::vector<TaskHandle> dependents;
+
+	std::atomic<bool> done;
+
+	// Whatever func threw, set before done
+	std::exception_ptr error;
+};
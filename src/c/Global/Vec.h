@@ -18,6 +18,8 @@
 
 #include "Defines.h"
 
+#include <cmath>
+#include <stdexcept>
 #include <type_traits>
 
 #undef min
@@ -50,22 +52,22 @@ public:
 		};
 	};
 
-	template<ScalarTypeCheck<T>* = 0>
+	template<ScalarTypeCheck<T>* = nullptr>
 	MIXED_PREFIX Vec() : x(0),y(0),z(0){}
 	
-	template<ScalarTypeCheck<T>* = 0>
+	template<ScalarTypeCheck<T>* = nullptr>
 	MIXED_PREFIX Vec(T val)
 		: x(val), y(val), z(val)
 	{}
 
-	template<typename U, ScalarTypeCheck<U>* = 0>
+	template<typename U, ScalarTypeCheck<U>* = nullptr>
 	MIXED_PREFIX Vec(const U* elems)
 		:	x(static_cast<T>(elems[0])),
 			y(static_cast<T>(elems[1])),
 			z(static_cast<T>(elems[2]))
 	{}
 
-	template<typename U, ScalarTypeCheck<U>* = 0>
+	template<typename U, ScalarTypeCheck<U>* = nullptr>
 	MIXED_PREFIX Vec(const Vec<U>& other)
 		:	x(static_cast<T>(other.x)),
 			y(static_cast<T>(other.y)),
@@ -73,7 +75,7 @@ public:
 	{}
 
 
-	template<ScalarTypeCheck<T>* = 0>
+	template<ScalarTypeCheck<T>* = nullptr>
 	MIXED_PREFIX Vec(T x, T y, T z)
 		: x(x), y(y), z(z)
 	{}
@@ -208,7 +210,7 @@ public:
 	{
 		Vec<size_t> vecOut = Vec<size_t>(0,0,0);
 		if(x==0 && y==0 && z==0)
-			throw runtime_error("Not a valid vector to index into!");
+			throw std::runtime_error("Not a valid vector to index into!");
 
 		if(x==0)
 		{
@@ -404,25 +406,25 @@ public:
 };
 
 // Scalar-vector binary operator definitions
-template <typename U, typename V, ScalarTypeCheck<U>* = 0>
+template <typename U, typename V, ScalarTypeCheck<U>* = nullptr>
 MIXED_PREFIX Vec<typename std::common_type<U, V>::type> operator+(U scalar, const Vec<V>& vec)
 {
 	return (vec + scalar);
 }
 
-template <typename U, typename V, ScalarTypeCheck<U>* = 0>
+template <typename U, typename V, ScalarTypeCheck<U>* = nullptr>
 MIXED_PREFIX Vec<typename std::common_type<U, V>::type> operator-(U scalar, const Vec<V>& vec)
 {
 	return vec.subFrom(scalar);
 }
 
-template <typename U, typename V, ScalarTypeCheck<U>* = 0>
+template <typename U, typename V, ScalarTypeCheck<U>* = nullptr>
 MIXED_PREFIX Vec<typename std::common_type<U, V>::type> operator*(U scalar, const Vec<V>& vec)
 {
 	return (vec * scalar);
 }
 
-template <typename U, typename V, ScalarTypeCheck<U>* = 0>
+template <typename U, typename V, ScalarTypeCheck<U>* = nullptr>
 MIXED_PREFIX Vec<typename std::common_type<U, V>::type> operator/(U scalar, const Vec<V>& vec)
 {
 	return vec.divideRight(scalar);
@@ -19,6 +19,8 @@ protected:
 		gRenderer->setRendering(false);
 		return true;
 	}
+
+	virtual bool writeLog(CommandLogWriter& log) const {log.writeType(LogTakeControl); return true;}
 };
 
 
@@ -35,6 +37,8 @@ protected:
 
 		return true;
 	}
+
+	virtual bool writeLog(CommandLogWriter& log) const {log.writeType(LogReleaseControl); return true;}
 };
 
 
@@ -51,6 +55,9 @@ protected:
 		return true;
 	}
 
+	virtual bool getCoalesceTarget(uint64_t& targetOut) const {targetOut = 0; return true;}
+	virtual bool writeLog(CommandLogWriter& log) const {log.writeType(LogSetPlayMovie); log.write(playing); return true;}
+
 private:
 	bool playing;
 };
@@ -68,6 +75,9 @@ protected:
 		return true;
 	}
 
+	virtual bool getCoalesceTarget(uint64_t& targetOut) const {targetOut = 0; return true;}
+	virtual bool writeLog(CommandLogWriter& log) const {log.writeType(LogSetSpinning); log.write(spinning); return true;}
+
 private:
 	bool spinning;
 };
@@ -80,6 +90,8 @@ public:
 
 protected:
 	virtual bool process();
+	virtual bool getCoalesceTarget(uint64_t& targetOut) const {targetOut = 0; return true;}
+	virtual bool writeLog(CommandLogWriter& log) const {log.writeType(LogSetMovieFrame); log.write(frame); return true;}
 
 private:
 	int frame;
@@ -110,6 +122,8 @@ public:
 
 protected:
 	virtual bool process();
+	virtual bool getCoalesceTarget(uint64_t& targetOut) const {targetOut = 0; return true;}
+	virtual bool writeLog(CommandLogWriter& log) const {log.writeType(LogSetCaptureSize); log.write(captureSize); return true;}
 
 private:
 	Vec<int> captureSize;
@@ -0,0 +1,457 @@
+#include "CommandLog.h"
+#include "Message.h"
+
+#include <cstring>
+#include <utility>
+
+namespace
+{
+	const char logMagic[8] = "D3DLOG1";
+
+	enum RecordKinds
+	{
+		RecordPayload,
+		RecordMessage
+	};
+
+	const char* typeNames[NumLoggedMessages] =
+	{
+		"None",
+		"InitVolume",
+		"LoadTextureFrame",
+		"ClearTextureFrame",
+		"LoadTexture",
+		"ClearAllTexture",
+		"LoadPolys",
+		"DeletePoly",
+		"DeleteAllPolys",
+		"UpdateRender",
+		"SetWindowSize",
+		"SetDpiScale",
+		"ResetView",
+		"SetViewOrigin",
+		"SetViewRotation",
+		"SetWorldRotation",
+		"SetFrontClipPlane",
+		"ShowFrame",
+		"ShowLabels",
+		"ShowScale",
+		"SetBackgroundColor",
+		"SetObjectColor",
+		"MoveCamera",
+		"ShowPolys",
+		"SetPolygonState",
+		"ShowObjectType",
+		"SelectRegion",
+		"SetPolyWireframe",
+		"SetPolyLighting",
+		"UpdateTransferFcn",
+		"SetTextureLighting",
+		"SetTextureAttenuation",
+		"SetPolygonLod",
+		"SetMeshOptimize",
+		"TakeControl",
+		"ReleaseControl",
+		"SetPlayMovie",
+		"SetSpinning",
+		"SetMovieFrame",
+		"SetCaptureSize",
+		"SetFrameBudget"
+	};
+
+	// Payload comparisons read the file back in pieces of this size
+	const size_t readBufferSize = 1024 * 1024;
+
+	// Logs easily pass the 2GB a long can seek to on Windows
+	bool seekFile(FILE* file, uint64_t offset)
+	{
+#ifdef _WIN32
+		return _fseeki64(file, int64_t(offset), SEEK_SET) == 0;
+#else
+		return fseeko(file, off_t(offset), SEEK_SET) == 0;
+#endif
+	}
+}
+
+
+CommandLogWriter::CommandLogWriter()
+	: file(NULL), numRecorded(0), numSkipped(0), bytesWritten(0), writeFailed(false)
+{}
+
+CommandLogWriter::~CommandLogWriter()
+{
+	close();
+}
+
+bool CommandLogWriter::open(const std::string& path)
+{
+	std::lock_guard<std::mutex> lock(mutex);
+
+	if ( file )
+		fclose(file);
+
+	// Readable too, repeated payloads are compared with the copy already in the file
+	file = fopen(path.c_str(), "w+b");
+	if ( !file )
+		return false;
+
+	startTime = std::chrono::steady_clock::now();
+	payloadsWritten.clear();
+
+	numRecorded = 0;
+	numSkipped = 0;
+	bytesWritten = 0;
+	writeFailed = false;
+
+	writeFile(logMagic, sizeof(logMagic));
+
+	return true;
+}
+
+void CommandLogWriter::close()
+{
+	std::lock_guard<std::mutex> lock(mutex);
+
+	// Buffered writes only fail here if the disk filled up at the end
+	if ( file && fclose(file) != 0 )
+		writeFailed = true;
+
+	file = NULL;
+	payloadsWritten.clear();
+	readBuffer = std::vector<unsigned char>();
+}
+
+void CommandLogWriter::record(const Message* message, bool waited)
+{
+	std::lock_guard<std::mutex> lock(mutex);
+
+	if ( !file || writeFailed )
+		return;
+
+	double time = std::chrono::duration<double>(std::chrono::steady_clock::now() - startTime).count();
+
+	messageRecord.clear();
+	write(time);
+	write(uint8_t(waited ? 1 : 0));
+
+	if ( !message->writeLog(*this) )
+	{
+		++numSkipped;
+		return;
+	}
+
+	writeRecord(RecordMessage, messageRecord.data(), messageRecord.size());
+	++numRecorded;
+}
+
+void CommandLogWriter::writeType(LoggedMessages type)
+{
+	write(uint16_t(type));
+}
+
+void CommandLogWriter::writeBytes(const void* data, size_t size)
+{
+	const unsigned char* bytes = (const unsigned char*)data;
+	messageRecord.insert(messageRecord.end(), bytes, bytes + size);
+}
+
+void CommandLogWriter::writeString(const std::string& str)
+{
+	write(uint64_t(str.size()));
+	writeBytes(str.data(), str.size());
+}
+
+void CommandLogWriter::writePayload(const void* data, size_t size)
+{
+	uint64_t key = hashPayload(data, size);
+	for ( ;; )
+	{
+		std::unordered_map<uint64_t, WrittenPayload>::const_iterator it = payloadsWritten.find(key);
+		if ( it == payloadsWritten.end() )
+			break;
+
+		if ( matchesWritten(it->second, data, size) )
+		{
+			write(key);
+			return;
+		}
+
+		// Same hash, different data
+		++key;
+	}
+
+	write(key);
+
+	// Goes out ahead of the message that refers to it, the data follows the record header and the key
+	WrittenPayload written;
+	written.offset = bytesWritten + sizeof(uint8_t) + sizeof(uint64_t) + sizeof(key);
+	written.size = size;
+
+	std::vector<unsigned char> payload(sizeof(key) + size);
+	memcpy(payload.data(), &key, sizeof(key));
+	memcpy(payload.data() + sizeof(key), data, size);
+
+	writeRecord(RecordPayload, payload.data(), payload.size());
+
+	if ( !writeFailed )
+		payloadsWritten[key] = written;
+}
+
+uint64_t CommandLogWriter::hashPayload(const void* data, size_t size)
+{
+	// Only picks the key, matches are confirmed against the data, so a word at a time multiply-xor is plenty
+	const uint64_t prime = 0x100000001B3ull;
+	const unsigned char* bytes = (const unsigned char*)data;
+
+	uint64_t hash = 0xCBF29CE484222325ull ^ uint64_t(size);
+
+	size_t numWords = size / sizeof(uint64_t);
+	for ( size_t i = 0; i < numWords; ++i )
+	{
+		uint64_t word;
+		memcpy(&word, bytes + i*sizeof(uint64_t), sizeof(uint64_t));
+
+		hash = (hash ^ word) * prime;
+		hash ^= hash >> 29;
+	}
+
+	for ( size_t i = numWords*sizeof(uint64_t); i < size; ++i )
+		hash = (hash ^ bytes[i]) * prime;
+
+	return hash;
+}
+
+bool CommandLogWriter::matchesWritten(const WrittenPayload& written, const void* data, size_t size)
+{
+	if ( written.size != size )
+		return false;
+
+	// Read back from the file rather than keeping every payload in memory
+	if ( fflush(file) != 0 || !seekFile(file, written.offset) )
+	{
+		writeFailed = true;
+		return false;
+	}
+
+	readBuffer.resize(readBufferSize);
+
+	const unsigned char* bytes = (const unsigned char*)data;
+	bool same = true;
+	for ( size_t pos = 0; same && pos < size; pos += readBufferSize )
+	{
+		size_t count = (size - pos < readBufferSize) ? (size - pos) : readBufferSize;
+		same = (fread(readBuffer.data(), 1, count, file) == count && memcmp(readBuffer.data(), bytes + pos, count) == 0);
+	}
+
+	// Switching back to writing needs a seek
+	if ( fseek(file, 0, SEEK_END) != 0 )
+		writeFailed = true;
+
+	return same;
+}
+
+void CommandLogWriter::writeRecord(uint8_t kind, const void* data, size_t size)
+{
+	uint64_t length = size;
+
+	writeFile(&kind, sizeof(kind));
+	writeFile(&length, sizeof(length));
+	writeFile(data, size);
+}
+
+void CommandLogWriter::writeFile(const void* data, size_t size)
+{
+	// The rest of the log would be unreadable after a short write anyway
+	if ( writeFailed )
+		return;
+
+	if ( size > 0 && fwrite(data, 1, size, file) != size )
+	{
+		writeFailed = true;
+		return;
+	}
+
+	bytesWritten += size;
+}
+
+
+
+CommandLogReader::CommandLogReader()
+	: file(NULL), recordPos(0), readFailed(false)
+{}
+
+CommandLogReader::~CommandLogReader()
+{
+	if ( file )
+		fclose(file);
+}
+
+bool CommandLogReader::open(const std::string& path, std::string& errorOut)
+{
+	if ( file )
+		fclose(file);
+
+	payloads.clear();
+	error.clear();
+
+	file = fopen(path.c_str(), "rb");
+	if ( !file )
+	{
+		errorOut = "Could not open " + path;
+		return false;
+	}
+
+	char magic[sizeof(logMagic)];
+	if ( fread(magic, 1, sizeof(magic), file) != sizeof(magic) || memcmp(magic, logMagic, sizeof(magic)) != 0 )
+	{
+		fclose(file);
+		file = NULL;
+
+		errorOut = path + " is not a command log";
+		return false;
+	}
+
+	return true;
+}
+
+bool CommandLogReader::next(Entry& entryOut)
+{
+	entryOut.message = NULL;
+
+	if ( !file || !error.empty() )
+		return false;
+
+	for ( ;; )
+	{
+		uint8_t kind;
+		uint64_t length;
+
+		// A clean end of the log
+		if ( fread(&kind, sizeof(kind), 1, file) != 1 )
+			return false;
+
+		if ( fread(&length, sizeof(length), 1, file) != 1 )
+		{
+			error = "Log ends in the middle of a record";
+			return false;
+		}
+
+		std::unique_ptr<std::vector<unsigned char>> data(new std::vector<unsigned char>());
+		try
+		{
+			data->resize(size_t(length));
+		}
+		catch(const std::bad_alloc&)
+		{
+			error = "Log record is too large to read";
+			return false;
+		}
+
+		if ( length > 0 && fread(data->data(), 1, data->size(), file) != data->size() )
+		{
+			error = "Log ends in the middle of a record";
+			return false;
+		}
+
+		if ( kind == RecordPayload )
+		{
+			uint64_t hash;
+			if ( data->size() < sizeof(hash) )
+			{
+				error = "Damaged payload record";
+				return false;
+			}
+
+			memcpy(&hash, data->data(), sizeof(hash));
+			data->erase(data->begin(), data->begin() + sizeof(hash));
+
+			payloads[hash] = std::move(data);
+			continue;
+		}
+
+		if ( kind != RecordMessage )
+		{
+			error = "Unknown record in log";
+			return false;
+		}
+
+		record.swap(*data);
+		recordPos = 0;
+		readFailed = false;
+
+		entryOut.time = read<double>();
+		entryOut.waited = (read<uint8_t>() != 0);
+		entryOut.type = LoggedMessages(read<uint16_t>());
+
+		if ( readFailed || entryOut.type <= LogNone || entryOut.type >= NumLoggedMessages )
+		{
+			error = "Damaged message record";
+			return false;
+		}
+
+		entryOut.message = createMessage(entryOut.type);
+		if ( !entryOut.message || readFailed || recordPos != record.size() )
+		{
+			delete entryOut.message;
+			entryOut.message = NULL;
+
+			error = std::string("Damaged ") + getTypeName(entryOut.type) + " record";
+			return false;
+		}
+
+		return true;
+	}
+}
+
+const char* CommandLogReader::getTypeName(LoggedMessages type)
+{
+	if ( type < 0 || type >= NumLoggedMessages )
+		return "Unknown";
+
+	return typeNames[type];
+}
+
+bool CommandLogReader::readBytes(void* data, size_t size)
+{
+	if ( readFailed || size > record.size() - recordPos )
+	{
+		readFailed = true;
+		return false;
+	}
+
+	memcpy(data, record.data() + recordPos, size);
+	recordPos += size;
+
+	return true;
+}
+
+std::string CommandLogReader::readString()
+{
+	uint64_t length = read<uint64_t>();
+	if ( readFailed || length > record.size() - recordPos )
+	{
+		readFailed = true;
+		return std::string();
+	}
+
+	std::string str((const char*)record.data() + recordPos, size_t(length));
+	recordPos += size_t(length);
+
+	return str;
+}
+
+const std::vector<unsigned char>* CommandLogReader::readPayload()
+{
+	uint64_t hash = read<uint64_t>();
+	if ( readFailed )
+		return NULL;
+
+	auto it = payloads.find(hash);
+	if ( it == payloads.end() )
+	{
+		readFailed = true;
+		return NULL;
+	}
+
+	return it->second.get();
+}
@@ -0,0 +1,213 @@
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+class Message;
+
+// Message classes in a command log. The values are stored in the files, only ever add to the end.
+enum LoggedMessages
+{
+	LogNone,
+	LogInitVolume,
+	LogLoadTextureFrame,
+	LogClearTextureFrame,
+	LogLoadTexture,
+	LogClearAllTexture,
+	LogLoadPolys,
+	LogDeletePoly,
+	LogDeleteAllPolys,
+	LogUpdateRender,
+	LogSetWindowSize,
+	LogSetDpiScale,
+	LogResetView,
+	LogSetViewOrigin,
+	LogSetViewRotation,
+	LogSetWorldRotation,
+	LogSetFrontClipPlane,
+	LogShowFrame,
+	LogShowLabels,
+	LogShowScale,
+	LogSetBackgroundColor,
+	LogSetObjectColor,
+	LogMoveCamera,
+	LogShowPolys,
+	LogSetPolygonState,
+	LogShowObjectType,
+	LogSelectRegion,
+	LogSetPolyWireframe,
+	LogSetPolyLighting,
+	LogUpdateTransferFcn,
+	LogSetTextureLighting,
+	LogSetTextureAttenuation,
+	LogSetPolygonLod,
+	LogSetMeshOptimize,
+	LogTakeControl,
+	LogReleaseControl,
+	LogSetPlayMovie,
+	LogSetSpinning,
+	LogSetMovieFrame,
+	LogSetCaptureSize,
+	LogSetFrameBudget,
+	NumLoggedMessages
+};
+
+// Binary log of the messages pushed to the render thread, for replaying a session without MATLAB.
+// The file is a header followed by records. A message record holds its type, push time, whether the sender waited on it
+// and the fields the message writes (see Message::writeLog). Bulk data (images, meshes) goes into payload records
+// keyed by a hash of the content, written before the first message that refers to them, so repeated data is stored once.
+// Data is only reused when it matches the earlier payload byte for byte, a different payload with the same hash gets the
+// next free key.
+class CommandLogWriter
+{
+public:
+	CommandLogWriter();
+	~CommandLogWriter();
+
+	// Returns false if the file couldn't be created
+	bool open(const std::string& path);
+	void close();
+
+	// Called by the message queue for every push. Messages without a writeLog (outputs, captures, close) are skipped.
+	void record(const Message* message, bool waited);
+
+	size_t getNumRecorded() const {return numRecorded;}
+	size_t getNumSkipped() const {return numSkipped;}
+	uint64_t getBytesWritten() const {return bytesWritten;}
+
+	// True once a write to the file has failed (disk full, ...), nothing more is written and the log is incomplete.
+	// Also covers the final flush, so check it after close().
+	bool hasWriteFailed() const {return writeFailed;}
+
+	// The key a payload is stored under unless another payload already has it
+	static uint64_t hashPayload(const void* data, size_t size);
+
+	// For Message::writeLog, values are copied as raw bytes so only use this on plain data
+	void writeType(LoggedMessages type);
+	void writeBytes(const void* data, size_t size);
+	void writeString(const std::string& str);
+	void writePayload(const void* data, size_t size);
+
+	template <typename T>
+	void write(const T& value)
+	{
+		writeBytes(&value, sizeof(T));
+	}
+
+	template <typename T>
+	void writeVector(const std::vector<T>& values)
+	{
+		write(uint64_t(values.size()));
+		writeBytes(values.data(), values.size()*sizeof(T));
+	}
+
+private:
+	// Where an earlier payload's data sits in the file
+	struct WrittenPayload
+	{
+		uint64_t offset;
+		uint64_t size;
+	};
+
+	void writeRecord(uint8_t kind, const void* data, size_t size);
+	void writeFile(const void* data, size_t size);
+	bool matchesWritten(const WrittenPayload& written, const void* data, size_t size);
+
+	std::mutex mutex;
+	FILE* file;
+
+	std::chrono::steady_clock::time_point startTime;
+
+	// The message record being built
+	std::vector<unsigned char> messageRecord;
+
+	std::unordered_map<uint64_t, WrittenPayload> payloadsWritten;
+	// For comparing against payloads already in the file
+	std::vector<unsigned char> readBuffer;
+
+	size_t numRecorded;
+	size_t numSkipped;
+	uint64_t bytesWritten;
+	bool writeFailed;
+};
+
+
+// Reads a command log back into messages. Payloads stay in memory for as long as the reader exists,
+// messages that point at them (texture loads) must be processed before it is destroyed.
+class CommandLogReader
+{
+public:
+	struct Entry
+	{
+		// Seconds since recording started
+		double time;
+		bool waited;
+
+		LoggedMessages type;
+		Message* message;
+	};
+
+	CommandLogReader();
+	~CommandLogReader();
+
+	// errorOut says what went wrong when this returns false
+	bool open(const std::string& path, std::string& errorOut);
+
+	// Returns false at the end of the log or on a damaged record. The caller owns entryOut.message.
+	bool next(Entry& entryOut);
+
+	const std::string& getError() const {return error;}
+
+	static const char* getTypeName(LoggedMessages type);
+
+	// For creating messages from a record
+	bool readBytes(void* data, size_t size);
+	std::string readString();
+	// Returns NULL if the payload isn't in the log
+	const std::vector<unsigned char>* readPayload();
+
+	template <typename T>
+	T read()
+	{
+		T value = T();
+		readBytes(&value, sizeof(T));
+		return value;
+	}
+
+	template <typename T>
+	std::vector<T> readVector()
+	{
+		std::vector<T> values;
+
+		// A damaged count would otherwise ask for any amount of memory
+		uint64_t count = read<uint64_t>();
+		if ( readFailed || count > (record.size() - recordPos) / sizeof(T) )
+		{
+			readFailed = true;
+			return values;
+		}
+
+		values.resize(size_t(count));
+		readBytes(values.data(), values.size()*sizeof(T));
+		return values;
+	}
+
+private:
+	Message* createMessage(LoggedMessages type);
+
+	FILE* file;
+	std::string error;
+
+	std::vector<unsigned char> record;
+	size_t recordPos;
+	// Set when a read ran past the end of the record
+	bool readFailed;
+
+	std::unordered_map<uint64_t, std::unique_ptr<std::vector<unsigned char>>> payloads;
+};
@@ -0,0 +1,256 @@
+#include "CommandLog.h"
+#include "AnimMessages.h"
+#include "LoadMessages.h"
+#include "RenderMessages.h"
+#include "ViewMessages.h"
+
+// Builds messages back from their log records. Kept out of CommandLog.cpp, so the log format itself only needs the Message base class.
+
+Message* CommandLogReader::createMessage(LoggedMessages type)
+{
+	switch ( type )
+	{
+	case LogInitVolume:
+	{
+		int numFrames = read<int>();
+		int numChannels = read<int>();
+		Vec<size_t> dims = read<Vec<size_t>>();
+		Vec<float> physicalSize = read<Vec<float>>();
+		bool columnMajor = read<bool>();
+
+		return new MessageInitVolume(numFrames, numChannels, dims, physicalSize, columnMajor);
+	}
+	case LogLoadTextureFrame:
+	{
+		GraphicObjectTypes textureType = read<GraphicObjectTypes>();
+		int frame = read<int>();
+
+		// The message gets its own copy, the same payload can be loaded again later in the log
+		const std::vector<unsigned char>* payload = readPayload();
+		if ( !payload )
+			return NULL;
+
+		return new MessageLoadTextureFrame(textureType, frame, std::vector<unsigned char>(*payload));
+	}
+	case LogClearTextureFrame:
+	{
+		GraphicObjectTypes textureType = read<GraphicObjectTypes>();
+		int frame = read<int>();
+
+		return new MessageClearTextureFrame(textureType, frame);
+	}
+	case LogLoadTexture:
+	{
+		GraphicObjectTypes textureType = read<GraphicObjectTypes>();
+
+		const std::vector<unsigned char>* payload = readPayload();
+		if ( !payload )
+			return NULL;
+
+		return new MessageLoadTexture(textureType, std::vector<unsigned char>(*payload));
+	}
+	case LogClearAllTexture:
+		return new MessageClearAllTexture(read<GraphicObjectTypes>());
+	case LogLoadPolys:
+	{
+		uint64_t numPolys = read<uint64_t>();
+		if ( readFailed || numPolys > record.size() )
+			return NULL;
+
+		MessageLoadPolys* loadMsg = new MessageLoadPolys(size_t(numPolys));
+		for ( uint64_t i = 0; i < numPolys && !readFailed; ++i )
+		{
+			int frame = read<int>();
+			int index = read<int>();
+			std::string label = readString();
+			Vec<float> color = read<Vec<float>>();
+
+			const std::vector<unsigned char>* payload = readPayload();
+			if ( !payload )
+				break;
+
+			// The mesh payload is the three arrays one after the other, each with its count in front
+			CommandLogReader meshReader;
+			meshReader.record = *payload;
+
+			std::vector<Vec<uint32_t>> faces = meshReader.readVector<Vec<uint32_t>>();
+			std::vector<Vec<float>> verts = meshReader.readVector<Vec<float>>();
+			std::vector<Vec<float>> norms = meshReader.readVector<Vec<float>>();
+			if ( meshReader.readFailed )
+			{
+				readFailed = true;
+				break;
+			}
+
+			double colorData[3] = {color.x, color.y, color.z};
+
+			QueuePolygon* poly = loadMsg->createPoly(frame, index, label);
+			poly->setMeshData(faces, verts, norms);
+			poly->setcolorData(colorData);
+		}
+
+		return loadMsg;
+	}
+	case LogDeletePoly:
+		return new MessageDeletePoly(read<int>());
+	case LogDeleteAllPolys:
+		return new MessageDeleteAllPolys();
+	case LogUpdateRender:
+		return new MessageUpdateRender();
+	case LogSetWindowSize:
+	{
+		int width = read<int>();
+		int height = read<int>();
+
+		return new MessageSetWindowSize(width, height);
+	}
+	case LogSetDpiScale:
+		return new MessageSetDpiScale(read<int>());
+	case LogResetView:
+		return new MessageResetView();
+	case LogSetViewOrigin:
+		return new MessageSetViewOrigin(read<Vec<float>>());
+	case LogSetViewRotation:
+	{
+		Vec<double> axis = read<Vec<double>>();
+		double angle = read<double>();
+
+		return new MessageSetViewRotation(axis, angle);
+	}
+	case LogSetWorldRotation:
+	{
+		Vec<double> axis = read<Vec<double>>();
+		double angle = read<double>();
+
+		return new MessageSetWorldRotation(axis, angle);
+	}
+	case LogSetFrontClipPlane:
+		return new MessageSetFrontClipPlane(read<float>());
+	case LogShowFrame:
+		return new MessageShowFrame(read<bool>());
+	case LogShowLabels:
+		return new MessageShowLabels(read<bool>());
+	case LogShowScale:
+		return new MessageShowScale(read<bool>());
+	case LogSetBackgroundColor:
+		return new MessageSetBackgroundColor(read<Vec<float>>());
+	case LogSetObjectColor:
+	{
+		GraphicObjectTypes objectType = read<GraphicObjectTypes>();
+		Vec<float> color = read<Vec<float>>();
+
+		return new MessageSetObjectColor(objectType, color);
+	}
+	case LogMoveCamera:
+		return new MessageMoveCamera(Vec<double>(read<Vec<float>>()));
+	case LogShowPolys:
+	{
+		bool visible = read<bool>();
+		std::vector<int> indices = readVector<int>();
+
+		MessageShowPolys* showMsg = new MessageShowPolys(visible);
+		for ( int index : indices )
+			showMsg->setPoly(index);
+
+		return showMsg;
+	}
+	case LogSetPolygonState:
+	{
+		MessageSetPolygonState* stateMsg = new MessageSetPolygonState();
+
+		NodeRegistry::BulkState& state = stateMsg->getState();
+		state.indices = readVector<int>();
+		state.visible = readVector<char>();
+		state.colors = readVector<Vec<float>>();
+		state.alphas = readVector<float>();
+		state.clearColors = read<bool>();
+		state.wireframe = read<int>();
+
+		return stateMsg;
+	}
+	case LogShowObjectType:
+	{
+		GraphicObjectTypes objectType = read<GraphicObjectTypes>();
+		bool visible = read<bool>();
+
+		return new MessageShowObjectType(objectType, visible);
+	}
+	case LogSelectRegion:
+	{
+		std::vector<Vec<float>> region = readVector<Vec<float>>();
+		bool touching = read<bool>();
+
+		// Nobody is waiting on the indices, the selection goes out as an event like a mouse selection would
+		return new MessageSelectRegion(region, touching);
+	}
+	case LogSetPolyWireframe:
+		return new MessageSetPolyWireframe(read<bool>());
+	case LogSetPolyLighting:
+		return new MessageSetPolyLighting(read<bool>());
+	case LogUpdateTransferFcn:
+	{
+		GraphicObjectTypes objectType = read<GraphicObjectTypes>();
+		int channel = read<int>();
+		Vec<float> transferFcn = read<Vec<float>>();
+		Vec<float> range = read<Vec<float>>();
+		Vec<float> color = read<Vec<float>>();
+		float alpha = read<float>();
+
+		MessageUpdateTransferFcn* transferMsg = new MessageUpdateTransferFcn(objectType, channel);
+		transferMsg->setTransferFcn(transferFcn);
+		transferMsg->setRange(range);
+		transferMsg->setColor(color, alpha);
+
+		return transferMsg;
+	}
+	case LogSetTextureLighting:
+	{
+		GraphicObjectTypes objectType = read<GraphicObjectTypes>();
+		bool lightingOn = read<bool>();
+
+		return new MessageSetTextureLighting(objectType, lightingOn);
+	}
+	case LogSetTextureAttenuation:
+	{
+		GraphicObjectTypes objectType = read<GraphicObjectTypes>();
+		bool attenuate = read<bool>();
+
+		return new MessageSetTextureAttenuation(objectType, attenuate);
+	}
+	case LogSetPolygonLod:
+	{
+		float errorPixels = read<float>();
+		std::vector<float> levelPixels = readVector<float>();
+
+		return new MessageSetPolygonLod(errorPixels, levelPixels);
+	}
+	case LogSetMeshOptimize:
+		return new MessageSetMeshOptimize(read<bool>());
+	case LogTakeControl:
+		return new MessageTakeControl();
+	case LogReleaseControl:
+		return new MessageReleaseControl();
+	case LogSetPlayMovie:
+		return new MessageSetPlayMovie(read<bool>());
+	case LogSetSpinning:
+		return new MessageSetSpinning(read<bool>());
+	case LogSetMovieFrame:
+		return new MessageSetMovieFrame(read<int>());
+	case LogSetCaptureSize:
+	{
+		Vec<int> captureSize = read<Vec<int>>();
+
+		return new MessageSetCaptureSize(captureSize.x, captureSize.y);
+	}
+	case LogSetFrameBudget:
+	{
+		double targetFps = read<double>();
+		double budgetMs = read<double>();
+		int window = read<int>();
+
+		return new MessageSetFrameBudget(targetFps, budgetMs, window);
+	}
+	default:
+		return NULL;
+	}
+}
@@ -0,0 +1,200 @@
+#include "EventQueue.h"
+
+#include <comdef.h>
+
+#include <algorithm>
+#include <cstring>
+
+#undef min
+#undef max
+
+namespace
+{
+	// Same strings the old return queue used so existing MATLAB handlers keep working
+	const char* typeNames[NumEventTypes] =
+	{
+		"error",
+		"close",
+		"timeChange",
+		"play",
+		"rotate",
+		"keyDown",
+		"keyUp",
+		"cellSelected",
+		"rightClick",
+		"volumePoint",
+		"polygonsSelected",
+		"togglePolygons",
+		"toggleLabels",
+		"centerSelectedPolygon",
+		"frameOverBudget"
+	};
+
+	const char* keyNames[NumEventKeys] = {"", "shift", "ctrl", "alt", "number"};
+}
+
+
+EventQueue::EventQueue()
+	: startTime(std::chrono::steady_clock::now()), firstSequence(1), nextSequence(1), clearedSequence(0), numOverwritten(0), errorExist(false), loadDone(false)
+{
+	memset(events, 0, sizeof(events));
+}
+
+void EventQueue::addEvent(EventTypes type, double val)
+{
+	std::lock_guard<std::mutex> lock(eventMutex);
+
+	Event& event = nextEvent(type);
+	event.val = val;
+}
+
+void EventQueue::addEvent(EventTypes type, EventKeys key, double val)
+{
+	std::lock_guard<std::mutex> lock(eventMutex);
+
+	Event& event = nextEvent(type);
+	event.key = key;
+	event.val = val;
+}
+
+void EventQueue::addEvent(EventTypes type, const std::vector<double>& values)
+{
+	std::lock_guard<std::mutex> lock(eventMutex);
+
+	Event& event = nextEvent(type);
+	event.val = double(values.size());
+	event.numValues = uint32_t(values.size());
+
+	if ( values.size() <= maxInlineValues )
+	{
+		std::copy(values.begin(), values.end(), event.values);
+		return;
+	}
+
+	payloads[event.sequence].values = values;
+}
+
+void EventQueue::addErrorMessage(HRESULT hr)
+{
+	_com_error err(hr);
+	addErrorMessage(err.ErrorMessage(), double(hr));
+}
+
+void EventQueue::addErrorMessage(const std::string& message, double code)
+{
+	{
+		std::lock_guard<std::mutex> lock(eventMutex);
+
+		Event& event = nextEvent(EventError);
+		event.val = code;
+
+		payloads[event.sequence].message = message;
+	}
+
+	errorExist = true;
+}
+
+EventQueue::PollResult EventQueue::getEvents(uint64_t since, uint32_t typeMask, std::vector<PolledEvent>& eventsOut)
+{
+	std::lock_guard<std::mutex> lock(eventMutex);
+
+	since = std::min(since, nextSequence - 1);
+	uint64_t start = std::max(since + 1, firstSequence);
+
+	// Events removed by clear() were thrown away on purpose, they don't count as dropped
+	PollResult result;
+	result.lastSequence = nextSequence - 1;
+	result.dropped = start - 1 - std::max(since, clearedSequence);
+
+	for ( uint64_t sequence = start; sequence < nextSequence; ++sequence )
+	{
+		const Event& event = events[sequence % capacity];
+		if ( (typeMask & (1u << event.type)) == 0 )
+			continue;
+
+		eventsOut.push_back(PolledEvent());
+		PolledEvent& polled = eventsOut.back();
+		polled.event = event;
+
+		std::unordered_map<uint64_t, Payload>::const_iterator payload = payloads.find(sequence);
+		if ( payload != payloads.end() )
+		{
+			polled.message = payload->second.message;
+			polled.values = payload->second.values;
+		}
+		else
+		{
+			polled.values.assign(event.values, event.values + event.numValues);
+		}
+	}
+
+	// Whoever reads errors has seen them now
+	if ( typeMask & (1u << EventError) )
+		errorExist = false;
+
+	return result;
+}
+
+uint64_t EventQueue::getLastSequence()
+{
+	std::lock_guard<std::mutex> lock(eventMutex);
+	return nextSequence - 1;
+}
+
+void EventQueue::clear()
+{
+	std::lock_guard<std::mutex> lock(eventMutex);
+
+	firstSequence = nextSequence;
+	clearedSequence = nextSequence - 1;
+	payloads.clear();
+}
+
+const char* EventQueue::getTypeName(EventTypes type)
+{
+	return (type < NumEventTypes) ? typeNames[type] : "";
+}
+
+const char* EventQueue::getKeyName(EventKeys key)
+{
+	return (key < NumEventKeys) ? keyNames[key] : "";
+}
+
+bool EventQueue::findType(const std::string& name, EventTypes& typeOut)
+{
+	for ( int i = 0; i < NumEventTypes; ++i )
+	{
+		if ( name == typeNames[i] )
+		{
+			typeOut = (EventTypes)i;
+			return true;
+		}
+	}
+
+	return false;
+}
+
+EventQueue::Event& EventQueue::nextEvent(EventTypes type)
+{
+	uint64_t sequence = nextSequence++;
+
+	// Full ring, the oldest event goes
+	if ( sequence - firstSequence >= capacity )
+	{
+		if ( !payloads.empty() )
+			payloads.erase(firstSequence);
+
+		++firstSequence;
+		++numOverwritten;
+	}
+
+	Event& event = events[sequence % capacity];
+	event.sequence = sequence;
+	event.time = std::chrono::duration<double>(std::chrono::steady_clock::now() - startTime).count();
+	event.type = type;
+	event.key = KeyNone;
+	event.val = 0.0;
+	event.numValues = 0;
+
+	return event;
+}
@@ -0,0 +1,152 @@
+#pragma once
+
+#include "windows.h"
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+// Event types sent from the viewer back to MATLAB, the names are what Poll reports as the command
+enum EventTypes
+{
+	EventError,
+	EventClose,
+	EventTimeChange,
+	EventPlay,
+	EventRotate,
+	EventKeyDown,
+	EventKeyUp,
+	EventCellSelected,
+	EventRightClick,
+	EventVolumePoint,
+	EventPolygonsSelected,
+	EventTogglePolygons,
+	EventToggleLabels,
+	EventCenterSelectedPolygon,
+	EventFrameOverBudget,
+	NumEventTypes
+};
+
+// Modifier or key a keyDown/keyUp event is about
+enum EventKeys
+{
+	KeyNone,
+	KeyShift,
+	KeyCtrl,
+	KeyAlt,
+	KeyNumber,
+	NumEventKeys
+};
+
+// Events from the render thread (or anywhere else) to the MEX thread.
+// Events are small fixed records in a ring that overwrites the oldest entry when full, so the frequent ones
+// (frame changes, clicks, keys) never allocate. Readers ask for everything after the last sequence number they saw,
+// anything overwritten before they got to it is reported as dropped.
+class EventQueue
+{
+public:
+	static const size_t capacity = 4096;
+
+	// Values beyond this many (polygon selections) and error text are kept beside the ring
+	static const size_t maxInlineValues = 6;
+
+	struct Event
+	{
+		// Starts at 1 and increases by one for every event added
+		uint64_t sequence;
+
+		// Seconds since the queue was created
+		double time;
+
+		EventTypes type;
+		EventKeys key;
+
+		double val;
+
+		uint32_t numValues;
+		double values[maxInlineValues];
+	};
+
+	struct PolledEvent
+	{
+		Event event;
+		std::string message;
+		std::vector<double> values;
+	};
+
+	struct PollResult
+	{
+		// Pass this as since to the next poll
+		uint64_t lastSequence;
+
+		// Events after since that were overwritten before this poll
+		uint64_t dropped;
+	};
+
+	EventQueue();
+
+	void addEvent(EventTypes type, double val = 0.0);
+	void addEvent(EventTypes type, EventKeys key, double val = 0.0);
+	void addEvent(EventTypes type, const std::vector<double>& values);
+
+	void addErrorMessage(HRESULT hr);
+	void addErrorMessage(const std::string& message, double code = -1.0);
+
+	// Appends events after the given sequence number whose type bit is set in typeMask, oldest first
+	PollResult getEvents(uint64_t since, uint32_t typeMask, std::vector<PolledEvent>& eventsOut);
+
+	// Sequence number of the newest event, zero if none were ever added
+	uint64_t getLastSequence();
+
+	// Events lost to overwriting since the queue was created
+	uint64_t getNumOverwritten() {return numOverwritten;}
+
+	// Set when an error is added, cleared once a poll has returned it
+	bool hasError() {return errorExist;}
+
+	bool doneLoading() {return loadDone;}
+	void setLoadDone() {loadDone = true;}
+	void clearLoadFlag() {loadDone = false;}
+
+	// Drops everything queued, sequence numbers keep counting
+	void clear();
+
+	static const char* getTypeName(EventTypes type);
+	static const char* getKeyName(EventKeys key);
+	static bool findType(const std::string& name, EventTypes& typeOut);
+
+	static uint32_t allTypes() {return (1u << NumEventTypes) - 1;}
+
+private:
+	struct Payload
+	{
+		std::string message;
+		std::vector<double> values;
+	};
+
+	Event& nextEvent(EventTypes type);
+
+	std::chrono::steady_clock::time_point startTime;
+
+	std::mutex eventMutex;
+
+	Event events[capacity];
+
+	// Sequence of the oldest event still in the ring and the next one to be assigned
+	uint64_t firstSequence;
+	uint64_t nextSequence;
+
+	// Newest event thrown away by clear()
+	uint64_t clearedSequence;
+
+	// Keyed by sequence, pruned as the ring overwrites their events
+	std::unordered_map<uint64_t, Payload> payloads;
+
+	std::atomic<uint64_t> numOverwritten;
+	std::atomic<bool> errorExist;
+	std::atomic<bool> loadDone;
+};
@@ -1,6 +1,8 @@
 #include "Global/Globals.h"
+#include "Global/Profiler.h"
 #include "Global/Vec.h"
 #include "D3d/VolumeInfo.h"
+#include "D3d/ResourceCache.h"
 #include "Messages/QueuePolygon.h"
 #include "Messages/MessageQueue.h"
 
@@ -9,15 +11,13 @@
 #include <set>
 #include <vector>
 #include <memory>
+#include <utility>
 
 using std::vector;
 
-std::shared_ptr<MeshPrimitive> createPolygonMesh(double* faceData, size_t numFaces, double* vertData, size_t numVerts, double* normData, size_t numNormals, const Color& color)
+static void convertPolygonData(double* faceData, size_t numFaces, double* vertData, size_t numVerts, double* normData, size_t numNormals,
+	std::vector<Vec<unsigned int>>& faces, std::vector<Vec<float>>& verts, std::vector<Vec<float>>& normals)
 {
-	std::vector<Vec<unsigned int>> faces;
-	std::vector<Vec<float>> verts;
-	std::vector<Vec<float>> normals;
-
 	faces.resize(numFaces);
 	verts.resize(numVerts);
 	normals.resize(numNormals);
@@ -47,8 +47,17 @@ std::shared_ptr<MeshPrimitive> createPolygonMesh(double* faceData, size_t numFac
 		curNormal.y = float(normData[i + numVerts]);
 		curNormal.z = float(normData[i + 2 * numVerts]);
 	}
+}
 
-	return std::make_shared<StaticColorMesh>(gRenderer, faces, verts, normals, color);
+std::shared_ptr<MeshPrimitive> createPolygonMesh(double* faceData, size_t numFaces, double* vertData, size_t numVerts, double* normData, size_t numNormals, const Color& color)
+{
+	std::vector<Vec<unsigned int>> faces;
+	std::vector<Vec<float>> verts;
+	std::vector<Vec<float>> normals;
+
+	convertPolygonData(faceData, numFaces, vertData, numVerts, normData, numNormals, faces, verts, normals);
+
+	return std::make_shared<StaticColorMesh>(gRenderer, std::move(faces), std::move(verts), std::move(normals), color);
 }
 
 
@@ -134,6 +143,10 @@ HRESULT createBorder(Vec<float> &scale)
 void clearAllTextures(GraphicObjectTypes type)
 {
 	gRenderer->removeSceneObjects(type);
+
+	VolumeInfo* info = gRenderer->getVolumeInfo();
+	if ( info )
+		info->clearPickData(type);
 }
 
 HRESULT initVolume(int numFrames, int numChannels, Vec<size_t> dims, Vec<float> physicalSize, bool columnMajor)
@@ -163,16 +176,22 @@ void clearTextureFrame(int frame, GraphicObjectTypes typ)
 	GraphicObjectNode* node = gRenderer->findSceneObject(typ, frame);
 	if ( node )
 		delete node;
+
+	VolumeInfo* info = gRenderer->getVolumeInfo();
+	if ( info )
+		info->clearPickData(typ, frame);
 }
 
 HRESULT loadTextureFrame(GraphicObjectTypes typ, int frame, unsigned char* image)
 {
+	PROFILE_ZONE("LoadTextureFrame");
+
 	if ( gRenderer == NULL )
 		return E_FAIL;
 
 	clearTextureFrame(frame, typ);
 
-	const VolumeInfo* info = gRenderer->getVolumeInfo();
+	VolumeInfo* info = gRenderer->getVolumeInfo();
 	if ( info == NULL )
 		return S_FALSE;
 
@@ -185,12 +204,14 @@ HRESULT loadTextureFrame(GraphicObjectTypes typ, int frame, unsigned char* image
 
 HRESULT loadVolumeTexture(unsigned char* image, GraphicObjectTypes typ)
 {
+	PROFILE_ZONE("LoadVolumeTexture");
+
 	if (gRenderer == NULL)
 		return E_FAIL;
 
 	clearAllTextures(typ);
 
-	const VolumeInfo* info = gRenderer->getVolumeInfo();
+	VolumeInfo* info = gRenderer->getVolumeInfo();
 
 	int numFrames = info->getFrames();
 	int numChannels = info->getChannels();
@@ -213,25 +234,38 @@ void attachWidget(double* arrowFaces, size_t numArrowFaces, double* arrowVerts,
 	SceneNode* widgetScene = new SceneNode(GraphicObjectTypes::Group);
 	gRenderer->attachToRootScene(widgetScene, Renderer::Section::Post, 0);
 
-	std::shared_ptr<MeshPrimitive> arrowMeshX = createPolygonMesh(arrowFaces, numArrowFaces, arrowVerts, numArrowVerts, arrowNorms, numArrowNorms, Color(1.0f, 0.2f, 0.2f, 1.0f));
-	std::shared_ptr<MeshPrimitive> arrowMeshY = createPolygonMesh(arrowFaces, numArrowFaces, arrowVerts, numArrowVerts, arrowNorms, numArrowNorms, Color(0.1f, 1.0f, 0.1f, 1.0f));
-	std::shared_ptr<MeshPrimitive> arrowMeshZ = createPolygonMesh(arrowFaces, numArrowFaces, arrowVerts, numArrowVerts, arrowNorms, numArrowNorms, Color(0.4f, 0.4f, 1.0f, 1.0f));
-	std::shared_ptr<MeshPrimitive> sphereMesh = createPolygonMesh(sphereFaces, numSphereFaces, sphereVerts, numSphereVerts, sphereNorms, numSphereNorms, Color(0.9f, 0.9f, 0.9f, 1.0f));
+	// One white arrow mesh is shared by all three axes, colors come from the materials
+	std::shared_ptr<MeshPrimitive> arrowMesh = createPolygonMesh(arrowFaces, numArrowFaces, arrowVerts, numArrowVerts, arrowNorms, numArrowNorms, Color(1.0f, 1.0f, 1.0f, 1.0f));
+	std::shared_ptr<MeshPrimitive> sphereMesh = createPolygonMesh(sphereFaces, numSphereFaces, sphereVerts, numSphereVerts, sphereNorms, numSphereNorms, Color(1.0f, 1.0f, 1.0f, 1.0f));
+
+	const Vec<float> widgetColors[4] = {Vec<float>(1.0f, 0.2f, 0.2f), Vec<float>(0.1f, 1.0f, 0.1f), Vec<float>(0.4f, 0.4f, 1.0f), Vec<float>(0.9f, 0.9f, 0.9f)};
 
-	std::shared_ptr<PolygonMaterial> arrowMat = std::make_shared<PolygonMaterial>(gRenderer);
+	std::shared_ptr<PolygonMaterial> widgetMats[4];
+	for ( int i = 0; i < 4; ++i )
+	{
+		PolygonMaterial::State matState;
+		matState.color = widgetColors[i];
+		matState.useColor = true;
+
+		widgetMats[i] = gRenderer->getResourceCache()->getPolygonMaterial(matState);
+	}
 
-	GraphicObjectNode* arrowXnode = new GraphicObjectNode(0, GraphicObjectTypes::Widget, arrowMeshX, arrowMat);
+	GraphicObjectNode* arrowXnode = new GraphicObjectNode(0, GraphicObjectTypes::Widget, arrowMesh, widgetMats[0]);
+	arrowXnode->setMaterialShared(true);
 	arrowXnode->setLocalToParent(DirectX::XMMatrixRotationY(DirectX::XM_PI / 2.0f));
 	arrowXnode->attachToParentNode(widgetScene);
 
-	GraphicObjectNode* arrowYnode = new GraphicObjectNode(1, GraphicObjectTypes::Widget, arrowMeshY, arrowMat);
+	GraphicObjectNode* arrowYnode = new GraphicObjectNode(1, GraphicObjectTypes::Widget, arrowMesh, widgetMats[1]);
+	arrowYnode->setMaterialShared(true);
 	arrowYnode->setLocalToParent(DirectX::XMMatrixRotationX(-DirectX::XM_PI / 2.0f));
 	arrowYnode->attachToParentNode(widgetScene);
 
-	GraphicObjectNode* arrowZnode = new GraphicObjectNode(2, GraphicObjectTypes::Widget, arrowMeshZ, arrowMat);
+	GraphicObjectNode* arrowZnode = new GraphicObjectNode(2, GraphicObjectTypes::Widget, arrowMesh, widgetMats[2]);
+	arrowZnode->setMaterialShared(true);
 	arrowZnode->attachToParentNode(widgetScene);
 
-	GraphicObjectNode* sphereNode = new GraphicObjectNode(3, GraphicObjectTypes::Widget, sphereMesh, arrowMat);
+	GraphicObjectNode* sphereNode = new GraphicObjectNode(3, GraphicObjectTypes::Widget, sphereMesh, widgetMats[3]);
+	sphereNode->setMaterialShared(true);
 	sphereNode->attachToParentNode(widgetScene);
 }
 
@@ -3,9 +3,50 @@
 #include "MessageHelpers.h"
 
 #include "D3d/VolumeInfo.h"
+#include "D3d/ResourceCache.h"
 
 #include "Global/Globals.h"
 #include "Global/ErrorMsg.h"
+#include "Global/ParallelFor.h"
+#include "Global/Profiler.h"
+
+#include <utility>
+
+namespace
+{
+	// Queued after a message's preparation tasks so the render thread wakes up to commit it
+	void submitPrepareDone(const std::vector<ThreadPool::TaskHandle>& tasks)
+	{
+		ThreadPool::shared().submit([](){gMsgQueueToDirectX.notifyPrepared();}, tasks);
+	}
+
+	// For destructors, a failure has already gone out through process() or the message was dropped unprocessed
+	void waitForTask(const ThreadPool::TaskHandle& task)
+	{
+		if ( ThreadPool::isDone(task) )
+			return;
+
+		try
+		{
+			ThreadPool::shared().wait(task);
+		}
+		catch(...)
+		{
+		}
+	}
+
+	// Same layout as CommandLogWriter::writeVector, so CommandLogReader::readVector can split the payload again
+	template <typename T>
+	void appendMeshArray(std::vector<unsigned char>& mesh, const T* values, size_t numValues)
+	{
+		uint64_t count = numValues;
+		const unsigned char* countBytes = (const unsigned char*)&count;
+		const unsigned char* valueBytes = (const unsigned char*)values;
+
+		mesh.insert(mesh.end(), countBytes, countBytes + sizeof(count));
+		mesh.insert(mesh.end(), valueBytes, valueBytes + numValues*sizeof(T));
+	}
+}
 
 
 MessageInitVolume::MessageInitVolume(int numFrames, int numChannels, Vec<size_t> dims, Vec<float> physSize, bool columnMajor)
@@ -27,16 +68,34 @@ bool MessageInitVolume::process()
 	return true;
 }
 
+bool MessageInitVolume::writeLog(CommandLogWriter& log) const
+{
+	log.writeType(LogInitVolume);
+	log.write(numFrames);
+	log.write(numChannels);
+	log.write(dims);
+	log.write(physicalSize);
+	log.write(columnMajor);
+
+	return true;
+}
+
 
 
-MessageLoadTextureFrame::MessageLoadTextureFrame(GraphicObjectTypes type, int frame, unsigned char* data)
-	: textureType(type), frame(frame), imageData(data)
+MessageLoadTextureFrame::MessageLoadTextureFrame(GraphicObjectTypes type, int frame, std::vector<unsigned char>&& image)
+	: textureType(type), frame(frame), image(std::move(image))
 {}
 
+bool MessageLoadTextureFrame::getCoalesceTarget(uint64_t& targetOut) const
+{
+	targetOut = (uint64_t(textureType) << 32) | uint32_t(frame);
+	return true;
+}
+
 bool MessageLoadTextureFrame::process()
 {
 	if ( !gRenderer )
-		false;
+		return false;
 
 	const VolumeInfo* info = gRenderer->getVolumeInfo();
 	if ( !info )
@@ -45,7 +104,7 @@ bool MessageLoadTextureFrame::process()
 		return false;
 	}
 
-	HRESULT hr = loadTextureFrame(textureType, frame, imageData);
+	HRESULT hr = loadTextureFrame(textureType, frame, image.data());
 	if ( FAILED(hr) )
 	{
 		sendHrErrMessage(hr);
@@ -57,6 +116,16 @@ bool MessageLoadTextureFrame::process()
 	return true;
 }
 
+bool MessageLoadTextureFrame::writeLog(CommandLogWriter& log) const
+{
+	log.writeType(LogLoadTextureFrame);
+	log.write(textureType);
+	log.write(frame);
+	log.writePayload(image.data(), image.size());
+
+	return true;
+}
+
 
 
 MessageClearTextureFrame::MessageClearTextureFrame(GraphicObjectTypes type, int frame)
@@ -91,8 +160,8 @@ bool MessageClearAllTexture::process()
 
 
 
-MessageLoadTexture::MessageLoadTexture(GraphicObjectTypes inType, unsigned char* inData)
-	: textureType(inType), imageData(inData)
+MessageLoadTexture::MessageLoadTexture(GraphicObjectTypes inType, std::vector<unsigned char>&& image)
+	: textureType(inType), image(std::move(image))
 {}
 
 bool MessageLoadTexture::process()
@@ -107,7 +176,7 @@ bool MessageLoadTexture::process()
 		return false;
 	}
 
-	HRESULT hr = loadVolumeTexture(imageData, textureType);
+	HRESULT hr = loadVolumeTexture(image.data(), textureType);
 	if ( FAILED(hr) )
 	{
 		sendHrErrMessage(hr);
@@ -121,29 +190,102 @@ bool MessageLoadTexture::process()
 	return true;
 }
 
+bool MessageLoadTexture::writeLog(CommandLogWriter& log) const
+{
+	log.writeType(LogLoadTexture);
+	log.write(textureType);
+	log.writePayload(image.data(), image.size());
+
+	return true;
+}
+
 
 std::vector<SceneNode*> MessageLoadPolys::rootNodes;
 
-MessageLoadPolys::MessageLoadPolys(size_t numPolys)
+// Sized for every polygon, its destructor entry and the mesh bytes the sender expects, so the whole load fits in one chunk
+MessageLoadPolys::MessageLoadPolys(size_t numPolys, size_t meshBytes)
+	: arena(numPolys * (sizeof(QueuePolygon) + Arena::createOverhead + polyArrayOverhead) + meshBytes + 64)
 {
 	polygons.reserve(numPolys);
 }
 
 MessageLoadPolys::~MessageLoadPolys()
 {
-	for ( int i=0; i < polygons.size(); ++i )
-		delete polygons[i];
+	// The prepare task works on the polygons in place
+	ThreadPool::cancel(cancelToken);
+	waitForTask(prepareTask);
 
+	// The arena destroys the polygons
 	polygons.clear();
 }
 
-void MessageLoadPolys::addPoly(QueuePolygon* newPolygon)
+QueuePolygon* MessageLoadPolys::createPoly(int frame, int index, const std::string& label)
 {
+	QueuePolygon* newPolygon = arena.create<QueuePolygon>(arena, frame, index, label);
 	polygons.push_back(newPolygon);
+
+	return newPolygon;
+}
+
+bool MessageLoadPolys::prepare()
+{
+	if ( prepareTask )
+		return ThreadPool::isDone(prepareTask);
+
+	if ( !gRenderer || !gRenderer->getVolumeInfo() )
+		return true;
+
+	const VolumeInfo* info = gRenderer->getVolumeInfo();
+	ResourceCache* cache = gRenderer->getResourceCache();
+
+	ThreadPool& pool = ThreadPool::shared();
+	cancelToken = ThreadPool::makeCancelToken();
+
+	// Everything queued behind this message waits for it, so the cache and volume info won't change underneath these tasks
+	ThreadPool::TaskHandle optimizeTask = pool.submit([this, cache]()
+	{
+		std::vector<MeshOptimizer::MeshArrays> meshArrays(polygons.size());
+		for ( int i=0; i < polygons.size(); ++i )
+			meshArrays[i] = polygons[i]->getMesh();
+
+		cache->optimizeMeshes(meshArrays);
+	}, std::vector<ThreadPool::TaskHandle>(), cancelToken);
+
+	// Hashes have to see the reordered vertices
+	prepareTask = pool.submit([this, info, optimizeTask]()
+	{
+		// Passes on a failed optimize, process() rethrows it from prepareTask
+		ThreadPool::shared().wait(optimizeTask);
+
+		meshHashes.resize(polygons.size());
+		meshOffsets.resize(polygons.size());
+
+		parallelFor(polygons.size(), 16, [&](size_t begin, size_t end)
+		{
+			PROFILE_ZONE("PrepareMeshes");
+
+			for ( size_t i = begin; i < end && !ThreadPool::isCancelled(cancelToken); ++i )
+			{
+				const MeshOptimizer::MeshArrays& mesh = polygons[i]->getMesh();
+
+				// TODO: Can we build this into the local to parent without screwing up normals?
+				info->imageToModelSpace(mesh.vertices, mesh.numVerts);
+				meshHashes[i] = ResourceCache::preparePolygonMesh(mesh, meshOffsets[i]);
+			}
+		});
+	}, std::vector<ThreadPool::TaskHandle>(1, optimizeTask), cancelToken);
+
+	submitPrepareDone(std::vector<ThreadPool::TaskHandle>(1, prepareTask));
+
+	return false;
 }
 
 bool MessageLoadPolys::process()
 {
+	// Anything the preparation threw fails this load like an exception from process itself
+	if ( prepareTask )
+		ThreadPool::shared().wait(prepareTask);
+
 	if ( !gRenderer )
 		return false;
 
@@ -202,18 +344,22 @@ bool MessageLoadPolys::process()
 			rootNodes[frame] = frameNode;
 		}
 
-		double* color = poly->getcolorData();
-		Color polyColor(color[0], color[1], color[2], 1.0f);
+		// Identical shapes share a mesh and are placed by the node transform, color lives in the shared material.
+		// The queued arrays are only copied when the mesh is new.
+		Vec<float> meshOffset = meshOffsets[i];
+		std::shared_ptr<MeshPrimitive> polyMesh = gRenderer->getResourceCache()->getPreparedPolygonMesh(meshHashes[i], poly->getMesh());
 
-		// TODO: Can we build this into the local to parent without screwing up normals?
-		info->imageToModelSpace(poly->getvertData(), poly->getNumVerts());
+		PolygonMaterial::State matState;
+		matState.color = poly->getColor();
+		matState.useColor = true;
+		matState.wireframe = true;
 
-		std::shared_ptr<MeshPrimitive> polyMesh = createPolygonMesh(poly->getfaceData(), poly->getNumFaces(), poly->getvertData(), poly->getNumVerts(), poly->getnormData(), poly->getNumNormals(), polyColor);
-		std::shared_ptr<PolygonMaterial> polyMat = std::make_shared<PolygonMaterial>(gRenderer);
+		std::shared_ptr<PolygonMaterial> polyMat = gRenderer->getResourceCache()->getPolygonMaterial(matState);
 
 		GraphicObjectNode* polyNode = new GraphicObjectNode(index, GraphicObjectTypes::Polygons, polyMesh, polyMat);
+		polyNode->setMaterialShared(true);
 		polyNode->setLabel(poly->getLabel());
-		polyNode->setWireframe(true);
+		polyNode->setLocalToParent(DirectX::XMMatrixTranslation(meshOffset.x, meshOffset.y, meshOffset.z));
 
 		polyNode->attachToParentNode(frameNode);
 	}
@@ -221,6 +367,33 @@ bool MessageLoadPolys::process()
 	return true;
 }
 
+bool MessageLoadPolys::writeLog(CommandLogWriter& log) const
+{
+	log.writeType(LogLoadPolys);
+	log.write(uint64_t(polygons.size()));
+
+	// Pushed messages haven't been prepared yet, so these are still the arrays as they came from MATLAB.
+	// Each mesh is one payload, polygons that are loaded again (or are exact copies) only store an index to it.
+	std::vector<unsigned char> mesh;
+	for ( QueuePolygon* poly : polygons )
+	{
+		log.write(poly->getFrame());
+		log.write(poly->getIndex());
+		log.writeString(poly->getLabel());
+		log.write(poly->getColor());
+
+		mesh.clear();
+		const MeshOptimizer::MeshArrays& arrays = poly->getMesh();
+		appendMeshArray(mesh, arrays.faces, arrays.numFaces);
+		appendMeshArray(mesh, arrays.vertices, arrays.numVerts);
+		appendMeshArray(mesh, arrays.normals, poly->getNumNormals());
+
+		log.writePayload(mesh.data(), mesh.size());
+	}
+
+	return true;
+}
+
 
 
 bool MessageDeletePoly::process()
@@ -4,6 +4,12 @@
 
 #include "QueuePolygon.h"
 
+#include "Global/Arena.h"
+#include "Global/ThreadPool.h"
+
+#include <memory>
+#include <vector>
+
 // Control messages
 class MessageClose: public Message
 {
@@ -23,6 +29,7 @@ public:
 
 protected:
 	virtual bool process();
+	virtual bool writeLog(CommandLogWriter& log) const;
 
 private:
 	bool columnMajor;
@@ -35,19 +42,23 @@ private:
 };
 
 
+// Texture loads own their image, so the sender doesn't wait for the upload.
+// A newer load of the same type and frame replaces one that is still queued (see MessageQueue).
 class MessageLoadTextureFrame: public Message
 {
 public:
-	MessageLoadTextureFrame(GraphicObjectTypes type, int frame, unsigned char* data);
+	MessageLoadTextureFrame(GraphicObjectTypes type, int frame, std::vector<unsigned char>&& image);
 
 protected:
 	virtual bool process();
+	virtual bool getCoalesceTarget(uint64_t& targetOut) const;
+	virtual bool writeLog(CommandLogWriter& log) const;
 
 private:
 	GraphicObjectTypes textureType;
 	int frame;
 
-	unsigned char* imageData;
+	std::vector<unsigned char> image;
 };
 
 class MessageClearTextureFrame: public Message
@@ -57,6 +68,7 @@ public:
 
 protected:
     virtual bool process();
+	virtual bool writeLog(CommandLogWriter& log) const {log.writeType(LogClearTextureFrame); log.write(textureType); log.write(frame); return true;}
 
 private:
     GraphicObjectTypes textureType;
@@ -67,15 +79,17 @@ private:
 class MessageLoadTexture: public Message
 {
 public:
-	MessageLoadTexture(GraphicObjectTypes inType, unsigned char* inData);
+	MessageLoadTexture(GraphicObjectTypes inType, std::vector<unsigned char>&& image);
 
 protected:
 	virtual bool process();
+	virtual bool getCoalesceTarget(uint64_t& targetOut) const {targetOut = uint64_t(textureType); return true;}
+	virtual bool writeLog(CommandLogWriter& log) const;
 
 private:
 	GraphicObjectTypes textureType;
 
-	unsigned char* imageData;
+	std::vector<unsigned char> image;
 };
 
 class MessageClearAllTexture: public Message
@@ -85,6 +99,7 @@ public:
 
 protected:
     virtual bool process();
+	virtual bool writeLog(CommandLogWriter& log) const {log.writeType(LogClearAllTexture); log.write(textureType); return true;}
 
 private:
     GraphicObjectTypes textureType;
@@ -95,17 +110,40 @@ private:
 class MessageLoadPolys : public Message
 {
 public:
-	MessageLoadPolys(size_t numPolys);
+	// meshBytes is what the polygons' arrays and labels are expected to take (see meshBytes()), only used to size the arena
+	MessageLoadPolys(size_t numPolys, size_t meshBytes = 0);
 	virtual ~MessageLoadPolys();
 
-	void addPoly(QueuePolygon* newPolygon);
+	// Arena bytes for one polygon's arrays and label, not counting alignment
+	static size_t meshBytes(size_t numFaces, size_t numVerts, bool hasNormals, size_t labelLength)
+	{
+		return numFaces*sizeof(Vec<uint32_t>) + numVerts*sizeof(Vec<float>)*((hasNormals) ? 2 : 1) + labelLength + 1;
+	}
+
+	// The polygon and its arrays live in the message's arena and are released with it
+	QueuePolygon* createPoly(int frame, int index, const std::string& label);
 
 protected:
+	// Reorders, transforms and hashes the meshes on the thread pool, process() only does the cache lookups and scene nodes
+	virtual bool prepare();
 	virtual bool process();
+	virtual bool writeLog(CommandLogWriter& log) const;
 
 private:
+	// Alignment padding for a polygon's label and arrays
+	static const size_t polyArrayOverhead = 4 * alignof(Vec<float>);
+
+	// All the queued polygons and their arrays come out of this, so a load is a handful of allocations instead of several per polygon
+	Arena arena;
 	std::vector<QueuePolygon*> polygons;
 
+	ThreadPool::CancelToken cancelToken;
+	ThreadPool::TaskHandle prepareTask;
+
+	// Per polygon, filled in by the prepare task
+	std::vector<uint64_t> meshHashes;
+	std::vector<Vec<float>> meshOffsets;
+
 	// TODO: Get rid of this!
 	static std::vector<SceneNode*> rootNodes;
 };
@@ -118,6 +156,7 @@ public:
 
 protected:
 	virtual bool process();
+	virtual bool writeLog(CommandLogWriter& log) const {log.writeType(LogDeletePoly); log.write(index); return true;}
 
 private:
 	int index;
@@ -131,4 +170,5 @@ public:
 
 protected:
 	virtual bool process();
+	virtual bool writeLog(CommandLogWriter& log) const {log.writeType(LogDeleteAllPolys); return true;}
 };
@@ -1,12 +1,33 @@
 #pragma once
 
+#include "CommandLog.h"
+
 #include "Global/Vec.h"
-#include "D3d/Renderer.h"
+
+#include <chrono>
+#include <cstdint>
+#include <future>
+#include <memory>
+#include <string>
+
+// How a message went, handed back to a caller waiting on it
+struct MessageStatus
+{
+	MessageStatus() : processed(false), success(false) {}
+
+	// False if the queue was cleared or closed before the message ran
+	bool processed;
+	bool success;
+
+	// Errors reported on the render thread while the message was processing
+	std::string error;
+};
 
 class Message
 {
 public:
 	friend class MessageQueue;
+	friend class CommandLogWriter;
 
 	virtual ~Message(){};
 
@@ -14,4 +35,25 @@ protected:
 	Message(){}
 
 	virtual bool process() = 0;
+
+	// Messages that only overwrite one piece of state return true with the target they write (channel, object type, ...).
+	// A queued message is dropped when a later one of the same class and target arrives, see MessageQueue.
+	virtual bool getCoalesceTarget(uint64_t&) const {return false;}
+
+	// Messages with heavy CPU work start it on the thread pool here and return false until it is done, process() then
+	// only commits the results. Called on the render thread once every earlier message has been processed, and again on
+	// each loop turn until it returns true. Later messages wait behind it while the scene keeps rendering.
+	// The pool work should end by calling MessageQueue::notifyPrepared so a sleeping render thread looks again.
+	virtual bool prepare() {return true;}
+
+	// Writes the type (CommandLogWriter::writeType) and fields for a command log, CommandLogReader creates the message
+	// back from them. Messages that can't be replayed (outputs to a caller, captures to disk) leave this false.
+	virtual bool writeLog(CommandLogWriter&) const {return false;}
+
+private:
+	// Only set when a caller is waiting on this message, signaled by the queue once it is done with it
+	std::unique_ptr<std::promise<MessageStatus>> completion;
+
+	// Stamped when the message is pushed, for the queue's latency histograms
+	std::chrono::steady_clock::time_point queuedTime;
 };
@@ -5,24 +5,28 @@
 // Called from mex messages and from window proc
 void setObjectTypeVisibility(GraphicObjectTypes type, bool visible)
 {
-	for ( auto& itr : gRenderer->allSceneObjects(type) )
-		itr.second->setRenderable(visible);
+	gRenderer->allSceneObjects(type).setRenderable(visible);
 }
 
 void setObjectTypeColor(GraphicObjectTypes type, Vec<float> color, float alpha)
 {
-	for ( auto& itr : gRenderer->allSceneObjects(type) )
-		itr.second->setColor(color, alpha);
+	NodeRegistry::BulkState state;
+	state.colors.push_back(color);
+	state.alphas.push_back(alpha);
+
+	gRenderer->allSceneObjects(type).applyState(state);
 }
 
 void setObjectWireframe(GraphicObjectTypes type, bool wireframe)
 {
-	for ( auto& itr : gRenderer->allSceneObjects(type) )
-		itr.second->setWireframe(wireframe);
+	NodeRegistry::BulkState state;
+	state.wireframe = (wireframe) ? 1 : 0;
+
+	gRenderer->allSceneObjects(type).applyState(state);
 }
 
 void setObjectLighting(GraphicObjectTypes type, bool lightingOn)
 {
-	for ( auto& itr : gRenderer->allSceneObjects(type) )
-		itr.second->setLightOn(lightingOn);
+	for ( GraphicObjectNode* node : gRenderer->allSceneObjects(type) )
+		node->setLightOn(lightingOn);
 }
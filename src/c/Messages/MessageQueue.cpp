@@ -1,108 +1,363 @@
 #include "MessageQueue.h"
 #include "Global/ErrorMsg.h"
+#include "Global/Profiler.h"
 
-#include "comdef.h"
-
+#include <chrono>
+#include <exception>
 #include <string>
-#include <iostream>
 #include <thread>
+#include <typeinfo>
 
 
 MessageQueue::MessageQueue(bool waitAllowed)
-	: failed(false), waitAllowed(waitAllowed), queueOpen(false)
-{
-	mutex = CreateMutex(NULL, FALSE, NULL);
-}
+	: queueOpen(false), waitAllowed(waitAllowed), messages(capacity), backlogStart(0), backlogCount(0),
+	numProcessed(0), numCoalesced(0), consumerSleeping(false), recording(false)
+{}
 
 MessageQueue::~MessageQueue()
 {
-	if (mutex != NULL)
-		CloseHandle(mutex);
-
-	mutex = NULL;
+	clear();
 }
 
 void MessageQueue::open()
 {
 	queueOpen = true;
-    failed = false;
 }
 
 void MessageQueue::close()
 {
 	queueOpen = false;
+
+	// Anyone still waiting is released when their message is cleared
 	clear();
 }
 
-bool MessageQueue::pushMessage(Message* newMessage, bool forceWait)
+bool MessageQueue::pushMessage(Message* newMessage)
 {
-	DWORD waitTerm = WaitForSingleObject(mutex, INFINITE);
+	// Has to be set before the push, the render thread may be done with the message as soon as it is on the ring
+	newMessage->queuedTime = std::chrono::steady_clock::now();
+
+	if ( recording )
+	{
+		std::shared_ptr<CommandLogWriter> log;
+		{
+			std::lock_guard<std::mutex> lock(recorderMutex);
+			log = recorder;
+		}
 
-    failed = false;
-	messages.push(newMessage);
+		// Before the push, the message may be processed and deleted as soon as it is on the ring
+		if ( log )
+			log->record(newMessage, newMessage->completion != NULL);
+	}
 
-	ReleaseMutex(mutex);
+	while ( !messages.tryPush(newMessage) )
+	{
+		// Nothing will drain a full ring once the render thread has stopped
+		if ( !queueOpen )
+		{
+			delete newMessage;
+			return false;
+		}
+
+		std::this_thread::yield();
+	}
 
 	if ( !queueOpen )
 		return false;
 
-	if ( waitAllowed && forceWait )
+	wakeConsumer();
+
+	// A close after this point clears (and completes) the message
+	return true;
+}
+
+MessageStatus MessageQueue::pushMessageAndWait(Message* newMessage)
+{
+	if ( !waitAllowed )
 	{
-		while ( !failed && !messages.empty() )
-			std::this_thread::sleep_for(std::chrono::milliseconds(100));
+		pushMessage(newMessage);
+		return MessageStatus();
 	}
 
-	return true;
+	newMessage->completion.reset(new std::promise<MessageStatus>());
+	std::future<MessageStatus> result = newMessage->completion->get_future();
+
+	if ( !pushMessage(newMessage) )
+		return MessageStatus();
+
+	return result.get();
+}
+
+bool MessageQueue::processPending(double budgetSeconds)
+{
+	return processMessages(messages.capacity(), budgetSeconds);
 }
 
 bool MessageQueue::processNext()
 {
-	Message* nextMessage = NULL;
-	if ( !messages.empty() )
+	return processMessages(1, 0.0);
+}
+
+size_t MessageQueue::getNumMessages()
+{
+	return messages.sizeApprox() + backlogCount;
+}
+
+MessageQueue::Stats MessageQueue::getStats()
+{
+	Stats stats;
+	stats.processed = numProcessed;
+	stats.coalesced = numCoalesced;
+
+	return stats;
+}
+
+void MessageQueue::getTimes(std::vector<TypeTimes>& timesOut, bool reset)
+{
+	std::lock_guard<std::mutex> lock(timesMutex);
+
+	for ( auto& it : typeTimes )
+		timesOut.push_back(it.second);
+
+	if ( reset )
+		typeTimes.clear();
+}
+
+void MessageQueue::setWakeCallback(std::function<void()> wake)
+{
+	std::lock_guard<std::mutex> lock(wakeMutex);
+	wakeCallback = wake;
+}
+
+bool MessageQueue::prepareToSleep()
+{
+	consumerSleeping = true;
+
+	// A push that landed before the flag was set won't wake us, so look again.
+	// Pairs with the fence in wakeConsumer so one side always sees the other.
+	std::atomic_thread_fence(std::memory_order_seq_cst);
+	if ( messages.sizeApprox() > 0 || backlogReady() )
+	{
+		consumerSleeping = false;
+		return false;
+	}
+
+	return true;
+}
+
+void MessageQueue::notifyPrepared()
+{
+	wakeConsumer();
+}
+
+void MessageQueue::setRecorder(std::shared_ptr<CommandLogWriter> newRecorder)
+{
+	std::lock_guard<std::mutex> lock(recorderMutex);
+
+	recorder = newRecorder;
+	recording = (recorder != NULL);
+}
+
+std::shared_ptr<CommandLogWriter> MessageQueue::getRecorder()
+{
+	std::lock_guard<std::mutex> lock(recorderMutex);
+	return recorder;
+}
+
+void MessageQueue::clear()
+{
+	std::lock_guard<std::mutex> lock(consumerMutex);
+
+	drainRing();
+
+	for ( Message* nextMessage : backlog )
 	{
-		// NOTE: Front isn't threadsafe unfortunately, this is the only
-		// thread that pops though so only single conditional required
-		DWORD waitTerm = WaitForSingleObject(mutex, INFINITE);
-		nextMessage = messages.front();
-		ReleaseMutex(mutex);
+		if ( !nextMessage )
+			continue;
+
+		completeMessage(nextMessage, MessageStatus());
+		delete nextMessage;
 	}
 
-	// Process message before it's removed from the queue
+	backlogStart += backlog.size();
+	backlog.clear();
+	backlogCount = 0;
+	latestWrites.clear();
+}
+
+bool MessageQueue::processMessages(size_t maxMessages, double budgetSeconds)
+{
+	std::lock_guard<std::mutex> lock(consumerMutex);
+
+	std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+	std::chrono::duration<double> budget(budgetSeconds);
+
+	drainRing();
+
 	bool success = true;
-	if ( nextMessage )
-		success = nextMessage->process();
+	size_t numMessages = 0;
+	while ( numMessages < maxMessages && !backlog.empty() )
+	{
+		Message* nextMessage = backlog.front();
+
+		// Still preparing, everything behind it keeps its place in line
+		if ( nextMessage && !nextMessage->prepare() )
+			break;
+
+		backlog.pop_front();
+		++backlogStart;
+
+		// Superseded by a later write
+		if ( !nextMessage )
+			continue;
+
+		--backlogCount;
+		++numMessages;
+
+		MessageStatus status;
+		status.processed = true;
+
+		// A waiting caller gets this message's errors directly
+		if ( nextMessage->completion )
+			captureErrMessages(&status.error);
+
+		std::chrono::steady_clock::time_point started = std::chrono::steady_clock::now();
+
+		// A message that throws fails on its own, the rest of the queue is still processed
+		try
+		{
+			// Named after the message class
+			ProfileZone zone(typeid(*nextMessage).name());
+			success = nextMessage->process();
+		}
+		catch(const std::exception& e)
+		{
+			sendErrMessage(e.what());
+			success = false;
+		}
+		catch(const std::string& e)
+		{
+			sendErrMessage(e);
+			success = false;
+		}
+		catch(...)
+		{
+			sendErrMessage("Caught an unknown error!");
+			success = false;
+		}
 
-	// Acquire mutex to pop message, pop needs to happen last so that blocking push code works
-	DWORD waitTerm = WaitForSingleObject(mutex, INFINITE);
-	messages.pop();
-	ReleaseMutex(mutex);
+		status.success = success;
+		captureErrMessages(NULL);
 
-	SAFE_DELETE(nextMessage);
+		recordTimes(nextMessage, started, std::chrono::steady_clock::now());
 
-	// TODO: Have a better way of failing
-	if ( !success )
-		failed = true;
+		completeMessage(nextMessage, status);
+		SAFE_DELETE(nextMessage);
+
+		++numProcessed;
+
+		// TODO: Have a better way of failing
+		if ( !success )
+			break;
+
+		if ( std::chrono::steady_clock::now() - start >= budget )
+			break;
+	}
+
+	if ( backlog.empty() )
+		latestWrites.clear();
 
 	return success;
 }
 
-size_t MessageQueue::getNumMessages()
+bool MessageQueue::backlogReady()
 {
-	return messages.size();
+	std::lock_guard<std::mutex> lock(consumerMutex);
+
+	if ( backlog.empty() )
+		return false;
+
+	// A message that is still preparing gets its notifyPrepared wake, superseded slots just need popping
+	Message* nextMessage = backlog.front();
+	return !nextMessage || nextMessage->prepare();
 }
 
-void MessageQueue::clear()
+void MessageQueue::drainRing()
 {
-	DWORD waitTerm = WaitForSingleObject(mutex, INFINITE);
+	Message* nextMessage;
+	while ( messages.tryPop(nextMessage) )
+	{
+		uint64_t target;
+		if ( nextMessage->completion || !nextMessage->getCoalesceTarget(target) )
+		{
+			// This may read state an earlier write set, so no write coalesces across it
+			latestWrites.clear();
+		}
+		else
+		{
+			uint64_t position = backlogStart + backlog.size();
+
+			std::pair<std::unordered_map<CoalesceKey, uint64_t, CoalesceKeyHash>::iterator, bool> inserted =
+				latestWrites.insert(std::make_pair(CoalesceKey(typeid(*nextMessage), target), position));
+
+			if ( !inserted.second )
+			{
+				uint64_t previous = inserted.first->second;
+				inserted.first->second = position;
+
+				// Still queued, the later write makes it redundant
+				if ( previous >= backlogStart )
+				{
+					SAFE_DELETE(backlog[previous - backlogStart]);
+					--backlogCount;
+					++numCoalesced;
+				}
+			}
+		}
 
-	while ( !messages.empty() )
+		backlog.push_back(nextMessage);
+		++backlogCount;
+	}
+}
+
+void MessageQueue::completeMessage(Message* message, const MessageStatus& status)
+{
+	if ( message->completion )
+		message->completion->set_value(status);
+}
+
+void MessageQueue::recordTimes(const Message* message, std::chrono::steady_clock::time_point started, std::chrono::steady_clock::time_point finished)
+{
+	std::type_index type(typeid(*message));
+
+	std::lock_guard<std::mutex> lock(timesMutex);
+
+	std::unordered_map<std::type_index, TypeTimes>::iterator it = typeTimes.find(type);
+	if ( it == typeTimes.end() )
 	{
-		Message* nextMessage = messages.front();
-		messages.pop();
+		it = typeTimes.emplace(type, TypeTimes()).first;
 
-		delete nextMessage;
+		// MSVC names are "class MessageSetFrame", report just "SetFrame"
+		std::string& name = it->second.type;
+		name = type.name();
+		if ( name.compare(0, 6, "class ") == 0 )
+			name.erase(0, 6);
+		if ( name.compare(0, 7, "Message") == 0 )
+			name.erase(0, 7);
 	}
 
-	ReleaseMutex(mutex);
+	TypeTimes& times = it->second;
+	times.queued.record(uint64_t(std::chrono::duration_cast<std::chrono::nanoseconds>(started - message->queuedTime).count()));
+	times.processing.record(uint64_t(std::chrono::duration_cast<std::chrono::nanoseconds>(finished - started).count()));
 }
 
+void MessageQueue::wakeConsumer()
+{
+	std::atomic_thread_fence(std::memory_order_seq_cst);
+	if ( !consumerSleeping.load(std::memory_order_relaxed) || !consumerSleeping.exchange(false) )
+		return;
+
+	std::lock_guard<std::mutex> lock(wakeMutex);
+	if ( wakeCallback )
+		wakeCallback();
+}
@@ -2,31 +2,135 @@
 
 #include "Message.h"
 
-#include <windows.h>
-#include <queue>
+#include "Global/MpscRing.h"
+#include "Global/LatencyHistogram.h"
 
+#include <atomic>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <typeindex>
+#include <unordered_map>
+#include <vector>
+
+// Messages from any thread to the render thread.
+// Pushing is lock-free on a bounded ring, the render thread drains everything pending each loop turn.
+// While draining, a state write (see Message::getCoalesceTarget) replaces an earlier queued write of the same class
+// and target, as long as only other state writes were queued between them. Anything else may read that state,
+// so nothing is coalesced across it, and messages a caller is waiting on are never dropped.
+// A message still preparing on the thread pool (see Message::prepare) holds back the ones behind it, order is kept.
 class MessageQueue
 {
 public:
+	// Pushes wait for a free slot once this many messages are pending
+	static const size_t capacity = 16384;
+
+	struct Stats
+	{
+		uint64_t processed;
+		uint64_t coalesced;
+	};
+
+	// Timings of every processed message of one class
+	struct TypeTimes
+	{
+		std::string type;
+
+		// From the push until processing starts, including any wait on the message's own preparation
+		LatencyHistogram queued;
+		// Time in process()
+		LatencyHistogram processing;
+	};
+
 	MessageQueue(bool waitAllowed);
 	~MessageQueue();
 
 	void open();
 	void close();
 
-	bool pushMessage(Message* message, bool forceWait = false);
+	// Returns false if the queue is closed, the message is then deleted with the rest of the queue
+	bool pushMessage(Message* message);
+
+	// Returns once this message has been processed, cleared or the queue closes.
+	// Errors reported while it processes are returned here instead of going to the MEX return queue.
+	MessageStatus pushMessageAndWait(Message* message);
+
+	// Processes pending messages in order until the queue is empty, a message fails or budgetSeconds have passed.
+	// Returns false if a message failed. A message that throws fails with the exception as its error.
+	bool processPending(double budgetSeconds);
 	bool processNext();
 
-	size_t MessageQueue::getNumMessages();
+	size_t getNumMessages();
+	Stats getStats();
+
+	// Appends the timings of each message class seen since the last reset, reset clears them after copying
+	void getTimes(std::vector<TypeTimes>& timesOut, bool reset);
+
+	// Called by the first push after the consumer has gone to sleep (see prepareToSleep)
+	void setWakeCallback(std::function<void()> wake);
+
+	// The consumer calls this right before it blocks in its own wait.
+	// Returns false if messages are ready to process, otherwise the next push (or notifyPrepared) calls the wake callback.
+	bool prepareToSleep();
+
+	// Called from the thread pool when a message's preparation (see Message::prepare) has finished
+	void notifyPrepared();
+
+	// Every message pushed while a recorder is set is written to its command log first, NULL stops recording
+	void setRecorder(std::shared_ptr<CommandLogWriter> recorder);
+	std::shared_ptr<CommandLogWriter> getRecorder();
 
 	void clear();
 
 private:
-	HANDLE mutex;
+	bool processMessages(size_t maxMessages, double budgetSeconds);
+	bool backlogReady();
+	void drainRing();
+	static void completeMessage(Message* message, const MessageStatus& status);
+	void recordTimes(const Message* message, std::chrono::steady_clock::time_point started, std::chrono::steady_clock::time_point finished);
+	void wakeConsumer();
+
+	std::atomic<bool> queueOpen;
+	bool waitAllowed;
+
+	MpscRing<Message*> messages;
+
+	// Only one thread may pop, clear() can be called from the MEX thread
+	std::mutex consumerMutex;
+
+	typedef std::pair<std::type_index, uint64_t> CoalesceKey;
+
+	struct CoalesceKeyHash
+	{
+		size_t operator()(const CoalesceKey& key) const {return key.first.hash_code() ^ size_t(key.second * 0x9E3779B97F4A7C15ull);}
+	};
+
+	// Messages taken off the ring but not processed yet, superseded writes are left as NULL.
+	// Guarded by consumerMutex, positions are counted from the first message ever drained.
+	std::deque<Message*> backlog;
+	uint64_t backlogStart;
+	std::atomic<size_t> backlogCount;
+
+	// Position of the newest queued write for each key since the last message that wasn't a plain write
+	std::unordered_map<CoalesceKey, uint64_t, CoalesceKeyHash> latestWrites;
+
+	std::atomic<uint64_t> numProcessed;
+	std::atomic<uint64_t> numCoalesced;
+
+	// Only contended while the MEX thread copies the timings out
+	std::mutex timesMutex;
+	std::unordered_map<std::type_index, TypeTimes> typeTimes;
 
-	volatile bool queueOpen;
-	volatile bool waitAllowed;
-	volatile bool failed;
+	// Pushes only pay for the wake callback when the consumer is actually asleep
+	std::atomic<bool> consumerSleeping;
+	std::mutex wakeMutex;
+	std::function<void()> wakeCallback;
 
-	std::queue<Message*> messages;
-};
\ No newline at end of file
+	// Pushes only look at the recorder (and take its lock) while recording
+	std::atomic<bool> recording;
+	std::mutex recorderMutex;
+	std::shared_ptr<CommandLogWriter> recorder;
+};
@@ -4,6 +4,30 @@
 
 #include <comdef.h>
 
+namespace
+{
+	thread_local std::string* capturedErrors = NULL;
+
+	void sendMessage(const std::string& msg)
+	{
+		if ( !capturedErrors )
+		{
+			gMsgQueueToMex.addErrorMessage(msg);
+			return;
+		}
+
+		if ( !capturedErrors->empty() )
+			*capturedErrors += "\n";
+
+		*capturedErrors += msg;
+	}
+}
+
+void captureErrMessages(std::string* errorsOut)
+{
+	capturedErrors = errorsOut;
+}
+
 void errMessage(std::string message, const char *file, int line)
 {
 	char ln[5];
@@ -14,7 +38,7 @@ void errMessage(std::string message, const char *file, int line)
 	msg += " line ";
 	msg += ln;
 
-	gMsgQueueToMex.addErrorMessage(msg);
+	sendMessage(msg);
 }
 
 void hrErrMessage(HRESULT hr, const char *file, int line)
@@ -35,5 +59,5 @@ void hrErrMessage(HRESULT hr, const char *file, int line)
 	msg += " line ";
 	msg += buff;
 
-	gMsgQueueToMex.addErrorMessage(msg);
+	sendMessage(msg);
 }
@@ -1,87 +1,83 @@
 #include "QueuePolygon.h"
-#include "Global/Globals.h"
-#include "D3d/MessageProcessor.h"
-#include "D3d/VolumeInfo.h"
 
-QueuePolygon::QueuePolygon(size_t numFaces, size_t numVerts, size_t numNormals, int frame, int index, std::string label)
-{
-	setDefaults();
-
-	this->numFaces = numFaces;
-	this->numVerts = numVerts;
-	this->numNormals = numNormals;
-	this->frame = frame;
-	this->index = index;
-	this->label = label;
+#include "D3d/MeshPrep.h"
 
-	faceData = new double[numFaces * 3];
-	vertData = new double[numVerts * 3];
-	normData = new double[numVerts * 3];
-	colorData = new double[3];
-}
+#include <cstring>
 
-void QueuePolygon::setfaceData(double* faceData)
+QueuePolygon::QueuePolygon(Arena& arena, int frame, int index, const std::string& label)
+	: arena(arena), color(1.0f, 1.0f, 1.0f), frame(frame), index(index)
 {
-	memcpy(this->faceData, faceData, numFaces * 3 * sizeof(double));
-}
+	mesh.faces = NULL;
+	mesh.numFaces = 0;
+	mesh.vertices = NULL;
+	mesh.normals = NULL;
+	mesh.numVerts = 0;
 
-void QueuePolygon::setvertData(double* vertData)
-{
-	memcpy(this->vertData, vertData, numVerts * 3 * sizeof(double));
+	this->label = arena.allocArray<char>(label.size() + 1);
+	memcpy(this->label, label.c_str(), label.size() + 1);
 }
 
-void QueuePolygon::setnormData(double* normData)
+void QueuePolygon::setMatlabData(const double* faceData, size_t numFaces, const double* vertData, size_t numVerts, const double* normData)
 {
-	memcpy(this->normData, normData, numVerts * 3 * sizeof(double));
-}
+	mesh.faces = arena.allocArray<Vec<uint32_t>>(numFaces);
+	mesh.numFaces = numFaces;
+	for ( size_t i = 0; i < numFaces; ++i )
+	{
+		mesh.faces[i].x = uint32_t(faceData[i]) - 1;
+		mesh.faces[i].y = uint32_t(faceData[i + numFaces]) - 1;
+		mesh.faces[i].z = uint32_t(faceData[i + 2*numFaces]) - 1;
+	}
 
-void QueuePolygon::setcolorData(double* colorData)
-{
-	// Possibly going out of memory space here
-	memcpy(this->colorData, colorData, 3 * sizeof(double));
-}
+	mesh.vertices = arena.allocArray<Vec<float>>(numVerts);
+	mesh.numVerts = numVerts;
+	for ( size_t i = 0; i < numVerts; ++i )
+	{
+		mesh.vertices[i].x = float(vertData[i]);
+		mesh.vertices[i].y = float(vertData[i + numVerts]);
+		mesh.vertices[i].z = float(vertData[i + 2*numVerts]);
+	}
 
-double* QueuePolygon::getfaceData()
-{
-	return faceData;
-}
+	mesh.normals = NULL;
+	if ( !normData )
+		return;
 
-double* QueuePolygon::getvertData()
-{
-	return vertData;
+	mesh.normals = arena.allocArray<Vec<float>>(numVerts);
+	for ( size_t i = 0; i < numVerts; ++i )
+	{
+		mesh.normals[i].x = float(normData[i]);
+		mesh.normals[i].y = float(normData[i + numVerts]);
+		mesh.normals[i].z = float(normData[i + 2*numVerts]);
+	}
 }
 
-double* QueuePolygon::getnormData()
+void QueuePolygon::setMeshData(const std::vector<Vec<uint32_t>>& facesIn, const std::vector<Vec<float>>& vertsIn, const std::vector<Vec<float>>& normsIn)
 {
-	return normData;
-}
+	mesh.numFaces = facesIn.size();
+	mesh.faces = arena.allocArray<Vec<uint32_t>>(mesh.numFaces);
+	memcpy(mesh.faces, facesIn.data(), mesh.numFaces * sizeof(Vec<uint32_t>));
 
-double* QueuePolygon::getcolorData()
-{
-	return colorData;
+	mesh.numVerts = vertsIn.size();
+	mesh.vertices = arena.allocArray<Vec<float>>(mesh.numVerts);
+	memcpy(mesh.vertices, vertsIn.data(), mesh.numVerts * sizeof(Vec<float>));
+
+	mesh.normals = NULL;
+	if ( normsIn.size() != mesh.numVerts )
+		return;
+
+	mesh.normals = arena.allocArray<Vec<float>>(mesh.numVerts);
+	memcpy(mesh.normals, normsIn.data(), mesh.numVerts * sizeof(Vec<float>));
 }
 
-QueuePolygon::~QueuePolygon()
+void QueuePolygon::setcolorData(const double* colorData)
 {
-	SAFE_DELETE(faceData);
-	SAFE_DELETE(vertData);
-	SAFE_DELETE(normData);
-	SAFE_DELETE(colorData);
-
-	setDefaults();
+	color = Vec<float>(float(colorData[0]), float(colorData[1]), float(colorData[2]));
 }
 
-void QueuePolygon::setDefaults()
+void QueuePolygon::weldAndComputeNormals(float weldDistance)
 {
-	double* faceData = NULL;
-	double* vertData = NULL;
-	double* normData = NULL;
-	double* colorData = NULL;
+	MeshPrep::weldVertices(mesh.faces, mesh.numFaces, mesh.vertices, mesh.numVerts, weldDistance);
 
-	size_t numFaces = 0;
-	size_t numVerts = 0;
-	size_t numNormals = 0;
-	int frame = -1;
-	int index = -1;
-	char* label = NULL;
+	// Welding only shrinks the arrays, the normals get their own
+	mesh.normals = arena.allocArray<Vec<float>>(mesh.numVerts);
+	MeshPrep::computeNormals(mesh.faces, mesh.numFaces, mesh.vertices, mesh.numVerts, mesh.normals);
 }
@@ -1,42 +1,49 @@
 #pragma once
+#include "Global/Arena.h"
+#include "Global/Vec.h"
 
+#include "D3d/MeshOptimizer.h"
+
+#include <cstdint>
 #include <string>
+#include <vector>
 
+// A polygon on its way from MATLAB to the render thread.
+// The arrays and label are allocated from the arena of the message carrying the polygon, so a load doesn't take
+// heap allocations per polygon. The MATLAB arrays are read once into the mesh formats here, the pool transforms the
+// vertices in place and the render thread copies the arrays into a new mesh if no cached one matches.
 class QueuePolygon
 {
 public:
-	QueuePolygon(size_t numFaces, size_t numVerts, size_t numNormals, int frame, int index, std::string label);
-	~QueuePolygon();
-
-	void QueuePolygon::setfaceData(double* faceData);
-	void QueuePolygon::setvertData(double* vertData);
-	void QueuePolygon::setnormData(double* normData);
-	void QueuePolygon::setcolorData(double* colorData);
-
-	size_t getNumFaces() { return numFaces; }
-	size_t getNumVerts() { return numVerts; }
-	size_t getNumNormals() { return numNormals; }
-	int getFrame() { return frame; }
-	int getIndex() { return index; }
-	std::string getLabel() { return label; }
-
-	double* QueuePolygon::getfaceData();
-	double* QueuePolygon::getvertData();
-	double* QueuePolygon::getnormData();
-	double* QueuePolygon::getcolorData();
+	QueuePolygon(Arena& arena, int frame, int index, const std::string& label);
+
+	// Column-major MATLAB arrays, faces are 1-based. normData can be NULL to leave the normals empty.
+	void setMatlabData(const double* faceData, size_t numFaces, const double* vertData, size_t numVerts, const double* normData);
+	// Copies the arrays into the arena, norms can be empty
+	void setMeshData(const std::vector<Vec<uint32_t>>& facesIn, const std::vector<Vec<float>>& vertsIn, const std::vector<Vec<float>>& normsIn);
+	void setcolorData(const double* colorData);
+
+	// Welds the vertices (see MeshPrep::weldVertices) and replaces the normals with computed ones
+	void weldAndComputeNormals(float weldDistance);
+
+	size_t getNumFaces() const { return mesh.numFaces; }
+	size_t getNumVerts() const { return mesh.numVerts; }
+	size_t getNumNormals() const { return (mesh.normals) ? mesh.numVerts : 0; }
+	int getFrame() const { return frame; }
+	int getIndex() const { return index; }
+	const char* getLabel() const { return label; }
+	Vec<float> getColor() const { return color; }
+
+	// The arrays can be changed in place, their sizes stay fixed
+	const MeshOptimizer::MeshArrays& getMesh() const { return mesh; }
 
 private:
-	void setDefaults();
+	Arena& arena;
 
-	double* faceData;
-	double* vertData;
-	double* normData;
-	double* colorData;
+	MeshOptimizer::MeshArrays mesh;
+	Vec<float> color;
 
-	size_t numFaces;
-	size_t numVerts;
-	size_t numNormals;
 	int frame;
 	int index;
-	std::string label;
-};
\ No newline at end of file
+	char* label;
+};
@@ -2,6 +2,8 @@
 
 #include "Message.h"
 
+#include "D3d/Renderer.h"
+
 // This message forces a render update
 class MessageUpdateRender: public Message
 {
@@ -10,4 +12,5 @@ public:
 
 protected:
 	virtual bool process();
+	virtual bool writeLog(CommandLogWriter& log) const {log.writeType(LogUpdateRender); return true;}
 };
\ No newline at end of file
@@ -177,7 +177,7 @@ bool MessageMoveCamera::process()
 
 void MessageShowPolys::setPoly(int index)
 {
-	indices.insert(index);
+	indices.push_back(index);
 }
 
 bool MessageShowPolys::process()
@@ -192,17 +192,78 @@ bool MessageShowPolys::process()
 	}
 	else
 	{
-		for ( auto it : indices )
-		{
-			GraphicObjectNode* node = gRenderer->findSceneObject(GraphicObjectTypes::Polygons, it);
-			if ( node )
-				node->setRenderable(visible);
-		}
+		NodeRegistry& polygons = gRenderer->allSceneObjects(GraphicObjectTypes::Polygons);
+
+		std::vector<uint64_t> mask;
+		polygons.makeMask(indices, mask);
+		polygons.setRenderable(mask, visible);
 	}
 
 	return true;
 }
 
+bool MessageShowPolys::writeLog(CommandLogWriter& log) const
+{
+	log.writeType(LogShowPolys);
+	log.write(visible);
+	log.writeVector(indices);
+
+	return true;
+}
+
+
+
+bool MessageSetPolygonState::process()
+{
+	if ( !gRenderer )
+		return false;
+
+	gRenderer->allSceneObjects(GraphicObjectTypes::Polygons).applyState(state);
+
+	return true;
+}
+
+bool MessageSetPolygonState::writeLog(CommandLogWriter& log) const
+{
+	log.writeType(LogSetPolygonState);
+	log.writeVector(state.indices);
+	log.writeVector(state.visible);
+	log.writeVector(state.colors);
+	log.writeVector(state.alphas);
+	log.write(state.clearColors);
+	log.write(state.wireframe);
+
+	return true;
+}
+
+
+
+bool MessageSelectRegion::process()
+{
+	if ( !gRenderer )
+		return false;
+
+	std::vector<int> selected = gRenderer->getPolygonsInRegion(region, touching);
+
+	// Caller is waiting on the results, otherwise report them as a single event
+	if ( selectedOut )
+		*selectedOut = selected;
+	else
+		gMsgQueueToMex.addEvent(EventPolygonsSelected, std::vector<double>(selected.begin(), selected.end()));
+
+	return true;
+}
+
+// A replayed selection has no caller to hand the indices to, so it reports them as an event
+bool MessageSelectRegion::writeLog(CommandLogWriter& log) const
+{
+	log.writeType(LogSelectRegion);
+	log.writeVector(region);
+	log.write(touching);
+
+	return true;
+}
+
 
 
 bool MessageShowObjectType::process()
@@ -277,6 +338,19 @@ bool MessageUpdateTransferFcn::process()
 	return true;
 }
 
+bool MessageUpdateTransferFcn::writeLog(CommandLogWriter& log) const
+{
+	log.writeType(LogUpdateTransferFcn);
+	log.write(type);
+	log.write(channel);
+	log.write(transferFcn);
+	log.write(range);
+	log.write(color);
+	log.write(alpha);
+
+	return true;
+}
+
 
 
 bool MessageSetTextureLighting::process()
@@ -316,3 +390,112 @@ bool MessageSetTextureAttenuation::process()
 
 	return true;
 }
+
+
+
+bool MessageMeshStats::process()
+{
+	if ( !gRenderer )
+		return false;
+
+	*statsOut = gRenderer->getResourceCache()->getStats();
+	gRenderer->getPolygonFaceCounts(statsOut->frameFaces, statsOut->frameFullFaces);
+
+	return true;
+}
+
+
+
+bool MessageSetFrameBudget::process()
+{
+	if ( !gRenderer )
+		return false;
+
+	FrameStats& frameStats = gRenderer->getFrameStats();
+	FrameStats::Settings settings = frameStats.getSettings();
+
+	if ( targetFps > 0.0 )
+		settings.targetFps = targetFps;
+	if ( budgetMs >= 0.0 )
+		settings.budgetMs = budgetMs;
+	if ( window > 0 )
+		settings.window = window;
+
+	frameStats.setSettings(settings);
+
+	return true;
+}
+
+
+
+bool MessageFrameStats::process()
+{
+	if ( !gRenderer )
+		return false;
+
+	FrameStats& frameStats = gRenderer->getFrameStats();
+
+	frameStats.getSummary(*summaryOut);
+	if ( reset )
+		frameStats.reset();
+
+	return true;
+}
+
+
+
+bool MessageBufferMemory::process()
+{
+	if ( !gRenderer )
+		return false;
+
+	gRenderer->getBufferMemory(*memoryOut);
+
+	return true;
+}
+
+
+
+bool MessageSetPolygonLod::process()
+{
+	if ( !gRenderer )
+		return false;
+
+	ResourceCache* cache = gRenderer->getResourceCache();
+
+	ResourceCache::LodSettings settings = cache->getLodSettings();
+	settings.errorPixels = errorPixels;
+	for ( int i = 0; i < levelPixels.size() && i < ResourceCache::numLodLevels-1; ++i )
+		settings.levelPixels[i] = levelPixels[i];
+
+	if ( !cache->setLodSettings(settings) )
+		return true;
+
+	// Merged buffers hold copies of the old levels
+	cache->updateLods();
+	gRenderer->clearPolygonBatches();
+
+	return true;
+}
+
+bool MessageSetPolygonLod::writeLog(CommandLogWriter& log) const
+{
+	log.writeType(LogSetPolygonLod);
+	log.write(errorPixels);
+	log.writeVector(levelPixels);
+
+	return true;
+}
+
+
+
+bool MessageSetMeshOptimize::process()
+{
+	if ( !gRenderer )
+		return false;
+
+	// Only meshes loaded from now on are affected
+	gRenderer->getResourceCache()->setMeshOptimize(optimize);
+
+	return true;
+}
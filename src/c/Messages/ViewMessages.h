@@ -3,8 +3,10 @@
 #include "RenderMessages.h"
 
 #include "D3d/Renderer.h"
+#include "D3d/NodeRegistry.h"
+#include "D3d/ResourceCache.h"
 
-#include <set>
+#include <vector>
 
 // Basic view messages
 class MessageSetWindowSize: public Message
@@ -14,6 +16,8 @@ public:
 
 protected:
 	virtual bool process();
+	virtual bool getCoalesceTarget(uint64_t& targetOut) const {targetOut = 0; return true;}
+	virtual bool writeLog(CommandLogWriter& log) const {log.writeType(LogSetWindowSize); log.write(width); log.write(height); return true;}
 
 private:
 	int width;
@@ -28,6 +32,8 @@ public:
 
 protected:
 	virtual bool process();
+	virtual bool getCoalesceTarget(uint64_t& targetOut) const {targetOut = 0; return true;}
+	virtual bool writeLog(CommandLogWriter& log) const {log.writeType(LogSetDpiScale); log.write(scale); return true;}
 
 private:
 	int scale;
@@ -41,6 +47,7 @@ public:
 
 protected:
 	virtual bool process();
+	virtual bool writeLog(CommandLogWriter& log) const {log.writeType(LogResetView); return true;}
 };
 
 
@@ -51,6 +58,8 @@ public:
 
 protected:
 	virtual bool process();
+	virtual bool getCoalesceTarget(uint64_t& targetOut) const {targetOut = 0; return true;}
+	virtual bool writeLog(CommandLogWriter& log) const {log.writeType(LogSetViewOrigin); log.write(origin); return true;}
 
 private:
 	Vec<float> origin;
@@ -64,6 +73,7 @@ public:
 
 protected:
 	virtual bool process();
+	virtual bool writeLog(CommandLogWriter& log) const {log.writeType(LogSetViewRotation); log.write(axis); log.write(angle); return true;}
 
 private:
 	Vec<double> axis;
@@ -78,6 +88,7 @@ public:
 
 protected:
 	virtual bool process();
+	virtual bool writeLog(CommandLogWriter& log) const {log.writeType(LogSetWorldRotation); log.write(axis); log.write(angle); return true;}
 
 private:
 	Vec<double> axis;
@@ -92,6 +103,8 @@ public:
 
 protected:
 	virtual bool process();
+	virtual bool getCoalesceTarget(uint64_t& targetOut) const {targetOut = 0; return true;}
+	virtual bool writeLog(CommandLogWriter& log) const {log.writeType(LogSetFrontClipPlane); log.write(clipDistance); return true;}
 
 private:
 	float clipDistance;
@@ -106,6 +119,8 @@ public:
 
 protected:
 	virtual bool process();
+	virtual bool getCoalesceTarget(uint64_t& targetOut) const {targetOut = 0; return true;}
+	virtual bool writeLog(CommandLogWriter& log) const {log.writeType(LogShowFrame); log.write(visible); return true;}
 
 private:
 	bool visible;
@@ -119,6 +134,8 @@ public:
 
 protected:
 	virtual bool process();
+	virtual bool getCoalesceTarget(uint64_t& targetOut) const {targetOut = 0; return true;}
+	virtual bool writeLog(CommandLogWriter& log) const {log.writeType(LogShowLabels); log.write(visible); return true;}
 
 private:
 	bool visible;
@@ -132,6 +149,8 @@ public:
 
 protected:
 	virtual bool process();
+	virtual bool getCoalesceTarget(uint64_t& targetOut) const {targetOut = 0; return true;}
+	virtual bool writeLog(CommandLogWriter& log) const {log.writeType(LogShowScale); log.write(visible); return true;}
 
 private:
 	bool visible;
@@ -146,6 +165,8 @@ public:
 
 protected:
 	virtual bool process();
+	virtual bool getCoalesceTarget(uint64_t& targetOut) const {targetOut = 0; return true;}
+	virtual bool writeLog(CommandLogWriter& log) const {log.writeType(LogSetBackgroundColor); log.write(color); return true;}
 
 private:
 	Vec<float> color;
@@ -159,6 +180,8 @@ public:
 
 protected:
 	virtual bool process();
+	virtual bool getCoalesceTarget(uint64_t& targetOut) const {targetOut = type; return true;}
+	virtual bool writeLog(CommandLogWriter& log) const {log.writeType(LogSetObjectColor); log.write(type); log.write(color); return true;}
 
 private:
 	GraphicObjectTypes type;
@@ -174,6 +197,7 @@ public:
 
 protected:
 	virtual bool process();
+	virtual bool writeLog(CommandLogWriter& log) const {log.writeType(LogMoveCamera); log.write(delta); return true;}
 
 private:
 	Vec<float> delta;
@@ -190,11 +214,28 @@ public:
 
 protected:
 	virtual bool process();
+	virtual bool writeLog(CommandLogWriter& log) const;
 
 private:
 	bool visible;
 
-	std::set<int> indices;
+	std::vector<int> indices;
+};
+
+
+class MessageSetPolygonState: public Message
+{
+public:
+	MessageSetPolygonState(){}
+
+	NodeRegistry::BulkState& getState(){return state;}
+
+protected:
+	virtual bool process();
+	virtual bool writeLog(CommandLogWriter& log) const;
+
+private:
+	NodeRegistry::BulkState state;
 };
 
 
@@ -205,6 +246,8 @@ public:
 
 protected:
 	virtual bool process();
+	virtual bool getCoalesceTarget(uint64_t& targetOut) const {targetOut = type; return true;}
+	virtual bool writeLog(CommandLogWriter& log) const {log.writeType(LogShowObjectType); log.write(type); log.write(visible); return true;}
 
 private:
 	GraphicObjectTypes type;
@@ -212,6 +255,25 @@ private:
 };
 
 
+// Screen-space region selection, pixel coordinates are relative to the window client area
+class MessageSelectRegion: public Message
+{
+public:
+	MessageSelectRegion(const std::vector<Vec<float>>& region, bool touching, std::vector<int>* selectedOut = NULL)
+		: region(region), touching(touching), selectedOut(selectedOut){}
+
+protected:
+	virtual bool process();
+	virtual bool writeLog(CommandLogWriter& log) const;
+
+private:
+	std::vector<Vec<float>> region;
+	bool touching;
+
+	std::vector<int>* selectedOut;
+};
+
+
 // Polygon visualization settings
 class MessageSetPolyWireframe: public Message
 {
@@ -220,6 +282,8 @@ public:
 
 protected:
 	virtual bool process();
+	virtual bool getCoalesceTarget(uint64_t& targetOut) const {targetOut = 0; return true;}
+	virtual bool writeLog(CommandLogWriter& log) const {log.writeType(LogSetPolyWireframe); log.write(wireframe); return true;}
 
 private:
 	bool wireframe;
@@ -233,6 +297,8 @@ public:
 
 protected:
 	virtual bool process();
+	virtual bool getCoalesceTarget(uint64_t& targetOut) const {targetOut = 0; return true;}
+	virtual bool writeLog(CommandLogWriter& log) const {log.writeType(LogSetPolyLighting); log.write(lightingOn); return true;}
 
 private:
 	bool lightingOn;
@@ -251,6 +317,8 @@ public:
 
 protected:
 	virtual bool process();
+	virtual bool getCoalesceTarget(uint64_t& targetOut) const {targetOut = (uint64_t(type) << 32) | uint32_t(channel); return true;}
+	virtual bool writeLog(CommandLogWriter& log) const;
 
 private:
 	GraphicObjectTypes type;
@@ -271,6 +339,8 @@ public:
 
 protected:
 	virtual bool process();
+	virtual bool getCoalesceTarget(uint64_t& targetOut) const {targetOut = type; return true;}
+	virtual bool writeLog(CommandLogWriter& log) const {log.writeType(LogSetTextureLighting); log.write(type); log.write(lightingOn); return true;}
 
 private:
 	GraphicObjectTypes type;
@@ -285,8 +355,97 @@ public:
 
 protected:
 	virtual bool process();
+	virtual bool getCoalesceTarget(uint64_t& targetOut) const {targetOut = type; return true;}
+	virtual bool writeLog(CommandLogWriter& log) const {log.writeType(LogSetTextureAttenuation); log.write(type); log.write(attenuate); return true;}
 
 private:
 	GraphicObjectTypes type;
 	bool attenuate;
 };
+
+
+class MessageMeshStats: public Message
+{
+public:
+	MessageMeshStats(ResourceCache::Stats* statsOut) : statsOut(statsOut){}
+
+protected:
+	virtual bool process();
+
+private:
+	ResourceCache::Stats* statsOut;
+};
+
+
+class MessageBufferMemory: public Message
+{
+public:
+	MessageBufferMemory(std::vector<Renderer::BufferMemory>* memoryOut) : memoryOut(memoryOut){}
+
+protected:
+	virtual bool process();
+
+private:
+	std::vector<Renderer::BufferMemory>* memoryOut;
+};
+
+
+// Negative values keep the current setting (so these aren't coalesced), a budget of zero follows the target frame rate
+class MessageSetFrameBudget: public Message
+{
+public:
+	MessageSetFrameBudget(double targetFps, double budgetMs, int window) : targetFps(targetFps), budgetMs(budgetMs), window(window){}
+
+protected:
+	virtual bool process();
+	virtual bool writeLog(CommandLogWriter& log) const {log.writeType(LogSetFrameBudget); log.write(targetFps); log.write(budgetMs); log.write(window); return true;}
+
+private:
+	double targetFps;
+	double budgetMs;
+	int window;
+};
+
+
+class MessageFrameStats: public Message
+{
+public:
+	MessageFrameStats(FrameStats::Summary* summaryOut, bool reset) : summaryOut(summaryOut), reset(reset){}
+
+protected:
+	virtual bool process();
+
+private:
+	FrameStats::Summary* summaryOut;
+	bool reset;
+};
+
+
+class MessageSetPolygonLod: public Message
+{
+public:
+	// Empty levelPixels keeps the current level sizes
+	MessageSetPolygonLod(float errorPixels, const std::vector<float>& levelPixels) : errorPixels(errorPixels), levelPixels(levelPixels){}
+
+protected:
+	virtual bool process();
+	virtual bool writeLog(CommandLogWriter& log) const;
+
+private:
+	float errorPixels;
+	std::vector<float> levelPixels;
+};
+
+
+class MessageSetMeshOptimize: public Message
+{
+public:
+	MessageSetMeshOptimize(bool optimize) : optimize(optimize){}
+
+protected:
+	virtual bool process();
+	virtual bool writeLog(CommandLogWriter& log) const {log.writeType(LogSetMeshOptimize); log.write(optimize); return true;}
+
+private:
+	bool optimize;
+};
@@ -30,5 +30,5 @@ volatile bool gRendererInit = false;
 bool registerExitFunction = false;
 HANDLE messageLoopHandle = NULL;
 
-ReturnQueue gMsgQueueToMex;
+EventQueue gMsgQueueToMex;
 MessageQueue gMsgQueueToDirectX(true);
@@ -38,31 +38,46 @@ BEGIN_MEX_COMMANDS
 DEF_MEX_COMMAND(Info)
 DEF_MEX_COMMAND(Help)
 // Additional specific mex commands should be added here.
+DEF_MEX_COMMAND(AddLabelPolygons)
 DEF_MEX_COMMAND(AddPolygons)
+DEF_MEX_COMMAND(AllocationStats)
 DEF_MEX_COMMAND(CaptureSpinMovie)
 DEF_MEX_COMMAND(CaptureWindow)
 DEF_MEX_COMMAND(ClearAllTextures)
 DEF_MEX_COMMAND(ClearTextureFrame)
 DEF_MEX_COMMAND(Close)
 DEF_MEX_COMMAND(DeleteAllPolygons)
+DEF_MEX_COMMAND(FrameStats)
 DEF_MEX_COMMAND(Init)
 DEF_MEX_COMMAND(InitVolume)
+DEF_MEX_COMMAND(LayoutBenchmark)
 DEF_MEX_COMMAND(LoadTexture)
 DEF_MEX_COMMAND(LoadTextureFrame)
+DEF_MEX_COMMAND(MemoryReport)
+DEF_MEX_COMMAND(MeshStats)
+DEF_MEX_COMMAND(MessageStats)
 DEF_MEX_COMMAND(MoveCamera)
 DEF_MEX_COMMAND(Play)
 DEF_MEX_COMMAND(Poll)
+DEF_MEX_COMMAND(PollEvents)
 DEF_MEX_COMMAND(ReleaseControl)
 DEF_MEX_COMMAND(RemovePolygon)
 DEF_MEX_COMMAND(ResetView)
 DEF_MEX_COMMAND(PolygonLighting)
+DEF_MEX_COMMAND(QueueBenchmark)
+DEF_MEX_COMMAND(QueueStats)
+DEF_MEX_COMMAND(SelectPolygons)
 DEF_MEX_COMMAND(SetBackgroundColor)
 DEF_MEX_COMMAND(SetBorderColor)
 DEF_MEX_COMMAND(SetCapturePath)
 DEF_MEX_COMMAND(SetCaptureSize)
 DEF_MEX_COMMAND(SetDpiScale)
 DEF_MEX_COMMAND(SetFrame)
+DEF_MEX_COMMAND(SetFrameBudget)
 DEF_MEX_COMMAND(SetFrontClip)
+DEF_MEX_COMMAND(SetMeshOptimize)
+DEF_MEX_COMMAND(SetPolygonLod)
+DEF_MEX_COMMAND(SetPolygonState)
 DEF_MEX_COMMAND(SetViewOrigin)
 DEF_MEX_COMMAND(SetViewRotation)
 DEF_MEX_COMMAND(SetWindowSize)
@@ -75,10 +90,16 @@ DEF_MEX_COMMAND(ShowPolygonList)
 DEF_MEX_COMMAND(ShowTexture)
 DEF_MEX_COMMAND(ShowScaleBar)
 DEF_MEX_COMMAND(ShowWidget)
+DEF_MEX_COMMAND(StartProfiling)
+DEF_MEX_COMMAND(StartRecording)
+DEF_MEX_COMMAND(StopProfiling)
+DEF_MEX_COMMAND(StopRecording)
 DEF_MEX_COMMAND(TakeControl)
 DEF_MEX_COMMAND(TextureAttenuation)
 DEF_MEX_COMMAND(TextureLighting)
 DEF_MEX_COMMAND(TransferFunction)
+DEF_MEX_COMMAND(TransformBenchmark)
 DEF_MEX_COMMAND(ToggleWireframe)
 DEF_MEX_COMMAND(UpdateRender)
+DEF_MEX_COMMAND(WriteProfile)
 END_MEX_COMMANDS
\ No newline at end of file
@@ -0,0 +1,217 @@
+#include "MexCommand.h"
+#include "Global/Globals.h"
+#include "Messages/QueuePolygon.h"
+#include "Messages/LoadMessages.h"
+
+#include "D3d/MarchingCubes.h"
+
+#include <cmath>
+#include <cstdint>
+#include <limits>
+#include <utility>
+#include <vector>
+
+namespace
+{
+	// Same crossing level D3d.Polygon.Make passes to isosurface
+	const float labelIsoLevel = 0.75f;
+
+	template <typename T>
+	void copyLabels(const mxArray* mxLabels, std::vector<uint32_t>& labelsOut)
+	{
+		const T* data = (const T*)mxGetData(mxLabels);
+		for ( size_t i = 0; i < labelsOut.size(); ++i )
+			labelsOut[i] = (data[i] > 0) ? uint32_t(data[i]) : 0;
+	}
+
+	void readLabels(const mxArray* mxLabels, std::vector<uint32_t>& labelsOut)
+	{
+		labelsOut.resize(mxGetNumberOfElements(mxLabels));
+
+		switch ( mxGetClassID(mxLabels) )
+		{
+		case mxLOGICAL_CLASS:
+		case mxUINT8_CLASS:	copyLabels<uint8_t>(mxLabels, labelsOut); break;
+		case mxINT8_CLASS:	copyLabels<int8_t>(mxLabels, labelsOut); break;
+		case mxUINT16_CLASS:	copyLabels<uint16_t>(mxLabels, labelsOut); break;
+		case mxINT16_CLASS:	copyLabels<int16_t>(mxLabels, labelsOut); break;
+		case mxUINT32_CLASS:	copyLabels<uint32_t>(mxLabels, labelsOut); break;
+		case mxINT32_CLASS:	copyLabels<int32_t>(mxLabels, labelsOut); break;
+		case mxSINGLE_CLASS:	copyLabels<float>(mxLabels, labelsOut); break;
+		case mxDOUBLE_CLASS:	copyLabels<double>(mxLabels, labelsOut); break;
+		default: break;
+		}
+	}
+
+	// Spreads default colors around the hue wheel so neighboring labels differ
+	Vec<float> defaultLabelColor(uint32_t label)
+	{
+		float hue = std::fmod(label * 0.618034f, 1.0f) * 6.0f;
+		float frac = hue - std::floor(hue);
+
+		switch ( int(hue) )
+		{
+		case 0: return Vec<float>(1.0f, frac, 0.0f);
+		case 1: return Vec<float>(1.0f - frac, 1.0f, 0.0f);
+		case 2: return Vec<float>(0.0f, 1.0f, frac);
+		case 3: return Vec<float>(0.0f, 1.0f - frac, 1.0f);
+		case 4: return Vec<float>(frac, 0.0f, 1.0f);
+		default: return Vec<float>(1.0f, 0.0f, 1.0f - frac);
+		}
+	}
+}
+
+void MexAddLabelPolygons::execute(int nlhs, mxArray* plhs[], int nrhs, const mxArray* prhs[]) const
+{
+	const mxArray* mxLabels = prhs[0];
+	int frame = MAT_TO_C(int(mxGetScalar(prhs[1])));
+
+	size_t numDims = mxGetNumberOfDimensions(mxLabels);
+	const mwSize* mxDims = mxGetDimensions(mxLabels);
+	Vec<size_t> dims(mxDims[0], mxDims[1], (numDims > 2) ? mxDims[2] : 1);
+
+	std::vector<uint32_t> labels;
+	readLabels(mxLabels, labels);
+
+	// Binary masks are split into 26-connected components like bwconncomp
+	if ( mxIsLogical(mxLabels) )
+		MarchingCubes::labelComponents(dims, labels);
+
+	const double* colors = NULL;
+	size_t numColors = 0;
+	if ( nrhs > 2 && !mxIsEmpty(prhs[2]) )
+	{
+		colors = (double*)mxGetData(prhs[2]);
+		numColors = mxGetM(prhs[2]);
+	}
+
+	int indexOffset = 0;
+	if ( nrhs > 3 && !mxIsEmpty(prhs[3]) )
+		indexOffset = int(mxGetScalar(prhs[3]));
+
+	size_t minVoxels = 3;
+	size_t maxVoxels = std::numeric_limits<size_t>::max();
+	if ( nrhs > 4 && !mxIsEmpty(prhs[4]) )
+	{
+		double* voxelRange = (double*)mxGetData(prhs[4]);
+		minVoxels = size_t(voxelRange[0]);
+		if ( mxGetNumberOfElements(prhs[4]) > 1 && !mxIsInf(voxelRange[1]) )
+			maxVoxels = size_t(voxelRange[1]);
+	}
+
+	std::vector<MarchingCubes::Surface> surfaces;
+	MarchingCubes::extractSurfaces(dims, labels.data(), labelIsoLevel, minVoxels, maxVoxels, surfaces);
+
+	// Reported straight from the surfaces, the queued polygons get their own copies of the arrays
+	if ( nlhs > 0 )
+	{
+		const char* fields[] = {"index", "label", "frame", "CenterOfMass", "numVoxels", "numFaces"};
+		plhs[0] = mxCreateStructMatrix(surfaces.size(), 1, 6, fields);
+
+		for ( size_t i = 0; i < surfaces.size(); ++i )
+		{
+			const MarchingCubes::Surface& surface = surfaces[i];
+
+			mxArray* mxCenter = mxCreateDoubleMatrix(1, 3, mxREAL);
+			double* center = mxGetPr(mxCenter);
+			for ( int d = 0; d < 3; ++d )
+				center[d] = surface.centroid.e[d];
+
+			mxSetField(plhs[0], i, fields[0], mxCreateDoubleScalar(double(int(surface.label) + indexOffset)));
+			mxSetField(plhs[0], i, fields[1], mxCreateDoubleScalar(double(surface.label)));
+			mxSetField(plhs[0], i, fields[2], mxCreateDoubleScalar(C_TO_MAT(double(frame))));
+			mxSetField(plhs[0], i, fields[3], mxCenter);
+			mxSetField(plhs[0], i, fields[4], mxCreateDoubleScalar(double(surface.numVoxels)));
+			mxSetField(plhs[0], i, fields[5], mxCreateDoubleScalar(double(surface.faces.size())));
+		}
+	}
+
+	size_t meshBytes = 0;
+	for ( const MarchingCubes::Surface& surface : surfaces )
+		meshBytes += MessageLoadPolys::meshBytes(surface.faces.size(), surface.vertices.size(), !surface.normals.empty(),
+			std::to_string(int(surface.label) + indexOffset).size());
+
+	MessageLoadPolys* loadMsg = new MessageLoadPolys(surfaces.size(), meshBytes);
+	for ( MarchingCubes::Surface& surface : surfaces )
+	{
+		Vec<float> color = defaultLabelColor(surface.label);
+		if ( numColors > 0 )
+		{
+			size_t row = (surface.label - 1) % numColors;
+			color = Vec<float>(float(colors[row]), float(colors[row + numColors]), float(colors[row + 2*numColors]));
+		}
+
+		double colorData[3] = {color.x, color.y, color.z};
+
+		int index = int(surface.label) + indexOffset;
+
+		QueuePolygon* newPoly = loadMsg->createPoly(frame, index, std::to_string(index));
+		newPoly->setMeshData(surface.faces, surface.vertices, surface.normals);
+		newPoly->setcolorData(colorData);
+	}
+
+	gMsgQueueToDirectX.pushMessage(loadMsg);
+}
+
+std::string MexAddLabelPolygons::check(int nlhs, mxArray* plhs[], int nrhs, const mxArray* prhs[]) const
+{
+	if ( gRenderer == NULL )
+		return "No renderer instantiated!";
+
+	if ( nrhs < 2 || nrhs > 5 )
+		return "Not the right arguments for AddLabelPolygons!";
+
+	if ( nlhs > 1 )
+		return "AddLabelPolygons has at most one output!";
+
+	size_t numDims = mxGetNumberOfDimensions(prhs[0]);
+	if ( numDims > 3 || mxIsEmpty(prhs[0]) )
+		return "Labels must be a non-empty 2-D or 3-D image!";
+
+	switch ( mxGetClassID(prhs[0]) )
+	{
+	case mxLOGICAL_CLASS: case mxUINT8_CLASS: case mxINT8_CLASS: case mxUINT16_CLASS: case mxINT16_CLASS:
+	case mxUINT32_CLASS: case mxINT32_CLASS: case mxSINGLE_CLASS: case mxDOUBLE_CLASS:
+		break;
+	default:
+		return "Labels must be a logical, integer, single or double image!";
+	}
+
+	if ( mxGetNumberOfElements(prhs[1]) != 1 || mxGetScalar(prhs[1]) < 1 )
+		return "Frame must be a positive scalar!";
+
+	if ( nrhs > 2 && !mxIsEmpty(prhs[2]) && (!mxIsDouble(prhs[2]) || mxGetN(prhs[2]) != 3) )
+		return "Colors must be an (n x 3) double array!";
+
+	if ( nrhs > 3 && !mxIsEmpty(prhs[3]) && mxGetNumberOfElements(prhs[3]) != 1 )
+		return "IndexOffset must be a scalar!";
+
+	if ( nrhs > 4 && !mxIsEmpty(prhs[4]) && (!mxIsDouble(prhs[4]) || mxGetNumberOfElements(prhs[4]) > 2) )
+		return "VoxelRange must be [min] or [min,max]!";
+
+	return "";
+}
+
+void MexAddLabelPolygons::usage(std::vector<std::string>& outArgs, std::vector<std::string>& inArgs) const
+{
+	outArgs.push_back("PolygonInfo");
+
+	inArgs.push_back("Labels");
+	inArgs.push_back("Frame");
+	inArgs.push_back("Colors");
+	inArgs.push_back("IndexOffset");
+	inArgs.push_back("VoxelRange");
+}
+
+void MexAddLabelPolygons::help(std::vector<std::string>& helpLines) const
+{
+	helpLines.push_back("This builds polygons directly from a label or binary image and adds them to the viewer.");
+
+	helpLines.push_back("\tLabels -- A 2-D or 3-D label image, each non-zero label becomes one polygon.");
+	helpLines.push_back("\t\tLogical images are split into 26-connected components first, like bwconncomp.");
+	helpLines.push_back("\tFrame -- The frame the polygons will be displayed on.");
+	helpLines.push_back("\tColors -- Optional (n x 3) colors, label L uses row mod(L-1,n)+1. Empty spreads colors over the hue wheel.");
+	helpLines.push_back("\tIndexOffset -- Optional value added to each label to make the polygon index, use it to keep indices unique across frames.");
+	helpLines.push_back("\tVoxelRange -- Optional [min,max] voxel count for a label to become a polygon. Default is [3,inf].");
+	helpLines.push_back("\tPolygonInfo -- Optional structure array with the index, label, frame, CenterOfMass (x,y,z), numVoxels and numFaces of each added polygon.");
+}
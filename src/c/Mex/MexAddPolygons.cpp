@@ -6,13 +6,47 @@
 
 #include <vector>
 
+namespace
+{
+	// Verts closer than this (in voxels) are welded, well under isosurface vertex spacing
+	const float weldDistance = 1.0e-4f;
+
+	// Welds the polygon's verts and computes its normals, returns false if a face references a vertex that doesn't exist
+	bool prepPolygon(QueuePolygon* poly)
+	{
+		const MeshOptimizer::MeshArrays& mesh = poly->getMesh();
+
+		for ( size_t i = 0; i < mesh.numFaces; ++i )
+		{
+			const Vec<uint32_t>& face = mesh.faces[i];
+			if ( face.x >= mesh.numVerts || face.y >= mesh.numVerts || face.z >= mesh.numVerts )
+				return false;
+		}
+
+		poly->weldAndComputeNormals(weldDistance);
+
+		return true;
+	}
+}
+
 void MexAddPolygons::execute(int nlhs, mxArray* plhs[], int nrhs, const mxArray* prhs[]) const
 {
 	const mxArray* mxPolygons = prhs[0];
 
 	size_t numPolygons = mxGetNumberOfElements(mxPolygons);
 
-	MessageLoadPolys* loadMsg = new MessageLoadPolys(numPolygons);
+	// Every polygon ends up with normals, given or computed
+	size_t meshBytes = 0;
+	for(size_t i = 0; i<numPolygons; ++i)
+	{
+		mxArray* mxLabel = mxGetField(mxPolygons, i, "label");
+		size_t labelLength = (mxLabel) ? mxGetNumberOfElements(mxLabel) : 0;
+
+		meshBytes += MessageLoadPolys::meshBytes(mxGetM(mxGetField(mxPolygons, i, "faces")), mxGetM(mxGetField(mxPolygons, i, "verts")), true,
+			(labelLength < 256) ? labelLength : 255);
+	}
+
+	MessageLoadPolys* loadMsg = new MessageLoadPolys(numPolygons, meshBytes);
 	for(size_t i = 0; i<numPolygons; ++i)
 	{
 		mxArray* mxFaces = mxGetField(mxPolygons, i, "faces");
@@ -25,7 +59,7 @@ void MexAddPolygons::execute(int nlhs, mxArray* plhs[], int nrhs, const mxArray*
 
 		size_t numFaces = mxGetM(mxFaces);
 		size_t numVerts = mxGetM(mxVerts);
-		size_t numNormals = mxGetM(mxNorms);
+		size_t numNormals = (mxNorms) ? mxGetM(mxNorms) : 0;
 
 		char buff[256];
 		if(numVerts<1)
@@ -40,13 +74,7 @@ void MexAddPolygons::execute(int nlhs, mxArray* plhs[], int nrhs, const mxArray*
 			mexErrMsgTxt(buff);
 		}
 
-		if(numNormals<1)
-		{
-			sprintf(buff, "There are no normals for polygon for %zd!", i+1);
-			mexErrMsgTxt(buff);
-		}
-
-		if(numNormals!=numVerts)
+		if(numNormals>0 && numNormals!=numVerts)
 		{
 			sprintf(buff, "Number of verts does not match the number of normals for %zd!", i+1);
 			mexErrMsgTxt(buff);
@@ -54,20 +82,34 @@ void MexAddPolygons::execute(int nlhs, mxArray* plhs[], int nrhs, const mxArray*
 
 		double* faceData = (double*)mxGetData(mxFaces);
 		double* vertData = (double*)mxGetData(mxVerts);
-		double* normData = (double*)mxGetData(mxNorms);
+		double* normData = (numNormals>0) ? (double*)mxGetData(mxNorms) : NULL;
 		double* colorData = (double*)mxGetData(mxColor);
 		int frame = MAT_TO_C(int(mxGetScalar(mxFrame)));
 
 		mxGetString(mxLabel, buff, 256);
 
-
-		QueuePolygon* newPoly = new QueuePolygon(numFaces, numVerts, numNormals, frame, (int)mxGetScalar(mxIndex), buff);
-		newPoly->setfaceData(faceData);
-		newPoly->setvertData(vertData);
-		newPoly->setnormData(normData);
+		// The MATLAB arrays are only read here, straight into the mesh formats
+		QueuePolygon* newPoly = loadMsg->createPoly(frame, (int)mxGetScalar(mxIndex), buff);
+		newPoly->setMatlabData(faceData, numFaces, vertData, numVerts, normData);
 		newPoly->setcolorData(colorData);
 
-		loadMsg->addPoly(newPoly);
+		// Polygons without normals are welded and get their normals here
+		if(numNormals<1)
+		{
+			if(!prepPolygon(newPoly))
+			{
+				delete loadMsg;
+				sprintf(buff, "Faces reference a vertex that doesn't exist for %zd!", i+1);
+				mexErrMsgTxt(buff);
+			}
+
+			if(newPoly->getNumFaces()<1)
+			{
+				delete loadMsg;
+				sprintf(buff, "All faces collapsed when welding polygon for %zd!", i+1);
+				mexErrMsgTxt(buff);
+			}
+		}
 	}
 
 	gMsgQueueToDirectX.pushMessage(loadMsg);
@@ -86,8 +128,6 @@ std::string MexAddPolygons::check(int nlhs, mxArray* plhs[], int nrhs, const mxA
 		return "Polygon struct is malformed, no faces!";
 	if(mxGetField(polys, 0, "verts")==NULL)
 		return "Polygon struct is malformed, no verts!";
-	if(mxGetField(polys, 0, "norms")==NULL)
-		return "Polygon struct is malformed, no norms!";
 	if(mxGetField(polys, 0, "color")==NULL)
 		return "Polygon struct is malformed, no color!";
 	if(mxGetField(polys, 0, "frame")==NULL)
@@ -114,6 +154,7 @@ void MexAddPolygons::help(std::vector<std::string>& helpLines) const
 	helpLines.push_back("\t\t\tfaces - This is an ordered list of verticies where each group of three represent a triangle face.");
 	helpLines.push_back("\t\t\tverts - This is a list of verticies that represent the exterior of polygon.");
 	helpLines.push_back("\t\t\tnorms - This is a list where each group of three make up a vector that represents the normal of the corresponding face.");
+	helpLines.push_back("\t\t\t\tThis field is optional. When it is missing or empty, verts closer than 1e-4 are welded and area weighted normals are computed natively.");
 	helpLines.push_back("\t\t\tcolor - This is three doubles in the range [0,1] that represent the (r,g,b) color.");
 	helpLines.push_back("\t\t\t\tThis can also be three times as long as the vert list where each triple corresponds to a color for each vertex.");
 	helpLines.push_back("\t\t\tframe - This is the frame in which the polygon will be displayed on.");
@@ -0,0 +1,46 @@
+#include "MexCommand.h"
+
+#include "Global/AllocStats.h"
+#include "Global/Arena.h"
+
+void MexAllocationStats::execute(int nlhs, mxArray* plhs[], int nrhs, const mxArray* prhs[]) const
+{
+	Arena::Stats arenaStats = Arena::getStats();
+
+	const char* fields[] = {"HeapCounting", "HeapAllocations", "HeapFrees", "ArenaChunks", "ArenaAllocations", "ArenaBytes"};
+	plhs[0] = mxCreateStructMatrix(1, 1, 6, fields);
+
+	mxSetField(plhs[0], 0, fields[0], mxCreateLogicalScalar(AllocStats::isEnabled()));
+	mxSetField(plhs[0], 0, fields[1], mxCreateDoubleScalar(double(AllocStats::getHeapAllocations())));
+	mxSetField(plhs[0], 0, fields[2], mxCreateDoubleScalar(double(AllocStats::getHeapFrees())));
+	mxSetField(plhs[0], 0, fields[3], mxCreateDoubleScalar(double(arenaStats.chunks)));
+	mxSetField(plhs[0], 0, fields[4], mxCreateDoubleScalar(double(arenaStats.allocations)));
+	mxSetField(plhs[0], 0, fields[5], mxCreateDoubleScalar(double(arenaStats.bytes)));
+}
+
+std::string MexAllocationStats::check(int nlhs, mxArray* plhs[], int nrhs, const mxArray* prhs[]) const
+{
+	if ( nrhs != 0 )
+		return "AllocationStats takes no arguments!";
+
+	if ( nlhs != 1 )
+		return "AllocationStats requires one output!";
+
+	return "";
+}
+
+void MexAllocationStats::usage(std::vector<std::string>& outArgs, std::vector<std::string>& inArgs) const
+{
+	outArgs.push_back("Stats");
+}
+
+void MexAllocationStats::help(std::vector<std::string>& helpLines) const
+{
+	helpLines.push_back("This will report the allocation counters of the viewer module since it was loaded.");
+
+	helpLines.push_back("\tStats -- A structure with the running totals, take the difference of two calls to measure an operation.");
+	helpLines.push_back("\t\tHeapCounting is true if the viewer was built with D3D_ALLOC_STATS, only then do HeapAllocations and HeapFrees");
+	helpLines.push_back("\t\tcount every operator new and delete made by the viewer on any thread (they are zero otherwise).");
+	helpLines.push_back("\t\tArenaChunks is the number of heap blocks taken by arenas, ArenaAllocations and ArenaBytes are what they served");
+	helpLines.push_back("\t\tfrom those blocks instead of the heap (polygon load messages and mesh preparation scratch space).");
+}
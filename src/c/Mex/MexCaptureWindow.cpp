@@ -17,7 +17,9 @@ void MexCaptureWindow::execute(int nlhs, mxArray* plhs[], int nrhs, const mxArra
 	
 	// This is when the caller would like to receive the image in memory instead of the file system
 	MessageCaptureWindow::BMPData outData;
-	gMsgQueueToDirectX.pushMessage(new MessageCaptureWindow(&outData), true);
+	MessageStatus status = gMsgQueueToDirectX.pushMessageAndWait(new MessageCaptureWindow(&outData));
+	if ( !status.error.empty() )
+		mexErrMsgTxt(status.error.c_str());
 
 	// TODO: Remove this!
 	gMsgQueueToMex.clearLoadFlag();
@@ -6,7 +6,7 @@
 
 void MexClose::execute(int nlhs, mxArray* plhs[], int nrhs, const mxArray* prhs[]) const
 {
-	gMsgQueueToDirectX.pushMessage(new MessageClose(), true);
+	gMsgQueueToDirectX.pushMessageAndWait(new MessageClose());
 
 	cleanUp();
 
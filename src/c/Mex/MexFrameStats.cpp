@@ -0,0 +1,79 @@
+#include "MexCommand.h"
+#include "Global/Globals.h"
+
+#include "Messages/ViewMessages.h"
+
+void MexFrameStats::execute(int nlhs, mxArray* plhs[], int nrhs, const mxArray* prhs[]) const
+{
+	bool reset = (nrhs > 0 && mxGetScalar(prhs[0]) != 0.0);
+
+	FrameStats::Summary summary;
+
+	MessageStatus status = gMsgQueueToDirectX.pushMessageAndWait(new MessageFrameStats(&summary, reset));
+	if ( !status.error.empty() )
+		mexErrMsgTxt(status.error.c_str());
+
+	const char* fields[] = {"TargetFps", "BudgetMs", "Window", "WindowFrames", "Frames", "OverBudget", "DroppedFrames",
+		"MeanMs", "P50Ms", "P95Ms", "P99Ms", "MaxMs", "StageNames", "StageMeanMs", "StageMaxMs"};
+	plhs[0] = mxCreateStructMatrix(1, 1, 15, fields);
+
+	mxArray* mxStageNames = mxCreateCellMatrix(1, FrameStats::NumStages);
+	mxArray* mxStageMeans = mxCreateDoubleMatrix(1, FrameStats::NumStages, mxREAL);
+	mxArray* mxStageMaxes = mxCreateDoubleMatrix(1, FrameStats::NumStages, mxREAL);
+
+	double* stageMeans = mxGetPr(mxStageMeans);
+	double* stageMaxes = mxGetPr(mxStageMaxes);
+	for ( int i = 0; i < FrameStats::NumStages; ++i )
+	{
+		mxSetCell(mxStageNames, i, mxCreateString(FrameStats::getStageName(FrameStats::Stage(i))));
+		stageMeans[i] = summary.stageMeanMs[i];
+		stageMaxes[i] = summary.stageMaxMs[i];
+	}
+
+	mxSetField(plhs[0], 0, fields[0], mxCreateDoubleScalar(summary.settings.targetFps));
+	mxSetField(plhs[0], 0, fields[1], mxCreateDoubleScalar(summary.settings.budgetMs));
+	mxSetField(plhs[0], 0, fields[2], mxCreateDoubleScalar(double(summary.settings.window)));
+	mxSetField(plhs[0], 0, fields[3], mxCreateDoubleScalar(double(summary.windowFrames)));
+	mxSetField(plhs[0], 0, fields[4], mxCreateDoubleScalar(double(summary.frames)));
+	mxSetField(plhs[0], 0, fields[5], mxCreateDoubleScalar(double(summary.overBudget)));
+	mxSetField(plhs[0], 0, fields[6], mxCreateDoubleScalar(double(summary.droppedFrames)));
+	mxSetField(plhs[0], 0, fields[7], mxCreateDoubleScalar(summary.meanMs));
+	mxSetField(plhs[0], 0, fields[8], mxCreateDoubleScalar(summary.p50Ms));
+	mxSetField(plhs[0], 0, fields[9], mxCreateDoubleScalar(summary.p95Ms));
+	mxSetField(plhs[0], 0, fields[10], mxCreateDoubleScalar(summary.p99Ms));
+	mxSetField(plhs[0], 0, fields[11], mxCreateDoubleScalar(summary.maxMs));
+	mxSetField(plhs[0], 0, fields[12], mxStageNames);
+	mxSetField(plhs[0], 0, fields[13], mxStageMeans);
+	mxSetField(plhs[0], 0, fields[14], mxStageMaxes);
+}
+
+std::string MexFrameStats::check(int nlhs, mxArray* plhs[], int nrhs, const mxArray* prhs[]) const
+{
+	if ( nrhs > 1 )
+		return "Not the right arguments for FrameStats!";
+
+	if ( nrhs > 0 && mxGetNumberOfElements(prhs[0]) != 1 )
+		return "Reset must be a scalar!";
+
+	if ( nlhs != 1 )
+		return "FrameStats requires one output!";
+
+	return "";
+}
+
+void MexFrameStats::usage(std::vector<std::string>& outArgs, std::vector<std::string>& inArgs) const
+{
+	outArgs.push_back("Stats");
+	inArgs.push_back("Reset");
+}
+
+void MexFrameStats::help(std::vector<std::string>& helpLines) const
+{
+	helpLines.push_back("This reports how long rendered frames have been taking, to check the viewer stayed interactive.");
+
+	helpLines.push_back("\tReset -- Optional, true clears the statistics after reporting them so the next call only covers newer frames.");
+	helpLines.push_back("\tStats -- A structure with the TargetFps, BudgetMs and Window set by SetFrameBudget. Frames, OverBudget and DroppedFrames");
+	helpLines.push_back("\t\tcount rendered frames, frames over the budget and display intervals missed since the last reset.");
+	helpLines.push_back("\t\tMeanMs, P50Ms, P95Ms, P99Ms and MaxMs are taken over the last WindowFrames frames, in milliseconds at microsecond");
+	helpLines.push_back("\t\tresolution. StageMeanMs and StageMaxMs split those frames into the render stages listed in StageNames.");
+}
@@ -0,0 +1,135 @@
+#include "MexCommand.h"
+
+#include "D3d/VertexLayouts.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <vector>
+
+namespace
+{
+	const VertexLayout::Types benchLayouts[] =
+	{
+		VertexLayout::Types::P, VertexLayout::Types::PN, VertexLayout::Types::PT, VertexLayout::Types::PNT, VertexLayout::Types::PNC,
+		VertexLayout::Types::PTC, VertexLayout::Types::PTCC, VertexLayout::Types::PNTC, VertexLayout::Types::PNTCC, VertexLayout::Types::PNCPacked
+	};
+
+	const int numBenchLayouts = sizeof(benchLayouts) / sizeof(benchLayouts[0]);
+
+	// Best of several runs so page faults and other threads don't skew the numbers
+	template <typename F>
+	double bestSeconds(int repeats, F func)
+	{
+		double best = HUGE_VAL;
+		for ( int i = 0; i < repeats; ++i )
+		{
+			std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+			func();
+			best = std::min(best, std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count());
+		}
+
+		return best;
+	}
+}
+
+void MexLayoutBenchmark::execute(int nlhs, mxArray* plhs[], int nrhs, const mxArray* prhs[]) const
+{
+	size_t numVerts = 1 << 20;
+	if ( nrhs > 0 && !mxIsEmpty(prhs[0]) )
+		numVerts = size_t(mxGetScalar(prhs[0]));
+
+	int repeats = 10;
+	if ( nrhs > 1 && !mxIsEmpty(prhs[1]) )
+		repeats = int(mxGetScalar(prhs[1]));
+
+	// Positions in [0,1], unit-ish normals and colors, the same sources feed every layout
+	std::vector<float> sources[VertexLayout::Attributes::ATTR_END];
+	for ( int i = 0; i < VertexLayout::Attributes::ATTR_END; ++i )
+	{
+		int numElems = (i >= VertexLayout::Attributes::Color) ? 4 : 3;
+
+		sources[i].resize(numElems * numVerts);
+		for ( size_t j = 0; j < sources[i].size(); ++j )
+			sources[i][j] = float((j * 2654435761u) % 1024) / 1023.0f;
+	}
+
+	const char* fields[] = {"Layout", "VertexBytes", "SliceGBps", "InterleaveGBps", "Speedup"};
+	plhs[0] = mxCreateStructMatrix(numBenchLayouts, 1, 5, fields);
+
+	for ( int i = 0; i < numBenchLayouts; ++i )
+	{
+		VertexLayout layout(benchLayouts[i]);
+		if ( layout.isPacked() )
+			layout.setPositionBounds(Vec<float>(0.0f, 0.0f, 0.0f), Vec<float>(1.0f, 1.0f, 1.0f));
+
+		const float* attrData[VertexLayout::Attributes::ATTR_END] = {NULL};
+		for ( int j = 0; j < VertexLayout::Attributes::ATTR_END; ++j )
+		{
+			if ( layout.validAttribute((VertexLayout::Attributes)j) )
+				attrData[j] = sources[j].data();
+		}
+
+		size_t bufferBytes = numVerts * layout.getVertSize();
+		void* vertMem = layout.stagingLayout(numVerts);
+
+		double sliceSeconds = bestSeconds(repeats, [&]()
+		{
+			for ( int j = 0; j < VertexLayout::Attributes::ATTR_END; ++j )
+			{
+				if ( attrData[j] )
+					layout.sliceIntoLayout(vertMem, (VertexLayout::Attributes)j, numVerts, attrData[j]);
+			}
+		});
+
+		double interleaveSeconds = bestSeconds(repeats, [&]()
+		{
+			layout.interleave(vertMem, numVerts, attrData);
+		});
+
+		// Throughput is counted in vertex buffer bytes written
+		double sliceRate = double(bufferBytes) / (sliceSeconds * 1e9);
+		double interleaveRate = double(bufferBytes) / (interleaveSeconds * 1e9);
+
+		mxSetField(plhs[0], i, fields[0], mxCreateString(layout.getName().c_str()));
+		mxSetField(plhs[0], i, fields[1], mxCreateDoubleScalar(double(layout.getVertSize())));
+		mxSetField(plhs[0], i, fields[2], mxCreateDoubleScalar(sliceRate));
+		mxSetField(plhs[0], i, fields[3], mxCreateDoubleScalar(interleaveRate));
+		mxSetField(plhs[0], i, fields[4], mxCreateDoubleScalar(interleaveRate / sliceRate));
+	}
+}
+
+std::string MexLayoutBenchmark::check(int nlhs, mxArray* plhs[], int nrhs, const mxArray* prhs[]) const
+{
+	if ( nrhs > 2 )
+		return "Not the right arguments for LayoutBenchmark!";
+
+	if ( nlhs != 1 )
+		return "LayoutBenchmark requires one output!";
+
+	if ( nrhs > 0 && !mxIsEmpty(prhs[0]) && (mxGetNumberOfElements(prhs[0]) != 1 || mxGetScalar(prhs[0]) < 1) )
+		return "NumVerts must be a positive scalar!";
+
+	if ( nrhs > 1 && !mxIsEmpty(prhs[1]) && (mxGetNumberOfElements(prhs[1]) != 1 || mxGetScalar(prhs[1]) < 1) )
+		return "Repeats must be a positive scalar!";
+
+	return "";
+}
+
+void MexLayoutBenchmark::usage(std::vector<std::string>& outArgs, std::vector<std::string>& inArgs) const
+{
+	outArgs.push_back("Results");
+
+	inArgs.push_back("NumVerts");
+	inArgs.push_back("Repeats");
+}
+
+void MexLayoutBenchmark::help(std::vector<std::string>& helpLines) const
+{
+	helpLines.push_back("This times writing vertex buffers for each vertex layout, one attribute at a time and interleaved in a single pass.");
+
+	helpLines.push_back("\tNumVerts -- Optional number of vertices to write per run. Default is 2^20.");
+	helpLines.push_back("\tRepeats -- Optional number of runs, the fastest run is reported. Default is 10.");
+	helpLines.push_back("\tResults -- A structure array with the Layout name, VertexBytes per vertex, the throughput of both writers in GB/s");
+	helpLines.push_back("\t\tof vertex buffer written (SliceGBps and InterleaveGBps) and the Speedup of interleaving.");
+}
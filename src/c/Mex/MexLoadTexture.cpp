@@ -3,6 +3,9 @@
 
 #include "Messages/LoadMessages.h"
 
+#include <utility>
+#include <vector>
+
 void MexLoadTexture::execute(int nlhs, mxArray* plhs[], int nrhs, const mxArray* prhs[]) const
 {
 	// check the message queue for an error message before continuing
@@ -24,8 +27,9 @@ void MexLoadTexture::execute(int nlhs, mxArray* plhs[], int nrhs, const mxArray*
 	if (numDims > 4)
 		numFrames = int(DIMS[4]);
 
-	// ptr to image data
-	unsigned char* image = (unsigned char*)mxGetData(prhs[0]);
+	// Copied so MATLAB can carry on while the render thread uploads it
+	const unsigned char* imageData = (const unsigned char*)mxGetData(prhs[0]);
+	std::vector<unsigned char> image(imageData, imageData + mxGetNumberOfElements(prhs[0]));
 
 	GraphicObjectTypes texType = GraphicObjectTypes::OriginalVolume;
 	if (nrhs > 1)
@@ -39,7 +43,8 @@ void MexLoadTexture::execute(int nlhs, mxArray* plhs[], int nrhs, const mxArray*
 			texType = GraphicObjectTypes::ProcessedVolume;
 	}
 
-	gMsgQueueToDirectX.pushMessage(new MessageLoadTexture(texType, image), true);
+	// Errors come back through the MEX error queue on the next call
+	gMsgQueueToDirectX.pushMessage(new MessageLoadTexture(texType, std::move(image)));
 }
 
 std::string MexLoadTexture::check(int nlhs, mxArray* plhs[], int nrhs, const mxArray* prhs[]) const
@@ -62,7 +67,7 @@ void MexLoadTexture::usage(std::vector<std::string>& outArgs, std::vector<std::s
 
 void MexLoadTexture::help(std::vector<std::string>& helpLines) const
 {
-	helpLines.push_back("this will load the image into texture buffers for display in the D3d viewer.");
+	helpLines.push_back("this will load the image into texture buffers for display in the D3d viewer. The image is copied and this returns before it is uploaded, a newer load of the same buffer replaces one still waiting. Load errors are reported by the next viewer call.");
 
 	helpLines.push_back("\tImage -- This should be an matrix up to five dimensions in the order (y,x,z,channel,time).");
 	helpLines.push_back("\tBufferType -- this can either be 'original' or 'processed' and corresponds to the first and second texture buffer available to load images into.");
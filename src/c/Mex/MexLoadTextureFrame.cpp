@@ -3,6 +3,9 @@
 
 #include "Messages/LoadMessages.h"
 
+#include <utility>
+#include <vector>
+
 void MexLoadTextureFrame::execute(int nlhs, mxArray* plhs[], int nrhs, const mxArray* prhs[]) const
 {
 	// check the message queue for an error message before continuing
@@ -23,8 +26,9 @@ void MexLoadTextureFrame::execute(int nlhs, mxArray* plhs[], int nrhs, const mxA
 
 	int frame = (int)mxGetScalar(prhs[1]);
 
-	// ptr to image data
-	unsigned char* image = (unsigned char*)mxGetData(prhs[0]);
+	// Copied so MATLAB can carry on while the render thread uploads it
+	const unsigned char* imageData = (const unsigned char*)mxGetData(prhs[0]);
+	std::vector<unsigned char> image(imageData, imageData + mxGetNumberOfElements(prhs[0]));
 
 	GraphicObjectTypes texType = GraphicObjectTypes::OriginalVolume;
 	if ( nrhs > 2 )
@@ -38,7 +42,8 @@ void MexLoadTextureFrame::execute(int nlhs, mxArray* plhs[], int nrhs, const mxA
 			texType = GraphicObjectTypes::ProcessedVolume;
 	}
 
-	gMsgQueueToDirectX.pushMessage(new MessageLoadTextureFrame(texType, MAT_TO_C(frame), image), true);
+	// Errors come back through the MEX error queue on the next call
+	gMsgQueueToDirectX.pushMessage(new MessageLoadTextureFrame(texType, MAT_TO_C(frame), std::move(image)));
 }
 
 std::string MexLoadTextureFrame::check(int nlhs, mxArray* plhs[], int nrhs, const mxArray* prhs[]) const
@@ -71,7 +76,7 @@ void MexLoadTextureFrame::usage(std::vector<std::string>& outArgs, std::vector<s
 
 void MexLoadTextureFrame::help(std::vector<std::string>& helpLines) const
 {
-	helpLines.push_back("this will load the image into texture buffers for display in the D3d viewer.");
+	helpLines.push_back("this will load the image into texture buffers for display in the D3d viewer. The image is copied and this returns before it is uploaded, a newer load of the same buffer and frame replaces one still waiting. Load errors are reported by the next viewer call.");
 
 	helpLines.push_back("\tImage -- This should be an matrix up to 4 dimensions in the order (y,x,z,channel).");
 	helpLines.push_back("\tFrame -- The frame in the sequence at which to load this texture data.");
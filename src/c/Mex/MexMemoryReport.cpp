@@ -0,0 +1,54 @@
+#include "MexCommand.h"
+#include "Global/Globals.h"
+
+#include "Messages/ViewMessages.h"
+
+void MexMemoryReport::execute(int nlhs, mxArray* plhs[], int nrhs, const mxArray* prhs[]) const
+{
+	std::vector<Renderer::BufferMemory> memory;
+	MessageStatus status = gMsgQueueToDirectX.pushMessageAndWait(new MessageBufferMemory(&memory));
+	if ( !status.error.empty() )
+		mexErrMsgTxt(status.error.c_str());
+
+	const char* fields[] = {"Type", "Objects", "Buffers", "VertexBytes", "IndexBytes", "UnpackedBytes"};
+	plhs[0] = mxCreateStructMatrix(memory.size(), 1, 6, fields);
+
+	for ( size_t i = 0; i < memory.size(); ++i )
+	{
+		mxSetField(plhs[0], i, fields[0], mxCreateString(memory[i].name.c_str()));
+		mxSetField(plhs[0], i, fields[1], mxCreateDoubleScalar(double(memory[i].objects)));
+		mxSetField(plhs[0], i, fields[2], mxCreateDoubleScalar(double(memory[i].buffers)));
+		mxSetField(plhs[0], i, fields[3], mxCreateDoubleScalar(double(memory[i].vertexBytes)));
+		mxSetField(plhs[0], i, fields[4], mxCreateDoubleScalar(double(memory[i].indexBytes)));
+		mxSetField(plhs[0], i, fields[5], mxCreateDoubleScalar(double(memory[i].unpackedBytes)));
+	}
+}
+
+std::string MexMemoryReport::check(int nlhs, mxArray* plhs[], int nrhs, const mxArray* prhs[]) const
+{
+	if ( gRenderer == NULL )
+		return "No renderer instantiated!";
+
+	if ( nrhs != 0 )
+		return "MemoryReport takes no arguments!";
+
+	if ( nlhs != 1 )
+		return "MemoryReport requires one output!";
+
+	return "";
+}
+
+void MexMemoryReport::usage(std::vector<std::string>& outArgs, std::vector<std::string>& inArgs) const
+{
+	outArgs.push_back("Report");
+}
+
+void MexMemoryReport::help(std::vector<std::string>& helpLines) const
+{
+	helpLines.push_back("This will report the GPU vertex and index buffer memory held by each type of scene object.");
+
+	helpLines.push_back("\tReport -- A structure array with one entry per object Type and a final PolygonBatches entry for the merged per-frame buffers.");
+	helpLines.push_back("\t\tObjects is the number of scene objects, Buffers the number of unique meshes (shared meshes are counted once).");
+	helpLines.push_back("\t\tVertexBytes and IndexBytes are the sizes of the buffers on the GPU, UnpackedBytes is what the same buffers would take");
+	helpLines.push_back("\t\twith float vertex attributes and 32-bit indices.");
+}
@@ -0,0 +1,79 @@
+#include "MexCommand.h"
+#include "Global/Globals.h"
+
+#include "Messages/ViewMessages.h"
+
+#include <cstring>
+
+void MexMeshStats::execute(int nlhs, mxArray* plhs[], int nrhs, const mxArray* prhs[]) const
+{
+	ResourceCache::Stats stats;
+	memset(&stats, 0, sizeof(ResourceCache::Stats));
+
+	MessageStatus status = gMsgQueueToDirectX.pushMessageAndWait(new MessageMeshStats(&stats));
+	if ( !status.error.empty() )
+		mexErrMsgTxt(status.error.c_str());
+
+	double dedupRatio = (stats.meshes > 0) ? (double(stats.meshRefs) / double(stats.meshes)) : (1.0);
+
+	double acmrBefore = (stats.optimizedFaces > 0) ? (double(stats.optimizedMissesBefore) / double(stats.optimizedFaces)) : (0.0);
+	double acmrAfter = (stats.optimizedFaces > 0) ? (double(stats.optimizedMissesAfter) / double(stats.optimizedFaces)) : (0.0);
+
+	const char* fields[] = {"Meshes", "MeshReferences", "DedupRatio", "MeshBytes", "MeshBytesSaved", "Materials", "MaterialReferences",
+		"LodMeshes", "LodFaces", "LodMaxError", "LodBuildSeconds", "FrameFaces", "FrameFullDetailFaces",
+		"OptimizedMeshes", "AcmrBefore", "AcmrAfter", "OptimizeSeconds"};
+	plhs[0] = mxCreateStructMatrix(1, 1, 17, fields);
+
+	mxArray* mxLodFaces = mxCreateDoubleMatrix(1, ResourceCache::numLodLevels, mxREAL);
+	double* lodFaces = mxGetPr(mxLodFaces);
+	for ( int i = 0; i < ResourceCache::numLodLevels; ++i )
+		lodFaces[i] = double(stats.lodFaces[i]);
+
+	mxSetField(plhs[0], 0, fields[0], mxCreateDoubleScalar(double(stats.meshes)));
+	mxSetField(plhs[0], 0, fields[1], mxCreateDoubleScalar(double(stats.meshRefs)));
+	mxSetField(plhs[0], 0, fields[2], mxCreateDoubleScalar(dedupRatio));
+	mxSetField(plhs[0], 0, fields[3], mxCreateDoubleScalar(double(stats.meshBytes)));
+	mxSetField(plhs[0], 0, fields[4], mxCreateDoubleScalar(double(stats.meshBytesSaved)));
+	mxSetField(plhs[0], 0, fields[5], mxCreateDoubleScalar(double(stats.materials)));
+	mxSetField(plhs[0], 0, fields[6], mxCreateDoubleScalar(double(stats.materialRefs)));
+	mxSetField(plhs[0], 0, fields[7], mxCreateDoubleScalar(double(stats.lodMeshes)));
+	mxSetField(plhs[0], 0, fields[8], mxLodFaces);
+	mxSetField(plhs[0], 0, fields[9], mxCreateDoubleScalar(stats.lodMaxError));
+	mxSetField(plhs[0], 0, fields[10], mxCreateDoubleScalar(stats.lodBuildSeconds));
+	mxSetField(plhs[0], 0, fields[11], mxCreateDoubleScalar(double(stats.frameFaces)));
+	mxSetField(plhs[0], 0, fields[12], mxCreateDoubleScalar(double(stats.frameFullFaces)));
+	mxSetField(plhs[0], 0, fields[13], mxCreateDoubleScalar(double(stats.optimizedMeshes)));
+	mxSetField(plhs[0], 0, fields[14], mxCreateDoubleScalar(acmrBefore));
+	mxSetField(plhs[0], 0, fields[15], mxCreateDoubleScalar(acmrAfter));
+	mxSetField(plhs[0], 0, fields[16], mxCreateDoubleScalar(stats.optimizeSeconds));
+}
+
+std::string MexMeshStats::check(int nlhs, mxArray* plhs[], int nrhs, const mxArray* prhs[]) const
+{
+	if ( nrhs != 0 )
+		return "MeshStats takes no arguments!";
+
+	if ( nlhs != 1 )
+		return "MeshStats requires one output!";
+
+	return "";
+}
+
+void MexMeshStats::usage(std::vector<std::string>& outArgs, std::vector<std::string>& inArgs) const
+{
+	outArgs.push_back("Stats");
+}
+
+void MexMeshStats::help(std::vector<std::string>& helpLines) const
+{
+	helpLines.push_back("This will report how well polygon meshes and materials are being shared.");
+
+	helpLines.push_back("\tStats -- A structure with the number of unique meshes and materials, how many polygons reference them,");
+	helpLines.push_back("\t\tthe dedup ratio (references per unique mesh), the bytes of unique mesh data and the bytes saved by sharing.");
+	helpLines.push_back("\t\tLodFaces has the unique mesh faces at full detail and at each decimated level, LodMaxError is the largest decimation");
+	helpLines.push_back("\t\terror as a fraction of a hull's bounding box diagonal, an upper bound on how far a moved vertex is from the planes of");
+	helpLines.push_back("\t\tthe faces it replaced, and LodBuildSeconds is the total time spent decimating.");
+	helpLines.push_back("\t\tFrameFaces and FrameFullDetailFaces are the polygon faces drawn in the last frame and how many full detail would draw.");
+	helpLines.push_back("\t\tAcmrBefore and AcmrAfter are the vertex shader runs per triangle of the OptimizedMeshes before and after vertex cache");
+	helpLines.push_back("\t\toptimization (3 is no reuse, lower is better) and OptimizeSeconds is the time spent reordering them.");
+}
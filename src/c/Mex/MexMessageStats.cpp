@@ -0,0 +1,92 @@
+#include "MexCommand.h"
+#include "Global/Globals.h"
+
+#include <algorithm>
+
+namespace
+{
+	const double nsToMs = 1.0e-6;
+
+	void setTimes(mxArray* mxStats, size_t idx, const char* fields[], const std::string& type, const LatencyHistogram& queued,
+		const LatencyHistogram& processing)
+	{
+		const LatencyHistogram* hists[2] = {&queued, &processing};
+
+		mxSetField(mxStats, idx, fields[0], mxCreateString(type.c_str()));
+		mxSetField(mxStats, idx, fields[1], mxCreateDoubleScalar(double(queued.getCount())));
+
+		for ( int i = 0; i < 2; ++i )
+		{
+			const LatencyHistogram* hist = hists[i];
+			const char** histFields = fields + 2 + 5*i;
+
+			mxSetField(mxStats, idx, histFields[0], mxCreateDoubleScalar(hist->getMean() * nsToMs));
+			mxSetField(mxStats, idx, histFields[1], mxCreateDoubleScalar(double(hist->getPercentile(0.50)) * nsToMs));
+			mxSetField(mxStats, idx, histFields[2], mxCreateDoubleScalar(double(hist->getPercentile(0.95)) * nsToMs));
+			mxSetField(mxStats, idx, histFields[3], mxCreateDoubleScalar(double(hist->getPercentile(0.99)) * nsToMs));
+			mxSetField(mxStats, idx, histFields[4], mxCreateDoubleScalar(double(hist->getMax()) * nsToMs));
+		}
+	}
+}
+
+void MexMessageStats::execute(int nlhs, mxArray* plhs[], int nrhs, const mxArray* prhs[]) const
+{
+	bool reset = false;
+	if ( nrhs > 0 && !mxIsEmpty(prhs[0]) )
+		reset = (mxGetScalar(prhs[0]) != 0.0);
+
+	std::vector<MessageQueue::TypeTimes> times;
+	gMsgQueueToDirectX.getTimes(times, reset);
+
+	std::sort(times.begin(), times.end(), [](const MessageQueue::TypeTimes& a, const MessageQueue::TypeTimes& b){return a.type < b.type;});
+
+	LatencyHistogram allQueued;
+	LatencyHistogram allProcessing;
+	for ( const MessageQueue::TypeTimes& typeTimes : times )
+	{
+		allQueued.add(typeTimes.queued);
+		allProcessing.add(typeTimes.processing);
+	}
+
+	const char* fields[] = {"Type", "Count",
+		"QueuedMean", "QueuedP50", "QueuedP95", "QueuedP99", "QueuedMax",
+		"ProcessingMean", "ProcessingP50", "ProcessingP95", "ProcessingP99", "ProcessingMax"};
+
+	plhs[0] = mxCreateStructMatrix(times.size() + 1, 1, 12, fields);
+
+	setTimes(plhs[0], 0, fields, "All", allQueued, allProcessing);
+	for ( size_t i = 0; i < times.size(); ++i )
+		setTimes(plhs[0], i + 1, fields, times[i].type, times[i].queued, times[i].processing);
+}
+
+std::string MexMessageStats::check(int nlhs, mxArray* plhs[], int nrhs, const mxArray* prhs[]) const
+{
+	if ( nrhs > 1 )
+		return "Not the right arguments for MessageStats!";
+
+	if ( nlhs != 1 )
+		return "MessageStats requires one output!";
+
+	if ( nrhs > 0 && !mxIsEmpty(prhs[0]) && mxGetNumberOfElements(prhs[0]) != 1 )
+		return "Reset must be a scalar!";
+
+	return "";
+}
+
+void MexMessageStats::usage(std::vector<std::string>& outArgs, std::vector<std::string>& inArgs) const
+{
+	outArgs.push_back("Stats");
+
+	inArgs.push_back("Reset");
+}
+
+void MexMessageStats::help(std::vector<std::string>& helpLines) const
+{
+	helpLines.push_back("This will report how long commands to the viewer waited in its queue and how long they took to run.");
+
+	helpLines.push_back("\tReset -- true to clear the timings after reading them, so the next call only covers what ran in between. [] or false keeps them.");
+	helpLines.push_back("\tStats -- A structure array, the first entry (Type 'All') covers every command, then one entry per command Type.");
+	helpLines.push_back("\t\tCount is the number of commands run. Queued* is the time from sending a command until the viewer started it,");
+	helpLines.push_back("\t\tProcessing* the time it took to run, both as the Mean, P50, P95 and P99 percentiles and Max in milliseconds.");
+	helpLines.push_back("\t\tPercentiles are within about 6% of the true value. Time spent rendering shows up as queued time of the commands behind it.");
+}
@@ -1,41 +1,50 @@
 #include "MexCommand.h"
 #include "Global/Globals.h"
 
+#include <cstring>
+
+namespace
+{
+	// Poll returns everything since the previous Poll, PollEvents callers keep their own sequence
+	uint64_t lastPolled = 0;
+}
+
 void MexPoll::execute(int nlhs, mxArray* plhs[], int nrhs, const mxArray* prhs[]) const
 {
-	std::vector<RtnMessage> curMsgs = gMsgQueueToMex.flushQueue();
+	std::vector<EventQueue::PolledEvent> curEvents;
+	EventQueue::PollResult result = gMsgQueueToMex.getEvents(lastPolled, EventQueue::allTypes(), curEvents);
+	lastPolled = result.lastSequence;
 
 	const char* fields[] = {"command", "message", "val", "array"};
-	plhs[0] = mxCreateStructMatrix(curMsgs.size(), 1, 4, fields);
 
-	for(int i = 0; i < curMsgs.size(); ++i)
+	if ( curEvents.empty() )
+	{
+		plhs[0] = mxCreateStructMatrix(1, 1, 4, fields);
+		mxSetField(plhs[0], 0, fields[0], mxCreateString("null"));
+		mxSetField(plhs[0], 0, fields[1], mxCreateString(""));
+		mxSetField(plhs[0], 0, fields[2], mxCreateDoubleScalar(-1.0));
+		mxSetField(plhs[0], 0, fields[3], mxCreateDoubleMatrix(0, 0, mxREAL));
+		return;
+	}
+
+	plhs[0] = mxCreateStructMatrix(curEvents.size(), 1, 4, fields);
+
+	for ( size_t i = 0; i < curEvents.size(); ++i )
 	{
-		RtnMessage m = curMsgs[i];
-		mxArray* cmd = mxCreateString(m.command.c_str());
-		mxArray* msg = mxCreateString(m.message.c_str());
-		mxArray* val = mxCreateDoubleScalar(m.val1);
-		mxArray* aray;
-		if(m.aray!=NULL)
-		{
-			unsigned int numRows = (unsigned int)m.val1;
-			unsigned int numCols = (unsigned int)m.val2;
-
-			size_t dims[3];
-			dims[0] = numRows;
-			dims[1] = numCols;
-			dims[2] = 3;//TODO This needs to change for any messages that are not 3D
-
-			aray = mxCreateNumericArray(3, dims, mxUINT8_CLASS, mxREAL);
-			void* arayPtr = mxGetData(aray);
-			memcpy(arayPtr, m.aray, sizeof(unsigned char)*numRows*numCols*3);
-
-			delete[] m.aray;
-		} else
-			aray = mxCreateDoubleMatrix(0, 0, mxREAL);
-
-		mxSetField(plhs[0], i, fields[0], cmd);
-		mxSetField(plhs[0], i, fields[1], msg);
-		mxSetField(plhs[0], i, fields[2], val);
+		const EventQueue::PolledEvent& polled = curEvents[i];
+
+		// Key events name the key in the message like the old string messages did
+		const char* message = polled.message.c_str();
+		if ( polled.event.key != KeyNone )
+			message = EventQueue::getKeyName(polled.event.key);
+
+		mxArray* aray = mxCreateDoubleMatrix((polled.values.empty()) ? (0) : (1), polled.values.size(), mxREAL);
+		if ( !polled.values.empty() )
+			memcpy(mxGetPr(aray), polled.values.data(), sizeof(double)*polled.values.size());
+
+		mxSetField(plhs[0], i, fields[0], mxCreateString(EventQueue::getTypeName(polled.event.type)));
+		mxSetField(plhs[0], i, fields[1], mxCreateString(message));
+		mxSetField(plhs[0], i, fields[2], mxCreateDoubleScalar(polled.event.val));
 		mxSetField(plhs[0], i, fields[3], aray);
 	}
 }
@@ -56,4 +65,4 @@ void MexPoll::usage(std::vector<std::string>& outArgs, std::vector<std::string>&
 void MexPoll::help(std::vector<std::string>& helpLines) const
 {
 	helpLines.push_back("");
-}
\ No newline at end of file
+}
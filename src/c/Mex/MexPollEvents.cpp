@@ -0,0 +1,111 @@
+#include "MexCommand.h"
+#include "Global/Globals.h"
+
+#include <cstring>
+
+void MexPollEvents::execute(int nlhs, mxArray* plhs[], int nrhs, const mxArray* prhs[]) const
+{
+	uint64_t since = 0;
+	if ( !mxIsEmpty(prhs[0]) )
+		since = uint64_t(mxGetScalar(prhs[0]));
+
+	uint32_t typeMask = EventQueue::allTypes();
+	if ( !mxIsEmpty(prhs[1]) )
+	{
+		typeMask = 0;
+		for ( size_t i = 0; i < mxGetNumberOfElements(prhs[1]); ++i )
+		{
+			char buff[96];
+			mxGetString(mxGetCell(prhs[1], i), buff, 96);
+
+			EventTypes type;
+			if ( !EventQueue::findType(buff, type) )
+			{
+				std::string errStr = std::string("Unknown event type: ") + buff;
+				mexErrMsgTxt(errStr.c_str());
+			}
+
+			typeMask |= (1u << type);
+		}
+	}
+
+	std::vector<EventQueue::PolledEvent> curEvents;
+	EventQueue::PollResult result = gMsgQueueToMex.getEvents(since, typeMask, curEvents);
+
+	const char* fields[] = {"Sequence", "Time", "Type", "Key", "Value", "Message", "Array"};
+	plhs[0] = mxCreateStructMatrix(curEvents.size(), 1, 7, fields);
+
+	for ( size_t i = 0; i < curEvents.size(); ++i )
+	{
+		const EventQueue::PolledEvent& polled = curEvents[i];
+
+		mxArray* aray = mxCreateDoubleMatrix((polled.values.empty()) ? (0) : (1), polled.values.size(), mxREAL);
+		if ( !polled.values.empty() )
+			memcpy(mxGetPr(aray), polled.values.data(), sizeof(double)*polled.values.size());
+
+		mxSetField(plhs[0], i, fields[0], mxCreateDoubleScalar(double(polled.event.sequence)));
+		mxSetField(plhs[0], i, fields[1], mxCreateDoubleScalar(polled.event.time));
+		mxSetField(plhs[0], i, fields[2], mxCreateString(EventQueue::getTypeName(polled.event.type)));
+		mxSetField(plhs[0], i, fields[3], mxCreateString(EventQueue::getKeyName(polled.event.key)));
+		mxSetField(plhs[0], i, fields[4], mxCreateDoubleScalar(polled.event.val));
+		mxSetField(plhs[0], i, fields[5], mxCreateString(polled.message.c_str()));
+		mxSetField(plhs[0], i, fields[6], aray);
+	}
+
+	if ( nlhs > 1 )
+		plhs[1] = mxCreateDoubleScalar(double(result.lastSequence));
+
+	if ( nlhs > 2 )
+		plhs[2] = mxCreateDoubleScalar(double(result.dropped));
+}
+
+std::string MexPollEvents::check(int nlhs, mxArray* plhs[], int nrhs, const mxArray* prhs[]) const
+{
+	if ( nrhs != 2 )
+		return "Not the right arguments for PollEvents!";
+
+	if ( nlhs < 1 || nlhs > 3 )
+		return "PollEvents has one to three outputs!";
+
+	if ( !mxIsEmpty(prhs[0]) && mxGetNumberOfElements(prhs[0]) != 1 )
+		return "Since must be a scalar sequence number!";
+
+	if ( !mxIsEmpty(prhs[1]) )
+	{
+		if ( !mxIsCell(prhs[1]) )
+			return "Types must be a cell array of event type names!";
+
+		// Unset cells are NULL
+		for ( size_t i = 0; i < mxGetNumberOfElements(prhs[1]); ++i )
+		{
+			const mxArray* typeName = mxGetCell(prhs[1], i);
+			if ( !typeName || !mxIsChar(typeName) )
+				return "Types must be a cell array of event type names!";
+		}
+	}
+
+	return "";
+}
+
+void MexPollEvents::usage(std::vector<std::string>& outArgs, std::vector<std::string>& inArgs) const
+{
+	outArgs.push_back("Events");
+	outArgs.push_back("LastSequence");
+	outArgs.push_back("Dropped");
+
+	inArgs.push_back("Since");
+	inArgs.push_back("Types");
+}
+
+void MexPollEvents::help(std::vector<std::string>& helpLines) const
+{
+	helpLines.push_back("This returns the viewer events newer than a sequence number, optionally only some event types.");
+
+	helpLines.push_back("\tSince -- Sequence number of the last event already handled, use 0 or [] for everything still held.");
+	helpLines.push_back("\tTypes -- Cell array of event type names to return, e.g. {'timeChange','polygonsSelected'}. Empty returns all types.");
+	helpLines.push_back("\tEvents -- A structure array with the Sequence, Time (seconds since the viewer loaded), Type, Key (for keyDown/keyUp),");
+	helpLines.push_back("\t\tValue, Message (error text) and Array (points and polygon lists) of each event, oldest first.");
+	helpLines.push_back("\t\tframeOverBudget events have Array = [FrameMs, BudgetMs, NumFrames, SlowestStage, SlowestStageMs], see FrameStats.");
+	helpLines.push_back("\tLastSequence -- Pass this as Since on the next call to get only newer events.");
+	helpLines.push_back("\tDropped -- Number of events after Since the viewer had to overwrite before they were read, the last 4096 are kept.");
+}
@@ -0,0 +1,74 @@
+#include "MexCommand.h"
+
+#include "Global/MpscRing.h"
+#include "Global/QueueBenchmark.h"
+
+void MexQueueBenchmark::execute(int nlhs, mxArray* plhs[], int nrhs, const mxArray* prhs[]) const
+{
+	size_t numItems = 1000000;
+	if ( nrhs > 0 && !mxIsEmpty(prhs[0]) )
+		numItems = size_t(mxGetScalar(prhs[0]));
+
+	int numProducers = 4;
+	if ( nrhs > 1 && !mxIsEmpty(prhs[1]) )
+		numProducers = int(mxGetScalar(prhs[1]));
+
+	QueueBenchmark::Result results[2];
+	{
+		QueueBenchmark::MutexQueue queue;
+		results[0] = QueueBenchmark::run(queue, numItems, numProducers);
+	}
+	{
+		MpscRing<QueueBenchmark::Item> queue(16384);
+		results[1] = QueueBenchmark::run(queue, numItems, numProducers);
+	}
+
+	const char* queueNames[2] = {"Mutex", "MpscRing"};
+
+	const char* fields[] = {"Queue", "MessagesPerSec", "LatencyMedianUs", "Latency99Us", "Valid"};
+	plhs[0] = mxCreateStructMatrix(2, 1, 5, fields);
+
+	for ( int i = 0; i < 2; ++i )
+	{
+		mxSetField(plhs[0], i, fields[0], mxCreateString(queueNames[i]));
+		mxSetField(plhs[0], i, fields[1], mxCreateDoubleScalar(double(numItems) / results[i].seconds));
+		mxSetField(plhs[0], i, fields[2], mxCreateDoubleScalar(results[i].latencyMedianUs));
+		mxSetField(plhs[0], i, fields[3], mxCreateDoubleScalar(results[i].latency99Us));
+		mxSetField(plhs[0], i, fields[4], mxCreateLogicalScalar(results[i].valid));
+	}
+}
+
+std::string MexQueueBenchmark::check(int nlhs, mxArray* plhs[], int nrhs, const mxArray* prhs[]) const
+{
+	if ( nrhs > 2 )
+		return "Not the right arguments for QueueBenchmark!";
+
+	if ( nlhs != 1 )
+		return "QueueBenchmark requires one output!";
+
+	if ( nrhs > 0 && !mxIsEmpty(prhs[0]) && (mxGetNumberOfElements(prhs[0]) != 1 || mxGetScalar(prhs[0]) < 1) )
+		return "NumMessages must be a positive scalar!";
+
+	if ( nrhs > 1 && !mxIsEmpty(prhs[1]) && (mxGetNumberOfElements(prhs[1]) != 1 || mxGetScalar(prhs[1]) < 1) )
+		return "Producers must be a positive scalar!";
+
+	return "";
+}
+
+void MexQueueBenchmark::usage(std::vector<std::string>& outArgs, std::vector<std::string>& inArgs) const
+{
+	outArgs.push_back("Results");
+
+	inArgs.push_back("NumMessages");
+	inArgs.push_back("Producers");
+}
+
+void MexQueueBenchmark::help(std::vector<std::string>& helpLines) const
+{
+	helpLines.push_back("This stress tests the lock-free message ring against the old mutex queue, no viewer window is needed.");
+
+	helpLines.push_back("\tNumMessages -- Optional number of messages pushed in total. Default is 10^6.");
+	helpLines.push_back("\tProducers -- Optional number of threads pushing at once, one thread consumes. Default is 4.");
+	helpLines.push_back("\tResults -- A structure array with the Queue name, MessagesPerSec through it, the median and 99th percentile push to pop");
+	helpLines.push_back("\t\tlatency in microseconds and Valid, false if any message was lost, duplicated or reordered within its producer.");
+}
@@ -0,0 +1,39 @@
+#include "MexCommand.h"
+#include "Global/Globals.h"
+
+void MexQueueStats::execute(int nlhs, mxArray* plhs[], int nrhs, const mxArray* prhs[]) const
+{
+	MessageQueue::Stats stats = gMsgQueueToDirectX.getStats();
+
+	const char* fields[] = {"Processed", "Coalesced", "Pending"};
+	plhs[0] = mxCreateStructMatrix(1, 1, 3, fields);
+
+	mxSetField(plhs[0], 0, fields[0], mxCreateDoubleScalar(double(stats.processed)));
+	mxSetField(plhs[0], 0, fields[1], mxCreateDoubleScalar(double(stats.coalesced)));
+	mxSetField(plhs[0], 0, fields[2], mxCreateDoubleScalar(double(gMsgQueueToDirectX.getNumMessages())));
+}
+
+std::string MexQueueStats::check(int nlhs, mxArray* plhs[], int nrhs, const mxArray* prhs[]) const
+{
+	if ( nrhs != 0 )
+		return "QueueStats takes no arguments!";
+
+	if ( nlhs != 1 )
+		return "QueueStats requires one output!";
+
+	return "";
+}
+
+void MexQueueStats::usage(std::vector<std::string>& outArgs, std::vector<std::string>& inArgs) const
+{
+	outArgs.push_back("Stats");
+}
+
+void MexQueueStats::help(std::vector<std::string>& helpLines) const
+{
+	helpLines.push_back("This will report the counters of the command queue to the viewer since it was loaded.");
+
+	helpLines.push_back("\tStats -- A structure with Processed, the number of commands run by the viewer, Coalesced, the number of queued");
+	helpLines.push_back("\t\tsettings commands (transfer function, frame, colors, ...) dropped because a newer one for the same target");
+	helpLines.push_back("\t\tarrived before they ran, and Pending, the commands still waiting.");
+}
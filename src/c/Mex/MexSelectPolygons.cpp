@@ -0,0 +1,68 @@
+#include "MexCommand.h"
+#include "Global/Globals.h"
+
+#include "Messages/ViewMessages.h"
+
+#include <vector>
+
+void MexSelectPolygons::execute(int nlhs, mxArray* plhs[], int nrhs, const mxArray* prhs[]) const
+{
+	size_t numPoints = mxGetM(prhs[0]);
+	double* regionData = (double*)mxGetData(prhs[0]);
+
+	// Region points come in as an (n x 2) column-major array of window pixel positions
+	std::vector<Vec<float>> region(numPoints);
+	for ( size_t i = 0; i < numPoints; ++i )
+		region[i] = Vec<float>(float(regionData[i]), float(regionData[i + numPoints]), 0.0f);
+
+	bool touching = false;
+	if ( nrhs > 1 )
+		touching = (mxGetScalar(prhs[1]) != 0.0);
+
+	if ( nlhs == 0 )
+	{
+		gMsgQueueToDirectX.pushMessage(new MessageSelectRegion(region, touching));
+		return;
+	}
+
+	std::vector<int> selected;
+	MessageStatus status = gMsgQueueToDirectX.pushMessageAndWait(new MessageSelectRegion(region, touching, &selected));
+	if ( !status.error.empty() )
+		mexErrMsgTxt(status.error.c_str());
+
+	plhs[0] = mxCreateDoubleMatrix(1, selected.size(), mxREAL);
+	double* outIndices = mxGetPr(plhs[0]);
+	for ( size_t i = 0; i < selected.size(); ++i )
+		outIndices[i] = selected[i];
+}
+
+std::string MexSelectPolygons::check(int nlhs, mxArray* plhs[], int nrhs, const mxArray* prhs[]) const
+{
+	if ( nrhs < 1 || nrhs > 2 )
+		return "Not the right arguments for SelectPolygons!";
+
+	if ( !mxIsDouble(prhs[0]) || mxGetN(prhs[0]) != 2 )
+		return "Region must be an (n x 2) double array of window pixel coordinates!";
+
+	if ( mxGetM(prhs[0]) < 2 )
+		return "Region must have at least two points!";
+
+	return "";
+}
+
+void MexSelectPolygons::usage(std::vector<std::string>& outArgs, std::vector<std::string>& inArgs) const
+{
+	outArgs.push_back("PolygonIndices");
+
+	inArgs.push_back("Region");
+	inArgs.push_back("Touching");
+}
+
+void MexSelectPolygons::help(std::vector<std::string>& helpLines) const
+{
+	helpLines.push_back("This will select all visible polygons in the current frame that fall inside a screen-space region.");
+
+	helpLines.push_back("\tRegion -- An (n x 2) array of (x,y) window pixel coordinates. Two points are treated as the corners of a rectangle, more points form a closed lasso.");
+	helpLines.push_back("\tTouching -- If true, polygons with any vertex inside the region are also selected. Otherwise only polygons whose centroids are inside are selected.");
+	helpLines.push_back("\tPolygonIndices -- The selected polygon indices. If no output is requested the selection is sent as a 'polygonsSelected' message instead.");
+}
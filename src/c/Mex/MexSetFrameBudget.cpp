@@ -0,0 +1,65 @@
+#include "MexCommand.h"
+#include "Global/Globals.h"
+
+#include "Messages/ViewMessages.h"
+
+namespace
+{
+	// Empty keeps the current setting
+	double getSetting(int nrhs, const mxArray* prhs[], int idx)
+	{
+		if ( nrhs <= idx || mxIsEmpty(prhs[idx]) )
+			return -1.0;
+
+		return mxGetScalar(prhs[idx]);
+	}
+}
+
+void MexSetFrameBudget::execute(int nlhs, mxArray* plhs[], int nrhs, const mxArray* prhs[]) const
+{
+	double targetFps = getSetting(nrhs, prhs, 0);
+	double budgetMs = getSetting(nrhs, prhs, 1);
+	int window = int(getSetting(nrhs, prhs, 2));
+
+	gMsgQueueToDirectX.pushMessage(new MessageSetFrameBudget(targetFps, budgetMs, window));
+}
+
+std::string MexSetFrameBudget::check(int nlhs, mxArray* plhs[], int nrhs, const mxArray* prhs[]) const
+{
+	if ( nrhs < 1 || nrhs > 3 )
+		return "Not the right arguments for SetFrameBudget!";
+
+	for ( int i = 0; i < nrhs; ++i )
+	{
+		if ( !mxIsEmpty(prhs[i]) && mxGetNumberOfElements(prhs[i]) != 1 )
+			return "SetFrameBudget arguments must be scalars or []!";
+	}
+
+	if ( !mxIsEmpty(prhs[0]) && mxGetScalar(prhs[0]) <= 0.0 )
+		return "TargetFps must be positive!";
+
+	if ( nrhs > 1 && !mxIsEmpty(prhs[1]) && mxGetScalar(prhs[1]) < 0.0 )
+		return "BudgetMs must be non-negative!";
+
+	if ( nrhs > 2 && !mxIsEmpty(prhs[2]) && (mxGetScalar(prhs[2]) < 1.0 || mxGetScalar(prhs[2]) > 1.0e6) )
+		return "Window must be between 1 and 1000000 frames!";
+
+	return "";
+}
+
+void MexSetFrameBudget::usage(std::vector<std::string>& outArgs, std::vector<std::string>& inArgs) const
+{
+	inArgs.push_back("TargetFps");
+	inArgs.push_back("BudgetMs");
+	inArgs.push_back("Window");
+}
+
+void MexSetFrameBudget::help(std::vector<std::string>& helpLines) const
+{
+	helpLines.push_back("This sets what the frame statistics measure rendering against. Pass [] to keep a setting as it is.");
+
+	helpLines.push_back("\tTargetFps -- Display rate, a frame longer than 1/TargetFps counts the intervals it missed as dropped frames. Default is 60.");
+	helpLines.push_back("\tBudgetMs -- Optional, frames longer than this send a frameOverBudget event (see PollEvents).");
+	helpLines.push_back("\t\tDefault is 0, which uses the target frame interval.");
+	helpLines.push_back("\tWindow -- Optional number of most recent frames the FrameStats percentiles cover. Default is 600.");
+}
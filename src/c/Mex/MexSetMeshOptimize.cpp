@@ -0,0 +1,36 @@
+#include "MexCommand.h"
+#include "Global/Globals.h"
+
+#include "Messages/ViewMessages.h"
+
+void MexSetMeshOptimize::execute(int nlhs, mxArray* plhs[], int nrhs, const mxArray* prhs[]) const
+{
+	bool optimize = (mxGetScalar(prhs[0]) != 0.0);
+
+	gMsgQueueToDirectX.pushMessage(new MessageSetMeshOptimize(optimize));
+}
+
+std::string MexSetMeshOptimize::check(int nlhs, mxArray* plhs[], int nrhs, const mxArray* prhs[]) const
+{
+	if ( nrhs != 1 )
+		return "Not the right arguments for SetMeshOptimize!";
+
+	if ( mxGetNumberOfElements(prhs[0]) != 1 )
+		return "On must be a scalar!";
+
+	return "";
+}
+
+void MexSetMeshOptimize::usage(std::vector<std::string>& outArgs, std::vector<std::string>& inArgs) const
+{
+	inArgs.push_back("On");
+}
+
+void MexSetMeshOptimize::help(std::vector<std::string>& helpLines) const
+{
+	helpLines.push_back("This turns vertex cache optimization of newly added polygons on or off. It is on by default.");
+
+	helpLines.push_back("\tOn -- When true, faces of each new mesh are reordered for GPU vertex cache reuse and its vertices for fetch locality.");
+	helpLines.push_back("\t\tThe drawn triangles do not change. Decimated levels of detail have their faces reordered as well.");
+	helpLines.push_back("\tUse MeshStats to see the average cache miss ratio (ACMR) of the optimized meshes before and after.");
+}
@@ -0,0 +1,60 @@
+#include "MexCommand.h"
+#include "Global/Globals.h"
+
+#include "Messages/ViewMessages.h"
+
+void MexSetPolygonLod::execute(int nlhs, mxArray* plhs[], int nrhs, const mxArray* prhs[]) const
+{
+	float errorPixels = float(mxGetScalar(prhs[0]));
+
+	std::vector<float> levelPixels;
+	if ( nrhs > 1 && !mxIsEmpty(prhs[1]) )
+	{
+		double* sizes = (double*)mxGetData(prhs[1]);
+		levelPixels.resize(mxGetNumberOfElements(prhs[1]));
+		for ( size_t i = 0; i < levelPixels.size(); ++i )
+			levelPixels[i] = float(sizes[i]);
+	}
+
+	gMsgQueueToDirectX.pushMessage(new MessageSetPolygonLod(errorPixels, levelPixels));
+}
+
+std::string MexSetPolygonLod::check(int nlhs, mxArray* plhs[], int nrhs, const mxArray* prhs[]) const
+{
+	if ( nrhs < 1 || nrhs > 2 )
+		return "Not the right arguments for SetPolygonLod!";
+
+	if ( mxGetNumberOfElements(prhs[0]) != 1 || mxGetScalar(prhs[0]) < 0.0 )
+		return "ErrorBound must be a non-negative scalar!";
+
+	if ( nrhs > 1 && !mxIsEmpty(prhs[1]) )
+	{
+		if ( !mxIsDouble(prhs[1]) || mxGetNumberOfElements(prhs[1]) != ResourceCache::numLodLevels-1 )
+			return "LevelSizes must be a double array with one pixel size per decimated level!";
+
+		double* sizes = (double*)mxGetData(prhs[1]);
+		for ( size_t i = 1; i < mxGetNumberOfElements(prhs[1]); ++i )
+		{
+			if ( sizes[i] >= sizes[i-1] )
+				return "LevelSizes must be decreasing!";
+		}
+	}
+
+	return "";
+}
+
+void MexSetPolygonLod::usage(std::vector<std::string>& outArgs, std::vector<std::string>& inArgs) const
+{
+	inArgs.push_back("ErrorBound");
+	inArgs.push_back("LevelSizes");
+}
+
+void MexSetPolygonLod::help(std::vector<std::string>& helpLines) const
+{
+	helpLines.push_back("This sets how polygons are decimated into lower levels of detail for hulls that are small on screen.");
+
+	helpLines.push_back("\tErrorBound -- The largest on-screen deviation in pixels a decimated level may introduce. Default is 1, 0 always draws full detail.");
+	helpLines.push_back("\tLevelSizes -- Optional decreasing pixel sizes [level1,level2]. A hull uses a level once its projected bounding box");
+	helpLines.push_back("\t\tdiagonal is smaller than that level's size. Default is [128,32].");
+	helpLines.push_back("\tUse MeshStats to see the face counts of each level and how many faces were drawn in the last frame.");
+}
@@ -0,0 +1,150 @@
+#include "MexCommand.h"
+#include "Global/Globals.h"
+
+#include "Messages/ViewMessages.h"
+
+void MexSetPolygonState::execute(int nlhs, mxArray* plhs[], int nrhs, const mxArray* prhs[]) const
+{
+	MessageSetPolygonState* stateMsg = new MessageSetPolygonState();
+	NodeRegistry::BulkState& state = stateMsg->getState();
+
+	// Indices can be a list of polygon indices or a logical mask where element i selects polygon i
+	size_t numSelected = mxGetNumberOfElements(prhs[0]);
+	if ( mxIsLogical(prhs[0]) )
+	{
+		mxLogical* mask = mxGetLogicals(prhs[0]);
+		for ( size_t i = 0; i < numSelected; ++i )
+		{
+			if ( mask[i] )
+				state.indices.push_back(int(i + 1));
+		}
+
+		// An empty mask selects nothing rather than everything
+		if ( state.indices.empty() )
+		{
+			delete stateMsg;
+			return;
+		}
+	}
+	else
+	{
+		double* indices = (double*)mxGetData(prhs[0]);
+		state.indices.resize(numSelected);
+		for ( size_t i = 0; i < numSelected; ++i )
+			state.indices[i] = int(indices[i]);
+	}
+
+	if ( nrhs > 1 && !mxIsEmpty(prhs[1]) )
+	{
+		size_t numVisible = mxGetNumberOfElements(prhs[1]);
+		state.visible.resize(numVisible);
+
+		if ( mxIsLogical(prhs[1]) )
+		{
+			mxLogical* visible = mxGetLogicals(prhs[1]);
+			for ( size_t i = 0; i < numVisible; ++i )
+				state.visible[i] = (visible[i]) ? 1 : 0;
+		}
+		else
+		{
+			double* visible = (double*)mxGetData(prhs[1]);
+			for ( size_t i = 0; i < numVisible; ++i )
+				state.visible[i] = (visible[i] != 0.0) ? 1 : 0;
+		}
+	}
+
+	if ( nrhs > 2 && mxIsChar(prhs[2]) )
+	{
+		// 'none' goes back to the meshes' own vertex colors
+		state.clearColors = true;
+	}
+	else if ( nrhs > 2 && !mxIsEmpty(prhs[2]) )
+	{
+		// Colors are (n x 3) or (n x 4) with alpha in the last column
+		size_t numColors = mxGetM(prhs[2]);
+		size_t numCols = mxGetN(prhs[2]);
+		double* colors = (double*)mxGetData(prhs[2]);
+
+		state.colors.resize(numColors);
+		state.alphas.resize(numColors);
+		for ( size_t i = 0; i < numColors; ++i )
+		{
+			state.colors[i] = Vec<float>(float(colors[i]), float(colors[i + numColors]), float(colors[i + 2*numColors]));
+			state.alphas[i] = (numCols > 3) ? float(colors[i + 3*numColors]) : 1.0f;
+		}
+	}
+
+	if ( nrhs > 3 && !mxIsEmpty(prhs[3]) )
+		state.wireframe = (mxGetScalar(prhs[3]) != 0.0) ? 1 : 0;
+
+	gMsgQueueToDirectX.pushMessage(stateMsg);
+}
+
+std::string MexSetPolygonState::check(int nlhs, mxArray* plhs[], int nrhs, const mxArray* prhs[]) const
+{
+	if ( nrhs < 2 || nrhs > 4 )
+		return "Not the right arguments for SetPolygonState!";
+
+	if ( !mxIsDouble(prhs[0]) && !mxIsLogical(prhs[0]) )
+		return "PolygonIndices must be a double index list or a logical mask!";
+
+	// Per-polygon values must line up with the selected polygons
+	size_t numSelected = mxGetNumberOfElements(prhs[0]);
+	if ( mxIsLogical(prhs[0]) )
+	{
+		mxLogical* mask = mxGetLogicals(prhs[0]);
+
+		numSelected = 0;
+		for ( size_t i = 0; i < mxGetNumberOfElements(prhs[0]); ++i )
+			numSelected += (mask[i]) ? 1 : 0;
+	}
+
+	if ( !mxIsEmpty(prhs[1]) )
+	{
+		if ( !mxIsDouble(prhs[1]) && !mxIsLogical(prhs[1]) )
+			return "Visible must be a double or logical array!";
+
+		size_t numVisible = mxGetNumberOfElements(prhs[1]);
+		if ( numVisible != 1 && (mxIsEmpty(prhs[0]) || numVisible != numSelected) )
+			return "Visible must be a scalar or have one entry per selected polygon!";
+	}
+
+	if ( nrhs > 2 && mxIsChar(prhs[2]) )
+	{
+		char buff[8];
+		if ( mxGetString(prhs[2], buff, sizeof(buff)) != 0 || _strcmpi(buff, "none") != 0 )
+			return "Colors must be a double array or 'none'!";
+	}
+	else if ( nrhs > 2 && !mxIsEmpty(prhs[2]) )
+	{
+		if ( !mxIsDouble(prhs[2]) )
+			return "Colors must be a double array or 'none'!";
+
+		if ( mxGetN(prhs[2]) != 3 && mxGetN(prhs[2]) != 4 )
+			return "Colors must be (n x 3) or (n x 4) with alpha in the last column!";
+
+		size_t numColors = mxGetM(prhs[2]);
+		if ( numColors != 1 && (mxIsEmpty(prhs[0]) || numColors != numSelected) )
+			return "Colors must be a single row or have one row per selected polygon!";
+	}
+
+	return "";
+}
+
+void MexSetPolygonState::usage(std::vector<std::string>& outArgs, std::vector<std::string>& inArgs) const
+{
+	inArgs.push_back("PolygonIndices");
+	inArgs.push_back("Visible");
+	inArgs.push_back("Colors");
+	inArgs.push_back("Wireframe");
+}
+
+void MexSetPolygonState::help(std::vector<std::string>& helpLines) const
+{
+	helpLines.push_back("This will update the visibility, color and wireframe state of many polygons in a single pass.");
+
+	helpLines.push_back("\tPolygonIndices -- A list of polygon indices or a logical mask where element i selects polygon i. An empty list selects all polygons.");
+	helpLines.push_back("\tVisible -- Empty to leave visibility unchanged, a scalar for all selected polygons, or one value per selected polygon.");
+	helpLines.push_back("\tColors -- Empty to leave colors unchanged, a single (1 x 3) or (1 x 4) color, or one row per selected polygon. The optional fourth column is alpha. 'none' clears the colors back to each polygon's own vertex colors.");
+	helpLines.push_back("\tWireframe -- Empty to leave unchanged, otherwise turns wireframe rendering on or off for the selected polygons.");
+}
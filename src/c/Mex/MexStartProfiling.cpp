@@ -0,0 +1,27 @@
+#include "MexCommand.h"
+
+#include "Global/Profiler.h"
+
+void MexStartProfiling::execute(int nlhs, mxArray* plhs[], int nrhs, const mxArray* prhs[]) const
+{
+	Profiler::start();
+}
+
+std::string MexStartProfiling::check(int nlhs, mxArray* plhs[], int nrhs, const mxArray* prhs[]) const
+{
+	if ( nrhs != 0 )
+		return "StartProfiling takes no arguments!";
+
+	return "";
+}
+
+void MexStartProfiling::usage(std::vector<std::string>& outArgs, std::vector<std::string>& inArgs) const
+{
+}
+
+void MexStartProfiling::help(std::vector<std::string>& helpLines) const
+{
+	helpLines.push_back("This will start timing the viewer's rendering, command processing and loading, anything recorded before is cleared.");
+
+	helpLines.push_back("\tUse WriteProfile to save the timings as a trace and StopProfiling to stop recording them.");
+}
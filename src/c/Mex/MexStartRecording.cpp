@@ -0,0 +1,40 @@
+#include "MexCommand.h"
+#include "Global/Globals.h"
+
+#include <memory>
+
+void MexStartRecording::execute(int nlhs, mxArray* plhs[], int nrhs, const mxArray* prhs[]) const
+{
+	char filePath[1024];
+	mxGetString(prhs[0], filePath, 1024);
+
+	std::shared_ptr<CommandLogWriter> recorder = std::make_shared<CommandLogWriter>();
+	if ( !recorder->open(filePath) )
+		mexErrMsgTxt("Could not create the command log file!");
+
+	// Replaces (and closes) a recording that is already running
+	gMsgQueueToDirectX.setRecorder(recorder);
+}
+
+std::string MexStartRecording::check(int nlhs, mxArray* plhs[], int nrhs, const mxArray* prhs[]) const
+{
+	if ( nrhs != 1 || !mxIsChar(prhs[0]) )
+		return "Not the right arguments for StartRecording!";
+
+	return "";
+}
+
+void MexStartRecording::usage(std::vector<std::string>& outArgs, std::vector<std::string>& inArgs) const
+{
+	inArgs.push_back("File");
+}
+
+void MexStartRecording::help(std::vector<std::string>& helpLines) const
+{
+	helpLines.push_back("This will record every command sent to the viewer into a command log until StopRecording is called.");
+
+	helpLines.push_back("\tFile -- Path of the log to write, an existing file is replaced.");
+	helpLines.push_back("\t\tThe log can be replayed without MATLAB by the standalone viewer: d3dStandalone -replay File [-max] [-report ReportFile].");
+	helpLines.push_back("\t\tStart recording before InitVolume so the replay has a volume to work with. Images and meshes are stored once however often they are sent.");
+	helpLines.push_back("\t\tCaptures, outputs and Close are not recorded.");
+}
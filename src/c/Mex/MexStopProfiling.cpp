@@ -0,0 +1,25 @@
+#include "MexCommand.h"
+
+#include "Global/Profiler.h"
+
+void MexStopProfiling::execute(int nlhs, mxArray* plhs[], int nrhs, const mxArray* prhs[]) const
+{
+	Profiler::stop();
+}
+
+std::string MexStopProfiling::check(int nlhs, mxArray* plhs[], int nrhs, const mxArray* prhs[]) const
+{
+	if ( nrhs != 0 )
+		return "StopProfiling takes no arguments!";
+
+	return "";
+}
+
+void MexStopProfiling::usage(std::vector<std::string>& outArgs, std::vector<std::string>& inArgs) const
+{
+}
+
+void MexStopProfiling::help(std::vector<std::string>& helpLines) const
+{
+	helpLines.push_back("This will stop recording timings, what was recorded is kept for WriteProfile until the next StartProfiling.");
+}
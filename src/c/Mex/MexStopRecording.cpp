@@ -0,0 +1,51 @@
+#include "MexCommand.h"
+#include "Global/Globals.h"
+
+#include <memory>
+
+void MexStopRecording::execute(int nlhs, mxArray* plhs[], int nrhs, const mxArray* prhs[]) const
+{
+	std::shared_ptr<CommandLogWriter> recorder = gMsgQueueToDirectX.getRecorder();
+	gMsgQueueToDirectX.setRecorder(NULL);
+
+	if ( !recorder )
+		mexErrMsgTxt("No command log is being recorded!");
+
+	// A push that picked up the recorder before it was cleared finishes its record first
+	recorder->close();
+
+	if ( recorder->hasWriteFailed() )
+		mexErrMsgTxt("Writing the command log failed (is the disk full?), the log is incomplete!");
+
+	if ( nlhs < 1 )
+		return;
+
+	const char* fields[] = {"Recorded", "Skipped", "Bytes"};
+	plhs[0] = mxCreateStructMatrix(1, 1, 3, fields);
+
+	mxSetField(plhs[0], 0, fields[0], mxCreateDoubleScalar(double(recorder->getNumRecorded())));
+	mxSetField(plhs[0], 0, fields[1], mxCreateDoubleScalar(double(recorder->getNumSkipped())));
+	mxSetField(plhs[0], 0, fields[2], mxCreateDoubleScalar(double(recorder->getBytesWritten())));
+}
+
+std::string MexStopRecording::check(int nlhs, mxArray* plhs[], int nrhs, const mxArray* prhs[]) const
+{
+	if ( nrhs != 0 )
+		return "StopRecording takes no arguments!";
+
+	return "";
+}
+
+void MexStopRecording::usage(std::vector<std::string>& outArgs, std::vector<std::string>& inArgs) const
+{
+	outArgs.push_back("Stats");
+}
+
+void MexStopRecording::help(std::vector<std::string>& helpLines) const
+{
+	helpLines.push_back("This will stop the command log started with StartRecording and close its file.");
+
+	helpLines.push_back("\tStats -- A structure with the number of commands Recorded, the number Skipped because they can't be replayed,");
+	helpLines.push_back("\t\tand the size of the log in Bytes.");
+	helpLines.push_back("\t\tIt is an error if any part of the log could not be written, the file is then incomplete.");
+}
@@ -5,7 +5,9 @@
 
 void MexTakeControl::execute(int nlhs, mxArray* plhs[], int nrhs, const mxArray* prhs[]) const
 {
-	gMsgQueueToDirectX.pushMessage(new MessageTakeControl(),true);
+	MessageStatus status = gMsgQueueToDirectX.pushMessageAndWait(new MessageTakeControl());
+	if ( !status.error.empty() )
+		mexErrMsgTxt(status.error.c_str());
 }
 
 std::string MexTakeControl::check(int nlhs, mxArray* plhs[], int nrhs, const mxArray* prhs[]) const
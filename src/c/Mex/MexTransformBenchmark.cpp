@@ -0,0 +1,143 @@
+#include "MexCommand.h"
+
+#include "D3d/TransformKernels.h"
+
+#include <Eigen/Dense>
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <vector>
+
+#undef min
+#undef max
+
+namespace
+{
+	// Best of several runs so page faults and other threads don't skew the numbers
+	template <typename F>
+	double bestSeconds(int repeats, F func)
+	{
+		double best = HUGE_VAL;
+		for ( int i = 0; i < repeats; ++i )
+		{
+			std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+			func();
+			best = std::min(best, std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count());
+		}
+
+		return best;
+	}
+
+	float maxDifference(const std::vector<Vec<float>>& a, const std::vector<Vec<float>>& b)
+	{
+		float maxDiff = 0.0f;
+		for ( size_t i = 0; i < a.size(); ++i )
+		{
+			for ( int d = 0; d < 3; ++d )
+				maxDiff = std::max(maxDiff, std::abs(a[i].e[d] - b[i].e[d]));
+		}
+
+		return maxDiff;
+	}
+}
+
+void MexTransformBenchmark::execute(int nlhs, mxArray* plhs[], int nrhs, const mxArray* prhs[]) const
+{
+	size_t numVerts = 10000000;
+	if ( nrhs > 0 && !mxIsEmpty(prhs[0]) )
+		numVerts = size_t(mxGetScalar(prhs[0]));
+
+	int repeats = 5;
+	if ( nrhs > 1 && !mxIsEmpty(prhs[1]) )
+		repeats = int(mxGetScalar(prhs[1]));
+
+	// A typical image to model transform, anisotropic scale and a translation
+	Eigen::Affine3f transform = Eigen::Scaling(1.0f, 1.0f, 0.25f) * Eigen::Translation3f(-1.0f, -1.0f, -1.0f)
+		* Eigen::Scaling(2.0f / 512.0f, 2.0f / 512.0f, 2.0f / 64.0f);
+	Eigen::Matrix4f imToModel = transform.matrix();
+	TransformKernels::Affine affine = TransformKernels::Affine::fromColumnMajor(imToModel.data());
+
+	std::vector<Vec<float>> source(numVerts);
+	for ( size_t i = 0; i < numVerts; ++i )
+		source[i] = Vec<float>(float(i % 512), float((i / 512) % 512), float((i * 2654435761u) % 64));
+
+	std::vector<Vec<float>> reference(numVerts);
+	std::vector<Vec<float>> result(numVerts);
+
+	// The per vertex Eigen loop VolumeInfo::imageToModelSpace used before the kernels
+	double eigenSeconds = bestSeconds(repeats, [&]()
+	{
+		for ( size_t i = 0; i < numVerts; ++i )
+		{
+			Eigen::Vector4f newVert(source[i].x, source[i].y, source[i].z, 1.0f);
+			newVert = imToModel * newVert;
+
+			reference[i] = Vec<float>(newVert[0], newVert[1], newVert[2]);
+		}
+	});
+
+	const int numKernels = 3;
+	const char* kernelNames[numKernels] = {"EigenLoop", "Scalar", "Kernel"};
+	double seconds[numKernels] = {eigenSeconds, 0.0, 0.0};
+	float errors[numKernels] = {0.0f, 0.0f, 0.0f};
+
+	seconds[1] = bestSeconds(repeats, [&]()
+	{
+		TransformKernels::transformPointsScalar(affine, source.data(), result.data(), numVerts);
+	});
+	errors[1] = maxDifference(reference, result);
+
+	seconds[2] = bestSeconds(repeats, [&]()
+	{
+		TransformKernels::transformPoints(affine, source.data(), result.data(), numVerts);
+	});
+	errors[2] = maxDifference(reference, result);
+
+	const char* fields[] = {"Kernel", "MVertsPerSec", "Speedup", "MaxError", "Avx2"};
+	plhs[0] = mxCreateStructMatrix(numKernels, 1, 5, fields);
+
+	for ( int i = 0; i < numKernels; ++i )
+	{
+		mxSetField(plhs[0], i, fields[0], mxCreateString(kernelNames[i]));
+		mxSetField(plhs[0], i, fields[1], mxCreateDoubleScalar(double(numVerts) / (seconds[i] * 1e6)));
+		mxSetField(plhs[0], i, fields[2], mxCreateDoubleScalar(eigenSeconds / seconds[i]));
+		mxSetField(plhs[0], i, fields[3], mxCreateDoubleScalar(double(errors[i])));
+		mxSetField(plhs[0], i, fields[4], mxCreateLogicalScalar(i == 2 && TransformKernels::hasAvx2()));
+	}
+}
+
+std::string MexTransformBenchmark::check(int nlhs, mxArray* plhs[], int nrhs, const mxArray* prhs[]) const
+{
+	if ( nrhs > 2 )
+		return "Not the right arguments for TransformBenchmark!";
+
+	if ( nlhs != 1 )
+		return "TransformBenchmark requires one output!";
+
+	if ( nrhs > 0 && !mxIsEmpty(prhs[0]) && (mxGetNumberOfElements(prhs[0]) != 1 || mxGetScalar(prhs[0]) < 1) )
+		return "NumVerts must be a positive scalar!";
+
+	if ( nrhs > 1 && !mxIsEmpty(prhs[1]) && (mxGetNumberOfElements(prhs[1]) != 1 || mxGetScalar(prhs[1]) < 1) )
+		return "Repeats must be a positive scalar!";
+
+	return "";
+}
+
+void MexTransformBenchmark::usage(std::vector<std::string>& outArgs, std::vector<std::string>& inArgs) const
+{
+	outArgs.push_back("Results");
+
+	inArgs.push_back("NumVerts");
+	inArgs.push_back("Repeats");
+}
+
+void MexTransformBenchmark::help(std::vector<std::string>& helpLines) const
+{
+	helpLines.push_back("This times the image to model vertex transform with the old per vertex Eigen loop and the batch transform kernels.");
+
+	helpLines.push_back("\tNumVerts -- Optional number of vertices to transform per run. Default is 10^7.");
+	helpLines.push_back("\tRepeats -- Optional number of runs, the fastest run is reported. Default is 5.");
+	helpLines.push_back("\tResults -- A structure array with the Kernel name, millions of vertices transformed per second, the Speedup over");
+	helpLines.push_back("\t\tthe Eigen loop, the MaxError against it and whether the AVX2 path was used. Kernel is threaded above 2^18 vertices.");
+}
@@ -0,0 +1,49 @@
+#include "MexCommand.h"
+
+#include "Global/Profiler.h"
+
+void MexWriteProfile::execute(int nlhs, mxArray* plhs[], int nrhs, const mxArray* prhs[]) const
+{
+	char filePath[1024];
+	mxGetString(prhs[0], filePath, 1024);
+
+	Profiler::Stats stats;
+	if ( !Profiler::writeChromeTrace(filePath, stats) )
+		mexErrMsgTxt("Could not write the profile file!");
+
+	if ( nlhs < 1 )
+		return;
+
+	const char* fields[] = {"Zones", "Threads", "Dropped"};
+	plhs[0] = mxCreateStructMatrix(1, 1, 3, fields);
+
+	mxSetField(plhs[0], 0, fields[0], mxCreateDoubleScalar(double(stats.zones)));
+	mxSetField(plhs[0], 0, fields[1], mxCreateDoubleScalar(double(stats.threads)));
+	mxSetField(plhs[0], 0, fields[2], mxCreateDoubleScalar(double(stats.dropped)));
+}
+
+std::string MexWriteProfile::check(int nlhs, mxArray* plhs[], int nrhs, const mxArray* prhs[]) const
+{
+	if ( nrhs != 1 || !mxIsChar(prhs[0]) )
+		return "Not the right arguments for WriteProfile!";
+
+	return "";
+}
+
+void MexWriteProfile::usage(std::vector<std::string>& outArgs, std::vector<std::string>& inArgs) const
+{
+	outArgs.push_back("Stats");
+
+	inArgs.push_back("File");
+}
+
+void MexWriteProfile::help(std::vector<std::string>& helpLines) const
+{
+	helpLines.push_back("This will save the timings recorded since StartProfiling as a Chrome trace, it can be called while still recording.");
+
+	helpLines.push_back("\tFile -- Path of the JSON file to write, open it in chrome://tracing or https://ui.perfetto.dev.");
+	helpLines.push_back("\t\tEach thread (Render and the Worker pool) is a row of nested zones: frames and their render stages,");
+	helpLines.push_back("\t\tmaterial updates, scene traversal, every command by its message type and the texture and polygon load work.");
+	helpLines.push_back("\tStats -- A structure with the number of Zones and Threads written, and the zones Dropped because a thread recorded");
+	helpLines.push_back("\t\tmore than its buffer holds (about a million zones per thread).");
+}
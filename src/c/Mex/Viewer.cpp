@@ -1,6 +1,7 @@
 #define DLL_EXPORT_SYM __declspec(dllexport)
 #include "MexCommand.h"
 #include "Global/Globals.h"
+#include "Global/ThreadPool.h"
 
 #include "Messages/Threads.h"
 #include "Messages/LoadMessages.h"
@@ -14,10 +15,16 @@ MEXFUNCTION_LINKAGE void mexFunction(int nlhs, mxArray* plhs[], int nrhs, const
 
 extern "C" void exitFunc()
 {
-	gMsgQueueToDirectX.pushMessage(new MessageClose(), true);
+	gMsgQueueToDirectX.pushMessageAndWait(new MessageClose());
 
 	cleanUp();
 
 	gMsgQueueToMex.clear();
 	gMsgQueueToDirectX.clear();
+
+	// Closes a command log that was never stopped
+	gMsgQueueToDirectX.setRecorder(NULL);
+
+	// Workers have to be gone before the module is unloaded
+	ThreadPool::shutdownShared();
 }
\ No newline at end of file
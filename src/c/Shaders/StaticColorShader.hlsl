@@ -4,12 +4,15 @@ cbuffer VSConstantBuffer : register( b0 )
 	matrix View;
 	matrix Projection;
 	float4 depthPeelPlanes;
+	float4 positionScale;
+	float4 positionOffset;
 };
 
 cbuffer PSConstantBuffer : register( b1 )
 {
 	float4 flags;
 	float4 colorModifier;
+	float4 colorOverride;
 };
 
 struct VS_OUTPUT
@@ -38,10 +41,18 @@ VS_OUTPUT StaticColorVS_PNC( float4 Pos : POSITION, float3 Normal : NORMAL, floa
 	return output;
 }
 
+// Compact layout, positions are snorm16 over the mesh bounds and normals are biased into 10:10:10:2 unorm
+VS_OUTPUT StaticColorVS_PNCPacked( float4 Pos : POSITION, float4 Normal : NORMAL, float4 Color : COLOR )
+{
+	float4 modelPos = float4(Pos.xyz * positionScale.xyz + positionOffset.xyz, 1.0);
+
+	return StaticColorVS_PNC(modelPos, Normal.xyz * 2.0 - 1.0, Color);
+}
+
 float4 StaticColorPS( VS_OUTPUT input ) : SV_TARGET
 {
 	float4 mainLightDir = float4(-0.5774,-0.5774,0.5774,0);
-	float3 cval = input.Color;
+	float3 cval = lerp(input.Color.xyz, colorOverride.xyz, colorOverride.w);
 
 	if(flags.x>0)
 	{
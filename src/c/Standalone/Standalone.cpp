@@ -1,17 +1,29 @@
 #include "Global/Globals.h"
 #include "Global/ModuleInfo.h"
 #include "D3d/MessageProcessor.h"
+#include "Messages/CommandLog.h"
 #include "Messages/LoadMessages.h"
+#include "Messages/RenderMessages.h"
 #include "Messages/ViewMessages.h"
 
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <functional>
 #include <random>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
 
-unsigned char* createRandomVolume(int numChannels, Vec<size_t> dims)
+std::vector<unsigned char> createRandomVolume(int numChannels, Vec<size_t> dims)
 {
 	std::mt19937 mtRNG;
 	std::uniform_int_distribution<int> unifDist(0,255);
 
-	unsigned char* pixelVals = new unsigned char[numChannels*dims.product()];
+	std::vector<unsigned char> pixelVals(numChannels*dims.product());
 	for ( int c = 0; c < numChannels; ++c )
 	{
 		for ( int i=0; i < dims.product(); ++i )
@@ -23,6 +35,134 @@ unsigned char* createRandomVolume(int numChannels, Vec<size_t> dims)
 	return pixelVals;
 }
 
+
+// Command line: -replay <log> [-max] [-report <file>]
+struct ReplayOptions
+{
+	ReplayOptions() : maxSpeed(false) {}
+
+	std::string logPath;
+	std::string reportPath;
+
+	// Push every command as soon as the previous one is queued instead of at its recorded time
+	bool maxSpeed;
+};
+
+bool parseReplayOptions(int argc, char** argv, ReplayOptions& optionsOut)
+{
+	for ( int i = 1; i < argc; ++i )
+	{
+		std::string arg = argv[i];
+
+		if ( arg == "-replay" && i+1 < argc )
+			optionsOut.logPath = argv[++i];
+		else if ( arg == "-report" && i+1 < argc )
+			optionsOut.reportPath = argv[++i];
+		else if ( arg == "-max" )
+			optionsOut.maxSpeed = true;
+	}
+
+	if ( optionsOut.logPath.empty() )
+		return false;
+
+	if ( optionsOut.reportPath.empty() )
+		optionsOut.reportPath = optionsOut.logPath + ".csv";
+
+	return true;
+}
+
+void writeReplayReport(const std::string& path, std::vector<MessageQueue::TypeTimes>& times, size_t numCommands, double wallSeconds, const std::string& error)
+{
+	FILE* file = fopen(path.c_str(), "w");
+	if ( !file )
+		return;
+
+	const double nsToMs = 1.0e-6;
+
+	std::sort(times.begin(), times.end(), [](const MessageQueue::TypeTimes& a, const MessageQueue::TypeTimes& b){return a.type < b.type;});
+
+	MessageQueue::TypeTimes all;
+	all.type = "All";
+	for ( const MessageQueue::TypeTimes& typeTimes : times )
+	{
+		all.queued.add(typeTimes.queued);
+		all.processing.add(typeTimes.processing);
+	}
+
+	times.insert(times.begin(), all);
+
+	fprintf(file, "# Replayed %zu commands in %.3f s%s%s\n", numCommands, wallSeconds, error.empty() ? "" : ", stopped early: ", error.c_str());
+	fprintf(file, "Type,Count,QueuedMean,QueuedP50,QueuedP95,QueuedP99,QueuedMax,ProcessingMean,ProcessingP50,ProcessingP95,ProcessingP99,ProcessingMax\n");
+
+	for ( const MessageQueue::TypeTimes& typeTimes : times )
+	{
+		fprintf(file, "%s,%llu", typeTimes.type.c_str(), (unsigned long long)typeTimes.queued.getCount());
+
+		const LatencyHistogram* hists[2] = {&typeTimes.queued, &typeTimes.processing};
+		for ( const LatencyHistogram* hist : hists )
+		{
+			fprintf(file, ",%.4f,%.4f,%.4f,%.4f,%.4f", hist->getMean() * nsToMs,
+				double(hist->getPercentile(0.50)) * nsToMs, double(hist->getPercentile(0.95)) * nsToMs,
+				double(hist->getPercentile(0.99)) * nsToMs, double(hist->getMax()) * nsToMs);
+		}
+
+		fprintf(file, "\n");
+	}
+
+	fclose(file);
+}
+
+// Feeds a recorded command log to the render thread, then writes the queue timings and closes the window.
+// Runs on its own thread so the render thread sees the commands arrive the way they did from MATLAB.
+void replayCommands(CommandLogReader& reader, const ReplayOptions& options, const std::atomic<bool>& stop)
+{
+	while ( !gRendererInit )
+	{
+		if ( stop )
+			return;
+
+		std::this_thread::sleep_for(std::chrono::milliseconds(10));
+	}
+
+	// Only time the replayed commands
+	std::vector<MessageQueue::TypeTimes> times;
+	gMsgQueueToDirectX.getTimes(times, true);
+	times.clear();
+
+	std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+
+	size_t numCommands = 0;
+	CommandLogReader::Entry entry;
+	while ( !stop && reader.next(entry) )
+	{
+		if ( !options.maxSpeed )
+			std::this_thread::sleep_until(start + std::chrono::duration_cast<std::chrono::steady_clock::duration>(std::chrono::duration<double>(entry.time)));
+
+		// Commands MATLAB waited on are waited on here too, so nothing is queued behind them that wasn't originally
+		if ( entry.waited )
+		{
+			if ( !gMsgQueueToDirectX.pushMessageAndWait(entry.message).processed )
+				break;
+		}
+		else if ( !gMsgQueueToDirectX.pushMessage(entry.message) )
+		{
+			break;
+		}
+
+		++numCommands;
+	}
+
+	// Everything pushed has been processed once this comes back
+	gMsgQueueToDirectX.pushMessageAndWait(new MessageUpdateRender());
+
+	double wallSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+	gMsgQueueToDirectX.getTimes(times, false);
+	writeReplayReport(options.reportPath, times, numCommands, wallSeconds, reader.getError());
+
+	PostMessage(gWindowHandle, WM_CLOSE, 0, 0);
+}
+
 int CALLBACK WinMain(HINSTANCE hInstance, HINSTANCE hPrevInstance, LPSTR lpCmdLine, int nCmdShow)
 {
 	ModuleInfo::setModuleHandle(hInstance);
@@ -32,24 +172,46 @@ int CALLBACK WinMain(HINSTANCE hInstance, HINSTANCE hPrevInstance, LPSTR lpCmdLi
 
 	gUpdateShaders = true;
 
+	ReplayOptions replayOptions;
+	if ( parseReplayOptions(__argc, __argv, replayOptions) )
+	{
+		std::string error;
+
+		// Texture loads point into the reader's payloads, it has to outlive the render thread
+		CommandLogReader reader;
+		if ( !reader.open(replayOptions.logPath, error) )
+		{
+			MessageBoxA(NULL, error.c_str(), "Replay", MB_OK | MB_ICONERROR);
+			return 1;
+		}
+
+		std::atomic<bool> stopReplay(false);
+		std::thread replayThread(replayCommands, std::ref(reader), std::cref(replayOptions), std::cref(stopReplay));
+
+		SetProcessDPIAware();
+		messageLoop(pRootDir);
+
+		stopReplay = true;
+		replayThread.join();
+
+		return 0;
+	}
+
 	// Queue up a random volume to render
 	const bool columnMajor = false;
 	const int numChan = 2;
 	const Vec<size_t> dims(128,128,50);
 	const Vec<float> physSize = 1.0f * dims;
 
-	unsigned char* pixelVals = createRandomVolume(numChan, dims);
+	std::vector<unsigned char> pixelVals = createRandomVolume(numChan, dims);
 
 	// Setup demo noise volume
 	gMsgQueueToDirectX.pushMessage(new MessageInitVolume(1, numChan, dims, physSize, columnMajor));
-	gMsgQueueToDirectX.pushMessage(new MessageLoadTexture(GraphicObjectTypes::OriginalVolume, pixelVals));
+	gMsgQueueToDirectX.pushMessage(new MessageLoadTexture(GraphicObjectTypes::OriginalVolume, std::move(pixelVals)));
 	gMsgQueueToDirectX.pushMessage(new MessageUpdateRender());
 
 	SetProcessDPIAware();
 	messageLoop(pRootDir);
 
-	// This is sort of a leak, but we can't delete the image data until application close.
-	delete[] pixelVals;
-
 	return 0;
 }
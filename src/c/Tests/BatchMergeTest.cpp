@@ -0,0 +1,351 @@
+#include "TestUtils.h"
+
+#include "D3d/BatchMerge.h"
+
+#include <cstring>
+#include <random>
+#include <vector>
+
+namespace
+{
+	// Float PNC vertex as VertexLayout interleaves it
+	struct PNCVertex
+	{
+		float pos[3];
+		float norm[3];
+		float color[4];
+	};
+
+	struct TestMesh
+	{
+		std::vector<Vec<float>> vertices;
+		std::vector<Vec<float>> normals;
+		std::vector<Color> colors;
+		std::vector<Vec<uint32_t>> lodFaces[BatchMerge::maxLods];
+	};
+
+	TestMesh makeMesh(std::mt19937& rng, uint32_t numVerts, int numLods, bool withNormals, bool withColors)
+	{
+		std::uniform_real_distribution<float> coord(-10.0f, 10.0f);
+		std::uniform_real_distribution<float> unit(0.0f, 1.0f);
+
+		TestMesh mesh;
+		for ( uint32_t i = 0; i < numVerts; ++i )
+		{
+			mesh.vertices.push_back(Vec<float>(coord(rng), coord(rng), coord(rng)));
+			if ( withNormals )
+				mesh.normals.push_back(Vec<float>(unit(rng), unit(rng), unit(rng)));
+			if ( withColors )
+				mesh.colors.push_back(Color(unit(rng), unit(rng), unit(rng), unit(rng)));
+		}
+
+		// Each level has fewer faces, like the decimated levels
+		std::uniform_int_distribution<uint32_t> vert(0, numVerts-1);
+		for ( int lod = 0; lod < numLods; ++lod )
+		{
+			uint32_t numFaces = 2 * numVerts / (lod + 1);
+			for ( uint32_t f = 0; f < numFaces; ++f )
+				mesh.lodFaces[lod].push_back(Vec<uint32_t>(vert(rng), vert(rng), vert(rng)));
+		}
+
+		return mesh;
+	}
+
+	TransformKernels::Affine makeTransform(float angle, Vec<float> scale, Vec<float> translate)
+	{
+		TransformKernels::Affine tfm = TransformKernels::Affine::identity();
+		tfm.m[0][0] = std::cos(angle) * scale.x;
+		tfm.m[0][1] = -std::sin(angle) * scale.y;
+		tfm.m[1][0] = std::sin(angle) * scale.x;
+		tfm.m[1][1] = std::cos(angle) * scale.y;
+		tfm.m[2][2] = scale.z;
+
+		tfm.m[0][3] = translate.x;
+		tfm.m[1][3] = translate.y;
+		tfm.m[2][3] = translate.z;
+
+		return tfm;
+	}
+
+	// makeTransform is a rotation times a scale, so its inverse transpose is the same rotation over the scale
+	TransformKernels::Affine makeNormalTransform(float angle, Vec<float> scale)
+	{
+		return makeTransform(angle, Vec<float>(1.0f / scale.x, 1.0f / scale.y, 1.0f / scale.z), Vec<float>(0.0f, 0.0f, 0.0f));
+	}
+
+	Vec<float> applyPoint(const TransformKernels::Affine& tfm, const Vec<float>& pnt)
+	{
+		Vec<float> out;
+		for ( int r = 0; r < 3; ++r )
+			out.e[r] = tfm.m[r][0]*pnt.x + tfm.m[r][1]*pnt.y + tfm.m[r][2]*pnt.z + tfm.m[r][3];
+
+		return out;
+	}
+
+	Vec<float> applyVector(const TransformKernels::Affine& tfm, const Vec<float>& vec)
+	{
+		Vec<float> out;
+		for ( int r = 0; r < 3; ++r )
+			out.e[r] = tfm.m[r][0]*vec.x + tfm.m[r][1]*vec.y + tfm.m[r][2]*vec.z;
+
+		return out;
+	}
+
+	// Normals keep their mesh length, only their direction changes
+	Vec<float> applyNormal(const TransformKernels::Affine& normalTfm, Vec<float> norm)
+	{
+		Vec<float> out = applyVector(normalTfm, norm);
+		return out * float(norm.length() / out.length());
+	}
+
+	// Assigns buffer ranges the way PolygonBatch::build does, one index section per LOD level
+	std::vector<BatchMerge::Hull> makeHulls(const std::vector<TestMesh>& meshes, const std::vector<TransformKernels::Affine>& transforms,
+		std::mt19937& rng)
+	{
+		std::uniform_real_distribution<float> unit(0.0f, 1.0f);
+
+		std::vector<BatchMerge::Hull> hulls(meshes.size());
+
+		uint32_t vertOffset = 0;
+		for ( size_t i = 0; i < meshes.size(); ++i )
+		{
+			BatchMerge::Hull& hull = hulls[i];
+			const TestMesh& mesh = meshes[i];
+
+			hull.vertices = &mesh.vertices;
+			hull.normals = &mesh.normals;
+			hull.colors = &mesh.colors;
+			hull.localToFrame = transforms[i];
+
+			hull.color = Vec<float>(unit(rng), unit(rng), unit(rng));
+			hull.alpha = unit(rng);
+			hull.useColor = (i % 2 == 1);
+
+			hull.firstVert = vertOffset;
+			hull.numVerts = uint32_t(mesh.vertices.size());
+			vertOffset += hull.numVerts;
+
+			hull.numLods = 0;
+			for ( int lod = 0; lod < BatchMerge::maxLods; ++lod )
+			{
+				hull.lodFaces[lod] = &mesh.lodFaces[lod];
+				hull.firstFace[lod] = 0;
+				hull.numFaces[lod] = uint32_t(mesh.lodFaces[lod].size());
+				if ( !mesh.lodFaces[lod].empty() )
+					hull.numLods = lod + 1;
+			}
+		}
+
+		uint32_t faceOffset = 0;
+		for ( int lod = 0; lod < BatchMerge::maxLods; ++lod )
+		{
+			for ( BatchMerge::Hull& hull : hulls )
+			{
+				hull.firstFace[lod] = faceOffset;
+				faceOffset += (lod < hull.numLods) ? hull.numFaces[lod] : 0;
+			}
+		}
+
+		return hulls;
+	}
+
+	void checkMerged(const std::vector<TestMesh>& meshes, const std::vector<BatchMerge::Hull>& hulls,
+		const std::vector<TransformKernels::Affine>& normalTransforms, const std::vector<uint8_t>& vertMem, const std::vector<Vec<uint32_t>>& faces)
+	{
+		size_t totalVerts = 0;
+		size_t totalFaces = 0;
+		for ( const BatchMerge::Hull& hull : hulls )
+		{
+			totalVerts += hull.numVerts;
+			for ( int lod = 0; lod < hull.numLods; ++lod )
+				totalFaces += hull.numFaces[lod];
+		}
+
+		CHECK(vertMem.size() == totalVerts * sizeof(PNCVertex));
+		CHECK(faces.size() == totalFaces);
+		if ( vertMem.size() != totalVerts * sizeof(PNCVertex) || faces.size() != totalFaces )
+			return;
+
+		const PNCVertex* verts = (const PNCVertex*)vertMem.data();
+		for ( size_t i = 0; i < hulls.size(); ++i )
+		{
+			const BatchMerge::Hull& hull = hulls[i];
+			const TestMesh& mesh = meshes[i];
+
+			for ( uint32_t v = 0; v < hull.numVerts; ++v )
+			{
+				const PNCVertex& vert = verts[hull.firstVert + v];
+
+				Vec<float> pos = applyPoint(hull.localToFrame, mesh.vertices[v]);
+				Vec<float> norm = (v < mesh.normals.size()) ? applyNormal(normalTransforms[i], mesh.normals[v]) : Vec<float>(0.0f, 0.0f, 0.0f);
+				for ( int c = 0; c < 3; ++c )
+				{
+					CHECK_NEAR(vert.pos[c], pos.e[c], 1e-4);
+					CHECK_NEAR(vert.norm[c], norm.e[c], 1e-4);
+				}
+
+				// Override color keeps the vertex alpha, alpha always scales it
+				Color meshColor = (v < mesh.colors.size()) ? mesh.colors[v] : Color(1.0f, 1.0f, 1.0f, 1.0f);
+				Color expected = (hull.useColor) ? Color(hull.color, meshColor.a) : meshColor;
+				expected.a *= hull.alpha;
+
+				CHECK_NEAR(vert.color[0], expected.r, 1e-6);
+				CHECK_NEAR(vert.color[1], expected.g, 1e-6);
+				CHECK_NEAR(vert.color[2], expected.b, 1e-6);
+				CHECK_NEAR(vert.color[3], expected.a, 1e-6);
+			}
+
+			// Every level's faces land in that level's section, offset to the hull's vertices
+			for ( int lod = 0; lod < hull.numLods; ++lod )
+			{
+				for ( uint32_t f = 0; f < hull.numFaces[lod]; ++f )
+				{
+					const Vec<uint32_t>& face = faces[hull.firstFace[lod] + f];
+					CHECK(face == mesh.lodFaces[lod][f] + hull.firstVert);
+					CHECK(face.maxValue() < hull.firstVert + hull.numVerts);
+				}
+			}
+		}
+	}
+
+	void testSmallBatch()
+	{
+		std::mt19937 rng(7);
+
+		// Different LOD counts, a mesh without normals and one without colors
+		std::vector<TestMesh> meshes;
+		meshes.push_back(makeMesh(rng, 12, 3, true, true));
+		meshes.push_back(makeMesh(rng, 5, 1, true, true));
+		meshes.push_back(makeMesh(rng, 9, 2, false, false));
+
+		std::vector<TransformKernels::Affine> transforms;
+		transforms.push_back(makeTransform(0.0f, Vec<float>(1.0f, 1.0f, 1.0f), Vec<float>(3.0f, -2.0f, 1.5f)));
+		transforms.push_back(makeTransform(1.5707963f, Vec<float>(2.0f, 0.5f, 3.0f), Vec<float>(0.0f, 0.0f, 0.0f)));
+		transforms.push_back(makeTransform(0.3f, Vec<float>(1.0f, 1.0f, 1.0f), Vec<float>(-4.0f, 5.0f, 0.25f)));
+
+		std::vector<TransformKernels::Affine> normalTransforms;
+		normalTransforms.push_back(makeNormalTransform(0.0f, Vec<float>(1.0f, 1.0f, 1.0f)));
+		normalTransforms.push_back(makeNormalTransform(1.5707963f, Vec<float>(2.0f, 0.5f, 3.0f)));
+		normalTransforms.push_back(makeNormalTransform(0.3f, Vec<float>(1.0f, 1.0f, 1.0f)));
+
+		std::vector<BatchMerge::Hull> hulls = makeHulls(meshes, transforms, rng);
+
+		CHECK(hulls[0].numLods == 3 && hulls[1].numLods == 1 && hulls[2].numLods == 2);
+
+		// Level 1 section starts after all the level 0 faces, hull 1 has nothing there
+		CHECK(hulls[0].firstFace[1] == hulls[2].firstFace[0] + hulls[2].numFaces[0]);
+		CHECK(hulls[2].firstFace[1] == hulls[0].firstFace[1] + hulls[0].numFaces[1]);
+
+		std::vector<uint8_t> vertMem;
+		std::vector<Vec<uint32_t>> faces;
+		BatchMerge::merge(hulls, VertexLayout(VertexLayout::Types::PNC), vertMem, faces);
+
+		checkMerged(meshes, hulls, normalTransforms, vertMem, faces);
+
+		// A hull without normals gets zero normals
+		const PNCVertex* verts = (const PNCVertex*)vertMem.data();
+		const PNCVertex& noNormal = verts[hulls[2].firstVert];
+		CHECK(noNormal.norm[0] == 0.0f && noNormal.norm[1] == 0.0f && noNormal.norm[2] == 0.0f);
+	}
+
+	void testParallelBatch()
+	{
+		std::mt19937 rng(11);
+
+		// Enough hulls to be split over several merge tasks
+		std::vector<TestMesh> meshes;
+		std::vector<TransformKernels::Affine> transforms;
+		std::vector<TransformKernels::Affine> normalTransforms;
+		for ( int i = 0; i < 500; ++i )
+		{
+			Vec<float> scale(1.0f + 0.01f*i, 1.0f, 0.5f);
+
+			meshes.push_back(makeMesh(rng, 3 + i % 40, 1 + i % BatchMerge::maxLods, (i % 5) != 0, (i % 7) != 0));
+			transforms.push_back(makeTransform(0.01f * i, scale, Vec<float>(float(i), -float(i), 0.5f*i)));
+			normalTransforms.push_back(makeNormalTransform(0.01f * i, scale));
+		}
+
+		std::vector<BatchMerge::Hull> hulls = makeHulls(meshes, transforms, rng);
+
+		std::vector<uint8_t> vertMem;
+		std::vector<Vec<uint32_t>> faces;
+		BatchMerge::merge(hulls, VertexLayout(VertexLayout::Types::PNC), vertMem, faces);
+
+		checkMerged(meshes, hulls, normalTransforms, vertMem, faces);
+	}
+
+	void testSkewedNormals()
+	{
+		// A slanted quad's normal has to stay perpendicular to it when the scale stretches it unevenly
+		TestMesh mesh;
+		mesh.vertices.push_back(Vec<float>(0.0f, 0.0f, 0.0f));
+		mesh.vertices.push_back(Vec<float>(1.0f, 1.0f, 0.0f));
+		mesh.vertices.push_back(Vec<float>(1.0f, 1.0f, 1.0f));
+		mesh.vertices.push_back(Vec<float>(0.0f, 0.0f, 1.0f));
+		for ( int v = 0; v < 4; ++v )
+			mesh.normals.push_back(Vec<float>(0.70710678f, -0.70710678f, 0.0f));
+		mesh.lodFaces[0].push_back(Vec<uint32_t>(0, 1, 2));
+		mesh.lodFaces[0].push_back(Vec<uint32_t>(0, 2, 3));
+
+		std::vector<TestMesh> meshes(1, mesh);
+		std::vector<TransformKernels::Affine> transforms(1, makeTransform(0.4f, Vec<float>(4.0f, 0.5f, 2.0f), Vec<float>(1.0f, 2.0f, 3.0f)));
+
+		std::mt19937 rng(3);
+		std::vector<BatchMerge::Hull> hulls = makeHulls(meshes, transforms, rng);
+
+		std::vector<uint8_t> vertMem;
+		std::vector<Vec<uint32_t>> faces;
+		BatchMerge::merge(hulls, VertexLayout(VertexLayout::Types::PNC), vertMem, faces);
+
+		CHECK(vertMem.size() == 4 * sizeof(PNCVertex));
+		if ( vertMem.size() != 4 * sizeof(PNCVertex) )
+			return;
+
+		const PNCVertex* verts = (const PNCVertex*)vertMem.data();
+		Vec<float> pos[4];
+		for ( int v = 0; v < 4; ++v )
+			pos[v] = Vec<float>(verts[v].pos[0], verts[v].pos[1], verts[v].pos[2]);
+
+		Vec<float> edgeA = pos[1] - pos[0];
+		Vec<float> edgeB = pos[3] - pos[0];
+		for ( int v = 0; v < 4; ++v )
+		{
+			Vec<float> norm(verts[v].norm[0], verts[v].norm[1], verts[v].norm[2]);
+			CHECK_NEAR(norm.length(), 1.0, 1e-5);
+			CHECK_NEAR(norm.x*edgeA.x + norm.y*edgeA.y + norm.z*edgeA.z, 0.0, 1e-5);
+			CHECK_NEAR(norm.x*edgeB.x + norm.y*edgeB.y + norm.z*edgeB.z, 0.0, 1e-5);
+		}
+	}
+
+	void testBakeColors()
+	{
+		std::vector<Color> meshColors;
+		meshColors.push_back(Color(0.1f, 0.2f, 0.3f, 0.5f));
+
+		// Missing vertex colors are white, the override keeps the vertex alpha
+		std::vector<Color> baked;
+		BatchMerge::bakeColors(meshColors, 2, Vec<float>(1.0f, 0.0f, 0.0f), 0.5f, true, baked);
+
+		CHECK(baked.size() == 2);
+		CHECK_NEAR(baked[0].r, 1.0f, 0.0);
+		CHECK_NEAR(baked[0].g, 0.0f, 0.0);
+		CHECK_NEAR(baked[0].a, 0.25f, 1e-7);
+		CHECK_NEAR(baked[1].a, 0.5f, 1e-7);
+
+		BatchMerge::bakeColors(meshColors, 2, Vec<float>(1.0f, 0.0f, 0.0f), 1.0f, false, baked);
+		CHECK_NEAR(baked[0].g, 0.2f, 1e-7);
+		CHECK_NEAR(baked[1].g, 1.0f, 0.0);
+	}
+}
+
+int main()
+{
+	CHECK(VertexLayout(VertexLayout::Types::PNC).getVertSize() == sizeof(PNCVertex));
+
+	testSmallBatch();
+	testParallelBatch();
+	testSkewedNormals();
+	testBakeColors();
+
+	return TestUtils::finish("BatchMergeTest");
+}
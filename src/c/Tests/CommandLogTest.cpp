@@ -0,0 +1,233 @@
+#include "TestUtils.h"
+
+#include "Messages/Message.h"
+
+#include <cstdio>
+#include <cstring>
+#include <random>
+#include <string>
+#include <vector>
+
+namespace
+{
+	const char* logPath = "CommandLogTest.log";
+
+	typedef std::vector<unsigned char> Bytes;
+
+	// Carries one payload through the log
+	class MessagePayload : public Message
+	{
+	public:
+		MessagePayload(const Bytes& data) : data(data) {}
+
+		const Bytes& getData() const {return data;}
+
+	protected:
+		virtual bool process() {return true;}
+
+		virtual bool writeLog(CommandLogWriter& log) const
+		{
+			log.writeType(LogLoadTexture);
+			log.writePayload(data.data(), data.size());
+			return true;
+		}
+
+	private:
+		Bytes data;
+	};
+
+	Bytes makeBytes(std::mt19937& rng, size_t size)
+	{
+		std::uniform_int_distribution<int> byte(0, 255);
+
+		Bytes bytes(size);
+		for ( unsigned char& b : bytes )
+			b = (unsigned char)byte(rng);
+
+		return bytes;
+	}
+
+	Bytes makeWords(uint64_t first, uint64_t second)
+	{
+		Bytes bytes(2*sizeof(uint64_t));
+		memcpy(bytes.data(), &first, sizeof(first));
+		memcpy(bytes.data() + sizeof(first), &second, sizeof(second));
+
+		return bytes;
+	}
+
+	// State of CommandLogWriter::hashPayload after the first word of a 16 byte payload
+	uint64_t hashAfterFirstWord(uint64_t word)
+	{
+		uint64_t hash = (0xCBF29CE484222325ull ^ uint64_t(16) ^ word) * 0x100000001B3ull;
+		return hash ^ (hash >> 29);
+	}
+
+	void recordAll(const std::vector<Bytes>& payloads, uint64_t& bytesOut)
+	{
+		CommandLogWriter writer;
+		CHECK(writer.open(logPath));
+
+		for ( const Bytes& payload : payloads )
+		{
+			MessagePayload message(payload);
+			writer.record(&message, false);
+		}
+
+		writer.close();
+
+		CHECK(!writer.hasWriteFailed());
+		CHECK(writer.getNumRecorded() == payloads.size());
+
+		bytesOut = writer.getBytesWritten();
+	}
+
+	void checkReplay(const std::vector<Bytes>& payloads)
+	{
+		CommandLogReader reader;
+		std::string error;
+		CHECK(reader.open(logPath, error));
+
+		for ( const Bytes& payload : payloads )
+		{
+			CommandLogReader::Entry entry;
+			CHECK(reader.next(entry));
+			if ( !entry.message )
+				return;
+
+			CHECK(entry.type == LogLoadTexture);
+			CHECK(((MessagePayload*)entry.message)->getData() == payload);
+			delete entry.message;
+		}
+
+		CommandLogReader::Entry entry;
+		CHECK(!reader.next(entry));
+		CHECK(reader.getError().empty());
+	}
+
+	// Header, one payload record per distinct payload and one message record (time, waited, type, key) per message
+	uint64_t expectedBytes(const std::vector<Bytes>& payloads, size_t numDistinct, size_t distinctBytes)
+	{
+		const uint64_t recordHeader = sizeof(uint8_t) + sizeof(uint64_t);
+		const uint64_t messageRecord = recordHeader + sizeof(double) + sizeof(uint8_t) + sizeof(uint16_t) + sizeof(uint64_t);
+
+		return 8 + numDistinct*(recordHeader + sizeof(uint64_t)) + distinctBytes + payloads.size()*messageRecord;
+	}
+
+	void testRepeatedPayloads()
+	{
+		std::mt19937 rng(3);
+
+		// Bigger than one read back piece, so the comparison has to go through several
+		Bytes big = makeBytes(rng, 3*1024*1024 + 17);
+		Bytes small = makeBytes(rng, 100);
+		Bytes empty;
+
+		std::vector<Bytes> payloads;
+		payloads.push_back(small);
+		payloads.push_back(big);
+		payloads.push_back(small);
+		payloads.push_back(empty);
+		payloads.push_back(big);
+		payloads.push_back(empty);
+
+		uint64_t bytes;
+		recordAll(payloads, bytes);
+
+		// Each is stored once
+		CHECK(bytes == expectedBytes(payloads, 3, big.size() + small.size()));
+		checkReplay(payloads);
+	}
+
+	void testHashCollision()
+	{
+		// The hash mixes each word into its state, so a second word can cancel out a different first word
+		uint64_t firstA = 0x0123456789ABCDEFull;
+		uint64_t firstB = 0xFEDCBA9876543210ull;
+		uint64_t secondA = 42;
+		uint64_t secondB = secondA ^ hashAfterFirstWord(firstA) ^ hashAfterFirstWord(firstB);
+
+		Bytes a = makeWords(firstA, secondA);
+		Bytes b = makeWords(firstB, secondB);
+		CHECK(a != b);
+		CHECK(CommandLogWriter::hashPayload(a.data(), a.size()) == CommandLogWriter::hashPayload(b.data(), b.size()));
+
+		// A bigger payload with the same hash as neither, differing only in its last byte from a later one
+		std::mt19937 rng(8);
+		Bytes c = makeBytes(rng, 5000);
+		Bytes d = c;
+		d.back() ^= 1;
+
+		std::vector<Bytes> payloads;
+		payloads.push_back(a);
+		payloads.push_back(b);
+		payloads.push_back(a);
+		payloads.push_back(b);
+		payloads.push_back(c);
+		payloads.push_back(d);
+
+		uint64_t bytes;
+		recordAll(payloads, bytes);
+
+		// Both colliding payloads are kept, each under its own key
+		CHECK(bytes == expectedBytes(payloads, 4, a.size() + b.size() + c.size() + d.size()));
+		checkReplay(payloads);
+	}
+
+	void testWriteFailure()
+	{
+#ifndef _WIN32
+		std::mt19937 rng(1);
+
+		// Small enough to sit in the stdio buffer, it only fails on the final flush
+		{
+			CommandLogWriter writer;
+			CHECK(writer.open("/dev/full"));
+
+			MessagePayload message(makeBytes(rng, 64));
+			writer.record(&message, false);
+			writer.close();
+
+			CHECK(writer.hasWriteFailed());
+		}
+
+		// Too big for the buffer, fails while recording and nothing more is written
+		{
+			CommandLogWriter writer;
+			CHECK(writer.open("/dev/full"));
+
+			MessagePayload message(makeBytes(rng, 1024*1024));
+			writer.record(&message, false);
+			CHECK(writer.hasWriteFailed());
+
+			uint64_t bytes = writer.getBytesWritten();
+			writer.record(&message, false);
+			CHECK(writer.getBytesWritten() == bytes);
+
+			writer.close();
+			CHECK(writer.hasWriteFailed());
+		}
+#endif
+	}
+}
+
+// Every record in these logs is a MessagePayload
+Message* CommandLogReader::createMessage(LoggedMessages)
+{
+	const std::vector<unsigned char>* payload = readPayload();
+	if ( !payload )
+		return NULL;
+
+	return new MessagePayload(*payload);
+}
+
+int main()
+{
+	testRepeatedPayloads();
+	testHashCollision();
+	testWriteFailure();
+
+	remove(logPath);
+
+	return TestUtils::finish("CommandLogTest");
+}
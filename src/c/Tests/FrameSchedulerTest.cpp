@@ -0,0 +1,122 @@
+#include "TestUtils.h"
+
+#include "D3d/FrameScheduler.h"
+
+#include <chrono>
+
+namespace
+{
+	typedef FrameScheduler::Clock Clock;
+
+	// Fake clock, every test starts at the same arbitrary point and moves time by hand
+	Clock::time_point at(double seconds)
+	{
+		return Clock::time_point(std::chrono::hours(1)) + std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double>(seconds));
+	}
+
+	double toSeconds(Clock::duration duration)
+	{
+		return std::chrono::duration<double>(duration).count();
+	}
+
+	void testWholePeriods()
+	{
+		FrameScheduler scheduler;
+		CHECK(scheduler.timeUntilNext(at(0.0)) == Clock::duration::max());
+
+		// First fire is one period after starting
+		scheduler.setTimer(FrameScheduler::Play, true, 0.25, at(0.0));
+		CHECK(scheduler.takeElapsed(FrameScheduler::Play, at(0.1)) == 0);
+		CHECK_NEAR(toSeconds(scheduler.timeUntilNext(at(0.1))), 0.15, 1e-9);
+
+		// Waking a little late doesn't push the next deadline back
+		CHECK(scheduler.takeElapsed(FrameScheduler::Play, at(0.26)) == 1);
+		CHECK(scheduler.takeElapsed(FrameScheduler::Play, at(0.26)) == 0);
+		CHECK_NEAR(toSeconds(scheduler.timeUntilNext(at(0.26))), 0.24, 1e-9);
+
+		// Exactly on the deadline fires
+		CHECK(scheduler.takeElapsed(FrameScheduler::Play, at(0.5)) == 1);
+		CHECK_NEAR(toSeconds(scheduler.timeUntilNext(at(0.5))), 0.25, 1e-9);
+
+		// Firing on time many times keeps the average rate
+		int fired = 0;
+		for ( int i = 1; i <= 400; ++i )
+			fired += scheduler.takeElapsed(FrameScheduler::Play, at(0.5 + 0.01*i));
+
+		CHECK(fired == 16);
+	}
+
+	void testLateWakeup()
+	{
+		FrameScheduler scheduler;
+		scheduler.setTimer(FrameScheduler::Rotate, true, 0.25, at(0.0));
+
+		// A long stall reports every missed period at once instead of firing them one by one
+		CHECK(scheduler.takeElapsed(FrameScheduler::Rotate, at(1.3)) == 5);
+		CHECK(scheduler.takeElapsed(FrameScheduler::Rotate, at(1.3)) == 0);
+
+		// The next deadline stays on the original grid
+		CHECK_NEAR(toSeconds(scheduler.timeUntilNext(at(1.3))), 0.2, 1e-9);
+		CHECK(scheduler.takeElapsed(FrameScheduler::Rotate, at(1.49)) == 0);
+		CHECK(scheduler.takeElapsed(FrameScheduler::Rotate, at(1.5)) == 1);
+
+		// Overdue timers don't report a negative wait
+		CHECK(scheduler.timeUntilNext(at(10.0)) == Clock::duration::zero());
+	}
+
+	void testPeriodChanges()
+	{
+		FrameScheduler scheduler;
+		scheduler.setTimer(FrameScheduler::Play, true, 0.25, at(0.0));
+
+		// Same settings keep the deadline
+		scheduler.setTimer(FrameScheduler::Play, true, 0.25, at(0.2));
+		CHECK(scheduler.takeElapsed(FrameScheduler::Play, at(0.25)) == 1);
+
+		// A new period restarts from now
+		scheduler.setTimer(FrameScheduler::Play, true, 1.0, at(0.3));
+		CHECK(scheduler.takeElapsed(FrameScheduler::Play, at(1.29)) == 0);
+		CHECK(scheduler.takeElapsed(FrameScheduler::Play, at(1.3)) == 1);
+		CHECK(scheduler.takeElapsed(FrameScheduler::Play, at(3.35)) == 2);
+		CHECK_NEAR(toSeconds(scheduler.timeUntilNext(at(3.35))), 0.95, 1e-9);
+
+		// Stopping, and a non-positive period, turn the timer off
+		scheduler.setTimer(FrameScheduler::Play, false, 1.0, at(4.0));
+		CHECK(scheduler.takeElapsed(FrameScheduler::Play, at(100.0)) == 0);
+		CHECK(scheduler.timeUntilNext(at(100.0)) == Clock::duration::max());
+
+		scheduler.setTimer(FrameScheduler::Play, true, 0.0, at(100.0));
+		CHECK(scheduler.takeElapsed(FrameScheduler::Play, at(200.0)) == 0);
+
+		// Restarting after a stop waits a full period even with the old period
+		scheduler.setTimer(FrameScheduler::Play, true, 1.0, at(200.0));
+		CHECK(scheduler.takeElapsed(FrameScheduler::Play, at(200.5)) == 0);
+		CHECK(scheduler.takeElapsed(FrameScheduler::Play, at(201.0)) == 1);
+	}
+
+	void testSeveralTimers()
+	{
+		FrameScheduler scheduler;
+		scheduler.setTimer(FrameScheduler::Play, true, 0.5, at(0.0));
+		scheduler.setTimer(FrameScheduler::Rotate, true, 0.2, at(0.0));
+		scheduler.setTimer(FrameScheduler::ShaderReload, true, 1.0, at(0.0));
+
+		// The loop blocks until the earliest deadline, timers fire independently
+		CHECK_NEAR(toSeconds(scheduler.timeUntilNext(at(0.0))), 0.2, 1e-9);
+		CHECK(scheduler.takeElapsed(FrameScheduler::Rotate, at(0.45)) == 2);
+		CHECK_NEAR(toSeconds(scheduler.timeUntilNext(at(0.45))), 0.05, 1e-9);
+		CHECK(scheduler.takeElapsed(FrameScheduler::Play, at(0.5)) == 1);
+		CHECK(scheduler.takeElapsed(FrameScheduler::ShaderReload, at(0.5)) == 0);
+		CHECK_NEAR(toSeconds(scheduler.timeUntilNext(at(0.5))), 0.1, 1e-9);
+	}
+}
+
+int main()
+{
+	testWholePeriods();
+	testLateWakeup();
+	testPeriodChanges();
+	testSeveralTimers();
+
+	return TestUtils::finish("FrameSchedulerTest");
+}
@@ -0,0 +1,213 @@
+#include "TestUtils.h"
+
+#include "D3d/MeshOptimizer.h"
+
+#include <algorithm>
+#include <array>
+#include <random>
+#include <vector>
+
+namespace
+{
+	// Corner positions and normals of one triangle
+	typedef std::array<float, 18> Triangle;
+	typedef std::array<float, 6> Vertex;
+
+	Vertex getVertex(const std::vector<Vec<float>>& vertices, const std::vector<Vec<float>>& normals, uint32_t idx)
+	{
+		Vec<float> norm = (idx < normals.size()) ? normals[idx] : Vec<float>(0.0f, 0.0f, 0.0f);
+
+		Vertex vert = {{vertices[idx].x, vertices[idx].y, vertices[idx].z, norm.x, norm.y, norm.z}};
+		return vert;
+	}
+
+	// Rotated to start at the smallest corner, so the same triangle compares equal only if its winding is the same
+	Triangle getTriangle(const std::vector<Vec<float>>& vertices, const std::vector<Vec<float>>& normals, const Vec<uint32_t>& face)
+	{
+		Triangle rotations[3];
+		for ( int r = 0; r < 3; ++r )
+		{
+			for ( int c = 0; c < 3; ++c )
+			{
+				Vertex vert = getVertex(vertices, normals, face.e[(r + c) % 3]);
+				std::copy(vert.begin(), vert.end(), rotations[r].begin() + 6*c);
+			}
+		}
+
+		return *std::min_element(rotations, rotations + 3);
+	}
+
+	std::vector<Triangle> getTriangles(const std::vector<Vec<uint32_t>>& faces, const std::vector<Vec<float>>& vertices, const std::vector<Vec<float>>& normals)
+	{
+		std::vector<Triangle> triangles;
+		for ( const Vec<uint32_t>& face : faces )
+			triangles.push_back(getTriangle(vertices, normals, face));
+
+		std::sort(triangles.begin(), triangles.end());
+		return triangles;
+	}
+
+	std::vector<Vertex> getVertices(const std::vector<Vec<float>>& vertices, const std::vector<Vec<float>>& normals)
+	{
+		std::vector<Vertex> verts;
+		for ( uint32_t i = 0; i < vertices.size(); ++i )
+			verts.push_back(getVertex(vertices, normals, i));
+
+		std::sort(verts.begin(), verts.end());
+		return verts;
+	}
+
+	// Height field grid with shuffled faces, like an isosurface that arrives in no useful order
+	void makeGrid(int size, bool withNormals, std::mt19937& rng, std::vector<Vec<uint32_t>>& faces, std::vector<Vec<float>>& vertices,
+		std::vector<Vec<float>>& normals)
+	{
+		for ( int i = 0; i < size; ++i )
+		{
+			for ( int j = 0; j < size; ++j )
+			{
+				vertices.push_back(Vec<float>(float(i), float(j), float((i*j) % 7)));
+				if ( withNormals )
+					normals.push_back(Vec<float>(float(i), -float(j), 1.0f));
+			}
+		}
+
+		for ( int i = 0; i < size-1; ++i )
+		{
+			for ( int j = 0; j < size-1; ++j )
+			{
+				uint32_t a = i*size + j;
+				uint32_t b = a + 1;
+				uint32_t c = a + size;
+				uint32_t d = c + 1;
+
+				faces.push_back(Vec<uint32_t>(a, b, c));
+				faces.push_back(Vec<uint32_t>(b, d, c));
+			}
+		}
+
+		std::shuffle(faces.begin(), faces.end(), rng);
+	}
+
+	void checkOptimize(std::vector<Vec<uint32_t>> faces, std::vector<Vec<float>> vertices, std::vector<Vec<float>> normals)
+	{
+		std::vector<Triangle> trianglesBefore = getTriangles(faces, vertices, normals);
+		std::vector<Vertex> verticesBefore = getVertices(vertices, normals);
+		size_t missesBefore = MeshOptimizer::countCacheMisses(faces, vertices.size());
+		size_t numNormals = normals.size();
+
+		MeshOptimizer::Result result = MeshOptimizer::optimize(faces, vertices, normals);
+
+		CHECK(result.faces == faces.size());
+		CHECK(normals.size() == numNormals);
+
+		// Same triangles with the same winding, and the same vertices
+		CHECK(getTriangles(faces, vertices, normals) == trianglesBefore);
+		CHECK(getVertices(vertices, normals) == verticesBefore);
+
+		for ( const Vec<uint32_t>& face : faces )
+			CHECK(face.maxValue() < vertices.size());
+
+		// Never worse for the cache than the original order
+		size_t missesAfter = MeshOptimizer::countCacheMisses(faces, vertices.size());
+		CHECK(result.missesBefore == missesBefore);
+		CHECK(result.missesAfter == missesAfter);
+		CHECK(missesAfter <= missesBefore);
+	}
+
+	void testShuffledGrid()
+	{
+		std::mt19937 rng(1);
+
+		std::vector<Vec<uint32_t>> faces;
+		std::vector<Vec<float>> vertices;
+		std::vector<Vec<float>> normals;
+		makeGrid(120, true, rng, faces, vertices, normals);
+
+		double acmrBefore = MeshOptimizer::computeAcmr(faces, vertices.size());
+		checkOptimize(faces, vertices, normals);
+
+		MeshOptimizer::optimize(faces, vertices, normals);
+		double acmrAfter = MeshOptimizer::computeAcmr(faces, vertices.size());
+
+		// A shuffled grid starts near 3 (no reuse), a good order gets well under 1
+		CHECK(acmrBefore > 2.0);
+		CHECK(acmrAfter < 1.0);
+	}
+
+	void testRandomMeshes()
+	{
+		std::mt19937 rng(5);
+
+		for ( int trial = 0; trial < 20; ++trial )
+		{
+			std::uniform_int_distribution<uint32_t> vertCount(3, 300);
+			uint32_t numVerts = vertCount(rng);
+
+			std::uniform_real_distribution<float> coord(-1.0f, 1.0f);
+			std::vector<Vec<float>> vertices;
+			std::vector<Vec<float>> normals;
+			for ( uint32_t i = 0; i < numVerts; ++i )
+			{
+				vertices.push_back(Vec<float>(coord(rng), coord(rng), coord(rng)));
+				normals.push_back(Vec<float>(coord(rng), coord(rng), coord(rng)));
+			}
+
+			// Faces only use the first half of the vertices, the rest must survive the reorder unused
+			std::uniform_int_distribution<uint32_t> vert(0, std::max(2u, numVerts/2));
+			std::vector<Vec<uint32_t>> faces;
+			for ( uint32_t f = 0; f < 2*numVerts; ++f )
+				faces.push_back(Vec<uint32_t>(vert(rng), vert(rng), vert(rng)));
+
+			checkOptimize(faces, vertices, ((trial % 4) == 0) ? std::vector<Vec<float>>() : normals);
+		}
+	}
+
+	void testUnusedVerticesLast()
+	{
+		std::mt19937 rng(3);
+
+		std::vector<Vec<uint32_t>> faces;
+		std::vector<Vec<float>> vertices;
+		std::vector<Vec<float>> normals;
+		makeGrid(10, true, rng, faces, vertices, normals);
+
+		// Unused vertices go first in the input and keep their relative order after the used ones
+		vertices.insert(vertices.begin(), Vec<float>(-5.0f, -5.0f, -5.0f));
+		vertices.insert(vertices.begin(), Vec<float>(-6.0f, -6.0f, -6.0f));
+		normals.insert(normals.begin(), 2, Vec<float>(9.0f, 9.0f, 9.0f));
+		for ( Vec<uint32_t>& face : faces )
+			face = face + 2u;
+
+		checkOptimize(faces, vertices, normals);
+
+		MeshOptimizer::optimize(faces, vertices, normals);
+		CHECK(vertices[vertices.size()-2].x == -6.0f);
+		CHECK(vertices[vertices.size()-1].x == -5.0f);
+	}
+
+	void testEdgeCases()
+	{
+		std::vector<Vec<uint32_t>> faces;
+		std::vector<Vec<float>> vertices;
+		std::vector<Vec<float>> normals;
+
+		MeshOptimizer::Result result = MeshOptimizer::optimize(faces, vertices, normals);
+		CHECK(result.faces == 0 && faces.empty() && vertices.empty());
+
+		faces.push_back(Vec<uint32_t>(2, 0, 1));
+		vertices.push_back(Vec<float>(0.0f, 0.0f, 0.0f));
+		vertices.push_back(Vec<float>(1.0f, 0.0f, 0.0f));
+		vertices.push_back(Vec<float>(0.0f, 1.0f, 0.0f));
+		checkOptimize(faces, vertices, normals);
+	}
+}
+
+int main()
+{
+	testShuffledGrid();
+	testRandomMeshes();
+	testUnusedVerticesLast();
+	testEdgeCases();
+
+	return TestUtils::finish("MeshOptimizerTest");
+}
@@ -0,0 +1,398 @@
+#include "TestUtils.h"
+
+#include "Messages/MessageQueue.h"
+
+#include <atomic>
+#include <map>
+#include <random>
+#include <set>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+// Replay isn't exercised here, the log format only needs this to link
+Message* CommandLogReader::createMessage(LoggedMessages)
+{
+	return NULL;
+}
+
+namespace
+{
+	// What the messages act on, two write classes so coalescing is checked to be per class as well as per target
+	struct World
+	{
+		std::map<uint64_t, int> stateA;
+		std::map<uint64_t, int> stateB;
+
+		// Values seen by the reads, in processing order
+		std::vector<int> reads;
+		// Ids of every waited message that ran
+		std::set<int> waitedRan;
+
+		bool operator==(const World& other) const
+		{
+			return stateA == other.stateA && stateB == other.stateB && reads == other.reads;
+		}
+	};
+
+	class MessageWriteA : public Message
+	{
+	public:
+		MessageWriteA(World* world, uint64_t target, int value) : world(world), target(target), value(value) {}
+
+	protected:
+		virtual bool process() {world->stateA[target] = value; return true;}
+		virtual bool getCoalesceTarget(uint64_t& targetOut) const {targetOut = target; return true;}
+
+	private:
+		World* world;
+		uint64_t target;
+		int value;
+	};
+
+	class MessageWriteB : public Message
+	{
+	public:
+		MessageWriteB(World* world, uint64_t target, int value) : world(world), target(target), value(value) {}
+
+	protected:
+		virtual bool process() {world->stateB[target] = value; return true;}
+		virtual bool getCoalesceTarget(uint64_t& targetOut) const {targetOut = target; return true;}
+
+	private:
+		World* world;
+		uint64_t target;
+		int value;
+	};
+
+	// Not coalescable, reads what the writes before it set. Can be slow to prepare, holding back the ones behind it.
+	class MessageRead : public Message
+	{
+	public:
+		MessageRead(World* world, uint64_t target, int prepareTurns) : world(world), target(target), prepareTurns(prepareTurns) {}
+
+	protected:
+		virtual bool process()
+		{
+			std::map<uint64_t, int>::const_iterator it = world->stateA.find(target);
+			world->reads.push_back((it != world->stateA.end()) ? it->second : -1);
+			return true;
+		}
+
+		virtual bool prepare() {return (prepareTurns-- <= 0);}
+
+	private:
+		World* world;
+		uint64_t target;
+		int prepareTurns;
+	};
+
+	// A write that a caller waits on, must never be dropped even though it is coalescable
+	class MessageWaitedWrite : public MessageWriteA
+	{
+	public:
+		MessageWaitedWrite(World* world, uint64_t target, int value, int id) : MessageWriteA(world, target, value), world(world), id(id) {}
+
+	protected:
+		virtual bool process() {world->waitedRan.insert(id); return MessageWriteA::process();}
+
+	private:
+		World* world;
+		int id;
+	};
+
+	// Fails the way a load does when its pool work throws
+	class MessageThrow : public Message
+	{
+	protected:
+		virtual bool process() {throw std::runtime_error("load failed");}
+	};
+
+	enum Ops
+	{
+		WriteA,
+		WriteB,
+		Read,
+		WaitedWrite
+	};
+
+	struct Op
+	{
+		Ops type;
+		uint64_t target;
+		int value;
+		int prepareTurns;
+	};
+
+	std::vector<Op> makeOps(std::mt19937& rng, size_t count, bool withWaits)
+	{
+		// Few targets so writes to the same one pile up, reads and waits are rare enough that runs of writes form
+		std::uniform_int_distribution<int> pick(0, 99);
+		std::uniform_int_distribution<uint64_t> target(0, 4);
+		std::uniform_int_distribution<int> turns(0, 2);
+
+		std::vector<Op> ops;
+		for ( size_t i = 0; i < count; ++i )
+		{
+			int roll = pick(rng);
+
+			Op op;
+			op.type = (roll < 60) ? WriteA : ((roll < 85) ? WriteB : ((roll < 95 || !withWaits) ? Read : WaitedWrite));
+			op.target = target(rng);
+			op.value = int(i);
+			op.prepareTurns = (op.type == Read) ? turns(rng) : 0;
+
+			ops.push_back(op);
+		}
+
+		return ops;
+	}
+
+	Message* makeMessage(World* world, const Op& op, int id)
+	{
+		switch ( op.type )
+		{
+		case WriteA:
+			return new MessageWriteA(world, op.target, op.value);
+		case WriteB:
+			return new MessageWriteB(world, op.target, op.value);
+		case Read:
+			return new MessageRead(world, op.target, op.prepareTurns);
+		case WaitedWrite:
+			return new MessageWaitedWrite(world, op.target, op.value, id);
+		}
+
+		return NULL;
+	}
+
+	// Each op applied in order, nothing coalesced
+	World applyInOrder(const std::vector<Op>& ops)
+	{
+		World world;
+		for ( size_t i = 0; i < ops.size(); ++i )
+		{
+			const Op& op = ops[i];
+			if ( op.type == WriteA || op.type == WaitedWrite )
+				world.stateA[op.target] = op.value;
+			else if ( op.type == WriteB )
+				world.stateB[op.target] = op.value;
+			else
+				world.reads.push_back((world.stateA.count(op.target) > 0) ? world.stateA[op.target] : -1);
+
+			if ( op.type == WaitedWrite )
+				world.waitedRan.insert(int(i));
+		}
+
+		return world;
+	}
+
+	// Writes the queue should drop when everything is drained at once: an earlier write of the same class and target
+	// with only plain writes queued since
+	size_t countCoalescable(const std::vector<Op>& ops)
+	{
+		size_t count = 0;
+		std::set<std::pair<int, uint64_t>> pending;
+		for ( const Op& op : ops )
+		{
+			if ( op.type == Read || op.type == WaitedWrite )
+			{
+				pending.clear();
+				continue;
+			}
+
+			if ( !pending.insert(std::make_pair(int(op.type), op.target)).second )
+				++count;
+		}
+
+		return count;
+	}
+
+	void drain(MessageQueue& queue)
+	{
+		while ( queue.getNumMessages() > 0 )
+			CHECK(queue.processPending(1.0));
+	}
+
+	// Processes each message before the next is pushed, so nothing can coalesce
+	World runUncoalesced(const std::vector<Op>& ops)
+	{
+		World world;
+		MessageQueue queue(false);
+		queue.open();
+
+		for ( size_t i = 0; i < ops.size(); ++i )
+		{
+			queue.pushMessage(makeMessage(&world, ops[i], int(i)));
+			drain(queue);
+		}
+
+		CHECK(queue.getStats().coalesced == 0);
+		CHECK(queue.getStats().processed == ops.size());
+
+		return world;
+	}
+
+	// Queues everything before processing, so every write that can coalesce does
+	World runCoalesced(const std::vector<Op>& ops)
+	{
+		World world;
+		MessageQueue queue(false);
+		queue.open();
+
+		for ( size_t i = 0; i < ops.size(); ++i )
+			queue.pushMessage(makeMessage(&world, ops[i], int(i)));
+
+		drain(queue);
+
+		MessageQueue::Stats stats = queue.getStats();
+		CHECK(stats.coalesced == countCoalescable(ops));
+		CHECK(stats.processed + stats.coalesced == ops.size());
+
+		return world;
+	}
+
+	// Producers push from their own thread, waiting on some messages, while the consumer drains whatever has arrived
+	World runConcurrent(const std::vector<Op>& ops, std::mt19937& rng)
+	{
+		World world;
+		MessageQueue queue(true);
+		queue.open();
+
+		std::atomic<bool> done(false);
+		std::atomic<int> badWaits(0);
+
+		std::thread producer([&]()
+		{
+			for ( size_t i = 0; i < ops.size(); ++i )
+			{
+				Message* message = makeMessage(&world, ops[i], int(i));
+				if ( ops[i].type != WaitedWrite )
+				{
+					queue.pushMessage(message);
+					continue;
+				}
+
+				MessageStatus status = queue.pushMessageAndWait(message);
+				if ( !status.processed || !status.success )
+					++badWaits;
+			}
+
+			done = true;
+		});
+
+		// Random pauses let different amounts pile up between drains
+		std::uniform_int_distribution<int> pause(0, 20);
+		while ( !done || queue.getNumMessages() > 0 )
+		{
+			queue.processPending(0.001);
+			for ( int i = pause(rng); i > 0; --i )
+				std::this_thread::yield();
+		}
+
+		producer.join();
+
+		CHECK(badWaits == 0);
+
+		return world;
+	}
+
+	void testRandomSequences()
+	{
+		std::mt19937 rng(2024);
+
+		size_t totalCoalescable = 0;
+		for ( int trial = 0; trial < 200; ++trial )
+		{
+			std::vector<Op> ops = makeOps(rng, 50 + trial*5, false);
+			totalCoalescable += countCoalescable(ops);
+
+			World expected = applyInOrder(ops);
+
+			CHECK(runUncoalesced(ops) == expected);
+			CHECK(runCoalesced(ops) == expected);
+		}
+
+		// The sequences have to actually exercise coalescing
+		CHECK(totalCoalescable > 1000);
+	}
+
+	void testWaitedMessages()
+	{
+		std::mt19937 rng(99);
+
+		for ( int trial = 0; trial < 50; ++trial )
+		{
+			std::vector<Op> ops = makeOps(rng, 500, true);
+			World expected = applyInOrder(ops);
+
+			World world = runConcurrent(ops, rng);
+			CHECK(world == expected);
+			CHECK(world.waitedRan == expected.waitedRan);
+		}
+	}
+
+	void testCoalesceRules()
+	{
+		World world;
+		MessageQueue queue(false);
+		queue.open();
+
+		// Same class and target coalesce, a different class or target doesn't
+		queue.pushMessage(new MessageWriteA(&world, 1, 10));
+		queue.pushMessage(new MessageWriteB(&world, 1, 20));
+		queue.pushMessage(new MessageWriteA(&world, 2, 30));
+		queue.pushMessage(new MessageWriteA(&world, 1, 11));
+
+		// Nothing coalesces across a read
+		queue.pushMessage(new MessageRead(&world, 1, 2));
+		queue.pushMessage(new MessageWriteA(&world, 1, 12));
+
+		drain(queue);
+
+		CHECK(queue.getStats().coalesced == 1);
+		CHECK(queue.getStats().processed == 5);
+		CHECK(world.reads.size() == 1 && world.reads[0] == 11);
+		CHECK(world.stateA[1] == 12 && world.stateA[2] == 30 && world.stateB[1] == 20);
+	}
+
+	void testThrowingMessages()
+	{
+		World world;
+		MessageQueue queue(true);
+		queue.open();
+
+		// A waiter gets the exception as the message's error
+		std::thread producer([&]()
+		{
+			MessageStatus status = queue.pushMessageAndWait(new MessageThrow());
+			CHECK(status.processed && !status.success);
+			CHECK(status.error.find("load failed") != std::string::npos);
+
+			queue.pushMessage(new MessageThrow());
+			queue.pushMessage(new MessageWriteA(&world, 1, 5));
+		});
+
+		while ( queue.getStats().processed < 1 )
+			queue.processPending(0.001);
+
+		producer.join();
+
+		// The failure only stops this turn, the messages behind it are processed on the next
+		CHECK(!queue.processPending(1.0));
+		CHECK(queue.getNumMessages() == 1);
+		CHECK(queue.processPending(1.0));
+		CHECK(world.stateA[1] == 5);
+		CHECK(queue.getStats().processed == 3);
+	}
+}
+
+int main()
+{
+	testCoalesceRules();
+	testThrowingMessages();
+	testRandomSequences();
+	testWaitedMessages();
+
+	return TestUtils::finish("MessageQueueTest");
+}
@@ -0,0 +1,190 @@
+#include "TestUtils.h"
+
+#include "Global/MpscRing.h"
+#include "Global/QueueBenchmark.h"
+
+#include <atomic>
+#include <thread>
+#include <vector>
+
+namespace
+{
+	struct StressItem
+	{
+		uint32_t producer;
+		uint32_t sequence;
+	};
+
+	void testSingleThread()
+	{
+		MpscRing<int> ring(5);
+		CHECK(ring.capacity() == 8);
+
+		int item = 0;
+		CHECK(!ring.tryPop(item));
+
+		uint64_t ticket = 99;
+		for ( int i = 0; i < 8; ++i )
+		{
+			CHECK(ring.tryPush(i, &ticket));
+			CHECK(ticket == uint64_t(i));
+		}
+
+		// Full until the consumer frees a cell
+		CHECK(!ring.tryPush(8));
+		CHECK(ring.sizeApprox() == 8);
+
+		CHECK(ring.tryPop(item) && item == 0);
+		CHECK(ring.tryPush(8, &ticket) && ticket == 8);
+
+		for ( int i = 1; i <= 8; ++i )
+			CHECK(ring.tryPop(item) && item == i);
+
+		CHECK(!ring.tryPop(item));
+		CHECK(ring.sizeApprox() == 0);
+	}
+
+	// Producers push through a small ring so they keep hitting the full case. Nothing may be lost or duplicated,
+	// and each producer's items must come out in its push order.
+	void testStress(int numProducers, size_t capacity, uint32_t itemsPerProducer)
+	{
+		MpscRing<StressItem> ring(capacity);
+
+		std::atomic<bool> go(false);
+		std::vector<std::thread> producers;
+		for ( int p = 0; p < numProducers; ++p )
+		{
+			producers.emplace_back([&ring, &go, p, itemsPerProducer]()
+			{
+				while ( !go )
+					std::this_thread::yield();
+
+				for ( uint32_t i = 0; i < itemsPerProducer; ++i )
+				{
+					StressItem item = {uint32_t(p), i};
+					while ( !ring.tryPush(item) )
+						std::this_thread::yield();
+				}
+			});
+		}
+
+		go = true;
+
+		std::vector<uint32_t> nextSequence(numProducers, 0);
+		size_t total = size_t(numProducers) * itemsPerProducer;
+		size_t received = 0;
+		bool inOrder = true;
+		bool validProducer = true;
+
+		StressItem item;
+		while ( received < total )
+		{
+			if ( !ring.tryPop(item) )
+			{
+				std::this_thread::yield();
+				continue;
+			}
+
+			if ( item.producer >= uint32_t(numProducers) )
+			{
+				validProducer = false;
+				continue;
+			}
+
+			if ( item.sequence != nextSequence[item.producer]++ )
+				inOrder = false;
+
+			++received;
+		}
+
+		for ( std::thread& producer : producers )
+			producer.join();
+
+		CHECK(validProducer);
+		CHECK(inOrder);
+		CHECK(!ring.tryPop(item));
+
+		for ( int p = 0; p < numProducers; ++p )
+			CHECK(nextSequence[p] == itemsPerProducer);
+	}
+
+	// Tickets are handed out in claim order, which must be the pop order
+	void testTickets(int numProducers, uint32_t itemsPerProducer)
+	{
+		MpscRing<StressItem> ring(64);
+
+		std::vector<std::vector<uint64_t>> tickets(numProducers);
+		std::atomic<bool> go(false);
+		std::vector<std::thread> producers;
+		for ( int p = 0; p < numProducers; ++p )
+		{
+			producers.emplace_back([&ring, &go, &tickets, p, itemsPerProducer]()
+			{
+				while ( !go )
+					std::this_thread::yield();
+
+				for ( uint32_t i = 0; i < itemsPerProducer; ++i )
+				{
+					StressItem item = {uint32_t(p), i};
+
+					uint64_t ticket;
+					while ( !ring.tryPush(item, &ticket) )
+						std::this_thread::yield();
+
+					tickets[p].push_back(ticket);
+				}
+			});
+		}
+
+		go = true;
+
+		std::vector<StressItem> popped;
+		size_t total = size_t(numProducers) * itemsPerProducer;
+		StressItem item;
+		while ( popped.size() < total )
+		{
+			if ( ring.tryPop(item) )
+				popped.push_back(item);
+		}
+
+		for ( std::thread& producer : producers )
+			producer.join();
+
+		bool ticketsMatch = true;
+		for ( size_t pos = 0; pos < popped.size(); ++pos )
+		{
+			const StressItem& popItem = popped[pos];
+			if ( tickets[popItem.producer][popItem.sequence] != pos )
+				ticketsMatch = false;
+		}
+
+		CHECK(ticketsMatch);
+	}
+
+	void testBenchmarkValid()
+	{
+		QueueBenchmark::MutexQueue mutexQueue;
+		QueueBenchmark::Result mutexResult = QueueBenchmark::run(mutexQueue, 100000, 4);
+		CHECK(mutexResult.valid);
+
+		MpscRing<QueueBenchmark::Item> ring(1024);
+		QueueBenchmark::Result ringResult = QueueBenchmark::run(ring, 100000, 4);
+		CHECK(ringResult.valid);
+	}
+}
+
+int main()
+{
+	testSingleThread();
+
+	testStress(1, 4, 100000);
+	testStress(4, 2, 50000);
+	testStress(8, 16, 50000);
+	testStress(16, 1024, 20000);
+
+	testTickets(4, 20000);
+
+	testBenchmarkValid();
+
+	return TestUtils::finish("MpscRingTest");
+}
@@ -0,0 +1,40 @@
+// Standalone version of the QueueBenchmark command: QueueBenchmark [numMessages] [producers]
+#include "Global/MpscRing.h"
+#include "Global/QueueBenchmark.h"
+
+#include <cstdio>
+#include <cstdlib>
+
+int main(int argc, char* argv[])
+{
+	size_t numItems = (argc > 1) ? size_t(atof(argv[1])) : 1000000;
+	int numProducers = (argc > 2) ? atoi(argv[2]) : 4;
+
+	if ( numItems < 1 || numProducers < 1 )
+	{
+		fprintf(stderr, "usage: QueueBenchmark [numMessages] [producers]\n");
+		return 1;
+	}
+
+	QueueBenchmark::Result results[2];
+	{
+		QueueBenchmark::MutexQueue queue;
+		results[0] = QueueBenchmark::run(queue, numItems, numProducers);
+	}
+	{
+		MpscRing<QueueBenchmark::Item> queue(16384);
+		results[1] = QueueBenchmark::run(queue, numItems, numProducers);
+	}
+
+	const char* queueNames[2] = {"Mutex", "MpscRing"};
+
+	printf("%zu messages, %d producers\n", numItems, numProducers);
+	printf("%-10s %16s %14s %14s %6s\n", "Queue", "Messages/sec", "Median us", "99th us", "Valid");
+	for ( int i = 0; i < 2; ++i )
+	{
+		printf("%-10s %16.0f %14.2f %14.2f %6s\n", queueNames[i], double(numItems) / results[i].seconds,
+			results[i].latencyMedianUs, results[i].latency99Us, (results[i].valid) ? "yes" : "no");
+	}
+
+	return (results[0].valid && results[1].valid) ? 0 : 1;
+}
@@ -0,0 +1,142 @@
+#include "TestUtils.h"
+
+#include "D3d/RegionGeometry.h"
+
+#include <vector>
+
+namespace
+{
+	const Vec<int> viewSize(200, 100, 1);
+
+	std::vector<Vec<float>> makeRect(float minX, float minY, float maxX, float maxY)
+	{
+		std::vector<Vec<float>> rect;
+		rect.push_back(Vec<float>(minX, minY, 0.0f));
+		rect.push_back(Vec<float>(maxX, minY, 0.0f));
+		rect.push_back(Vec<float>(maxX, maxY, 0.0f));
+		rect.push_back(Vec<float>(minX, maxY, 0.0f));
+
+		return rect;
+	}
+
+	bool touches(const std::vector<Vec<float>>& tri, const std::vector<Vec<float>>& region)
+	{
+		return RegionGeometry::polygonTouchesRegion(tri.data(), tri.size(), region.data(), region.size());
+	}
+
+	// Clip space (x, y, w) for a window position at depth w
+	Vec<float> toClip(float x, float y, float w)
+	{
+		return Vec<float>((2.0f * x / viewSize.x - 1.0f) * w, (1.0f - 2.0f * y / viewSize.y) * w, w);
+	}
+
+	void testEdgesCrossing()
+	{
+		std::vector<Vec<float>> region = makeRect(40.0f, 40.0f, 60.0f, 60.0f);
+
+		// A thin triangle straight through the region, every vertex is outside it and none of the region is inside
+		std::vector<Vec<float>> through;
+		through.push_back(Vec<float>(0.0f, 49.0f, 0.0f));
+		through.push_back(Vec<float>(100.0f, 50.0f, 0.0f));
+		through.push_back(Vec<float>(0.0f, 51.0f, 0.0f));
+
+		for ( const Vec<float>& vert : through )
+			CHECK(!RegionGeometry::insideRegion(region.data(), region.size(), vert.x, vert.y));
+
+		CHECK(touches(through, region));
+
+		// The same triangle moved off the region's edge
+		std::vector<Vec<float>> beside = through;
+		for ( Vec<float>& vert : beside )
+			vert.y += 20.0f;
+
+		CHECK(!touches(beside, region));
+
+		// Its bounds overlap the region but the triangle itself passes by the corner
+		std::vector<Vec<float>> corner;
+		corner.push_back(Vec<float>(55.0f, 70.0f, 0.0f));
+		corner.push_back(Vec<float>(70.0f, 55.0f, 0.0f));
+		corner.push_back(Vec<float>(80.0f, 80.0f, 0.0f));
+
+		CHECK(!touches(corner, region));
+	}
+
+	void testRegionInsideTriangle()
+	{
+		std::vector<Vec<float>> tri;
+		tri.push_back(Vec<float>(0.0f, 0.0f, 0.0f));
+		tri.push_back(Vec<float>(100.0f, 0.0f, 0.0f));
+		tri.push_back(Vec<float>(0.0f, 100.0f, 0.0f));
+
+		// A small lasso well inside the triangle, nothing of the triangle is inside it
+		std::vector<Vec<float>> lasso;
+		lasso.push_back(Vec<float>(20.0f, 20.0f, 0.0f));
+		lasso.push_back(Vec<float>(30.0f, 22.0f, 0.0f));
+		lasso.push_back(Vec<float>(25.0f, 30.0f, 0.0f));
+
+		CHECK(touches(tri, lasso));
+
+		// Past the hypotenuse, inside the triangle's bounds but not the triangle
+		for ( Vec<float>& point : lasso )
+			point = point + Vec<float>(50.0f, 50.0f, 0.0f);
+
+		CHECK(!touches(tri, lasso));
+	}
+
+	void testClipping()
+	{
+		Vec<float> screen[4];
+
+		// All in front maps straight to the window
+		Vec<float> front[3] = {toClip(10.0f, 20.0f, 2.0f), toClip(50.0f, 20.0f, 3.0f), toClip(10.0f, 80.0f, 4.0f)};
+		CHECK(RegionGeometry::clipTriangleToScreen(front, viewSize, screen) == 3);
+		CHECK_NEAR(screen[0].x, 10.0f, 1.0e-3f);
+		CHECK_NEAR(screen[0].y, 20.0f, 1.0e-3f);
+		CHECK_NEAR(screen[2].y, 80.0f, 1.0e-3f);
+
+		// Behind the camera entirely
+		Vec<float> behind[3] = {Vec<float>(0.0f, 0.0f, -1.0f), Vec<float>(1.0f, 0.0f, -2.0f), Vec<float>(0.0f, 1.0f, -0.5f)};
+		CHECK(RegionGeometry::clipTriangleToScreen(behind, viewSize, screen) == 0);
+
+		// One vertex behind leaves a quad whose two new corners sit on the near side of the plane
+		Vec<float> oneBehind[3] = {toClip(100.0f, 50.0f, 1.0f), Vec<float>(0.5f, 0.0f, -1.0f), toClip(120.0f, 50.0f, 1.0f)};
+		CHECK(RegionGeometry::clipTriangleToScreen(oneBehind, viewSize, screen) == 4);
+
+		// Two behind leaves a triangle
+		Vec<float> twoBehind[3] = {toClip(100.0f, 50.0f, 1.0f), Vec<float>(0.5f, 0.0f, -1.0f), Vec<float>(-0.5f, 0.0f, -1.0f)};
+		CHECK(RegionGeometry::clipTriangleToScreen(twoBehind, viewSize, screen) == 3);
+		CHECK_NEAR(screen[0].x, 100.0f, 1.0e-3f);
+	}
+
+	void testPartlyBehindCamera()
+	{
+		// A triangle reaching behind the camera with its one front vertex left of a small region.
+		// Its front part runs off to the right across the region, so it touches even though no vertex is inside.
+		Vec<float> clipTri[3] = {toClip(20.0f, 50.0f, 1.0f), Vec<float>(1.0f, 0.05f, -1.0f), Vec<float>(1.0f, -0.05f, -1.0f)};
+
+		Vec<float> screen[4];
+		size_t numPoints = RegionGeometry::clipTriangleToScreen(clipTri, viewSize, screen);
+		CHECK(numPoints == 3);
+
+		std::vector<Vec<float>> region = makeRect(90.0f, 45.0f, 110.0f, 55.0f);
+		CHECK(RegionGeometry::polygonTouchesRegion(screen, numPoints, region.data(), region.size()));
+
+		// The front vertex alone is nowhere near the region
+		Vec<float> front = RegionGeometry::clipToScreen(clipTri[0], viewSize);
+		CHECK(!RegionGeometry::insideRegion(region.data(), region.size(), front.x, front.y));
+
+		// Above the triangle's sliver it doesn't touch
+		std::vector<Vec<float>> above = makeRect(90.0f, 5.0f, 110.0f, 15.0f);
+		CHECK(!RegionGeometry::polygonTouchesRegion(screen, numPoints, above.data(), above.size()));
+	}
+}
+
+int main()
+{
+	testEdgesCrossing();
+	testRegionInsideTriangle();
+	testClipping();
+	testPartlyBehindCamera();
+
+	return TestUtils::finish("RegionGeometryTest");
+}
@@ -0,0 +1,46 @@
+#pragma once
+// Scalar subset of DirectXMath used by the kernels under test, only for building the tests without the Windows SDK
+#include <cstring>
+
+namespace DirectX
+{
+	struct XMVECTOR
+	{
+		float v[4];
+	};
+	typedef const XMVECTOR& FXMVECTOR;
+
+	struct XMMATRIX
+	{
+		XMVECTOR r[4];
+	};
+	typedef const XMMATRIX& FXMMATRIX;
+
+	struct XMFLOAT4X4
+	{
+		float m[4][4];
+	};
+
+	inline XMVECTOR XMVectorSet(float x, float y, float z, float w)
+	{
+		XMVECTOR vec = {{x, y, z, w}};
+		return vec;
+	}
+
+	inline XMMATRIX XMMatrixSet(float m00, float m01, float m02, float m03, float m10, float m11, float m12, float m13,
+		float m20, float m21, float m22, float m23, float m30, float m31, float m32, float m33)
+	{
+		XMMATRIX mat;
+		mat.r[0] = XMVectorSet(m00, m01, m02, m03);
+		mat.r[1] = XMVectorSet(m10, m11, m12, m13);
+		mat.r[2] = XMVectorSet(m20, m21, m22, m23);
+		mat.r[3] = XMVectorSet(m30, m31, m32, m33);
+		return mat;
+	}
+
+	inline void XMStoreFloat4x4(XMFLOAT4X4* out, FXMMATRIX mat)
+	{
+		for ( int i = 0; i < 4; ++i )
+			memcpy(out->m[i], mat.r[i].v, sizeof(out->m[i]));
+	}
+}
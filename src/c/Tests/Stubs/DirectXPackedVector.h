@@ -0,0 +1,82 @@
+#pragma once
+// Packed vertex formats used by VertexPacking, only for building the tests without the Windows SDK
+#include "DirectXMath.h"
+
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+
+namespace DirectX
+{
+	namespace PackedVector
+	{
+		struct XMSHORTN4
+		{
+			int16_t x, y, z, w;
+		};
+
+		struct XMUDECN4
+		{
+			uint32_t v;
+		};
+
+		struct XMUBYTEN4
+		{
+			uint8_t x, y, z, w;
+		};
+
+		inline uint16_t XMConvertFloatToHalf(float value)
+		{
+			uint32_t bits;
+			memcpy(&bits, &value, sizeof(bits));
+
+			uint32_t sign = (bits >> 16) & 0x8000;
+			int exponent = int((bits >> 23) & 0xFF) - 127 + 15;
+			uint32_t mantissa = bits & 0x7FFFFF;
+
+			if ( exponent <= 0 )
+				return uint16_t(sign);
+			if ( exponent >= 31 )
+				return uint16_t(sign | 0x7C00);
+
+			return uint16_t(sign | (exponent << 10) | (mantissa >> 13));
+		}
+
+		struct XMHALF2
+		{
+			uint16_t x, y;
+
+			XMHALF2(float xIn, float yIn) : x(XMConvertFloatToHalf(xIn)), y(XMConvertFloatToHalf(yIn)) {}
+		};
+
+		inline float saturateStub(float value, float lo, float hi)
+		{
+			return (value < lo) ? lo : ((value > hi) ? hi : value);
+		}
+
+		inline void XMStoreShortN4(XMSHORTN4* out, FXMVECTOR vec)
+		{
+			out->x = int16_t(std::lround(saturateStub(vec.v[0], -1.0f, 1.0f) * 32767.0f));
+			out->y = int16_t(std::lround(saturateStub(vec.v[1], -1.0f, 1.0f) * 32767.0f));
+			out->z = int16_t(std::lround(saturateStub(vec.v[2], -1.0f, 1.0f) * 32767.0f));
+			out->w = int16_t(std::lround(saturateStub(vec.v[3], -1.0f, 1.0f) * 32767.0f));
+		}
+
+		inline void XMStoreUDecN4(XMUDECN4* out, FXMVECTOR vec)
+		{
+			uint32_t x = uint32_t(std::lround(saturateStub(vec.v[0], 0.0f, 1.0f) * 1023.0f));
+			uint32_t y = uint32_t(std::lround(saturateStub(vec.v[1], 0.0f, 1.0f) * 1023.0f));
+			uint32_t z = uint32_t(std::lround(saturateStub(vec.v[2], 0.0f, 1.0f) * 1023.0f));
+			uint32_t w = uint32_t(std::lround(saturateStub(vec.v[3], 0.0f, 1.0f) * 3.0f));
+			out->v = x | (y << 10) | (z << 20) | (w << 30);
+		}
+
+		inline void XMStoreUByteN4(XMUBYTEN4* out, FXMVECTOR vec)
+		{
+			out->x = uint8_t(std::lround(saturateStub(vec.v[0], 0.0f, 1.0f) * 255.0f));
+			out->y = uint8_t(std::lround(saturateStub(vec.v[1], 0.0f, 1.0f) * 255.0f));
+			out->z = uint8_t(std::lround(saturateStub(vec.v[2], 0.0f, 1.0f) * 255.0f));
+			out->w = uint8_t(std::lround(saturateStub(vec.v[3], 0.0f, 1.0f) * 255.0f));
+		}
+	}
+}
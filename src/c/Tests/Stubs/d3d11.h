@@ -0,0 +1,33 @@
+#pragma once
+// Just the Direct3D declarations VertexLayout needs, only for building the tests without the Windows SDK
+#include <cstdint>
+
+enum DXGI_FORMAT
+{
+	DXGI_FORMAT_UNKNOWN = 0,
+	DXGI_FORMAT_R32G32B32A32_FLOAT = 2,
+	DXGI_FORMAT_R32G32B32_FLOAT = 6,
+	DXGI_FORMAT_R16G16B16A16_SNORM = 13,
+	DXGI_FORMAT_R10G10B10A2_UNORM = 24,
+	DXGI_FORMAT_R8G8B8A8_UNORM = 28,
+	DXGI_FORMAT_R16G16_FLOAT = 34,
+	DXGI_FORMAT_R32_UINT = 42,
+	DXGI_FORMAT_R16_UINT = 57
+};
+
+enum D3D11_INPUT_CLASSIFICATION
+{
+	D3D11_INPUT_PER_VERTEX_DATA = 0,
+	D3D11_INPUT_PER_INSTANCE_DATA = 1
+};
+
+struct D3D11_INPUT_ELEMENT_DESC
+{
+	const char* SemanticName;
+	uint32_t SemanticIndex;
+	DXGI_FORMAT Format;
+	uint32_t InputSlot;
+	uint32_t AlignedByteOffset;
+	D3D11_INPUT_CLASSIFICATION InputSlotClass;
+	uint32_t InstanceDataStepRate;
+};
@@ -0,0 +1,39 @@
+#pragma once
+// Portable stand-ins for the MSVC intrinsics the kernels use, only for building the tests with gcc/clang
+// cpuid.h already has __cpuidex
+#include <cpuid.h>
+#include <immintrin.h>
+
+#undef __cpuid
+inline void __cpuid(int info[4], int function)
+{
+	__cpuid_count(function, 0, info[0], info[1], info[2], info[3]);
+}
+
+inline unsigned long long xgetbvStub(unsigned int index)
+{
+	unsigned int eax, edx;
+	__asm__ volatile("xgetbv" : "=a"(eax), "=d"(edx) : "c"(index));
+	return (((unsigned long long)edx) << 32) | eax;
+}
+
+#undef _xgetbv
+#define _xgetbv xgetbvStub
+
+inline unsigned char _BitScanForward64(unsigned long* index, unsigned long long mask)
+{
+	if ( mask == 0 )
+		return 0;
+
+	*index = (unsigned long)__builtin_ctzll(mask);
+	return 1;
+}
+
+inline unsigned char _BitScanReverse64(unsigned long* index, unsigned long long mask)
+{
+	if ( mask == 0 )
+		return 0;
+
+	*index = 63 - (unsigned long)__builtin_clzll(mask);
+	return 1;
+}
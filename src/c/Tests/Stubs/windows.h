@@ -0,0 +1,3 @@
+#pragma once
+// Just the Windows types the shared headers mention, only for building the tests without the Windows SDK
+typedef long HRESULT;
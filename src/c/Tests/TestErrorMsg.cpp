@@ -0,0 +1,34 @@
+// Error reporting for the tests, in place of the MEX module's return queue (Messages/MexErrorMsg.cpp)
+#include "Global/ErrorMsg.h"
+
+#include <cstdio>
+
+namespace
+{
+	thread_local std::string* capturedErrors = NULL;
+}
+
+void captureErrMessages(std::string* errorsOut)
+{
+	capturedErrors = errorsOut;
+}
+
+void errMessage(std::string message, const char *file, int line)
+{
+	std::string msg = message + " In file:" + file + " line " + std::to_string(line);
+	if ( !capturedErrors )
+	{
+		fprintf(stderr, "%s\n", msg.c_str());
+		return;
+	}
+
+	if ( !capturedErrors->empty() )
+		*capturedErrors += "\n";
+
+	*capturedErrors += msg;
+}
+
+void hrErrMessage(HRESULT hr, const char *file, int line)
+{
+	errMessage("HRESULT " + std::to_string(hr), file, line);
+}
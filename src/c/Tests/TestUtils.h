@@ -0,0 +1,33 @@
+#pragma once
+
+#include <cmath>
+#include <cstdio>
+
+// Minimal checks for the standalone test programs, a program fails if any check does
+namespace TestUtils
+{
+	inline int& failures()
+	{
+		static int count = 0;
+		return count;
+	}
+
+	inline void fail(const char* file, int line, const char* expr)
+	{
+		fprintf(stderr, "%s(%d): check failed: %s\n", file, line, expr);
+		++failures();
+	}
+
+	inline int finish(const char* testName)
+	{
+		if ( failures() == 0 )
+			printf("%s passed\n", testName);
+		else
+			printf("%s failed %d checks\n", testName, failures());
+
+		return (failures() == 0) ? 0 : 1;
+	}
+}
+
+#define CHECK(expr) do { if ( !(expr) ) TestUtils::fail(__FILE__, __LINE__, #expr); } while ( 0 )
+#define CHECK_NEAR(a, b, tol) do { if ( !(std::fabs(double(a) - double(b)) <= double(tol)) ) TestUtils::fail(__FILE__, __LINE__, #a " ~= " #b); } while ( 0 )
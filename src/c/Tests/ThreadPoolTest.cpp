@@ -0,0 +1,262 @@
+#include "TestUtils.h"
+
+#include "Global/Arena.h"
+#include "Global/ParallelFor.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace
+{
+	struct Counted
+	{
+		Counted(int& numAlive) : numAlive(numAlive) {++numAlive;}
+		~Counted() {--numAlive;}
+
+		int& numAlive;
+	};
+
+	void testArenaScopes()
+	{
+		Arena arena(1024);
+		int numAlive = 0;
+
+		uint32_t* outer = arena.allocArray<uint32_t>(64);
+		for ( uint32_t i = 0; i < 64; ++i )
+			outer[i] = i;
+
+		arena.create<Counted>(numAlive);
+		size_t usedBefore = arena.getBytesUsed();
+
+		{
+			Arena::Scope scope(arena);
+
+			// Bigger than the first chunk, so the scope has chunks of its own to give back
+			uint32_t* inner = arena.allocArray<uint32_t>(4096);
+			for ( uint32_t i = 0; i < 4096; ++i )
+				inner[i] = 0xFFFFFFFF;
+
+			arena.create<Counted>(numAlive);
+			CHECK(numAlive == 2);
+
+			{
+				Arena::Scope nested(arena);
+				arena.create<Counted>(numAlive);
+				CHECK(numAlive == 3);
+			}
+
+			CHECK(numAlive == 2);
+		}
+
+		// Only the scope's objects are gone, what was allocated before it is untouched
+		CHECK(numAlive == 1);
+		CHECK(arena.getBytesUsed() == usedBefore);
+		for ( uint32_t i = 0; i < 64; ++i )
+			CHECK(outer[i] == i);
+
+		// The next allocation carries on after the outer data
+		uint32_t* next = arena.allocArray<uint32_t>(4);
+		CHECK(next >= outer + 64 || next + 4 <= outer);
+
+		arena.reset();
+		CHECK(numAlive == 0);
+	}
+
+	void testScratchSurvivesNestedUse()
+	{
+		Arena& scratch = Arena::threadScratch();
+		Arena::Scope scope(scratch);
+
+		const size_t count = 100000;
+		uint32_t* values = scratch.allocArray<uint32_t>(count);
+		for ( size_t i = 0; i < count; ++i )
+			values[i] = uint32_t(i);
+
+		// Each chunk takes scratch of its own, on whatever thread it lands
+		parallelFor(count, 1000, [&](size_t begin, size_t end)
+		{
+			Arena& chunkScratch = Arena::threadScratch();
+			Arena::Scope chunkScope(chunkScratch);
+
+			uint32_t* temp = chunkScratch.allocArray<uint32_t>(end - begin);
+			for ( size_t i = begin; i < end; ++i )
+				temp[i - begin] = 0xDEADBEEF;
+		});
+
+		bool intact = true;
+		for ( size_t i = 0; i < count; ++i )
+			intact = intact && (values[i] == uint32_t(i));
+
+		CHECK(intact);
+	}
+
+	void testJoinOnlyRunsOwnChunks()
+	{
+		ThreadPool& pool = ThreadPool::shared();
+		std::thread::id mainThread = std::this_thread::get_id();
+
+		// Unrelated work queued ahead of the loop, none of it may end up on the thread running the loop
+		std::atomic<int> ranOnMain(0);
+		std::vector<ThreadPool::TaskHandle> others;
+		for ( int i = 0; i < 2000; ++i )
+		{
+			others.push_back(pool.submit([&]()
+			{
+				if ( std::this_thread::get_id() == mainThread )
+					++ranOnMain;
+
+				std::this_thread::sleep_for(std::chrono::microseconds(20));
+			}));
+		}
+
+		std::atomic<size_t> sum(0);
+		parallelFor(64, 1, [&](size_t begin, size_t end)
+		{
+			for ( size_t i = begin; i < end; ++i )
+				sum += i;
+
+			std::this_thread::sleep_for(std::chrono::milliseconds(1));
+		});
+
+		CHECK(sum == 64*63/2);
+		CHECK(ranOnMain == 0);
+
+		for ( const ThreadPool::TaskHandle& task : others )
+			pool.join(task);
+	}
+
+	void testNestedParallelFor()
+	{
+		// Chunks that loop in parallel themselves, from every thread at once
+		std::vector<std::atomic<int>> hits(256);
+		for ( std::atomic<int>& hit : hits )
+			hit = 0;
+
+		parallelFor(16, 1, [&](size_t begin, size_t end)
+		{
+			for ( size_t i = begin; i < end; ++i )
+			{
+				parallelFor(16, 1, [&](size_t innerBegin, size_t innerEnd)
+				{
+					for ( size_t j = innerBegin; j < innerEnd; ++j )
+						++hits[i*16 + j];
+				});
+			}
+		});
+
+		bool once = true;
+		for ( std::atomic<int>& hit : hits )
+			once = once && (hit == 1);
+
+		CHECK(once);
+	}
+
+	void testJoinWaitsForDependencies()
+	{
+		ThreadPool& pool = ThreadPool::shared();
+
+		std::atomic<bool> firstDone(false);
+		std::atomic<bool> orderKept(false);
+
+		ThreadPool::TaskHandle first = pool.submit([&]()
+		{
+			std::this_thread::sleep_for(std::chrono::milliseconds(20));
+			firstDone = true;
+		});
+
+		ThreadPool::TaskHandle second = pool.submit([&](){orderKept = firstDone.load();}, std::vector<ThreadPool::TaskHandle>(1, first));
+
+		pool.join(second);
+		CHECK(ThreadPool::isDone(first));
+		CHECK(orderKept);
+	}
+
+	void testTaskExceptions()
+	{
+		ThreadPool& pool = ThreadPool::shared();
+
+		ThreadPool::TaskHandle failed = pool.submit([](){throw std::runtime_error("task failed");});
+
+		// Every waiter sees it, whether it waits or joins
+		int numCaught = 0;
+		for ( int i = 0; i < 2; ++i )
+		{
+			try
+			{
+				if ( i == 0 )
+					pool.wait(failed);
+				else
+					pool.join(failed);
+			}
+			catch(const std::runtime_error& e)
+			{
+				numCaught += (std::string(e.what()) == "task failed");
+			}
+		}
+
+		CHECK(numCaught == 2);
+
+		// Dependents still run after a failed dependency
+		std::atomic<bool> dependentRan(false);
+		ThreadPool::TaskHandle dependent = pool.submit([&](){dependentRan = true;}, std::vector<ThreadPool::TaskHandle>(1, failed));
+		pool.wait(dependent);
+		CHECK(dependentRan);
+	}
+
+	void testParallelForExceptions()
+	{
+		// The caller's chunk or a pool chunk fails, every other chunk has finished by the time it is rethrown
+		for ( size_t failAt : {size_t(0), size_t(37), size_t(63)} )
+		{
+			std::atomic<int> numDone(0);
+			bool caught = false;
+
+			try
+			{
+				parallelFor(64, 1, [&](size_t begin, size_t end)
+				{
+					for ( size_t i = begin; i < end; ++i )
+					{
+						if ( i == failAt )
+							throw std::runtime_error("chunk failed");
+
+						++numDone;
+					}
+				});
+			}
+			catch(const std::runtime_error&)
+			{
+				caught = true;
+			}
+
+			CHECK(caught);
+
+			// Only the rest of the failed chunk is skipped, chunked the way parallelFor splits the range
+			size_t numThreads = std::min<size_t>(ThreadPool::shared().getNumWorkers() + 1, 64);
+			size_t chunkSize = (64 + numThreads - 1) / numThreads;
+			size_t chunkEnd = std::min<size_t>((failAt / chunkSize + 1) * chunkSize, 64);
+			CHECK(numDone == int(63 - (chunkEnd - failAt - 1)));
+		}
+	}
+}
+
+int main()
+{
+	testArenaScopes();
+	testScratchSurvivesNestedUse();
+	testJoinOnlyRunsOwnChunks();
+	testNestedParallelFor();
+	testJoinWaitsForDependencies();
+	testTaskExceptions();
+	testParallelForExceptions();
+
+	ThreadPool::shutdownShared();
+
+	return TestUtils::finish("ThreadPoolTest");
+}
@@ -39,6 +39,10 @@ for i=1:length(msgs)
                 if (msgs(i).val ~= -1)
                     fprintf('Right click value: %d\n',msgs(i).val);
                 end
+            case 'polygonsSelected'
+                fprintf('Selected %d polygons\n',length(msgs(i).array));
+            case 'volumePoint'
+                fprintf('Volume point: (%.1f, %.1f, %.1f)\n',msgs(i).array(1:3));
         end
     end
     
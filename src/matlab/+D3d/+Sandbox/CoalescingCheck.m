@@ -0,0 +1,47 @@
+%% Checks that coalescing queued settings commands doesn't change what gets drawn
+% Run with a viewer already open on a volume (e.g. D3d.Open(im,imD)).
+% The same slider-like burst is sent twice, once with a blocking call after every command so each one
+% runs on its own, and once all at once so the render thread can drop superseded commands.
+numSteps = 200;
+
+fence = @()(D3d.Viewer.SelectPolygons([0,0;1,1],false));
+
+tf = struct('color',[1,1,1], 'a',0, 'b',1, 'c',0, 'minVal',0, 'maxVal',1, 'alphaMod',1, 'visible',true);
+steps = linspace(0,0.5,numSteps);
+
+images = cell(1,2);
+coalesced = zeros(1,2);
+for pass=1:2
+    % Start each pass from the same state
+    D3d.Viewer.SetBackgroundColor([0,0,0]);
+    D3d.Viewer.SetFrame(1);
+    tf.minVal = 0;
+    D3d.Viewer.TransferFunction(tf,'original');
+    fence();
+
+    before = D3d.Viewer.QueueStats();
+    for i=1:numSteps
+        tf.minVal = steps(i);
+        tf.alphaMod = 1 - steps(i);
+        D3d.Viewer.TransferFunction(tf,'original');
+        D3d.Viewer.SetBackgroundColor([steps(i),0,0]);
+        D3d.Viewer.SetFrame(1);
+
+        if ( pass==1 )
+            fence();
+        end
+    end
+    fence();
+    after = D3d.Viewer.QueueStats();
+
+    D3d.Viewer.UpdateRender();
+    images{pass} = D3d.Viewer.CaptureWindow();
+    coalesced(pass) = after.Coalesced - before.Coalesced;
+end
+
+fprintf('%d steps, coalesced one at a time: %d, as a burst: %d\n', numSteps, coalesced(1), coalesced(2));
+if ( isequal(images{1},images{2}) )
+    fprintf('Final render is identical\n');
+else
+    fprintf('Final render DIFFERS, %d pixels changed\n', nnz(any(images{1}~=images{2},3)));
+end
@@ -0,0 +1,55 @@
+%% Allocation counts for loading 50k small polygons, with and without normals
+% Run with a viewer already open on a volume (e.g. D3d.Open(im,imD)).
+% Polygons without norms are welded and get their normals in the MEX, using the scratch arenas.
+numPolys = 50000;
+imDims = [512,512,64];
+
+tetVerts = [0 0 0; 1 0 0; 0 1 0; 0 0 1];
+tetFaces = [1 3 2; 1 2 4; 1 4 3; 2 3 4];
+tetNorms = D3d.Polygon.CalcNorms(tetVerts,tetFaces);
+
+centers = rand(numPolys,3) .* repmat(imDims-1,numPolys,1);
+
+polygons = D3d.Polygon.MakeEmptyStruct();
+polygons(numPolys).index = numPolys;
+for i=1:numPolys
+    polygons(i).index = i;
+    polygons(i).frame = 1;
+    polygons(i).label = '';
+    polygons(i).color = [1,0,0];
+    polygons(i).faces = tetFaces;
+    polygons(i).verts = tetVerts + repmat(centers(i,:),4,1);
+    polygons(i).norms = tetNorms;
+    polygons(i).CenterOfMass = centers(i,:);
+end
+
+fence = @()(D3d.Viewer.SelectPolygons([0,0;1,1],false));
+
+stats = D3d.Viewer.AllocationStats();
+if ( ~stats.HeapCounting )
+    warning('Heap allocations are only counted when the viewer is built with D3D_ALLOC_STATS, they will show as zero.');
+end
+
+noNorms = polygons;
+[noNorms.norms] = deal([]);
+
+tests = {'With norms',polygons; 'Without norms',noNorms};
+
+fprintf('%d polygons, counts per load (and per polygon)\n', numPolys);
+fprintf('%-14s %16s %16s %12s %14s\n', 'Load', 'Heap allocs', 'Arena allocs', 'Arena chunks', 'Arena MB');
+for t=1:size(tests,1)
+    D3d.Viewer.DeleteAllPolygons();
+    fence();
+
+    before = D3d.Viewer.AllocationStats();
+    D3d.Viewer.AddPolygons(tests{t,2});
+    fence();
+    after = D3d.Viewer.AllocationStats();
+
+    heapAllocs = after.HeapAllocations - before.HeapAllocations;
+    arenaAllocs = after.ArenaAllocations - before.ArenaAllocations;
+    fprintf('%-14s %8d (%5.1f) %8d (%5.1f) %12d %14.2f\n', tests{t,1}, heapAllocs, heapAllocs/numPolys,...
+        arenaAllocs, arenaAllocs/numPolys, after.ArenaChunks - before.ArenaChunks, (after.ArenaBytes - before.ArenaBytes)/2^20);
+end
+
+D3d.Viewer.DeleteAllPolygons();
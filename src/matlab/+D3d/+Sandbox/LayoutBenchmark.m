@@ -0,0 +1,13 @@
+%% Vertex layout microbenchmark: per attribute slicing vs single pass interleaving
+% Runs on the MEX thread, no viewer window is needed.
+numVerts = 2^20;
+repeats = 10;
+
+results = D3d.Viewer.LayoutBenchmark(numVerts,repeats);
+
+fprintf('%d vertices, best of %d runs (GB/s of vertex buffer written)\n', numVerts, repeats);
+fprintf('%-10s %6s %10s %12s %8s\n', 'Layout', 'Bytes', 'Slice', 'Interleave', 'Speedup');
+for i=1:length(results)
+    fprintf('%-10s %6d %10.2f %12.2f %7.2fx\n', results(i).Layout, results(i).VertexBytes,...
+        results(i).SliceGBps, results(i).InterleaveGBps, results(i).Speedup);
+end
@@ -0,0 +1,13 @@
+%% Message queue microbenchmark: old mutex queue vs the lock-free ring the render thread drains
+% Runs on the MEX thread, no viewer window is needed.
+numMessages = 1e6;
+
+fprintf('%d messages, one consumer\n', numMessages);
+fprintf('%9s %-10s %14s %14s %14s %6s\n', 'Producers', 'Queue', 'Messages/s', 'Median (us)', '99% (us)', 'Valid');
+for producers=[1,2,4,8]
+    results = D3d.Viewer.QueueBenchmark(numMessages,producers);
+    for i=1:length(results)
+        fprintf('%9d %-10s %14.0f %14.1f %14.1f %6d\n', producers, results(i).Queue, results(i).MessagesPerSec,...
+            results(i).LatencyMedianUs, results(i).Latency99Us, results(i).Valid);
+    end
+end
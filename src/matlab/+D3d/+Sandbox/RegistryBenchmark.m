@@ -0,0 +1,63 @@
+%% Registry microbenchmark: show, hide, list and remove 100k small polygons
+% Run with a viewer already open on a volume (e.g. D3d.Open(im,imD)).
+% Blocking SelectPolygons calls are used as fences so the timings include the render thread work.
+numPolys = 100000;
+imDims = [512,512,64];
+
+tetVerts = [0 0 0; 1 0 0; 0 1 0; 0 0 1];
+tetFaces = [1 3 2; 1 2 4; 1 4 3; 2 3 4];
+tetNorms = D3d.Polygon.CalcNorms(tetVerts,tetFaces);
+
+centers = rand(numPolys,3) .* repmat(imDims-1,numPolys,1);
+
+polygons = D3d.Polygon.MakeEmptyStruct();
+polygons(numPolys).index = numPolys;
+for i=1:numPolys
+    polygons(i).index = i;
+    polygons(i).frame = 1;
+    polygons(i).label = '';
+    polygons(i).color = [1,0,0];
+    polygons(i).faces = tetFaces;
+    polygons(i).verts = tetVerts + repmat(centers(i,:),4,1);
+    polygons(i).norms = tetNorms;
+    polygons(i).CenterOfMass = centers(i,:);
+end
+
+fence = @()(D3d.Viewer.SelectPolygons([0,0;1,1],false));
+
+D3d.Viewer.DeleteAllPolygons();
+fence();
+
+tic;
+D3d.Viewer.AddPolygons(polygons);
+fence();
+fprintf('Add %d polygons: %.1f ms\n', numPolys, toc*1000);
+
+tic;
+D3d.Viewer.ShowAllPolygons(false);
+fence();
+fprintf('Hide all: %.2f ms\n', toc*1000);
+
+showList = randperm(numPolys,numPolys/2);
+tic;
+D3d.Viewer.ShowPolygonList(showList);
+fence();
+fprintf('Show list of %d: %.2f ms\n', length(showList), toc*1000);
+
+tic;
+D3d.Viewer.ShowAllPolygons(true);
+fence();
+fprintf('Show all: %.2f ms\n', toc*1000);
+
+removeList = randperm(numPolys,1000);
+tic;
+for i=1:length(removeList)
+    D3d.Viewer.RemovePolygon(removeList(i));
+end
+fence();
+fprintf('Remove %d random polygons: %.2f ms\n', length(removeList), toc*1000);
+
+tic;
+D3d.Viewer.DeleteAllPolygons();
+fence();
+fprintf('Delete all: %.1f ms\n', toc*1000);
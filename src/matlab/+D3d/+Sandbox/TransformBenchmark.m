@@ -0,0 +1,13 @@
+%% Image to model transform microbenchmark: per vertex Eigen loop vs the batch transform kernels
+% Runs on the MEX thread, no viewer window is needed.
+numVerts = 1e7;
+repeats = 5;
+
+results = D3d.Viewer.TransformBenchmark(numVerts,repeats);
+
+fprintf('%d vertices, best of %d runs\n', numVerts, repeats);
+fprintf('%-10s %14s %8s %10s %5s\n', 'Kernel', 'MVerts/s', 'Speedup', 'MaxError', 'AVX2');
+for i=1:length(results)
+    fprintf('%-10s %14.1f %7.2fx %10.2g %5d\n', results(i).Kernel, results(i).MVertsPerSec,...
+        results(i).Speedup, results(i).MaxError, results(i).Avx2);
+end
@@ -0,0 +1,12 @@
+% AddLabelPolygons - This builds polygons directly from a label or binary image and adds them to the viewer.
+%    PolygonInfo = Viewer.AddLabelPolygons(Labels,Frame,Colors,IndexOffset,VoxelRange)
+%    	Labels -- A 2-D or 3-D label image, each non-zero label becomes one polygon.
+%    		Logical images are split into 26-connected components first, like bwconncomp.
+%    	Frame -- The frame the polygons will be displayed on.
+%    	Colors -- Optional (n x 3) colors, label L uses row mod(L-1,n)+1. Empty spreads colors over the hue wheel.
+%    	IndexOffset -- Optional value added to each label to make the polygon index, use it to keep indices unique across frames.
+%    	VoxelRange -- Optional [min,max] voxel count for a label to become a polygon. Default is [3,inf].
+%    	PolygonInfo -- Optional structure array with the index, label, frame, CenterOfMass (x,y,z), numVoxels and numFaces of each added polygon.
+function PolygonInfo = AddLabelPolygons(Labels,Frame,Colors,IndexOffset,VoxelRange)
+    [PolygonInfo] = D3d.Viewer.Mex('AddLabelPolygons',Labels,Frame,Colors,IndexOffset,VoxelRange);
+end
@@ -5,6 +5,7 @@
 %    			faces - This is an ordered list of verticies where each group of three represent a triangle face.
 %    			verts - This is a list of verticies that represent the exterior of polygon.
 %    			norms - This is a list where each group of three make up a vector that represents the normal of the corresponding face.
+%    				This field is optional. When it is missing or empty, verts closer than 1e-4 are welded and area weighted normals are computed natively.
 %    			color - This is three doubles in the range [0,1] that represent the (r,g,b) color.
 %    				This can also be three times as long as the vert list where each triple corresponds to a color for each vertex.
 %    			frame - This is the frame in which the polygon will be displayed on.
@@ -0,0 +1,10 @@
+% AllocationStats - This will report the allocation counters of the viewer module since it was loaded.
+%    Stats = Viewer.AllocationStats()
+%    	Stats -- A structure with the running totals, take the difference of two calls to measure an operation.
+%    		HeapCounting is true if the viewer was built with D3D_ALLOC_STATS, only then do HeapAllocations and HeapFrees
+%    		count every operator new and delete made by the viewer on any thread (they are zero otherwise).
+%    		ArenaChunks is the number of heap blocks taken by arenas, ArenaAllocations and ArenaBytes are what they served
+%    		from those blocks instead of the heap (polygon load messages and mesh preparation scratch space).
+function Stats = AllocationStats()
+    [Stats] = D3d.Viewer.Mex('AllocationStats');
+end
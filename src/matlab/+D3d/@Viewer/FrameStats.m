@@ -0,0 +1,10 @@
+% FrameStats - This reports how long rendered frames have been taking, to check the viewer stayed interactive.
+%    Stats = Viewer.FrameStats(Reset)
+%    	Reset -- Optional, true clears the statistics after reporting them so the next call only covers newer frames.
+%    	Stats -- A structure with the TargetFps, BudgetMs and Window set by SetFrameBudget. Frames, OverBudget and DroppedFrames
+%    		count rendered frames, frames over the budget and display intervals missed since the last reset.
+%    		MeanMs, P50Ms, P95Ms, P99Ms and MaxMs are taken over the last WindowFrames frames, in milliseconds at microsecond
+%    		resolution. StageMeanMs and StageMaxMs split those frames into the render stages listed in StageNames.
+function Stats = FrameStats(Reset)
+    [Stats] = D3d.Viewer.Mex('FrameStats',Reset);
+end
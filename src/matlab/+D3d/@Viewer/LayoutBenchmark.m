@@ -0,0 +1,9 @@
+% LayoutBenchmark - This times writing vertex buffers for each vertex layout, one attribute at a time and interleaved in a single pass.
+%    Results = Viewer.LayoutBenchmark(NumVerts,Repeats)
+%    	NumVerts -- Optional number of vertices to write per run. Default is 2^20.
+%    	Repeats -- Optional number of runs, the fastest run is reported. Default is 10.
+%    	Results -- A structure array with the Layout name, VertexBytes per vertex, the throughput of both writers in GB/s
+%    		of vertex buffer written (SliceGBps and InterleaveGBps) and the Speedup of interleaving.
+function Results = LayoutBenchmark(NumVerts,Repeats)
+    [Results] = D3d.Viewer.Mex('LayoutBenchmark',NumVerts,Repeats);
+end
@@ -1,4 +1,4 @@
-% LoadTexture - this will load the image into texture buffers for display in the D3d viewer.
+% LoadTexture - this will load the image into texture buffers for display in the D3d viewer. The image is copied and this returns before it is uploaded, a newer load of the same buffer replaces one still waiting. Load errors are reported by the next viewer call.
 %    Viewer.LoadTexture(Image,BufferType)
 %    	Image -- This should be an matrix up to five dimensions in the order (y,x,z,channel,time).
 %    	BufferType -- this can either be 'original' or 'processed' and corresponds to the first and second texture buffer available to load images into.
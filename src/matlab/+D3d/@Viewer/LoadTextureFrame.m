@@ -1,4 +1,4 @@
-% LoadTextureFrame - this will load the image into texture buffers for display in the D3d viewer.
+% LoadTextureFrame - this will load the image into texture buffers for display in the D3d viewer. The image is copied and this returns before it is uploaded, a newer load of the same buffer and frame replaces one still waiting. Load errors are reported by the next viewer call.
 %    Viewer.LoadTextureFrame(Image,Frame,BufferType)
 %    	Image -- This should be an matrix up to 4 dimensions in the order (y,x,z,channel).
 %    	Frame -- The frame in the sequence at which to load this texture data.
@@ -0,0 +1,9 @@
+% MemoryReport - This will report the GPU vertex and index buffer memory held by each type of scene object.
+%    Report = Viewer.MemoryReport()
+%    	Report -- A structure array with one entry per object Type and a final PolygonBatches entry for the merged per-frame buffers.
+%    		Objects is the number of scene objects, Buffers the number of unique meshes (shared meshes are counted once).
+%    		VertexBytes and IndexBytes are the sizes of the buffers on the GPU, UnpackedBytes is what the same buffers would take
+%    		with float vertex attributes and 32-bit indices.
+function Report = MemoryReport()
+    [Report] = D3d.Viewer.Mex('MemoryReport');
+end
@@ -0,0 +1,13 @@
+% MeshStats - This will report how well polygon meshes and materials are being shared.
+%    Stats = Viewer.MeshStats()
+%    	Stats -- A structure with the number of unique meshes and materials, how many polygons reference them,
+%    		the dedup ratio (references per unique mesh), the bytes of unique mesh data and the bytes saved by sharing.
+%    		LodFaces has the unique mesh faces at full detail and at each decimated level, LodMaxError is the largest decimation
+%    		error as a fraction of a hull's bounding box diagonal, an upper bound on how far a moved vertex is from the planes of
+%    		the faces it replaced, and LodBuildSeconds is the total time spent decimating.
+%    		FrameFaces and FrameFullDetailFaces are the polygon faces drawn in the last frame and how many full detail would draw.
+%    		AcmrBefore and AcmrAfter are the vertex shader runs per triangle of the OptimizedMeshes before and after vertex cache
+%    		optimization (3 is no reuse, lower is better) and OptimizeSeconds is the time spent reordering them.
+function Stats = MeshStats()
+    [Stats] = D3d.Viewer.Mex('MeshStats');
+end
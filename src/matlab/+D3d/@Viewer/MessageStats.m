@@ -0,0 +1,10 @@
+% MessageStats - This will report how long commands to the viewer waited in its queue and how long they took to run.
+%    Stats = Viewer.MessageStats(Reset)
+%    	Reset -- true to clear the timings after reading them, so the next call only covers what ran in between. [] or false keeps them.
+%    	Stats -- A structure array, the first entry (Type 'All') covers every command, then one entry per command Type.
+%    		Count is the number of commands run. Queued* is the time from sending a command until the viewer started it,
+%    		Processing* the time it took to run, both as the Mean, P50, P95 and P99 percentiles and Max in milliseconds.
+%    		Percentiles are within about 6% of the true value. Time spent rendering shows up as queued time of the commands behind it.
+function Stats = MessageStats(Reset)
+    [Stats] = D3d.Viewer.Mex('MessageStats',Reset);
+end
@@ -0,0 +1,11 @@
+% PollEvents - This returns the viewer events newer than a sequence number, optionally only some event types.
+%    [Events,LastSequence,Dropped] = Viewer.PollEvents(Since,Types)
+%    	Since -- Sequence number of the last event already handled, use 0 or [] for everything still held.
+%    	Types -- Cell array of event type names to return, e.g. {'timeChange','polygonsSelected'}. Empty returns all types.
+%    	Events -- A structure array with the Sequence, Time (seconds since the viewer loaded), Type, Key (for keyDown/keyUp),
+%    		Value, Message (error text) and Array (points and polygon lists) of each event, oldest first.
+%    	LastSequence -- Pass this as Since on the next call to get only newer events.
+%    	Dropped -- Number of events after Since the viewer had to overwrite before they were read, the last 4096 are kept.
+function [Events,LastSequence,Dropped] = PollEvents(Since,Types)
+    [Events,LastSequence,Dropped] = D3d.Viewer.Mex('PollEvents',Since,Types);
+end
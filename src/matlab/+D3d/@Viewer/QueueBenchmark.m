@@ -0,0 +1,9 @@
+% QueueBenchmark - This stress tests the lock-free message ring against the old mutex queue, no viewer window is needed.
+%    Results = Viewer.QueueBenchmark(NumMessages,Producers)
+%    	NumMessages -- Optional number of messages pushed in total. Default is 10^6.
+%    	Producers -- Optional number of threads pushing at once, one thread consumes. Default is 4.
+%    	Results -- A structure array with the Queue name, MessagesPerSec through it, the median and 99th percentile push to pop
+%    		latency in microseconds and Valid, false if any message was lost, duplicated or reordered within its producer.
+function Results = QueueBenchmark(NumMessages,Producers)
+    [Results] = D3d.Viewer.Mex('QueueBenchmark',NumMessages,Producers);
+end
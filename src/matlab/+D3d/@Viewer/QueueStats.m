@@ -0,0 +1,8 @@
+% QueueStats - This will report the counters of the command queue to the viewer since it was loaded.
+%    Stats = Viewer.QueueStats()
+%    	Stats -- A structure with Processed, the number of commands run by the viewer, Coalesced, the number of queued
+%    		settings commands (transfer function, frame, colors, ...) dropped because a newer one for the same target
+%    		arrived before they ran, and Pending, the commands still waiting.
+function Stats = QueueStats()
+    [Stats] = D3d.Viewer.Mex('QueueStats');
+end
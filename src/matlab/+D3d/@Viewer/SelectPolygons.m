@@ -0,0 +1,8 @@
+% SelectPolygons - This will select all visible polygons in the current frame that fall inside a screen-space region.
+%    PolygonIndices = Viewer.SelectPolygons(Region,Touching)
+%    	Region -- An (n x 2) array of (x,y) window pixel coordinates. Two points are treated as the corners of a rectangle, more points form a closed lasso.
+%    	Touching -- If true, polygons with any vertex inside the region are also selected. Otherwise only polygons whose centroids are inside are selected.
+%    	PolygonIndices -- The selected polygon indices. If no output is requested the selection is sent as a 'polygonsSelected' message instead.
+function PolygonIndices = SelectPolygons(Region,Touching)
+    [PolygonIndices] = D3d.Viewer.Mex('SelectPolygons',Region,Touching);
+end
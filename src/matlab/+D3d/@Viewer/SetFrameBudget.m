@@ -0,0 +1,9 @@
+% SetFrameBudget - This sets what the frame statistics measure rendering against. Pass [] to keep a setting as it is.
+%    Viewer.SetFrameBudget(TargetFps,BudgetMs,Window)
+%    	TargetFps -- Display rate, a frame longer than 1/TargetFps counts the intervals it missed as dropped frames. Default is 60.
+%    	BudgetMs -- Optional, frames longer than this send a frameOverBudget event (see PollEvents).
+%    		Default is 0, which uses the target frame interval.
+%    	Window -- Optional number of most recent frames the FrameStats percentiles cover. Default is 600.
+function SetFrameBudget(TargetFps,BudgetMs,Window)
+    D3d.Viewer.Mex('SetFrameBudget',TargetFps,BudgetMs,Window);
+end
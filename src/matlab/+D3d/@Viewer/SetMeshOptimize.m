@@ -0,0 +1,8 @@
+% SetMeshOptimize - This turns vertex cache optimization of newly added polygons on or off. It is on by default.
+%    Viewer.SetMeshOptimize(On)
+%    	On -- When true, faces of each new mesh are reordered for GPU vertex cache reuse and its vertices for fetch locality.
+%    		The drawn triangles do not change. Decimated levels of detail have their faces reordered as well.
+%    	Use MeshStats to see the average cache miss ratio (ACMR) of the optimized meshes before and after.
+function SetMeshOptimize(On)
+    D3d.Viewer.Mex('SetMeshOptimize',On);
+end
@@ -0,0 +1,9 @@
+% SetPolygonLod - This sets how polygons are decimated into lower levels of detail for hulls that are small on screen.
+%    Viewer.SetPolygonLod(ErrorBound,LevelSizes)
+%    	ErrorBound -- The largest on-screen deviation in pixels a decimated level may introduce. Default is 1, 0 always draws full detail.
+%    	LevelSizes -- Optional decreasing pixel sizes [level1,level2]. A hull uses a level once its projected bounding box
+%    		diagonal is smaller than that level's size. Default is [128,32].
+%    	Use MeshStats to see the face counts of each level and how many faces were drawn in the last frame.
+function SetPolygonLod(ErrorBound,LevelSizes)
+    D3d.Viewer.Mex('SetPolygonLod',ErrorBound,LevelSizes);
+end
@@ -0,0 +1,9 @@
+% SetPolygonState - This will update the visibility, color and wireframe state of many polygons in a single pass.
+%    Viewer.SetPolygonState(PolygonIndices,Visible,Colors,Wireframe)
+%    	PolygonIndices -- A list of polygon indices or a logical mask where element i selects polygon i. An empty list selects all polygons.
+%    	Visible -- Empty to leave visibility unchanged, a scalar for all selected polygons, or one value per selected polygon.
+%    	Colors -- Empty to leave colors unchanged, a single (1 x 3) or (1 x 4) color, or one row per selected polygon. The optional fourth column is alpha. 'none' clears the colors back to each polygon's own vertex colors.
+%    	Wireframe -- Empty to leave unchanged, otherwise turns wireframe rendering on or off for the selected polygons.
+function SetPolygonState(PolygonIndices,Visible,Colors,Wireframe)
+    D3d.Viewer.Mex('SetPolygonState',PolygonIndices,Visible,Colors,Wireframe);
+end
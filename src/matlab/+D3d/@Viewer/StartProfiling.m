@@ -0,0 +1,6 @@
+% StartProfiling - This will start timing the viewer's rendering, command processing and loading, anything recorded before is cleared.
+%    Viewer.StartProfiling()
+%    	Use WriteProfile to save the timings as a trace and StopProfiling to stop recording them.
+function StartProfiling()
+    D3d.Viewer.Mex('StartProfiling');
+end
@@ -0,0 +1,9 @@
+% StartRecording - This will record every command sent to the viewer into a command log until StopRecording is called.
+%    Viewer.StartRecording(File)
+%    	File -- Path of the log to write, an existing file is replaced.
+%    		The log can be replayed without MATLAB by the standalone viewer: d3dStandalone -replay File [-max] [-report ReportFile].
+%    		Start recording before InitVolume so the replay has a volume to work with. Images and meshes are stored once however often they are sent.
+%    		Captures, outputs and Close are not recorded.
+function StartRecording(File)
+    D3d.Viewer.Mex('StartRecording',File);
+end
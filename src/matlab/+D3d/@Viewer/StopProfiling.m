@@ -0,0 +1,4 @@
+% StopProfiling - StopProfiling() This will stop recording timings, what was recorded is kept for WriteProfile until the next StartProfiling.
+function StopProfiling()
+    D3d.Viewer.Mex('StopProfiling');
+end
@@ -0,0 +1,8 @@
+% StopRecording - This will stop the command log started with StartRecording and close its file.
+%    Stats = Viewer.StopRecording()
+%    	Stats -- A structure with the number of commands Recorded, the number Skipped because they can't be replayed,
+%    		and the size of the log in Bytes.
+%    		It is an error if any part of the log could not be written, the file is then incomplete.
+function Stats = StopRecording()
+    [Stats] = D3d.Viewer.Mex('StopRecording');
+end
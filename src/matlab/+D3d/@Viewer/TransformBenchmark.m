@@ -0,0 +1,9 @@
+% TransformBenchmark - This times the image to model vertex transform with the old per vertex Eigen loop and the batch transform kernels.
+%    Results = Viewer.TransformBenchmark(NumVerts,Repeats)
+%    	NumVerts -- Optional number of vertices to transform per run. Default is 10^7.
+%    	Repeats -- Optional number of runs, the fastest run is reported. Default is 5.
+%    	Results -- A structure array with the Kernel name, millions of vertices transformed per second, the Speedup over
+%    		the Eigen loop, the MaxError against it and whether the AVX2 path was used. Kernel is threaded above 2^18 vertices.
+function Results = TransformBenchmark(NumVerts,Repeats)
+    [Results] = D3d.Viewer.Mex('TransformBenchmark',NumVerts,Repeats);
+end
@@ -2,31 +2,46 @@ classdef (Abstract,Sealed) Viewer
 methods (Static)
     commandInfo = Info()
     Help(command)
+    PolygonInfo = AddLabelPolygons(Labels,Frame,Colors,IndexOffset,VoxelRange)
     AddPolygons(polygonsStruct)
+    Stats = AllocationStats()
     CaptureSpinMovie()
     ImageOut = CaptureWindow()
     ClearAllTextures(BufferType)
     ClearTextureFrame(Frame,BufferType)
     Close()
     DeleteAllPolygons()
+    Stats = FrameStats(Reset)
     Init(pathStr)
     InitVolume(ImageDims,PhysicalUnits)
+    Results = LayoutBenchmark(NumVerts,Repeats)
     LoadTexture(Image,BufferType)
     LoadTextureFrame(Image,Frame,BufferType)
+    Report = MemoryReport()
+    Stats = MeshStats()
+    Stats = MessageStats(Reset)
     MoveCamera(deltas)
     Play(playOn)
     MessageArray = Poll()
+    [Events,LastSequence,Dropped] = PollEvents(Since,Types)
+    Results = QueueBenchmark(NumMessages,Producers)
+    Stats = QueueStats()
     ReleaseControl()
     RemovePolygon(index)
     ResetView()
     PolygonLighting(lightOn)
+    PolygonIndices = SelectPolygons(Region,Touching)
     SetBackgroundColor(color)
     SetBorderColor(color)
     SetCapturePath(filePath,filePrefix)
     SetCaptureSize(width,height)
     SetDpiScale(scalePct)
     SetFrame(frame)
+    SetFrameBudget(TargetFps,BudgetMs,Window)
     SetFrontClip(FrontClipDistance)
+    SetMeshOptimize(On)
+    SetPolygonLod(ErrorBound,LevelSizes)
+    SetPolygonState(PolygonIndices,Visible,Colors,Wireframe)
     SetViewOrigin(viewOrigin)
     SetViewRotation(rotationVector_xyz,deltaAngle)
     SetWindowSize(width,height)
@@ -39,12 +54,18 @@ methods (Static)
     ShowTexture(bufferType)
     ShowScaleBar(on)
     ShowWidget(on)
+    StartProfiling()
+    StartRecording(File)
+    StopProfiling()
+    Stats = StopRecording()
     TakeControl()
     TextureAttenuation(on)
     TextureLighting(lightOn)
     TransferFunction(TransferFunctionStruct,BufferType)
     ToggleWireframe(wireFrameOn)
+    Results = TransformBenchmark(NumVerts,Repeats)
     UpdateRender()
+    Stats = WriteProfile(File)
 end
 methods (Static, Access = private)
     varargout = Mex(command, varargin)
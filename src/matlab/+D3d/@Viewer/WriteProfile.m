@@ -0,0 +1,10 @@
+% WriteProfile - This will save the timings recorded since StartProfiling as a Chrome trace, it can be called while still recording.
+%    Stats = Viewer.WriteProfile(File)
+%    	File -- Path of the JSON file to write, open it in chrome://tracing or https://ui.perfetto.dev.
+%    		Each thread (Render and the Worker pool) is a row of nested zones: frames and their render stages,
+%    		material updates, scene traversal, every command by its message type and the texture and polygon load work.
+%    	Stats -- A structure with the number of Zones and Threads written, and the zones Dropped because a thread recorded
+%    		more than its buffer holds (about a million zones per thread).
+function Stats = WriteProfile(File)
+    [Stats] = D3d.Viewer.Mex('WriteProfile',File);
+end